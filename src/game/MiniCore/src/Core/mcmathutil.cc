@@ -22,21 +22,23 @@
 
 float MCMathUtil::rotatedX(float x0, float y0, float angle)
 {
-    return MCTrigonom::cos(angle) * x0 -
-        MCTrigonom::sin(angle) * y0;
+    float sin, cos;
+    MCTrigonom::sinCos(angle, sin, cos);
+    return cos * x0 - sin * y0;
 }
 
 float MCMathUtil::rotatedY(float x0, float y0, float angle)
 {
-    return MCTrigonom::sin(angle) * x0 +
-        MCTrigonom::cos(angle) * y0;
+    float sin, cos;
+    MCTrigonom::sinCos(angle, sin, cos);
+    return sin * x0 + cos * y0;
 }
 
 void MCMathUtil::rotateVector(
     const MCVector2dF & v0, MCVector2dF & v1, float angle)
 {
-    const float sin = MCTrigonom::sin(angle);
-    const float cos = MCTrigonom::cos(angle);
+    float sin, cos;
+    MCTrigonom::sinCos(angle, sin, cos);
 
     v1.setI(cos * v0.i() - sin * v0.j());
     v1.setJ(sin * v0.i() + cos * v0.j());
@@ -44,8 +46,8 @@ void MCMathUtil::rotateVector(
 
 MCVector2dF MCMathUtil::rotatedVector(const MCVector2dF & v0, float angle)
 {
-    const float sin = MCTrigonom::sin(angle);
-    const float cos = MCTrigonom::cos(angle);
+    float sin, cos;
+    MCTrigonom::sinCos(angle, sin, cos);
 
     return MCVector2dF(cos * v0.i() - sin * v0.j(), sin * v0.i() + cos * v0.j());
 }
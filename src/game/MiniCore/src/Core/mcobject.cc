@@ -19,21 +19,20 @@
 
 #include "mcobject.hh"
 
-#include "mccamera.hh"
 #include "mccircleshape.hh"
 #include "mccollisionevent.hh"
+#include "mccontactevent.hh"
 #include "mcevent.hh"
+#include "mcobjectgrid.hh"
 #include "mcoutofboundariesevent.hh"
 #include "mcphysicscomponent.hh"
 #include "mcrectshape.hh"
-#include "mcshapeview.hh"
-#include "mcsurface.hh"
+#include "mcstatebuffer.hh"
 #include "mctimerevent.hh"
 #include "mctrigonom.hh"
-#include "mcsurfaceview.hh"
 #include "mcworld.hh"
-#include "mcworldrenderer.hh"
 
+#include <atomic>
 #include <cassert>
 
 namespace {
@@ -41,15 +40,21 @@ const int physicsObjectBit    = 1;
 const int triggerObjectBit    = 2;
 const int renderableBit       = 4;
 const int bypassCollisionsBit = 8;
+const int renderOnlyBit       = 16;
 const int removingBit         = 32;
+const int dirtyChildrenBit    = 64;
 const int isParticleBit       = 128;
+const int childVelocityBit    = 256;
+const int persistContactsBit  = 512;
+
+std::atomic<unsigned int> nextObjectId(0);
 }
 
 MCTypeRegistry MCObject::m_typeRegistry;
-MCObject::TimerEventObjectsList MCObject::m_timerEventObjects;
 
 MCObject::MCObject(const std::string & typeName)
     : m_typeId(MCObject::m_typeRegistry.registerType(typeName))
+    , m_id(nextObjectId++)
     , m_typeName(typeName)
     , m_status(physicsObjectBit | renderableBit)
     , m_parent(this)
@@ -64,18 +69,6 @@ MCObject::MCObject(MCShapePtr shape, const std::string & typeName)
     setShape(shape);
 }
 
-MCObject::MCObject(MCSurface & surface, const std::string & typeName)
-    : MCObject(typeName)
-{
-    // Create an MCRectShape using surface with an MCSurfaceView
-    MCShapePtr rectShape(new MCRectShape(
-        MCShapeViewPtr(new MCSurfaceView(surface.handle(), &surface)),
-        surface.width(),
-        surface.height()));
-
-    setShape(rectShape);
-}
-
 unsigned int MCObject::getTypeIdForName(const std::string & typeName)
 {
     return MCObject::m_typeRegistry.getTypeIdForName(typeName);
@@ -102,6 +95,7 @@ void MCObject::removeChildObject(MCObject & child)
     if (child.m_parent == this)
     {
         child.m_parent = &child;
+        child.updateCollisionFilter();
         for (auto iter = m_children.begin(); iter != m_children.end(); iter++)
         {
             if ((*iter).get() == &child)
@@ -118,6 +112,7 @@ void MCObject::removeChildObject(MCObjectPtr child)
     if (child->m_parent == this)
     {
         child->m_parent = child.get();
+        child->updateCollisionFilter();
         for (auto iter = m_children.begin(); iter != m_children.end(); iter++)
         {
             if ((*iter) == child)
@@ -134,9 +129,26 @@ const MCObject::Children & MCObject::children() const
     return m_children;
 }
 
+void MCObject::addTriggerVolume(MCTriggerVolumePtr volume)
+{
+    volume->m_owner = this;
+    m_triggerVolumes.push_back(volume);
+
+    if (m_world)
+    {
+        m_world->addTriggerVolume(*volume);
+    }
+}
+
+const MCObject::TriggerVolumes & MCObject::triggerVolumes() const
+{
+    return m_triggerVolumes;
+}
+
 void MCObject::setParent(MCObject & parent)
 {
     m_parent = &parent;
+    updateCollisionFilter();
 }
 
 MCObject & MCObject::parent() const
@@ -168,7 +180,12 @@ void MCObject::checkBoundaries()
 
 void MCObject::checkXBoundariesAndSendEvent(float minX, float maxX)
 {
-    const MCWorld & world = MCWorld::instance();
+    if (!m_world)
+    {
+        return;
+    }
+
+    const MCWorld & world = *m_world;
     if (minX < world.minX())
     {
         MCOutOfBoundariesEvent e(MCOutOfBoundariesEvent::West, *this);
@@ -183,7 +200,12 @@ void MCObject::checkXBoundariesAndSendEvent(float minX, float maxX)
 
 void MCObject::checkYBoundariesAndSendEvent(float minY, float maxY)
 {
-    const MCWorld & world = MCWorld::instance();
+    if (!m_world)
+    {
+        return;
+    }
+
+    const MCWorld & world = *m_world;
     if (minY < world.minY())
     {
         MCOutOfBoundariesEvent e(MCOutOfBoundariesEvent::South, *this);
@@ -198,7 +220,12 @@ void MCObject::checkYBoundariesAndSendEvent(float minY, float maxY)
 
 void MCObject::checkZBoundariesAndSendEvent()
 {
-    const MCWorld & world = MCWorld::instance();
+    if (!m_world)
+    {
+        return;
+    }
+
+    const MCWorld & world = *m_world;
     if (m_location.k() < world.minZ())
     {
         m_physicsComponent->resetZ();
@@ -222,6 +249,11 @@ unsigned int MCObject::typeId() const
     return m_typeId;
 }
 
+unsigned int MCObject::id() const
+{
+    return m_id;
+}
+
 unsigned int MCObject::typeId(const std::string & typeName)
 {
     return MCObject::getTypeIdForName(typeName);
@@ -239,6 +271,11 @@ bool MCObject::event(MCEvent & event)
         outOfBoundariesEvent(static_cast<MCOutOfBoundariesEvent &>(event));
         return true;
     }
+    else if (event.instanceTypeId() == MCContactEvent::typeId())
+    {
+        contactEvent(static_cast<MCContactEvent &>(event));
+        return true;
+    }
 
     return false;
 }
@@ -248,94 +285,78 @@ void MCObject::collisionEvent(MCCollisionEvent & event)
     event.accept();
 }
 
-void MCObject::outOfBoundariesEvent(MCOutOfBoundariesEvent & event)
+void MCObject::contactEvent(MCContactEvent & event)
 {
     event.accept();
 }
 
-void MCObject::sendEvent(MCObject & object, MCEvent & event)
-{
-    object.event(event);
-}
-
-void MCObject::subscribeTimerEvent(MCObject & object)
-{
-    if (object.m_timerEventObjectsIndex == -1)
-    {
-        m_timerEventObjects.push_back(&object);
-        object.m_timerEventObjectsIndex = static_cast<int>(m_timerEventObjects.size()) - 1;
-    }
-}
-
-void MCObject::unsubscribeTimerEvent(MCObject & object)
+void MCObject::outOfBoundariesEvent(MCOutOfBoundariesEvent & event)
 {
-    if (object.m_timerEventObjectsIndex > -1)
-    {
-        m_timerEventObjects.back()->m_timerEventObjectsIndex =
-            object.m_timerEventObjectsIndex;
-        m_timerEventObjects.at(object.m_timerEventObjectsIndex) =
-            m_timerEventObjects.back();
-        m_timerEventObjects.pop_back();
-        object.m_timerEventObjectsIndex = -1;
-    }
+    event.accept();
 }
 
-void MCObject::sendTimerEvent(MCTimerEvent & event)
+void MCObject::sendEvent(MCObject & object, MCEvent & event)
 {
-    for (MCObject * obj : m_timerEventObjects)
-    {
-        MCObject::sendEvent(*obj, event);
-    }
+    object.event(event);
 }
 
-void MCObject::addToWorld()
+void MCObject::addToWorld(MCWorld & world)
 {
-    MCWorld::instance().addObject(*this);
+    world.addObject(*this);
 
     for (auto child : m_children)
     {
-        MCWorld::instance().addObject(*child);
+        if (!child->isRenderOnly())
+        {
+            world.addObject(*child);
+        }
     }
 }
 
-void MCObject::addToWorld(float x, float y, float z)
+void MCObject::addToWorld(MCWorld & world, float x, float y, float z)
 {
-    MCWorld::instance().addObject(*this);
-
-    for (auto child : m_children)
-    {
-        MCWorld::instance().addObject(*child);
-    }
+    addToWorld(world);
 
     translate(MCVector3dF(x, y, z));
 }
 
 void MCObject::removeFromWorld()
 {
-    if (MCWorld::hasInstance())
+    if (m_world)
     {
-        MCWorld::instance().removeObject(*this);
+        m_world->removeObject(*this);
+    }
 
-        for (auto child : m_children)
+    for (auto child : m_children)
+    {
+        if (child->m_world)
         {
-            MCWorld::instance().removeObjectNow(*child);
+            child->m_world->removeObjectNow(*child);
         }
     }
 }
 
 void MCObject::removeFromWorldNow()
 {
-    if (MCWorld::hasInstance())
+    if (m_world)
     {
-        MCWorld::instance().removeObjectNow(*this);
+        m_world->removeObjectNow(*this);
+    }
 
-        for (auto child : m_children)
+    for (auto child : m_children)
+    {
+        if (child->m_world)
         {
-            MCWorld::instance().removeObjectNow(*child);
+            child->m_world->removeObjectNow(*child);
         }
     }
 }
 
+MCWorld * MCObject::world() const
+{
+    return m_world;
+}
+
 void MCObject::render(MCCamera * p)
 {
     if (m_shape)
@@ -372,6 +393,7 @@ bool MCObject::testStatus(int bit) const
 void MCObject::setIsPhysicsObject(bool flag)
 {
     setStatus(physicsObjectBit, flag);
+    updateCollisionFilter();
 }
 
 bool MCObject::isPhysicsObject() const
@@ -382,6 +404,7 @@ bool MCObject::isPhysicsObject() const
 void MCObject::setIsTriggerObject(bool flag)
 {
     setStatus(triggerObjectBit, flag);
+    updateCollisionFilter();
 }
 
 bool MCObject::isTriggerObject() const
@@ -392,6 +415,7 @@ bool MCObject::isTriggerObject() const
 void MCObject::setBypassCollisions(bool flag)
 {
     setStatus(bypassCollisionsBit, flag);
+    updateCollisionFilter();
 }
 
 bool MCObject::bypassCollisions() const
@@ -409,6 +433,26 @@ bool MCObject::isRenderable() const
     return testStatus(renderableBit);
 }
 
+void MCObject::setIsRenderOnly(bool flag)
+{
+    setStatus(renderOnlyBit, flag);
+}
+
+bool MCObject::isRenderOnly() const
+{
+    return testStatus(renderOnlyBit);
+}
+
+void MCObject::setReceivesPersistContactEvents(bool flag)
+{
+    setStatus(persistContactsBit, flag);
+}
+
+bool MCObject::receivesPersistContactEvents() const
+{
+    return testStatus(persistContactsBit);
+}
+
 void MCObject::setIsParticle(bool flag)
 {
     setStatus(isParticleBit, flag);
@@ -440,18 +484,16 @@ void MCObject::translate(const MCVector3dF & newLocation)
     {
         m_location = newLocation;
 
-        updateChildTransforms();
+        invalidateChildTransforms();
     }
     else
     {
-        const bool wasInWorld = !removing() && MCWorld::instance().objectGrid().remove(*this);
-
         // Calculate velocity if this object is a child object and is thus moved
         // by the parent. This way we'll automatically get linear velocity +
         // possible orbital velocity.
         // TODO: do we need to take the time step into account here?
         if (m_parent != this &&
-            m_parent->physicsComponent().isIntegrating() &&
+            (m_parent->physicsComponent().isIntegrating() || m_parent->testStatus(childVelocityBit)) &&
             !m_parent->physicsComponent().isStationary())
         {
             m_physicsComponent->setVelocity(newLocation - m_location);
@@ -461,11 +503,19 @@ void MCObject::translate(const MCVector3dF & newLocation)
 
         m_shape->translate(m_location - MCVector3dF(m_center));
 
-        updateChildTransforms();
+        invalidateChildTransforms();
 
-        if (wasInWorld)
+        // Objects that are being removed drop out of the broadphase
+        if (m_world)
         {
-            MCWorld::instance().objectGrid().insert(*this);
+            if (removing())
+            {
+                m_world->removeObjectFromBroadphase(*this);
+            }
+            else
+            {
+                m_world->updateObjectInBroadphase(*this);
+            }
         }
     }
 }
@@ -505,7 +555,7 @@ void MCObject::rotate(float newAngle, bool updateChildTransforms_)
 
     if (updateChildTransforms_)
     {
-        updateChildTransforms();
+        invalidateChildTransforms();
     }
 }
 
@@ -530,14 +580,12 @@ void MCObject::rotateShape(float angle)
         }
         else
         {
-            const bool wasInWorld = MCWorld::instance().objectGrid().remove(*this);
-
             m_shape->rotate(angle);
             m_shape->translate(m_location - MCVector3dF(m_center));
 
-            if (wasInWorld)
+            if (m_world)
             {
-                MCWorld::instance().objectGrid().insert(*this);
+                m_world->updateObjectInBroadphase(*this);
             }
         }
     }
@@ -578,6 +626,7 @@ MCShapePtr MCObject::shape() const
 void MCObject::setCollisionLayer(int layer)
 {
     m_collisionLayer = layer;
+    updateCollisionFilter();
 
     for (auto child : m_children) {
         child->setCollisionLayer(layer);
@@ -589,6 +638,16 @@ int MCObject::collisionLayer() const
     return m_collisionLayer;
 }
 
+const MCCollisionFilter & MCObject::collisionFilter() const
+{
+    return m_collisionFilter;
+}
+
+void MCObject::updateCollisionFilter()
+{
+    m_collisionFilter.update(*this);
+}
+
 void MCObject::setIndex(int newIndex)
 {
     m_index = newIndex;
@@ -599,6 +658,45 @@ int MCObject::index() const
     return m_index;
 }
 
+void MCObject::saveState(MCStateBuffer & state) const
+{
+    state.write(m_location);
+    state.write(m_angle);
+    state.write(m_relativeLocation);
+    state.write(m_relativeAngle);
+    state.write(m_center);
+
+    const unsigned int indexRange[] = {m_i0, m_i1, m_j0, m_j1};
+    state.write(indexRange, 4);
+
+    if (m_shape)
+    {
+        m_shape->saveState(state);
+    }
+
+    m_physicsComponent->saveState(state);
+}
+
+void MCObject::restoreState(MCStateBuffer & state)
+{
+    state.read(m_location);
+    state.read(m_angle);
+    state.read(m_relativeLocation);
+    state.read(m_relativeAngle);
+    state.read(m_center);
+
+    unsigned int indexRange[4];
+    state.read(indexRange, 4);
+    cacheIndexRange(indexRange[0], indexRange[1], indexRange[2], indexRange[3]);
+
+    if (m_shape)
+    {
+        m_shape->restoreState(state);
+    }
+
+    m_physicsComponent->restoreState(state);
+}
+
 void MCObject::cacheIndexRange(unsigned int i0, unsigned int i1, unsigned int j0, unsigned int j1)
 {
     m_i0 = i0;
@@ -615,42 +713,6 @@ void MCObject::restoreIndexRange(unsigned int * i0, unsigned int * i1, unsigned
     *j1 = m_j1;
 }
 
-void MCObject::addContact(MCContact & contact)
-{
-    m_contacts[&contact.object()].push_back(&contact);
-}
-
-const MCObject::ContactHash & MCObject::contacts() const
-{
-    return m_contacts;
-}
-
-void MCObject::deleteContacts()
-{
-    auto i(m_contacts.begin());
-    for (; i != m_contacts.end(); i++)
-    {
-        for (unsigned int j = 0; j < i->second.size(); j++)
-        {
-            i->second[j]->free();
-        }
-    }
-    m_contacts.clear();
-}
-
-void MCObject::deleteContacts(MCObject & object)
-{
-    auto i(m_contacts.find(&object));
-    if (i != m_contacts.end())
-    {
-        for (unsigned int j = 0; j < i->second.size(); j++)
-        {
-            i->second[j]->free();
-        }
-        i->second.clear();
-    }
-}
-
 void MCObject::setInitialLocation(const MCVector3dF & location)
 {
     m_initialLocation = location;
@@ -671,8 +733,41 @@ int MCObject::initialAngle() const
     return m_initialAngle;
 }
 
+void MCObject::invalidateChildTransforms()
+{
+    if (m_children.empty())
+    {
+        return;
+    }
+
+    if (m_world && m_world->isStepping())
+    {
+        // Children moved by the integration get the velocity of the move when updated
+        if (m_physicsComponent->isIntegrating())
+        {
+            setStatus(childVelocityBit, true);
+        }
+
+        if (testStatus(dirtyChildrenBit))
+        {
+            m_world->m_avoidedChildTransformUpdates++;
+        }
+        else
+        {
+            setStatus(dirtyChildrenBit, true);
+            m_world->m_dirtyChildTransformObjs.push_back(this);
+        }
+    }
+    else
+    {
+        updateChildTransforms();
+    }
+}
+
 void MCObject::updateChildTransforms()
 {
+    setStatus(dirtyChildrenBit, false);
+
     for (auto child : m_children)
     {
         const float newAngle = m_angle + child->m_relativeAngle;
@@ -681,6 +776,13 @@ void MCObject::updateChildTransforms()
             MCVector3dF(MCMathUtil::rotatedVector(child->m_relativeLocation, m_angle),
                 child->m_relativeLocation.k()));
     }
+
+    setStatus(childVelocityBit, false);
+}
+
+bool MCObject::hasDirtyChildTransforms() const
+{
+    return testStatus(dirtyChildrenBit);
 }
 
 float MCObject::calculateLinearBalance(const MCVector3dF & force, const MCVector3dF & pos)
@@ -703,6 +805,7 @@ void MCObject::setPhysicsComponent(MCPhysicsComponent & physicsComponent)
     delete m_physicsComponent;
     m_physicsComponent = &physicsComponent;
     m_physicsComponent->setObject(*this);
+    updateCollisionFilter();
 }
 
 MCPhysicsComponent & MCObject::physicsComponent()
@@ -713,6 +816,5 @@ MCPhysicsComponent & MCObject::physicsComponent()
 MCObject::~MCObject()
 {
     removeFromWorldNow();
-    deleteContacts();
     delete m_physicsComponent;
 }
@@ -21,10 +21,10 @@
 #define MCOBJECT_HH
 
 #include "mcbbox.hh"
-#include "mccontact.hh"
+#include "mccollisionfilter.hh"
 #include "mcmacros.hh"
-#include "mcobjectgrid.hh"
 #include "mcshape.hh"
+#include "mctriggervolume.hh"
 #include "mctyperegistry.hh"
 #include "mcvector3d.hh"
 #include "mcworld.hh"
@@ -39,8 +39,10 @@ class MCShapeView;
 class MCSurface;
 class MCEvent;
 class MCCollisionEvent;
+class MCContactEvent;
 class MCOutOfBoundariesEvent;
 class MCPhysicsComponent;
+class MCStateBuffer;
 class MCTimerEvent;
 class MCCamera;
 
@@ -54,9 +56,6 @@ class MCObject
 {
 public:
 
-    //! Hash container for contacts. Prefer map here for iteration performance.
-    typedef std::map<MCObject *, std::vector<MCContact *> > ContactHash;
-
     /*! Constructor.
      *  \param typeId Type name string e.g. "CAR". All identical objects should have the same typeName. */
     explicit MCObject(const std::string & typeName);
@@ -73,7 +72,8 @@ public:
      *  \param surface Pointer to the (shared) surface to be used.
      *  MCObject won't take the ownership, because the same surface
      *  can be used to draw multiple objects and is managed by MCSurfaceManager.
-     *  \param typeName Type name string e.g. "CAR". All identical objects should have the same typeName. */
+     *  \param typeName Type name string e.g. "CAR". All identical objects should have the same typeName.
+     *  This is a part of the graphics library. */
     MCObject(MCSurface & surface, const std::string & typeName);
 
     //! Return integer id corresponding to the given object name.
@@ -90,6 +90,10 @@ public:
      *  to match given types of objects. */
     virtual unsigned int typeId() const;
 
+    /*! \return id that is unique among all objects and increases in the order of
+     *  creation. Used to order objects independent of their memory addresses. */
+    unsigned int id() const;
+
     /*! Return typeId for the given typeName string from
      *  MCObject's hash table. Each object registers
      *  its type in its constructor. This is automatic for
@@ -106,16 +110,6 @@ public:
      *  \param event Event to be sent. */
     static void sendEvent(MCObject & object, MCEvent & event);
 
-    //! Subscribe the given object to timer events.
-    static void subscribeTimerEvent(MCObject & object);
-
-    //! Subscribe the given object from timer events.
-    static void unsubscribeTimerEvent(MCObject & object);
-
-    /*! Send the given timer event to all objects that
-     *  have subscribed to timer events. */
-    static void sendTimerEvent(MCTimerEvent & event);
-
     /*! Render the object.
      *  \param p Camera window to be used. */
     virtual void render(MCCamera * p = nullptr);
@@ -131,24 +125,42 @@ public:
     //! \brief Return whether the object should be automatically rendered.
     bool isRenderable() const;
 
-    /*! \brief Add object to the World.
-     *  Convenience method to add object to the MCWorld instance.
+    /*! \brief Sets whether the object is only a visual part of its parent.
+     *  Render-only child objects are not added to the world with the parent: they
+     *  follow the transforms of the parent and are rendered with it, but they have
+     *  no physics, no collisions and onStepTime() is not called. False is the default. */
+    void setIsRenderOnly(bool flag);
+
+    //! \brief Return whether the object is only a visual part of its parent.
+    bool isRenderOnly() const;
+
+    /*! \brief Sets whether the object receives MCContactEvent::Type::Persist events on
+     *  each step of a contact. Begin and End are always sent. False is the default. */
+    void setReceivesPersistContactEvents(bool flag);
+
+    //! \brief Return whether the object receives MCContactEvent::Type::Persist events.
+    bool receivesPersistContactEvents() const;
+
+    /*! \brief Add object and its children to the given world.
      *  Composite objects may override this and add all their sub-objects. */
-    virtual void addToWorld();
+    virtual void addToWorld(MCWorld & world);
 
-    //! \brief Combined addToWorld() and translate.
-    virtual void addToWorld(float x, float y, float z = 0);
+    //! \brief Combined addToWorld(MCWorld &) and translate.
+    virtual void addToWorld(MCWorld & world, float x, float y, float z = 0);
 
     /*! \brief Remove object from the World.
-     *  Convenience method to remove object from the MCWorld instance.
+     *  Convenience method to remove object from the world it has been added to.
      *  Composite objects may re-implement this and remove all their sub-objects. */
     virtual void removeFromWorld();
 
     /*! \brief Remove object from the World immediately.
-     *  Convenience method to remove object from the MCWorld instance.
+     *  Convenience method to remove object from the world it has been added to.
      *  Composite objects may re-implement this and remove all their sub-objects. */
     virtual void removeFromWorldNow();
 
+    //! \return the world the object has been added to or nullptr.
+    MCWorld * world() const;
+
     /*! \brief Sets whether the physics of the object should be updated.
      *  True is the default. */
     void setIsPhysicsObject(bool flag);
@@ -185,7 +197,9 @@ public:
     //! Return true if the object is a particle.
     bool isParticle() const;
 
-    /*! Set location
+    /*! Set location. The child objects follow immediately, or, if the object
+     *  is in a world that is stepping, before the next collision detection.
+     *  \see MCWorld::updateChildTransforms()
      *  \param newLocation The new location. */
     void translate(const MCVector3dF & newLocation);
 
@@ -241,17 +255,9 @@ public:
     //! Return the collision layer.
     int collisionLayer() const;
 
-    //! Add a collision contact.
-    void addContact(MCContact & contact);
-
-    //! Get collision contact hash.
-    const ContactHash & contacts() const;
-
-    //! Delete current contacts.
-    void deleteContacts();
-
-    //! Delete all contacts with the given object.
-    void deleteContacts(MCObject & object);
+    /*! \return the collision filter derived from the parent, the collision flags,
+     *  the collision layer, the collision tags and the sleep state. */
+    const MCCollisionFilter & collisionFilter() const;
 
     //! Return index in MCWorld's object vector. Returns -1 if not in the world.
     int index() const;
@@ -283,6 +289,13 @@ public:
     typedef std::vector<MCObjectPtr> Children;
     const Children & children() const;
 
+    /*! Add a trigger volume that follows the object. The volume is evaluated
+     *  while the object is in the world. \see MCTriggerVolume. */
+    void addTriggerVolume(MCTriggerVolumePtr volume);
+
+    typedef std::vector<MCTriggerVolumePtr> TriggerVolumes;
+    const TriggerVolumes & triggerVolumes() const;
+
     //! Get parent or self;
     MCObject & parent() const;
 
@@ -305,6 +318,11 @@ protected:
      *  \param event Event to be handled. */
     virtual void collisionEvent(MCCollisionEvent & event);
 
+    /*! Event handler for MCContactEvent. Sent once per step when a contact with
+     *  another object begins, persists or ends.
+     *  \param event Event to be handled. */
+    virtual void contactEvent(MCContactEvent & event);
+
     /*! Event handler for MCOutOfBoundariesEvent.
      *  \param event Event to be handled. */
     virtual void outOfBoundariesEvent(MCOutOfBoundariesEvent & event);
@@ -339,6 +357,14 @@ private:
      *  Used by MCWorld. */
     void setIndex(int index);
 
+    /*! Save the transform, the shape and the physics component into the given buffer.
+     *  Used by MCWorld. */
+    void saveState(MCStateBuffer & state) const;
+
+    /*! Restore the state saved with saveState(). The grid cells are not updated.
+     *  Used by MCWorld. */
+    void restoreState(MCStateBuffer & state);
+
     //! Set parent object. Used on composite objects.
     void setParent(MCObject & parent);
 
@@ -347,10 +373,21 @@ private:
      *  be completed. Used by MCWorld. */
     void setRemoving(bool flag);
 
+    /*! Update the child objects after a transform change. The update is deferred
+     *  to MCWorld while the world is stepping. */
+    void invalidateChildTransforms();
+
+    //! Move the child objects to follow the transform of this object.
     void updateChildTransforms();
 
+    //! \return true if the child transforms are waiting for MCWorld::updateChildTransforms().
+    bool hasDirtyChildTransforms() const;
+
     void updateCenter();
 
+    //! Update the collision filter after a property affecting collisions has changed.
+    void updateCollisionFilter();
+
     void setStatus(int bit, bool flag);
 
     bool testStatus(int bit) const;
@@ -359,6 +396,8 @@ private:
 
     unsigned int m_typeId;
 
+    unsigned int m_id;
+
     std::string m_typeName;
 
     float m_angle = 0; // Degrees
@@ -377,6 +416,8 @@ private:
 
     unsigned int m_j1 = 0;
 
+    bool m_isStaticInGrid = false;
+
     MCVector3dF m_initialLocation;
 
     int m_initialAngle = 0;
@@ -393,20 +434,27 @@ private:
 
     MCShapePtr m_shape;
 
-    typedef std::vector<MCObject * > TimerEventObjectsList;
+    //! Span list of the object in MCContactArena. Valid only if the generation matches.
+    int m_firstContactSpan = -1;
 
-    static TimerEventObjectsList m_timerEventObjects;
+    int m_lastContactSpan = -1;
 
-    MCObject::ContactHash m_contacts;
+    unsigned int m_contactArenaGeneration = 0;
 
     int m_timerEventObjectsIndex = -1;
 
     int m_status;
 
+    MCCollisionFilter m_collisionFilter;
+
     Children m_children;
 
+    TriggerVolumes m_triggerVolumes;
+
     MCObject * m_parent;
 
+    MCWorld * m_world = nullptr;
+
     MCPhysicsComponent * m_physicsComponent;
 
     //! Disable copy constructor and assignment.
@@ -417,6 +465,8 @@ private:
     friend class MCObjectGridImpl;
     friend class MCWorld;
     friend class MCCollisionDetector;
+    friend class MCContactArena;
+    friend class MCPhysicsComponent;
 };
 
 #endif // MCOBJECT_HH
@@ -34,6 +34,11 @@ MCObject & MCObjectComponent::object() const
     return *m_object;
 }
 
+bool MCObjectComponent::hasObject() const
+{
+    return m_object;
+}
+
 void MCObjectComponent::stepTime(int)
 {
 }
@@ -43,6 +43,9 @@ protected:
 
     MCObject & object() const;
 
+    //! \return true if the component has been attached to an object.
+    bool hasObject() const;
+
 private:
 
     DISABLE_ASSI(MCObjectComponent);
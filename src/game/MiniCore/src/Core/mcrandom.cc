@@ -18,88 +18,34 @@
 //
 
 #include "mcrandom.hh"
-#include "mccast.hh"
 
-#include <cstdlib>
-#include <limits>
-#include <random>
-#include <vector>
-
-namespace
-{
-const unsigned int LUT_SIZE = 1024;
-const unsigned int MOD_MASK = 0x3ff;
-}
-
-//! Implementation class for MCRandom
-class MCRandomImpl
-{
-public:
-  MCRandomImpl();
-  inline float getValue();
-
-private:
-  void buildLUT();
-
-  mutable unsigned int m_valPtr;
-  std::vector<float> m_data;
-  int m_seed;
-  bool m_isBuilt;
-  friend class MCRandom;
-};
-
-std::unique_ptr<MCRandomImpl> const MCRandom::m_impl(new MCRandomImpl);
-
-MCRandomImpl::MCRandomImpl() :
-    m_valPtr(0),
-    m_data(LUT_SIZE, 0),
-    m_seed(0),
-    m_isBuilt(false)
-{
-}
-
-void MCRandomImpl::buildLUT()
-{
-    std::mt19937 engine(m_seed);
-    std::uniform_real_distribution<float> dist(0, 1);
-
-    for (unsigned int i = 0; i < LUT_SIZE; i++) {
-        m_data[i] = dist(engine);
-    }
-
-    m_isBuilt = true;
-}
-
-float MCRandomImpl::getValue()
+float MCRandom::getValue()
 {
-    if (!MCRandomImpl::m_isBuilt) {
-        MCRandomImpl::buildLUT();
-    }
-
-    return MCRandomImpl::m_data[++m_valPtr & MOD_MASK];
+    return stream().getValue();
 }
 
-float MCRandom::getValue()
+void MCRandom::setSeed(int seed)
 {
-    return MCRandom::m_impl->getValue();
+    stream().seed(static_cast<uint64_t>(seed));
 }
 
-void MCRandom::setSeed(int seed)
+MCRandomStream & MCRandom::stream()
 {
-    MCRandom::m_impl->m_seed = seed;
+    static thread_local MCRandomStream stream;
+    return stream;
 }
 
 MCVector2dF MCRandom::randomVector2d()
 {
-    return MCVector2dF(getValue() - .5f, getValue() - .5f).normalized();
+    return stream().randomVector2d();
 }
 
 MCVector3dF MCRandom::randomVector3d()
 {
-    return MCVector3dF(getValue() - .5f, getValue() - .5f, getValue() - .5f).normalized();
+    return stream().randomVector3d();
 }
 
 MCVector3dF MCRandom::randomVector3dPositiveZ()
 {
-    return MCVector3dF(getValue() - .5f, getValue() - .5f, std::fabs(getValue() - .5f)).normalized();
+    return stream().randomVector3dPositiveZ();
 }
@@ -21,21 +21,16 @@
 #define MCRANDOM_HH
 
 #include "mcmacros.hh"
+#include "mcrandomstream.hh"
 
-
-#include "mcvector2d.hh"
-#include "mcvector3d.hh"
-
-#include <memory>
-
-class MCRandomImpl;
-
-//! MCRandom number LUT.
+/*! Random values from the stream of the calling thread.
+ *  Prefer streams of the world, e.g. MCWorld::randomStream(), in simulation
+ *  code so that parallel worlds stay deterministic. */
 class MCRandom
 {
 public:
 
-    //! Get next random value [0.0..1.0] in the table
+    //! Get next random value [0.0..1.0)
     static float getValue();
 
     //! Return a random 2d vector
@@ -47,9 +42,12 @@ public:
     //! Return a random 3d vector with a positive Z only
     static MCVector3dF randomVector3dPositiveZ();
 
-    //! Set random seed (before getValue() is called the first time).
+    //! Set random seed. The sequence of the calling thread restarts.
     static void setSeed(int seed);
 
+    //! \return the stream of the calling thread.
+    static MCRandomStream & stream();
+
 private:
 
     //! Constructor disabled
@@ -60,8 +58,6 @@ private:
 
     //! Disable assignment
     DISABLE_ASSI(MCRandom);
-
-    static std::unique_ptr<MCRandomImpl> const m_impl;
 };
 
 #endif // MCRANDOM_HH
@@ -0,0 +1,91 @@
+// This file belongs to the "MiniCore" game engine.
+// Copyright (C) 2018 Jussi Lind <jussi.lind@iki.fi>
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+// MA  02110-1301, USA.
+//
+
+#include "mcrandomstream.hh"
+
+#include <cmath>
+
+MCRandomStream::MCRandomStream(uint64_t seed, uint64_t stream)
+{
+    MCRandomStream::seed(seed, stream);
+}
+
+void MCRandomStream::seed(uint64_t seed, uint64_t stream)
+{
+    m_state = 0;
+    m_increment = (stream << 1) | 1;
+    next();
+    m_state += seed;
+    next();
+}
+
+MCVector2dF MCRandomStream::randomVector2d()
+{
+    const float x = getValue() - .5f;
+    const float y = getValue() - .5f;
+    return MCVector2dF(x, y).normalized();
+}
+
+MCVector3dF MCRandomStream::randomVector3d()
+{
+    const float x = getValue() - .5f;
+    const float y = getValue() - .5f;
+    const float z = getValue() - .5f;
+    return MCVector3dF(x, y, z).normalized();
+}
+
+MCVector3dF MCRandomStream::randomVector3dPositiveZ()
+{
+    const float x = getValue() - .5f;
+    const float y = getValue() - .5f;
+    const float z = std::fabs(getValue() - .5f);
+    return MCVector3dF(x, y, z).normalized();
+}
+
+void MCRandomStream::fill(float * values, size_t count)
+{
+    for (size_t i = 0; i < count; i++)
+    {
+        values[i] = getValue();
+    }
+}
+
+void MCRandomStream::fill(MCVector2dF * vectors, size_t count)
+{
+    for (size_t i = 0; i < count; i++)
+    {
+        vectors[i] = randomVector2d();
+    }
+}
+
+void MCRandomStream::fill(MCVector3dF * vectors, size_t count)
+{
+    for (size_t i = 0; i < count; i++)
+    {
+        vectors[i] = randomVector3d();
+    }
+}
+
+void MCRandomStream::fillPositiveZ(MCVector3dF * vectors, size_t count)
+{
+    for (size_t i = 0; i < count; i++)
+    {
+        vectors[i] = randomVector3dPositiveZ();
+    }
+}
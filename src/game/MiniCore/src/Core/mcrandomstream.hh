@@ -0,0 +1,91 @@
+// This file belongs to the "MiniCore" game engine.
+// Copyright (C) 2018 Jussi Lind <jussi.lind@iki.fi>
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+// MA  02110-1301, USA.
+//
+
+#ifndef MCRANDOMSTREAM_HH
+#define MCRANDOMSTREAM_HH
+
+#include "mcvector2d.hh"
+#include "mcvector3d.hh"
+
+#include <cstddef>
+#include <cstdint>
+
+/*! A seedable stream of pseudo random numbers (PCG32). Streams with the same seed
+ *  but a different stream index give independent sequences, so each subsystem
+ *  can have its own stream and the values it gets don't depend on the others.
+ *  The state is only 16 bytes and a value costs a multiply and a few shifts.
+ *
+ *  A stream must be used by one thread at a time. \see MCWorld::randomStream() */
+class MCRandomStream
+{
+public:
+
+    //! Constructor.
+    explicit MCRandomStream(uint64_t seed = 0, uint64_t stream = 0);
+
+    //! Restart the sequence of the given seed and stream index.
+    void seed(uint64_t seed, uint64_t stream = 0);
+
+    //! \return next 32-bit random value.
+    inline uint32_t next()
+    {
+        const uint64_t state = m_state;
+        m_state = state * 6364136223846793005ull + m_increment;
+
+        const uint32_t xorShifted = static_cast<uint32_t>(((state >> 18) ^ state) >> 27);
+        const uint32_t rotation = static_cast<uint32_t>(state >> 59);
+        return (xorShifted >> rotation) | (xorShifted << ((32 - rotation) & 31));
+    }
+
+    //! \return next random value [0.0..1.0).
+    inline float getValue()
+    {
+        // 24 bits fill the mantissa
+        return static_cast<float>(next() >> 8) * (1.0f / 16777216.0f);
+    }
+
+    //! \return a random unit 2d vector.
+    MCVector2dF randomVector2d();
+
+    //! \return a random unit 3d vector.
+    MCVector3dF randomVector3d();
+
+    //! \return a random unit 3d vector with a positive Z only.
+    MCVector3dF randomVector3dPositiveZ();
+
+    //! Fill the given array with random values [0.0..1.0).
+    void fill(float * values, size_t count);
+
+    //! Fill the given array with random unit 2d vectors.
+    void fill(MCVector2dF * vectors, size_t count);
+
+    //! Fill the given array with random unit 3d vectors.
+    void fill(MCVector3dF * vectors, size_t count);
+
+    //! Fill the given array with random unit 3d vectors with a positive Z only.
+    void fillPositiveZ(MCVector3dF * vectors, size_t count);
+
+private:
+
+    uint64_t m_state;
+
+    uint64_t m_increment;
+};
+
+#endif // MCRANDOMSTREAM_HH
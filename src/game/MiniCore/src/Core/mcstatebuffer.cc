@@ -0,0 +1,96 @@
+// This file belongs to the "MiniCore" game engine.
+// Copyright (C) 2018 Jussi Lind <jussi.lind@iki.fi>
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+// MA  02110-1301, USA.
+//
+
+#include "mcstatebuffer.hh"
+
+MCStateBuffer::MCStateBuffer()
+    : m_readPos(0)
+    , m_isValid(true)
+{
+}
+
+void MCStateBuffer::clear()
+{
+    m_data.clear();
+    rewind();
+}
+
+void MCStateBuffer::rewind()
+{
+    m_readPos = 0;
+    m_isValid = true;
+}
+
+size_t MCStateBuffer::size() const
+{
+    return m_data.size();
+}
+
+const char * MCStateBuffer::data() const
+{
+    return m_data.data();
+}
+
+bool MCStateBuffer::isValid() const
+{
+    return m_isValid;
+}
+
+bool MCStateBuffer::atEnd() const
+{
+    return m_readPos == m_data.size();
+}
+
+size_t MCStateBuffer::bytesLeft() const
+{
+    return m_data.size() - m_readPos;
+}
+
+void MCStateBuffer::invalidate()
+{
+    m_isValid = false;
+}
+
+void MCStateBuffer::write(const MCVector2dF & value)
+{
+    const float components[] = {value.i(), value.j()};
+    write(components, 2);
+}
+
+void MCStateBuffer::write(const MCVector3dF & value)
+{
+    const float components[] = {value.i(), value.j(), value.k()};
+    write(components, 3);
+}
+
+bool MCStateBuffer::read(MCVector2dF & value)
+{
+    float components[2];
+    const bool ok = read(components, 2);
+    value = MCVector2dF(components[0], components[1]);
+    return ok;
+}
+
+bool MCStateBuffer::read(MCVector3dF & value)
+{
+    float components[3];
+    const bool ok = read(components, 3);
+    value = MCVector3dF(components[0], components[1], components[2]);
+    return ok;
+}
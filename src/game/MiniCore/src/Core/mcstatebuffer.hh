@@ -0,0 +1,172 @@
+// This file belongs to the "MiniCore" game engine.
+// Copyright (C) 2018 Jussi Lind <jussi.lind@iki.fi>
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+// MA  02110-1301, USA.
+//
+
+#ifndef MCSTATEBUFFER_HH
+#define MCSTATEBUFFER_HH
+
+#include "mcvector2d.hh"
+#include "mcvector3d.hh"
+
+#include <cassert>
+#include <cstring>
+#include <type_traits>
+#include <vector>
+
+/*! A contiguous binary buffer for saving and restoring state, e.g. with
+ *  MCWorld::saveState() and MCWorld::restoreState(). Values are copied as
+ *  raw bytes, so a buffer is valid only in the process that wrote it:
+ *  pointers to objects are stored as such.
+ *
+ *  The buffer keeps its capacity when cleared, so saving the same state
+ *  repeatedly doesn't allocate in the steady state. */
+class MCStateBuffer
+{
+public:
+
+    //! Constructor.
+    MCStateBuffer();
+
+    //! Clear the data. Keeps the capacity.
+    void clear();
+
+    //! Start reading from the beginning.
+    void rewind();
+
+    //! \return size of the data in bytes.
+    size_t size() const;
+
+    //! \return the data.
+    const char * data() const;
+
+    /*! \return false if a read has run out of data. Reading returns
+     *  zeroed values after that. Cleared by clear() and rewind(). */
+    bool isValid() const;
+
+    //! \return true if all data has been read.
+    bool atEnd() const;
+
+    //! \return number of bytes left to read.
+    size_t bytesLeft() const;
+
+    //! Mark the data invalid, e.g. if it doesn't match the state being restored.
+    void invalidate();
+
+    //! Write a value.
+    template <typename T>
+    void write(const T & value)
+    {
+        write(&value, 1);
+    }
+
+    //! Write the components of a vector.
+    void write(const MCVector2dF & value);
+
+    //! Write the components of a vector.
+    void write(const MCVector3dF & value);
+
+    //! Write an array of values.
+    template <typename T>
+    void write(const T * values, size_t count)
+    {
+        static_assert(std::is_trivially_copyable<T>::value, "Only trivially copyable types can be written");
+
+        const char * bytes = reinterpret_cast<const char *>(values);
+        m_data.insert(m_data.end(), bytes, bytes + sizeof(T) * count);
+    }
+
+    /*! Overwrite a value written earlier at the given byte offset,
+     *  e.g. the size of data that is known only after writing it. */
+    template <typename T>
+    void overwrite(size_t offset, const T & value)
+    {
+        static_assert(std::is_trivially_copyable<T>::value, "Only trivially copyable types can be written");
+
+        assert(offset + sizeof(T) <= m_data.size());
+        std::memcpy(&m_data[offset], &value, sizeof(T));
+    }
+
+    //! Write the size and the values of a vector.
+    template <typename T>
+    void writeVector(const std::vector<T> & values)
+    {
+        write(static_cast<unsigned int>(values.size()));
+        write(values.data(), values.size());
+    }
+
+    //! Read a value. \return false if there's not enough data.
+    template <typename T>
+    bool read(T & value)
+    {
+        return read(&value, 1);
+    }
+
+    //! Read the components of a vector. \return false if there's not enough data.
+    bool read(MCVector2dF & value);
+
+    //! Read the components of a vector. \return false if there's not enough data.
+    bool read(MCVector3dF & value);
+
+    //! Read an array of values. \return false if there's not enough data.
+    template <typename T>
+    bool read(T * values, size_t count)
+    {
+        static_assert(std::is_trivially_copyable<T>::value, "Only trivially copyable types can be read");
+
+        const size_t bytes = sizeof(T) * count;
+        if (!m_isValid || m_readPos + bytes > m_data.size())
+        {
+            m_isValid = false;
+            std::memset(static_cast<void *>(values), 0, bytes);
+            return false;
+        }
+
+        if (bytes)
+        {
+            std::memcpy(static_cast<void *>(values), &m_data[m_readPos], bytes);
+        }
+        m_readPos += bytes;
+        return true;
+    }
+
+    //! Read a vector written with writeVector(). \return false if there's not enough data.
+    template <typename T>
+    bool readVector(std::vector<T> & values)
+    {
+        unsigned int size = 0;
+        if (!read(size) || m_readPos + sizeof(T) * size > m_data.size())
+        {
+            m_isValid = false;
+            values.clear();
+            return false;
+        }
+
+        values.resize(size);
+        return read(values.data(), size);
+    }
+
+private:
+
+    std::vector<char> m_data;
+
+    size_t m_readPos;
+
+    bool m_isValid;
+};
+
+#endif // MCSTATEBUFFER_HH
@@ -18,43 +18,12 @@
 //
 
 #include "mctrigonom.hh"
-#include "mccast.hh"
-
-#include <cmath>
-#include <vector>
 
 namespace
 {
-    const unsigned int LutSize = 7200;
     const float PI = 3.1415926536f;
 }
 
-//! Implementation class for MCTrigonom
-class MCTrigonomImpl
-{
-public:
-    MCTrigonomImpl();
-
-private:
-    std::vector<float> m_sin;
-    std::vector<float> m_cos;
-    friend class MCTrigonom;
-};
-
-std::unique_ptr<MCTrigonomImpl> const MCTrigonom::m_pImpl(new MCTrigonomImpl);
-
-MCTrigonomImpl::MCTrigonomImpl()
-: m_sin(LutSize, 0)
-, m_cos(LutSize, 0)
-{
-    for (unsigned int i = 0; i < LutSize; i++) {
-        MCTrigonomImpl::m_sin.at(i) =
-            std::sin(MCTrigonom::degToRad(TO_FLOAT(i) / 10.0f - 3600));
-        MCTrigonomImpl::m_cos.at(i) =
-            std::cos(MCTrigonom::degToRad(TO_FLOAT(i) / 10.0f - 3600));
-    }
-}
-
 float MCTrigonom::degToRad(float angle)
 {
     static const float DegToRad(PI / 180.0f);
@@ -67,22 +36,10 @@ float MCTrigonom::radToDeg(float angle)
     return angle * RadToDeg;
 }
 
-float MCTrigonom::sin(float angle)
-{
-    const int index = static_cast<int>(angle * 10.0f) + 3600;
-    if (index >= 0 && index < static_cast<int>(LutSize))
-    {
-        return m_pImpl->m_sin[index];
-    }
-    return std::sin(degToRad(angle));
-}
-
-float MCTrigonom::cos(float angle)
+void MCTrigonom::sinCos(const float * angles, float * sines, float * cosines, size_t count)
 {
-    const int index = static_cast<int>(angle * 10.0f) + 3600;
-    if (index >= 0 && index < static_cast<int>(LutSize))
+    for (size_t i = 0; i < count; i++)
     {
-        return m_pImpl->m_cos[index];
+        sinCos(angles[i], sines[i], cosines[i]);
     }
-    return std::cos(degToRad(angle));
 }
@@ -23,15 +23,20 @@
 #include "mcmacros.hh"
 #include "mcvector2d.hh"
 
-#include <memory>
-
-class MCTrigonomImpl;
+#include <cmath>
+#include <cstddef>
 
 /*!
  *  \class MCTrigonom
  *
- *  MCTrigonom implements fast trigonometry routines using cached values from
- *  lookup tables.
+ *  MCTrigonom implements fast trigonometry routines for angles in degrees.
+ *
+ *  The angle is reduced to [-45..45] degrees around the nearest multiple of 90
+ *  degrees. The reduction is exact for angles of any size that a float can
+ *  represent with a fractional part, so accumulated angles don't need to be
+ *  wrapped. Sine and cosine are then evaluated with polynomials that are accurate
+ *  to a few float ulps. There are no tables or branches, so the batch version
+ *  can be vectorized by the compiler and gives the same results as the others.
  *
  *  Cannot be instantiated.
  */
@@ -45,11 +50,47 @@ public:
     //! Convert radian to degrees
     static float radToDeg(float angle);
 
-    //! Get sine of given angle (0..360)
-    static float sin(float angle);
+    //! Get sine of given angle in degrees
+    static inline float sin(float angle)
+    {
+        float s, c;
+        sinCos(angle, s, c);
+        return s;
+    }
+
+    //! Get cosine of given angle in degrees
+    static inline float cos(float angle)
+    {
+        float s, c;
+        sinCos(angle, s, c);
+        return c;
+    }
+
+    //! Get both sine and cosine of given angle in degrees
+    static inline void sinCos(float angle, float & sin, float & cos)
+    {
+        // Nearest multiple of 90 degrees. q * 90 and the difference are exact.
+        const float k = angle * (1.0f / 90.0f);
+        const int q = static_cast<int>(k + std::copysign(0.5f, k));
+        const float r = (angle - static_cast<float>(q) * 90.0f) * (3.1415926536f / 180.0f);
+        const float z = r * r;
 
-    //! Get cosine of given angle (0..360)
-    static float cos(float angle);
+        // Minimax polynomials for [-pi/4..pi/4]
+        const float s = r + r * z * (-1.6666654611e-1f + z * (8.3321608736e-3f + z * -1.9515295891e-4f));
+        const float c = 1.0f - 0.5f * z + z * z * (4.166664568298827e-2f + z * (-1.388731625493765e-3f + z * 2.443315711809948e-5f));
+
+        // Rotate by the quadrant without branches. One of the terms is always zero, so the sums are exact.
+        const float odd = static_cast<float>(q & 1);
+        const float even = 1.0f - odd;
+        const float sinSign = static_cast<float>(1 - (q & 2));
+        const float cosSign = static_cast<float>(1 - ((q + 1) & 2));
+        sin = (s * even + c * odd) * sinSign;
+        cos = (c * even + s * odd) * cosSign;
+    }
+
+    /*! Get sines and cosines of the given angles in degrees.
+     *  The result is the same as with sinCos() for each angle. */
+    static void sinCos(const float * angles, float * sines, float * cosines, size_t count);
 
 private:
 
@@ -58,9 +99,6 @@ private:
 
     DISABLE_COPY(MCTrigonom);
     DISABLE_ASSI(MCTrigonom);
-
-    static std::unique_ptr<MCTrigonomImpl> const m_pImpl;
 };
 
 #endif // MCTRIGONOM_HH
-
@@ -26,6 +26,8 @@ MCTypeRegistry::MCTypeRegistry()
 
 unsigned int MCTypeRegistry::registerType(const std::string & typeName)
 {
+    std::lock_guard<std::mutex> lock(m_mutex);
+
     auto i(m_typeHash.find(typeName));
     if (i == m_typeHash.end())
     {
@@ -41,6 +43,8 @@ unsigned int MCTypeRegistry::registerType(const std::string & typeName)
 
 unsigned int MCTypeRegistry::getTypeIdForName(const std::string & typeName)
 {
+    std::lock_guard<std::mutex> lock(m_mutex);
+
     auto i(m_typeHash.find(typeName));
     return i == m_typeHash.end() ? 0 : i->second;
 }
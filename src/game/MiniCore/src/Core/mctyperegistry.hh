@@ -23,6 +23,7 @@
 
 
 
+#include <mutex>
 #include <string>
 #include <unordered_map>
 
@@ -44,6 +45,9 @@ private:
     TypeHash m_typeHash;
 
     unsigned int m_typeIdCount;
+
+    //! Objects can be created in parallel threads.
+    std::mutex m_mutex;
 };
 
 #endif // MCTYPEREGISTRY_HH
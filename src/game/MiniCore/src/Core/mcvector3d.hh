@@ -26,6 +26,10 @@
 #include <iostream>
 #include <limits>
 
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
 /*! 3-dimensional vector template. Template parameter represents
  *  the data type of the components. 
  *
@@ -66,9 +70,6 @@ public:
     template <typename U>
     MCVector3d(const MCVector3d<U> && r);
 
-    //! Destructor
-    inline ~MCVector3d() {}
-
     //! Type conversion to MCVector2d
     template <typename U>
     operator MCVector2d<U>() const;
@@ -205,7 +206,19 @@ public:
 
 private:
 
-    //! Components
+#ifdef __SSE2__
+    //! Construct from the four lanes of an SSE register.
+    explicit MCVector3d(__m128 value);
+
+    //! \return the components and the padding as an SSE register.
+    __m128 load() const;
+
+    //! Store the components and the padding from an SSE register.
+    void store(__m128 value);
+#endif
+
+    /*! Components. The padding is zero so that the float version can be
+     *  processed as four lanes, see the end of this file. */
     T m_i, m_j, m_k, padding;
 };
 
@@ -216,14 +229,16 @@ template <typename T>
 MCVector3d<T>::MCVector3d() :
     m_i(0),
     m_j(0),
-    m_k(0)
+    m_k(0),
+    padding(0)
 {}
 
 template <typename T>
 MCVector3d<T>::MCVector3d(T newI, T newJ, T newK) :
     m_i(newI),
     m_j(newJ),
-    m_k(newK)
+    m_k(newK),
+    padding(0)
 {}
 
 template <typename T>
@@ -231,7 +246,8 @@ template <typename U>
 MCVector3d<T>::MCVector3d(const MCVector3d<U> & r) :
     m_i(r.i()),
     m_j(r.j()),
-    m_k(r.k())
+    m_k(r.k()),
+    padding(0)
 {}
 
 template <typename T>
@@ -239,7 +255,8 @@ template <typename U>
 MCVector3d<T>::MCVector3d(const MCVector3d<U> && r) :
     m_i(r.i()),
     m_j(r.j()),
-    m_k(r.k())
+    m_k(r.k()),
+    padding(0)
 {}
 
 template <typename T>
@@ -247,7 +264,8 @@ template <typename U>
 MCVector3d<T>::MCVector3d(const MCVector2d<U> & r, U k) :
     m_i(r.i()),
     m_j(r.j()),
-    m_k(k)
+    m_k(k),
+    padding(0)
 {}
 
 template <typename T>
@@ -610,4 +628,149 @@ MCVector3d<T> operator - (const MCVector3d<T> & r)
     return MCVector3d<T>(-r.i(), -r.j(), -r.k());
 }
 
+#ifdef __SSE2__
+
+// SSE2 versions for floats. The four components are processed as one register.
+// The lane operations are the same as in the generic versions, so the results
+// are bit-exact. The padding lane stays zero.
+
+template <>
+inline __m128 MCVector3d<float>::load() const
+{
+    return _mm_loadu_ps(&m_i);
+}
+
+template <>
+inline void MCVector3d<float>::store(__m128 value)
+{
+    _mm_storeu_ps(&m_i, value);
+}
+
+template <>
+inline MCVector3d<float>::MCVector3d(__m128 value)
+{
+    store(value);
+}
+
+template <>
+template <>
+inline MCVector3d<float> MCVector3d<float>::operator % (const MCVector3d<float> & r) const
+{
+    const __m128 a = load();
+    const __m128 b = r.load();
+
+    // [j, i, i] * [rk, rk, rj] - [rj, ri, ri] * [k, k, j], and then negate j
+    const __m128 lhs = _mm_mul_ps(_mm_shuffle_ps(a, a, _MM_SHUFFLE(3, 0, 0, 1)), _mm_shuffle_ps(b, b, _MM_SHUFFLE(3, 1, 2, 2)));
+    const __m128 rhs = _mm_mul_ps(_mm_shuffle_ps(b, b, _MM_SHUFFLE(3, 0, 0, 1)), _mm_shuffle_ps(a, a, _MM_SHUFFLE(3, 1, 2, 2)));
+    return MCVector3d<float>(_mm_xor_ps(_mm_sub_ps(lhs, rhs), _mm_set_ps(0.0f, 0.0f, -0.0f, 0.0f)));
+}
+
+template <>
+template <>
+inline MCVector3d<float> MCVector3d<float>::comp(const MCVector3d<float> & r) const
+{
+    return MCVector3d<float>(_mm_mul_ps(load(), r.load()));
+}
+
+template <>
+template <>
+inline MCVector3d<float> & MCVector3d<float>::compStore(const MCVector3d<float> & r)
+{
+    store(_mm_mul_ps(load(), r.load()));
+    return *this;
+}
+
+template <>
+template <>
+inline MCVector3d<float> MCVector3d<float>::operator * (float n) const
+{
+    return MCVector3d<float>(_mm_mul_ps(load(), _mm_set_ps(0.0f, n, n, n)));
+}
+
+template <>
+inline MCVector3d<float> MCVector3d<float>::operator * (const MCVector3d<float> & n) const
+{
+    return MCVector3d<float>(_mm_mul_ps(load(), n.load()));
+}
+
+template <>
+template <>
+inline MCVector3d<float> & MCVector3d<float>::operator *= (float n)
+{
+    store(_mm_mul_ps(load(), _mm_set_ps(0.0f, n, n, n)));
+    return *this;
+}
+
+template <>
+inline MCVector3d<float> & MCVector3d<float>::operator *= (const MCVector3d<float> & n)
+{
+    store(_mm_mul_ps(load(), n.load()));
+    return *this;
+}
+
+template <>
+template <>
+inline MCVector3d<float> MCVector3d<float>::operator / (float n) const
+{
+    return MCVector3d<float>(_mm_div_ps(load(), _mm_set_ps(1.0f, n, n, n)));
+}
+
+template <>
+template <>
+inline MCVector3d<float> & MCVector3d<float>::operator /= (float n)
+{
+    store(_mm_div_ps(load(), _mm_set_ps(1.0f, n, n, n)));
+    return *this;
+}
+
+template <>
+template <>
+inline MCVector3d<float> MCVector3d<float>::operator + (const MCVector3d<float> & r) const
+{
+    return MCVector3d<float>(_mm_add_ps(load(), r.load()));
+}
+
+template <>
+template <>
+inline MCVector3d<float> & MCVector3d<float>::operator += (const MCVector3d<float> & r)
+{
+    store(_mm_add_ps(load(), r.load()));
+    return *this;
+}
+
+template <>
+template <>
+inline MCVector3d<float> MCVector3d<float>::operator - (const MCVector3d<float> & r) const
+{
+    return MCVector3d<float>(_mm_sub_ps(load(), r.load()));
+}
+
+template <>
+template <>
+inline MCVector3d<float> & MCVector3d<float>::operator -= (const MCVector3d<float> & r)
+{
+    store(_mm_sub_ps(load(), r.load()));
+    return *this;
+}
+
+template <>
+inline MCVector3d<float> MCVector3d<float>::inverted() const
+{
+    return MCVector3d<float>(_mm_xor_ps(load(), _mm_set_ps(0.0f, -0.0f, -0.0f, -0.0f)));
+}
+
+template <>
+inline void MCVector3d<float>::invert()
+{
+    store(_mm_xor_ps(load(), _mm_set_ps(0.0f, -0.0f, -0.0f, -0.0f)));
+}
+
+template <>
+inline MCVector3d<float> operator - (const MCVector3d<float> & r)
+{
+    return r.inverted();
+}
+
+#endif // __SSE2__
+
 #endif // MCVECTOR3D_HH
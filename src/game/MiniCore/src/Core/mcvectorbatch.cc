@@ -0,0 +1,164 @@
+// This file belongs to the "MiniCore" game engine.
+// Copyright (C) 2018 Jussi Lind <jussi.lind@iki.fi>
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+// MA  02110-1301, USA.
+//
+
+#include "mcvectorbatch.hh"
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+namespace {
+
+#ifdef __SSE2__
+
+// The lanes are computed as in MCVector2d::lengthFast(). _mm_min_ps(b, a)
+// returns the same value as std::min(a, b) also when a value is NaN.
+inline __m128 lengthFast(__m128 i, __m128 j)
+{
+    const __m128 signMask = _mm_set1_ps(-0.0f);
+    const __m128 a = _mm_andnot_ps(signMask, i);
+    const __m128 b = _mm_andnot_ps(signMask, j);
+    const __m128 m = _mm_min_ps(b, a);
+    return _mm_sub_ps(_mm_add_ps(a, b), _mm_div_ps(m, _mm_set1_ps(2.0f)));
+}
+
+// The vectors with lengths above maxLength are scaled as in MCVector2d::clampFast().
+inline __m128 clamp(__m128 component, __m128 length, __m128 maxLength, __m128 mask)
+{
+    const __m128 clamped = _mm_div_ps(_mm_mul_ps(component, maxLength), length);
+    return _mm_or_ps(_mm_and_ps(mask, clamped), _mm_andnot_ps(mask, component));
+}
+
+#endif
+
+} // namespace
+
+void MCVectorBatch::addScaled(MCVector3dF * vectors, const MCVector3dF * deltas, float scale, size_t count)
+{
+    for (size_t i = 0; i < count; i++)
+    {
+        vectors[i] += deltas[i] * scale;
+    }
+}
+
+void MCVectorBatch::lengthFast(const MCVector2dF * vectors, float * lengths, size_t count)
+{
+    size_t n = 0;
+#ifdef __SSE2__
+    const float * data = reinterpret_cast<const float *>(vectors);
+    for (; n + 4 <= count; n += 4)
+    {
+        const __m128 v01 = _mm_loadu_ps(data + n * 2);
+        const __m128 v23 = _mm_loadu_ps(data + n * 2 + 4);
+        const __m128 i = _mm_shuffle_ps(v01, v23, _MM_SHUFFLE(2, 0, 2, 0));
+        const __m128 j = _mm_shuffle_ps(v01, v23, _MM_SHUFFLE(3, 1, 3, 1));
+        _mm_storeu_ps(lengths + n, ::lengthFast(i, j));
+    }
+#endif
+    for (; n < count; n++)
+    {
+        lengths[n] = vectors[n].lengthFast();
+    }
+}
+
+void MCVectorBatch::lengthFast(const MCVector3dF * vectors, float * lengths, size_t count)
+{
+    size_t n = 0;
+#ifdef __SSE2__
+    const float * data = reinterpret_cast<const float *>(vectors);
+    for (; n + 4 <= count; n += 4)
+    {
+        __m128 i = _mm_loadu_ps(data + n * 4);
+        __m128 j = _mm_loadu_ps(data + n * 4 + 4);
+        __m128 k = _mm_loadu_ps(data + n * 4 + 8);
+        __m128 padding = _mm_loadu_ps(data + n * 4 + 12);
+        _MM_TRANSPOSE4_PS(i, j, k, padding);
+        _mm_storeu_ps(lengths + n, ::lengthFast(::lengthFast(i, j), k));
+    }
+#endif
+    for (; n < count; n++)
+    {
+        lengths[n] = vectors[n].lengthFast();
+    }
+}
+
+void MCVectorBatch::clampFast(MCVector2dF * vectors, float maxLength, size_t count)
+{
+    size_t n = 0;
+#ifdef __SSE2__
+    float * data = reinterpret_cast<float *>(vectors);
+    const __m128 maxLength4 = _mm_set1_ps(maxLength);
+    for (; n + 4 <= count; n += 4)
+    {
+        const __m128 v01 = _mm_loadu_ps(data + n * 2);
+        const __m128 v23 = _mm_loadu_ps(data + n * 2 + 4);
+        __m128 i = _mm_shuffle_ps(v01, v23, _MM_SHUFFLE(2, 0, 2, 0));
+        __m128 j = _mm_shuffle_ps(v01, v23, _MM_SHUFFLE(3, 1, 3, 1));
+
+        const __m128 length = ::lengthFast(i, j);
+        const __m128 mask = _mm_cmpgt_ps(length, maxLength4);
+        if (_mm_movemask_ps(mask))
+        {
+            i = clamp(i, length, maxLength4, mask);
+            j = clamp(j, length, maxLength4, mask);
+            _mm_storeu_ps(data + n * 2, _mm_unpacklo_ps(i, j));
+            _mm_storeu_ps(data + n * 2 + 4, _mm_unpackhi_ps(i, j));
+        }
+    }
+#endif
+    for (; n < count; n++)
+    {
+        vectors[n].clampFast(maxLength);
+    }
+}
+
+void MCVectorBatch::clampFast(MCVector3dF * vectors, float maxLength, size_t count)
+{
+    size_t n = 0;
+#ifdef __SSE2__
+    float * data = reinterpret_cast<float *>(vectors);
+    const __m128 maxLength4 = _mm_set1_ps(maxLength);
+    for (; n + 4 <= count; n += 4)
+    {
+        __m128 i = _mm_loadu_ps(data + n * 4);
+        __m128 j = _mm_loadu_ps(data + n * 4 + 4);
+        __m128 k = _mm_loadu_ps(data + n * 4 + 8);
+        __m128 padding = _mm_loadu_ps(data + n * 4 + 12);
+        _MM_TRANSPOSE4_PS(i, j, k, padding);
+
+        const __m128 length = ::lengthFast(::lengthFast(i, j), k);
+        const __m128 mask = _mm_cmpgt_ps(length, maxLength4);
+        if (_mm_movemask_ps(mask))
+        {
+            i = clamp(i, length, maxLength4, mask);
+            j = clamp(j, length, maxLength4, mask);
+            k = clamp(k, length, maxLength4, mask);
+            _MM_TRANSPOSE4_PS(i, j, k, padding);
+            _mm_storeu_ps(data + n * 4, i);
+            _mm_storeu_ps(data + n * 4 + 4, j);
+            _mm_storeu_ps(data + n * 4 + 8, k);
+            _mm_storeu_ps(data + n * 4 + 12, padding);
+        }
+    }
+#endif
+    for (; n < count; n++)
+    {
+        vectors[n].clampFast(maxLength);
+    }
+}
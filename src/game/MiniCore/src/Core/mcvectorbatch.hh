@@ -0,0 +1,62 @@
+// This file belongs to the "MiniCore" game engine.
+// Copyright (C) 2018 Jussi Lind <jussi.lind@iki.fi>
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+// MA  02110-1301, USA.
+//
+
+#ifndef MCVECTORBATCH_HH
+#define MCVECTORBATCH_HH
+
+#include "mcmacros.hh"
+#include "mcvector2d.hh"
+#include "mcvector3d.hh"
+
+#include <cstddef>
+
+/*! Operations over arrays of vectors. The results are bit-exact with the
+ *  corresponding operations on single vectors, e.g. MCVector3dF::lengthFast(),
+ *  but with SSE2 four vectors are processed at a time.
+ *
+ *  Cannot be instantiated. */
+class MCVectorBatch
+{
+public:
+
+    //! vectors[i] += deltas[i] * scale
+    static void addScaled(MCVector3dF * vectors, const MCVector3dF * deltas, float scale, size_t count);
+
+    //! lengths[i] = vectors[i].lengthFast()
+    static void lengthFast(const MCVector2dF * vectors, float * lengths, size_t count);
+
+    //! lengths[i] = vectors[i].lengthFast()
+    static void lengthFast(const MCVector3dF * vectors, float * lengths, size_t count);
+
+    //! vectors[i].clampFast(maxLength)
+    static void clampFast(MCVector2dF * vectors, float maxLength, size_t count);
+
+    //! vectors[i].clampFast(maxLength)
+    static void clampFast(MCVector3dF * vectors, float maxLength, size_t count);
+
+private:
+
+    //! Disabled constructor.
+    MCVectorBatch();
+
+    DISABLE_COPY(MCVectorBatch);
+    DISABLE_ASSI(MCVectorBatch);
+};
+
+#endif // MCVECTORBATCH_HH
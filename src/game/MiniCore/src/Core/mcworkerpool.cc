@@ -0,0 +1,129 @@
+// This file belongs to the "MiniCore" game engine.
+// Copyright (C) 2018 Jussi Lind <jussi.lind@iki.fi>
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+// MA  02110-1301, USA.
+//
+
+#include "mcworkerpool.hh"
+
+MCWorkerPool::MCWorkerPool(unsigned int threadCount)
+: m_job(nullptr)
+, m_jobCount(0)
+, m_nextJob(0)
+, m_busyWorkers(0)
+, m_generation(0)
+, m_quit(false)
+{
+    if (!threadCount)
+    {
+        threadCount = std::thread::hardware_concurrency();
+    }
+
+    // The calling thread takes part in run(), so one thread less is needed.
+    for (unsigned int i = 1; i < threadCount; i++)
+    {
+        m_threads.push_back(std::thread(&MCWorkerPool::workerLoop, this));
+    }
+}
+
+MCWorkerPool::~MCWorkerPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_quit = true;
+    }
+
+    m_startCondition.notify_all();
+
+    for (auto && thread : m_threads)
+    {
+        thread.join();
+    }
+}
+
+unsigned int MCWorkerPool::threadCount() const
+{
+    return static_cast<unsigned int>(m_threads.size()) + 1;
+}
+
+void MCWorkerPool::run(unsigned int jobCount, const Job & job)
+{
+    if (m_threads.empty() || jobCount < 2)
+    {
+        for (unsigned int i = 0; i < jobCount; i++)
+        {
+            job(i);
+        }
+
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_job = &job;
+        m_jobCount = jobCount;
+        m_nextJob = 0;
+        m_busyWorkers = static_cast<unsigned int>(m_threads.size());
+        m_generation++;
+    }
+
+    m_startCondition.notify_all();
+
+    runJobs();
+
+    // Every worker must have left the job before it goes out of scope.
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_doneCondition.wait(lock, [this] { return m_busyWorkers == 0; });
+    m_job = nullptr;
+}
+
+void MCWorkerPool::runJobs()
+{
+    unsigned int jobIndex;
+    while ((jobIndex = m_nextJob++) < m_jobCount)
+    {
+        (*m_job)(jobIndex);
+    }
+}
+
+void MCWorkerPool::workerLoop()
+{
+    unsigned int generation = 0;
+    for (;;)
+    {
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_startCondition.wait(lock, [this, generation] { return m_quit || m_generation != generation; });
+
+            if (m_quit)
+            {
+                return;
+            }
+
+            generation = m_generation;
+        }
+
+        runJobs();
+
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if (--m_busyWorkers == 0)
+            {
+                m_doneCondition.notify_one();
+            }
+        }
+    }
+}
@@ -0,0 +1,86 @@
+// This file belongs to the "MiniCore" game engine.
+// Copyright (C) 2018 Jussi Lind <jussi.lind@iki.fi>
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+// MA  02110-1301, USA.
+//
+
+#ifndef MCWORKERPOOL_HH
+#define MCWORKERPOOL_HH
+
+#include "mcmacros.hh"
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/*! A persistent pool of worker threads for data-parallel jobs.
+ *  run() hands out job indices to the workers and to the calling thread
+ *  and returns when all jobs are finished. */
+class MCWorkerPool
+{
+public:
+
+    typedef std::function<void (unsigned int jobIndex)> Job;
+
+    /*! Constructor.
+     *  \param threadCount Total number of threads including the calling thread.
+     *         0 means std::thread::hardware_concurrency(). */
+    explicit MCWorkerPool(unsigned int threadCount = 0);
+
+    //! Destructor. Joins the worker threads.
+    ~MCWorkerPool();
+
+    //! \return total number of threads including the calling thread.
+    unsigned int threadCount() const;
+
+    /*! Run job(0) ... job(jobCount - 1) and block until all of them are finished.
+     *  The order of execution is undefined. Not reentrant. */
+    void run(unsigned int jobCount, const Job & job);
+
+private:
+
+    void workerLoop();
+
+    void runJobs();
+
+    std::vector<std::thread> m_threads;
+
+    std::mutex m_mutex;
+
+    std::condition_variable m_startCondition;
+
+    std::condition_variable m_doneCondition;
+
+    const Job * m_job;
+
+    unsigned int m_jobCount;
+
+    std::atomic<unsigned int> m_nextJob;
+
+    unsigned int m_busyWorkers;
+
+    unsigned int m_generation;
+
+    bool m_quit;
+
+    DISABLE_COPY(MCWorkerPool);
+    DISABLE_ASSI(MCWorkerPool);
+};
+
+#endif // MCWORKERPOOL_HH
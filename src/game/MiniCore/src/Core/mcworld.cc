@@ -20,45 +20,54 @@
 #include "mcworld.hh"
 
 #include "mcbbox.hh"
-#include "mccamera.hh"
 #include "mccollisiondetector.hh"
 #include "mcforcegenerator.hh"
 #include "mcforceregistry.hh"
-#include "mcfrictiongenerator.hh"
 #include "mcimpulsegenerator.hh"
+#include "mcislandmanager.hh"
 #include "mcmathutil.hh"
 #include "mcobject.hh"
 #include "mcobjectgrid.hh"
-#include "mcparticle.hh"
 #include "mcphysicscomponent.hh"
+#include "mcphysicsstate.hh"
+#include "mcrandomstream.hh"
 #include "mcshape.hh"
-#include "mcshapeview.hh"
 #include "mcrectshape.hh"
+#include "mcstatebuffer.hh"
+#include "mcsweepandprune.hh"
+#include "mctimerevent.hh"
+#include "mctriggervolume.hh"
 #include "mctrigonom.hh"
-#include "mcworldrenderer.hh"
+#include "mcworldrendererbase.hh"
 
+#include <algorithm>
 #include <cassert>
+#include <iostream>
 
-MCWorld * MCWorld::m_instance             = nullptr;
-float   MCWorld::m_metersPerUnit        = 1.0;
-float   MCWorld::m_metersPerUnitSquared = 1.0;
+thread_local MCWorld * MCWorld::m_instance = nullptr;
 
 namespace {
 const int REMOVED_INDEX = -1;
+const unsigned int STATE_VERSION = 4;
 }
 
-MCWorld::MCWorld()
-: m_renderer(new MCWorldRenderer)
+MCWorld::MCWorld(MCWorldRendererBase * renderer)
+: m_renderer(renderer)
 , m_forceRegistry(new MCForceRegistry)
 , m_collisionDetector(new MCCollisionDetector)
 , m_impulseGenerator(new MCImpulseGenerator)
+, m_islandManager(new MCIslandManager)
+, m_physicsState(new MCPhysicsState)
 , m_objectGrid(nullptr)
+, m_sweepAndPrune(nullptr)
+, m_metersPerUnit(1.0f)
 , m_minX(0)
 , m_maxX(0)
 , m_minY(0)
 , m_maxY(0)
 , m_minZ(0)
 , m_maxZ(0)
+, m_randomSeed(0)
 , m_leftWallObject(nullptr)
 , m_rightWallObject(nullptr)
 , m_topWallObject(nullptr)
@@ -66,17 +75,21 @@ MCWorld::MCWorld()
 , m_numCollisions(0)
 , m_resolverLoopCount(5)
 , m_resolverStep(1.0 / m_resolverLoopCount)
+, m_resolverMode(ResolverMode::Full)
+, m_resolverDepthTolerance(0)
+, m_possibleCollisions(nullptr)
+, m_resolverIteration(0)
+, m_triggerVolumeLoopDepth(0)
+, m_avoidedChildTransformUpdates(0)
+, m_stepCount(0)
+, m_isStepping(false)
+, m_renderInterpolation(1.0f)
 , m_gravity(MCVector3dF(0, 0, -9.81))
 {
     if (!MCWorld::m_instance)
     {
         MCWorld::m_instance = this;
     }
-    else
-    {
-        std::cerr << "ERROR!!: Only one MCWorld can exist!" << std::endl;
-        exit(EXIT_FAILURE);
-    }
 
     // Default dimensions. Creates also MCObjectGrid.
     setDimensions(0.0, 1.0, 0.0, 1.0, 0.0, 1.0, 1.0);
@@ -90,9 +103,20 @@ MCWorld::~MCWorld()
     delete m_forceRegistry;
     delete m_collisionDetector;
     delete m_impulseGenerator;
+    delete m_islandManager;
+    delete m_physicsState;
     delete m_objectGrid;
+    delete m_sweepAndPrune;
+
+    for (MCObject * object : m_timerEventObjs)
+    {
+        object->m_timerEventObjectsIndex = -1;
+    }
 
-    MCWorld::m_instance = nullptr;
+    if (MCWorld::m_instance == this)
+    {
+        MCWorld::m_instance = nullptr;
+    }
 
     delete m_leftWallObject;
     delete m_rightWallObject;
@@ -102,43 +126,111 @@ MCWorld::~MCWorld()
 
 void MCWorld::integrate(int step)
 {
-    // Integrate and update all registered objects
     m_forceRegistry->update();
-    for (auto && object : m_objs)
+
+    // Compute new velocities of all awake bodies in one pass
+    m_physicsState->integrate(float(step) / 1000);
+
+    // Commit and update all registered objects. Objects that fall asleep are swapped
+    // with the last one, which is then processed in their place. Objects that wake up
+    // are appended and will be integrated on the next step.
+    unsigned int count = static_cast<unsigned int>(m_objs.size());
+    for (unsigned int i = 0; i < count && i < m_objs.size();)
     {
+        MCObject * object = m_objs[i];
         if (object->isPhysicsObject() && !object->physicsComponent().isStationary())
         {
             object->physicsComponent().stepTime(step);
         }
 
         object->onStepTime(step);
+
+        if (i < m_objs.size() && m_objs[i] == object)
+        {
+            i++;
+        }
+        else
+        {
+            count--;
+        }
     }
 }
 
 void MCWorld::detectCollisions()
 {
+    updateChildTransforms();
+
     // Check collisions for all registered objects
-    m_numCollisions = m_collisionDetector->detectCollisions(*m_objectGrid);
+    if (m_sweepAndPrune)
+    {
+        m_possibleCollisions = &m_sweepAndPrune->getPossibleCollisions();
+    }
+    else
+    {
+        m_possibleCollisions = &m_objectGrid->getPossibleCollisions();
+    }
+
+    m_numCollisions = m_collisionDetector->detectCollisions(*m_possibleCollisions);
+}
+
+void MCWorld::detectCollisionsOfMarkedObjects()
+{
+    updateChildTransforms();
+
+    // The pairs keep their order, so the contacts are stored in the same order as on a full pass
+    m_resolverPairs.clear();
+    for (auto && pair : *m_possibleCollisions)
+    {
+        if (isMarked(*pair.first) || isMarked(*pair.second))
+        {
+            m_resolverPairs.push_back(pair);
+        }
+    }
+
+    m_numCollisions = m_collisionDetector->detectCollisions(m_resolverPairs);
+}
+
+void MCWorld::markObject(MCObject & object)
+{
+    const unsigned int slot = static_cast<unsigned int>(object.physicsComponent().m_slot);
+    if (slot >= m_resolverMarks.size())
+    {
+        m_resolverMarks.resize(slot + 1, 0);
+    }
+
+    m_resolverMarks[slot] = m_resolverIteration;
+}
+
+bool MCWorld::isMarked(MCObject & object) const
+{
+    const unsigned int slot = static_cast<unsigned int>(object.physicsComponent().m_slot);
+    return slot < m_resolverMarks.size() && m_resolverMarks[slot] == m_resolverIteration;
 }
 
 void MCWorld::generateImpulses()
 {
-    m_impulseGenerator->generateImpulsesFromDeepestContacts(m_objs);
+    m_impulseGenerator->generateImpulsesFromDeepestContacts(m_objs, m_collisionDetector->contactArena());
 }
 
-void MCWorld::resolvePositions(float accuracy)
+float MCWorld::resolvePositions(float accuracy)
 {
-    m_impulseGenerator->resolvePositions(m_objs, accuracy);
+    return m_impulseGenerator->resolvePositions(m_objs, m_collisionDetector->contactArena(), accuracy);
 }
 
 void MCWorld::prepareRendering(MCCamera * camera)
 {
-    m_renderer->buildBatches(camera);
+    if (m_renderer)
+    {
+        m_renderer->buildBatches(camera);
+    }
 }
 
 void MCWorld::render(MCCamera * camera, MCRenderGroup renderGroup)
 {
-    m_renderer->render(camera, renderGroup);
+    if (m_renderer)
+    {
+        m_renderer->render(camera, renderGroup);
+    }
 }
 
 bool MCWorld::hasInstance()
@@ -159,36 +251,58 @@ MCWorld & MCWorld::instance()
 
 void MCWorld::clear()
 {
+    // Sleeping objects are brought back to the object vector so that
+    // they are detached from the world like the other objects.
+    m_islandManager->wakeAll();
+
+    updateChildTransforms();
+
     // This does the same as removeObject(), but the removal
     // process here is simpler as all data structures will be
     // cleared and all objects will be removed at once.
     for (MCObject * object : m_objs)
     {
-        object->deleteContacts();
+        m_forceRegistry->removeFriction(*object);
         object->physicsComponent().reset();
         object->setIndex(REMOVED_INDEX);
-
-        if (object->isParticle())
-        {
-            static_cast<MCParticle *>(object)->die();
-        }
+        object->m_world = nullptr;
     }
 
-    m_renderer->clear();
+    if (m_renderer)
+    {
+        m_renderer->clear();
+    }
+    m_collisionDetector->clear();
     m_objectGrid->removeAll();
+    if (m_sweepAndPrune)
+    {
+        m_sweepAndPrune->removeAll();
+    }
+
+    for (MCTriggerVolume * volume : m_triggerVolumes)
+    {
+        volume->m_world = nullptr;
+        volume->m_index = -1;
+        volume->m_objects.clear();
+        volume->m_previousObjects.clear();
+    }
+    m_triggerVolumes.clear();
+
     m_objs.clear();
     m_removeObjs.clear();
+    m_physicsState->detachAll();
+    m_islandManager->clear();
 }
 
 void MCWorld::setDimensions(
     float minX, float maxX, float minY, float maxY, float minZ, float maxZ,
-    float metersPerUnit, bool addAreaWalls, int gridSize)
+    float metersPerUnit, bool addAreaWalls, int gridSize, Broadphase broadphase)
 {
     assert(maxX - minX > 0);
     assert(maxY - minY > 0);
     assert(maxZ - minZ > 0);
 
-    MCWorld::setMetersPerUnit(metersPerUnit);
+    setMetersPerUnit(metersPerUnit);
 
     // Set dimensions
     m_minX = minX;
@@ -207,6 +321,17 @@ void MCWorld::setDimensions(
         m_maxX, m_maxY,
         leafWidth, leafHeight);
 
+    delete m_sweepAndPrune;
+    m_sweepAndPrune = nullptr;
+    if (broadphase == Broadphase::SweepAndPrune)
+    {
+        // The view queries use cells of the same size as the grid
+        m_sweepAndPrune = new MCSweepAndPrune(
+            m_minX, m_minY,
+            m_maxX, m_maxY,
+            leafWidth, leafHeight);
+    }
+
     if (addAreaWalls)
     {
         // Create "wall" objects
@@ -225,7 +350,7 @@ void MCWorld::setDimensions(
         m_leftWallObject->setShape(MCShapePtr(new MCRectShape(nullptr, w, h)));
         m_leftWallObject->physicsComponent().setMass(0, true);
         m_leftWallObject->physicsComponent().setRestitution(wallRestitution);
-        m_leftWallObject->addToWorld();
+        m_leftWallObject->addToWorld(*this);
         m_leftWallObject->translate(MCVector3dF(-w / 2, h / 2, 0));
 
         if (m_rightWallObject)
@@ -238,7 +363,7 @@ void MCWorld::setDimensions(
         m_rightWallObject->setShape(MCShapePtr(new MCRectShape(nullptr, w, h)));
         m_rightWallObject->physicsComponent().setMass(0, true);
         m_rightWallObject->physicsComponent().setRestitution(wallRestitution);
-        m_rightWallObject->addToWorld();
+        m_rightWallObject->addToWorld(*this);
         m_rightWallObject->translate(MCVector3dF(w + w / 2, h / 2, 0));
 
         if (m_topWallObject)
@@ -251,7 +376,7 @@ void MCWorld::setDimensions(
         m_topWallObject->setShape(MCShapePtr(new MCRectShape(nullptr, w, h)));
         m_topWallObject->physicsComponent().setMass(0, true);
         m_topWallObject->physicsComponent().setRestitution(wallRestitution);
-        m_topWallObject->addToWorld();
+        m_topWallObject->addToWorld(*this);
         m_topWallObject->translate(MCVector3dF(w / 2, h + h / 2, 0));
 
         if (m_bottomWallObject)
@@ -264,11 +389,16 @@ void MCWorld::setDimensions(
         m_bottomWallObject->setShape(MCShapePtr(new MCRectShape(nullptr, w, h)));
         m_bottomWallObject->physicsComponent().setMass(0, true);
         m_bottomWallObject->physicsComponent().setRestitution(wallRestitution);
-        m_bottomWallObject->addToWorld();
+        m_bottomWallObject->addToWorld(*this);
         m_bottomWallObject->translate(MCVector3dF(w / 2, -h / 2, 0));
     }
 }
 
+MCWorld::Broadphase MCWorld::broadphase() const
+{
+    return m_sweepAndPrune ? Broadphase::SweepAndPrune : Broadphase::Grid;
+}
+
 float MCWorld::minX() const
 {
     return m_minX;
@@ -310,21 +440,39 @@ void MCWorld::addObject(MCObject & object)
     {
         if (object.index() == REMOVED_INDEX)
         {
-            m_renderer->addObject(object);
+            object.m_world = this;
+
+            if (m_renderer)
+            {
+                m_renderer->addObject(object);
+            }
 
             // Add to object vector (O(1))
             m_objs.push_back(&object);
             object.setIndex(static_cast<int>(m_objs.size()) - 1);
 
-            m_objectGrid->insert(object);
+            m_physicsState->attach(object.physicsComponent());
+
+            if (m_sweepAndPrune)
+            {
+                m_sweepAndPrune->insert(object);
+            }
+            else
+            {
+                m_objectGrid->insert(object);
+            }
+
+            for (auto && volume : object.m_triggerVolumes)
+            {
+                addTriggerVolume(*volume);
+            }
 
             // Add xy friction
             const float FrictionThreshold = 0.001f;
             if (object.physicsComponent().xyFriction() > FrictionThreshold)
             {
-                m_forceRegistry->addForceGenerator(
-                    MCForceGeneratorPtr(new MCFrictionGenerator(
-                        object.physicsComponent().xyFriction(), object.physicsComponent().xyFriction())), object);
+                m_forceRegistry->addFriction(
+                    object.physicsComponent().xyFriction(), object.physicsComponent().xyFriction(), object);
             }
         }
     }
@@ -348,40 +496,94 @@ void MCWorld::removeObjectNow(MCObject & object)
     if (object.index() > REMOVED_INDEX || object.physicsComponent().isSleeping())
     {
         object.setRemoving(true);
-        for (MCObject * obj : m_objs)
-        {
-            if (obj != &object)
-            {
-                if (obj->isPhysicsObject())
-                {
-                    obj->deleteContacts(object);
-                }
-            }
-        }
-
         doRemoveObject(object);
     }
 }
 
 void MCWorld::doRemoveObject(MCObject & object)
 {
+    // The children of an object leaving the world are not updated by the world anymore
+    if (object.hasDirtyChildTransforms())
+    {
+        m_dirtyChildTransformObjs.erase(
+            std::find(m_dirtyChildTransformObjs.begin(), m_dirtyChildTransformObjs.end(), &object));
+        object.updateChildTransforms();
+    }
+
     // Reset motion
     object.physicsComponent().reset();
 
-    m_renderer->removeObject(object);
+    if (m_renderer)
+    {
+        m_renderer->removeObject(object);
+    }
 
     // Remove from object vector (O(1))
     removeObjectFromIntegration(object);
 
     // Remove from ObjectTree
-    if (object.isPhysicsObject() && !object.bypassCollisions())
+    if (m_sweepAndPrune)
+    {
+        m_sweepAndPrune->remove(object);
+    }
+    else if (object.isPhysicsObject() && !object.bypassCollisions())
     {
         m_objectGrid->remove(object);
     }
 
+    m_collisionDetector->removeObject(object);
+
+    for (auto && volume : object.m_triggerVolumes)
+    {
+        removeTriggerVolume(*volume);
+    }
+
+    // The callbacks may add or remove volumes
+    m_triggerVolumeLoopDepth++;
+    for (size_t i = 0; i < m_triggerVolumes.size(); i++)
+    {
+        if (MCTriggerVolume * volume = m_triggerVolumes[i])
+        {
+            volume->removeObject(object);
+        }
+    }
+    m_triggerVolumeLoopDepth--;
+    compactTriggerVolumes();
+
+    m_islandManager->removeObject(object);
+
+    m_forceRegistry->removeFriction(object);
+
+    MCPhysicsState::detachedState().attach(object.physicsComponent());
+
+    object.m_world = nullptr;
     object.setRemoving(false);
 }
 
+void MCWorld::updateObjectInBroadphase(MCObject & object)
+{
+    if (m_sweepAndPrune)
+    {
+        m_sweepAndPrune->update(object);
+    }
+    else
+    {
+        m_objectGrid->update(object);
+    }
+}
+
+void MCWorld::removeObjectFromBroadphase(MCObject & object)
+{
+    if (m_sweepAndPrune)
+    {
+        m_sweepAndPrune->remove(object);
+    }
+    else
+    {
+        m_objectGrid->remove(object);
+    }
+}
+
 void MCWorld::removeObjectFromIntegration(MCObject & object)
 {
     // Remove from object vector (O(1))
@@ -421,18 +623,198 @@ void MCWorld::processCollisions()
 {
     detectCollisions();
 
+    m_collisionDetector->processContactEvents();
+
+    m_resolverStatistics = ResolverStatistics();
+    const unsigned int primaryPairCount = static_cast<unsigned int>(m_possibleCollisions->size());
+
     if (m_numCollisions)
     {
+        const bool isIncremental = m_resolverMode == ResolverMode::Incremental;
+        if (isIncremental)
+        {
+            // The first iteration re-tests the pairs of the objects that have contacts
+            m_resolverIteration++;
+            for (auto && pair : *m_possibleCollisions)
+            {
+                if (m_collisionDetector->contactArena().firstSpan(*pair.first) >= 0)
+                {
+                    markObject(*pair.first);
+                }
+            }
+        }
+
         generateImpulses();
 
         // Process contacts and generate impulses
+        const auto startTime = std::chrono::steady_clock::now();
         m_collisionDetector->enablePrimaryCollisionEvents(false);
         for (unsigned int i = 0; i < m_resolverLoopCount && m_numCollisions > 0; i++)
         {
-            detectCollisions();
-            resolvePositions(m_resolverStep);
+            if (isIncremental)
+            {
+                detectCollisionsOfMarkedObjects();
+                m_resolverStatistics.m_testedPairs += static_cast<unsigned int>(m_resolverPairs.size());
+            }
+            else
+            {
+                detectCollisions();
+                m_resolverStatistics.m_testedPairs += static_cast<unsigned int>(m_possibleCollisions->size());
+            }
+
+            m_impulseGenerator->clearDisplacedObjects();
+            const float maxDepth = resolvePositions(m_resolverStep);
+            m_resolverStatistics.m_iterations++;
+
+            if (isIncremental)
+            {
+                if (maxDepth < m_resolverDepthTolerance)
+                {
+                    break;
+                }
+
+                m_resolverIteration++;
+                for (MCObject * object : m_impulseGenerator->displacedObjects())
+                {
+                    markObject(*object);
+                }
+            }
         }
         m_collisionDetector->enablePrimaryCollisionEvents(true);
+        m_resolverStatistics.m_elapsedTime = std::chrono::steady_clock::now() - startTime;
+    }
+
+    m_resolverStatistics.m_skippedIterations = m_resolverLoopCount - m_resolverStatistics.m_iterations;
+    const unsigned int fullPairTests = m_resolverLoopCount * primaryPairCount;
+    m_resolverStatistics.m_avoidedPairTests =
+        fullPairTests > m_resolverStatistics.m_testedPairs ? fullPairTests - m_resolverStatistics.m_testedPairs : 0;
+
+    m_possibleCollisions = nullptr;
+}
+
+void MCWorld::processTriggerVolumes()
+{
+    // The callbacks may add or remove volumes. Added volumes are appended, so they are
+    // evaluated on this step, and removed volumes leave an empty slot until the loop ends.
+    m_triggerVolumeLoopDepth++;
+    for (size_t i = 0; i < m_triggerVolumes.size(); i++)
+    {
+        if (!m_triggerVolumes[i])
+        {
+            continue;
+        }
+
+        MCTriggerVolume & volume = *m_triggerVolumes[i];
+        volume.updateTransform();
+
+        m_triggerObjs.clear();
+        auto collectObject = [this, &volume] (MCObject & object) {
+            if ((object.collisionFilter().m_flags & MCCollisionFilter::Collides) &&
+                &object.parent() != volume.owner() &&
+                volume.overlaps(object))
+            {
+                m_triggerObjs.push_back(&object);
+            }
+        };
+
+        if (m_sweepAndPrune)
+        {
+            m_sweepAndPrune->forEachDynamicObjectWithinBBox(volume.obbox().bbox(), collectObject);
+        }
+        else
+        {
+            m_objectGrid->forEachDynamicObjectWithinBBox(volume.obbox().bbox(), collectObject);
+        }
+
+        volume.update(m_triggerObjs);
+    }
+    m_triggerVolumeLoopDepth--;
+    compactTriggerVolumes();
+}
+
+void MCWorld::compactTriggerVolumes()
+{
+    if (m_triggerVolumeLoopDepth)
+    {
+        return;
+    }
+
+    // Keep the order of the remaining volumes, because it defines the order of the callbacks
+    size_t count = 0;
+    for (size_t i = 0; i < m_triggerVolumes.size(); i++)
+    {
+        if (MCTriggerVolume * volume = m_triggerVolumes[i])
+        {
+            volume->m_index = static_cast<int>(count);
+            m_triggerVolumes[count++] = volume;
+        }
+    }
+
+    m_triggerVolumes.resize(count);
+}
+
+void MCWorld::addTriggerVolume(MCTriggerVolume & volume)
+{
+    if (!volume.m_world)
+    {
+        m_triggerVolumes.push_back(&volume);
+        volume.m_world = this;
+        volume.m_index = static_cast<int>(m_triggerVolumes.size()) - 1;
+    }
+}
+
+void MCWorld::removeTriggerVolume(MCTriggerVolume & volume)
+{
+    if (volume.m_world == this)
+    {
+        if (m_triggerVolumeLoopDepth)
+        {
+            // Don't move the other volumes under the loop, see compactTriggerVolumes()
+            m_triggerVolumes[volume.m_index] = nullptr;
+        }
+        else
+        {
+            // Swap with the last one (O(1))
+            m_triggerVolumes.back()->m_index = volume.m_index;
+            m_triggerVolumes[volume.m_index] = m_triggerVolumes.back();
+            m_triggerVolumes.pop_back();
+        }
+
+        volume.m_world = nullptr;
+        volume.m_index = -1;
+        volume.m_objects.clear();
+        volume.m_previousObjects.clear();
+    }
+}
+
+void MCWorld::subscribeTimerEvent(MCObject & object)
+{
+    if (object.m_timerEventObjectsIndex == -1)
+    {
+        m_timerEventObjs.push_back(&object);
+        object.m_timerEventObjectsIndex = static_cast<int>(m_timerEventObjs.size()) - 1;
+    }
+}
+
+void MCWorld::unsubscribeTimerEvent(MCObject & object)
+{
+    if (object.m_timerEventObjectsIndex > -1 &&
+        object.m_timerEventObjectsIndex < static_cast<int>(m_timerEventObjs.size()) &&
+        m_timerEventObjs[object.m_timerEventObjectsIndex] == &object)
+    {
+        // Swap with the last one (O(1))
+        m_timerEventObjs.back()->m_timerEventObjectsIndex = object.m_timerEventObjectsIndex;
+        m_timerEventObjs[object.m_timerEventObjectsIndex] = m_timerEventObjs.back();
+        m_timerEventObjs.pop_back();
+        object.m_timerEventObjectsIndex = -1;
+    }
+}
+
+void MCWorld::sendTimerEvent(MCTimerEvent & event)
+{
+    for (MCObject * object : m_timerEventObjs)
+    {
+        MCObject::sendEvent(*object, event);
     }
 }
 
@@ -444,14 +826,325 @@ MCForceRegistry & MCWorld::forceRegistry() const
 
 void MCWorld::stepTime(int step)
 {
+    m_stepCount++;
+    m_isStepping = true;
+    m_avoidedChildTransformUpdates = 0;
+
     // Integrate physics
     integrate(step);
 
     // Process collisions and generate impulses
     processCollisions();
 
+    // Trigger volumes are evaluated once per step against the resolved positions
+    updateChildTransforms();
+    processTriggerVolumes();
+
+    // Put the islands that have come to rest to sleep
+    m_islandManager->update(m_objs, m_collisionDetector->pairCache());
+
     // Remove objects that are marked to be removed
     processRemovedObjects();
+
+    // Contacts live only for one step
+    m_collisionDetector->contactArena().reset();
+
+    updateChildTransforms();
+    m_isStepping = false;
+}
+
+unsigned int MCWorld::stepCount() const
+{
+    return m_stepCount;
+}
+
+bool MCWorld::isStepping() const
+{
+    return m_isStepping;
+}
+
+MCRandomStream & MCWorld::randomStream(unsigned int index)
+{
+    while (m_randomStreams.size() <= index)
+    {
+        m_randomStreams.push_back(std::unique_ptr<MCRandomStream>(new MCRandomStream(m_randomSeed, m_randomStreams.size())));
+    }
+
+    return *m_randomStreams[index];
+}
+
+void MCWorld::setRandomSeed(uint64_t seed)
+{
+    m_randomSeed = seed;
+    for (unsigned int index = 0; index < m_randomStreams.size(); index++)
+    {
+        m_randomStreams[index]->seed(seed, index);
+    }
+}
+
+void MCWorld::saveState(MCStateBuffer & state) const
+{
+    assert(!m_isStepping);
+
+    state.write(STATE_VERSION);
+
+    // The size of the rest lets restoreState() reject a truncated state before changing the world
+    const size_t sizeOffset = state.size();
+    state.write(0u);
+    state.write(m_stepCount);
+
+    // All objects of the world have their physics slot here, also the sleeping ones
+    const unsigned int objectCount = m_physicsState->size();
+    state.write(objectCount);
+    for (unsigned int slot = 0; slot < objectCount; slot++)
+    {
+        state.write(&m_physicsState->component(slot).object());
+    }
+
+    // Everything that restoreState() checks comes before the state of the objects
+    state.write(m_sweepAndPrune != nullptr);
+    state.writeVector(m_triggerVolumes);
+
+    for (unsigned int slot = 0; slot < objectCount; slot++)
+    {
+        m_physicsState->component(slot).object().saveState(state);
+    }
+
+    state.writeVector(m_objs);
+    state.writeVector(m_removeObjs);
+
+    m_objectGrid->saveState(state);
+
+    if (m_sweepAndPrune)
+    {
+        m_sweepAndPrune->saveState(state);
+    }
+
+    m_islandManager->saveState(state);
+    m_collisionDetector->saveState(state);
+    m_forceRegistry->saveState(state);
+
+    for (MCTriggerVolume * volume : m_triggerVolumes)
+    {
+        state.writeVector(volume->m_objects);
+    }
+
+    state.write(static_cast<unsigned int>(m_randomStreams.size()));
+    for (auto && stream : m_randomStreams)
+    {
+        state.write(*stream);
+    }
+
+    state.overwrite(sizeOffset, static_cast<unsigned int>(state.size() - sizeOffset - sizeof(unsigned int)));
+}
+
+bool MCWorld::canRestoreObjects(const std::vector<MCTriggerVolume *> & triggerVolumes)
+{
+    m_stateMarks.assign(m_physicsState->size(), 0);
+    for (MCObject * object : m_stateObjs)
+    {
+        if (object->m_world == this)
+        {
+            m_stateMarks[object->physicsComponent().m_slot] = 1;
+        }
+        else if (object->m_world)
+        {
+            return false;
+        }
+    }
+
+    // Count the volumes that the world will have after restoring. The volumes of
+    // the objects are added and removed together with the objects.
+    size_t volumeCount = 0;
+    for (MCTriggerVolume * volume : m_triggerVolumes)
+    {
+        if (volume && (!volume->m_owner || volume->m_owner->m_world != this))
+        {
+            volumeCount++;
+        }
+    }
+
+    for (MCObject * object : m_stateObjs)
+    {
+        for (auto && volume : object->m_triggerVolumes)
+        {
+            if (volume->m_world == (object->m_world == this ? this : nullptr))
+            {
+                volumeCount++;
+            }
+        }
+    }
+
+    if (triggerVolumes.size() != volumeCount)
+    {
+        return false;
+    }
+
+    // The volumes of the state are distinct, so the sets are the same if each of them will be in the world
+    for (MCTriggerVolume * volume : triggerVolumes)
+    {
+        MCObject * owner = volume->m_owner;
+        if (volume->m_world == this)
+        {
+            if (owner && owner->m_world == this && !m_stateMarks[owner->physicsComponent().m_slot])
+            {
+                return false;
+            }
+        }
+        else if (volume->m_world || !owner || owner->m_world ||
+            std::find(m_stateObjs.begin(), m_stateObjs.end(), owner) == m_stateObjs.end())
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+bool MCWorld::restoreState(MCStateBuffer & state)
+{
+    assert(!m_isStepping);
+
+    // Everything that rejects the state is checked before the world is changed
+    unsigned int version = 0;
+    state.read(version);
+    unsigned int byteCount = 0;
+    state.read(byteCount);
+    if (!state.isValid() || version != STATE_VERSION || state.bytesLeft() < byteCount)
+    {
+        return false;
+    }
+
+    unsigned int stepCount = 0;
+    state.read(stepCount);
+    state.readVector(m_stateObjs);
+    bool hasSweepAndPrune = false;
+    state.read(hasSweepAndPrune);
+    std::vector<MCTriggerVolume *> triggerVolumes;
+    state.readVector(triggerVolumes);
+    if (!state.isValid() || hasSweepAndPrune != (m_sweepAndPrune != nullptr) || !canRestoreObjects(triggerVolumes))
+    {
+        return false;
+    }
+
+    // Pending removals are a part of the state
+    for (MCObject * object : m_removeObjs)
+    {
+        object->setRemoving(false);
+    }
+    m_removeObjs.clear();
+
+    // Add the objects removed since saving
+    for (MCObject * object : m_stateObjs)
+    {
+        if (object->m_world != this)
+        {
+            addObject(*object);
+        }
+    }
+
+    // The objects inside the trigger volumes and the touching pairs are restored below,
+    // so the objects removed here must not leave the volumes with a callback or end contacts.
+    for (MCTriggerVolume * volume : m_triggerVolumes)
+    {
+        volume->m_objects.clear();
+        volume->m_previousObjects.clear();
+    }
+    m_collisionDetector->clear();
+
+    // Remove the objects added since saving. The objects added back above have
+    // slots after the ones marked by canRestoreObjects().
+    if (m_physicsState->size() != m_stateObjs.size())
+    {
+        // Removing changes the slots, so collect the objects first
+        ObjectVector addedObjs;
+        for (unsigned int slot = 0; slot < m_stateMarks.size(); slot++)
+        {
+            if (!m_stateMarks[slot])
+            {
+                addedObjs.push_back(&m_physicsState->component(slot).object());
+            }
+        }
+
+        for (MCObject * object : addedObjs)
+        {
+            removeObjectNow(*object);
+        }
+    }
+
+    for (MCObject * object : m_stateObjs)
+    {
+        object->restoreState(state);
+        object->setIndex(REMOVED_INDEX);
+    }
+
+    state.readVector(m_objs);
+    for (unsigned int i = 0; i < m_objs.size(); i++)
+    {
+        m_objs[i]->setIndex(static_cast<int>(i));
+    }
+
+    state.readVector(m_removeObjs);
+    for (MCObject * object : m_removeObjs)
+    {
+        object->setRemoving(true);
+    }
+
+    m_objectGrid->restoreState(state);
+
+    if (m_sweepAndPrune)
+    {
+        m_sweepAndPrune->restoreState(state);
+    }
+
+    m_islandManager->restoreState(state);
+    m_collisionDetector->restoreState(state);
+    m_forceRegistry->restoreState(state);
+
+    // The volumes of the objects have been added and removed together with the objects,
+    // but their order defines the order of the callbacks.
+    m_triggerVolumes = triggerVolumes;
+    for (unsigned int i = 0; i < m_triggerVolumes.size(); i++)
+    {
+        MCTriggerVolume * volume = m_triggerVolumes[i];
+        volume->m_index = static_cast<int>(i);
+        state.readVector(volume->m_objects);
+        volume->m_previousObjects.clear();
+    }
+
+    // Streams created since saving are restarted
+    unsigned int streamCount = 0;
+    state.read(streamCount);
+    if (streamCount > m_randomStreams.size())
+    {
+        randomStream(streamCount - 1);
+    }
+
+    for (unsigned int index = 0; index < m_randomStreams.size(); index++)
+    {
+        if (index < streamCount)
+        {
+            state.read(*m_randomStreams[index]);
+        }
+        else
+        {
+            m_randomStreams[index]->seed(m_randomSeed, index);
+        }
+    }
+
+    m_stepCount = stepCount;
+
+    return state.isValid();
+}
+
+void MCWorld::setRenderInterpolation(float alpha)
+{
+    m_renderInterpolation = std::min(std::max(alpha, 0.0f), 1.0f);
+}
+
+float MCWorld::renderInterpolation() const
+{
+    return m_renderInterpolation;
 }
 
 MCWorld::ObjectVector MCWorld::objects() const
@@ -459,16 +1152,33 @@ MCWorld::ObjectVector MCWorld::objects() const
     return m_objs;
 }
 
+MCCollisionDetector & MCWorld::collisionDetector() const
+{
+    assert(m_collisionDetector);
+    return *m_collisionDetector;
+}
+
+MCIslandManager & MCWorld::islandManager() const
+{
+    assert(m_islandManager);
+    return *m_islandManager;
+}
+
 MCObjectGrid & MCWorld::objectGrid() const
 {
     assert(m_objectGrid);
     return *m_objectGrid;
 }
 
-MCWorldRenderer & MCWorld::renderer() const
+MCSweepAndPrune & MCWorld::sweepAndPrune() const
+{
+    assert(m_sweepAndPrune);
+    return *m_sweepAndPrune;
+}
+
+bool MCWorld::hasRenderer() const
 {
-    assert(m_renderer);
-    return *m_renderer;
+    return m_renderer != nullptr;
 }
 
 void MCWorld::setGravity(const MCVector3dF & gravity)
@@ -483,29 +1193,28 @@ const MCVector3dF & MCWorld::gravity() const
 
 void MCWorld::setMetersPerUnit(float value)
 {
-    MCWorld::m_metersPerUnit        = value;
-    MCWorld::m_metersPerUnitSquared = value * value;
+    m_metersPerUnit = value;
+    m_impulseGenerator->setMetersPerUnit(value);
 }
 
-float MCWorld::metersPerUnit()
+float MCWorld::metersPerUnit() const
 {
-    assert(MCWorld::m_instance);
-    return MCWorld::m_metersPerUnit;
+    return m_metersPerUnit;
 }
 
-void MCWorld::toMeters(float & units)
+void MCWorld::toMeters(float & units) const
 {
-    units *= MCWorld::m_metersPerUnit;
+    units *= m_metersPerUnit;
 }
 
-void MCWorld::toMeters(MCVector2dF & units)
+void MCWorld::toMeters(MCVector2dF & units) const
 {
-    units *= MCWorld::m_metersPerUnit;
+    units *= m_metersPerUnit;
 }
 
-void MCWorld::toMeters(MCVector3dF & units)
+void MCWorld::toMeters(MCVector3dF & units) const
 {
-    units *= MCWorld::m_metersPerUnit;
+    units *= m_metersPerUnit;
 }
 
 void MCWorld::setResolverLoopCount(unsigned int resolverLoopCount)
@@ -513,3 +1222,35 @@ void MCWorld::setResolverLoopCount(unsigned int resolverLoopCount)
     m_resolverLoopCount = resolverLoopCount;
     m_resolverStep = 1.0f / resolverLoopCount;
 }
+
+void MCWorld::setResolverMode(ResolverMode resolverMode, float depthTolerance)
+{
+    m_resolverMode = resolverMode;
+    m_resolverDepthTolerance = depthTolerance;
+}
+
+MCWorld::ResolverMode MCWorld::resolverMode() const
+{
+    return m_resolverMode;
+}
+
+const MCWorld::ResolverStatistics & MCWorld::resolverStatistics() const
+{
+    return m_resolverStatistics;
+}
+
+void MCWorld::updateChildTransforms()
+{
+    // Updating the children may dirty their own children, which are appended to the vector
+    for (unsigned int i = 0; i < m_dirtyChildTransformObjs.size(); i++)
+    {
+        m_dirtyChildTransformObjs[i]->updateChildTransforms();
+    }
+
+    m_dirtyChildTransformObjs.clear();
+}
+
+unsigned int MCWorld::avoidedChildTransformUpdates() const
+{
+    return m_avoidedChildTransformUpdates;
+}
@@ -25,16 +25,27 @@
 #include "mcvector3d.hh"
 #include "mcrendergroup.hh"
 
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <utility>
 #include <vector>
 
 class MCCamera;
 class MCCollisionDetector;
-class MCContact;
 class MCForceRegistry;
 class MCImpulseGenerator;
+class MCIslandManager;
 class MCObject;
 class MCObjectGrid;
+class MCPhysicsState;
+class MCRandomStream;
+class MCStateBuffer;
+class MCSweepAndPrune;
+class MCTimerEvent;
+class MCTriggerVolume;
 class MCWorldRenderer;
+class MCWorldRendererBase;
 
 /*! \class World base class.
  *  \brief World class holds every MCObject in the scene.
@@ -46,7 +57,12 @@ class MCWorldRenderer;
  * MCWorld has always positive Z-axis pointing "up" and objects
  * move on the XY-plane. Direction of the gravity can be freely set.
  *
- * MCWorld uses MCWorldRenderer to render the scene.
+ * MCWorld uses MCWorldRenderer to render the scene. Without a renderer the
+ * world only simulates, which doesn't need the graphics library or OpenGL.
+ *
+ * Multiple worlds can exist at the same time. A world and its objects must be
+ * used by one thread at a time, but independent worlds can be stepped in parallel
+ * threads. Objects know the world they have been added to.
  */
 class MCWorld
 {
@@ -54,15 +70,55 @@ public:
 
     typedef std::vector<MCObject *> ObjectVector;
 
-    //! Constructor.
-    MCWorld();
+    //! Broadphase collision detection methods. \see setDimensions().
+    enum class Broadphase
+    {
+        Grid,
+        SweepAndPrune
+    };
+
+    //! Ways to re-detect collisions between the position resolver iterations. \see setResolverMode().
+    enum class ResolverMode
+    {
+        Full,
+        Incremental
+    };
+
+    //! Statistics of the position resolver iterations of the latest step.
+    struct ResolverStatistics
+    {
+        //! Resolver iterations run.
+        unsigned int m_iterations = 0;
+
+        //! Iterations of the loop count left unused, because the contacts were resolved.
+        unsigned int m_skippedIterations = 0;
+
+        //! Pairs tested by the narrowphase on the resolver iterations.
+        unsigned int m_testedPairs = 0;
+
+        /*! Pair tests avoided compared to testing the whole broadphase result of the
+         *  primary detection pass on each iteration of the loop count. */
+        unsigned int m_avoidedPairTests = 0;
+
+        /*! Wall-clock time spent on the resolver iterations, including the collision
+         *  re-detection. Compare this between the modes rather than the pair counts,
+         *  because the incremental mode has a bookkeeping cost of its own. */
+        std::chrono::nanoseconds m_elapsedTime = std::chrono::nanoseconds(0);
+    };
+
+    /*! Constructor.
+     *  \param renderer Renderer that will be owned by the world, e.g. MCWorldRenderer.
+     *  If nullptr, then the world is not rendered. */
+    explicit MCWorld(MCWorldRendererBase * renderer = nullptr);
 
     //! Destructor.
     virtual ~MCWorld();
 
-    //! Return the one-and-only MCWorld instance.
+    /*! Return the MCWorld instance of the calling thread. This is the first
+     *  world created in the thread that still exists. */
     static MCWorld & instance();
 
+    //! \return true if the calling thread has an instance.
     static bool hasInstance();
 
     //! Remove all objects.
@@ -76,6 +132,12 @@ public:
      *
      *  \param gridSize ver and hor size of the object grid. This affects the collision
      *  detection performance.
+     *
+     *  \param broadphase The broadphase used to find possible collisions. The object grid is
+     *  not maintained when Broadphase::SweepAndPrune is selected, so the spatial queries
+     *  must then be done with sweepAndPrune(). Prefer Broadphase::Grid: on all but one of
+     *  the shipped tracks the sweep-and-prune steps the world slower, up to five times.
+     *  It is faster only in the view queries of the renderer.
      */
     void setDimensions(
         float minX,
@@ -86,7 +148,11 @@ public:
         float maxZ,
         float metersPerUnit = 1.0f,
         bool addAreaWalls = true,
-        int gridSize = 128);
+        int gridSize = 128,
+        Broadphase broadphase = Broadphase::Grid);
+
+    //! \return the broadphase set by setDimensions().
+    Broadphase broadphase() const;
 
     /*! Set gravity vector used by default friction generators (on XY-plane).
      *  The default is [0, 0, -9.81]. Set the gravity (acceleration) for objects
@@ -96,19 +162,19 @@ public:
     const MCVector3dF & gravity() const;
 
     //! Set how many meters equal one unit in the scene.
-    static void setMetersPerUnit(float value);
+    void setMetersPerUnit(float value);
 
     //! Get how many meters equal one unit in the scene.
-    static float metersPerUnit();
+    float metersPerUnit() const;
 
     //! Convert scene units to meters.
-    static void toMeters(float & units);
+    void toMeters(float & units) const;
 
     //! Convert scene units to meters.
-    static void toMeters(MCVector2dF & units);
+    void toMeters(MCVector2dF & units) const;
 
     //! Convert scene units to meters.
-    static void toMeters(MCVector3dF & units);
+    void toMeters(MCVector3dF & units) const;
 
     /*! Add object to the world. Object's current location is used.
      *  \param object Object to be added. */
@@ -132,14 +198,70 @@ public:
     //! Restart integrating the given object.
     void restoreObjectToIntegration(MCObject & object);
 
+    //! Subscribe the given object to the timer events of this world.
+    void subscribeTimerEvent(MCObject & object);
+
+    //! Unsubscribe the given object from the timer events of this world.
+    void unsubscribeTimerEvent(MCObject & object);
+
+    /*! Send the given timer event to all objects that
+     *  have subscribed to the timer events of this world. */
+    void sendTimerEvent(MCTimerEvent & event);
+
     //! \return Force registry. Use this to add force generators to objects.
     MCForceRegistry & forceRegistry() const;
 
+    //! \return Collision detector. Use this e.g. to set the number of detection threads.
+    MCCollisionDetector & collisionDetector() const;
+
+    //! \return Island manager. Use this e.g. to get the island statistics.
+    MCIslandManager & islandManager() const;
+
     /*! \brief Step world time
      *  This causes the integration of physics and executes collision detections.
      *  \param step Time step to be updated in msecs. */
     void stepTime(int step);
 
+    //! \return number of stepTime() calls. Identifies the latest step.
+    unsigned int stepCount() const;
+
+    //! \return true while stepTime() is in progress.
+    bool isStepping() const;
+
+    /*! \return the random stream of the given index. Give each subsystem, e.g. AI or
+     *  particles, its own index so that the values it gets don't depend on the others.
+     *  Streams are created on demand and saved with saveState().
+     *  \see setRandomSeed() */
+    MCRandomStream & randomStream(unsigned int index = 0);
+
+    //! Restart all random streams with the given seed. The default seed is 0.
+    void setRandomSeed(uint64_t seed);
+
+    /*! Append the dynamic state of the world to the given buffer: the transforms,
+     *  motion and sleep states of the objects, the object vector, the sleeping islands,
+     *  the touching pairs, the grid cells and the enable flags of the force generators.
+     *  Configuration such as masses and shapes is not saved. Other state can be appended
+     *  to the same buffer. Must not be called during stepTime(). */
+    void saveState(MCStateBuffer & state) const;
+
+    /*! Restore the state saved with saveState(). Stepping the world after this gives
+     *  bit-identical results with the steps taken after saving. Objects removed since
+     *  saving are added back and objects added since saving are removed, so the objects
+     *  of the state must still exist. The dimensions and the force generators must be
+     *  the same as when saving. Must not be called during stepTime().
+     *  \return false if the state is invalid. A truncated state or a state whose objects
+     *  or trigger volumes don't match the world is rejected before the world is changed. */
+    bool restoreState(MCStateBuffer & state);
+
+    /*! Set the render interpolation factor [0.0..1.0]. Objects moved on the latest step
+     *  are rendered between their transforms before and after the step. The default 1.0
+     *  renders the current transforms. This can be used to render at a rate that is
+     *  independent of the fixed step rate. */
+    void setRenderInterpolation(float alpha);
+
+    //! \return the render interpolation factor.
+    float renderInterpolation() const;
+
     /*! \brief Call this (once) before calling render() or renderShadows().
      *  \param camera The camera window to be used. If nullptr, then
      *         no any translations or clipping done. */
@@ -149,12 +271,19 @@ public:
      *  \param camera Camera box, can be nullptr. */
     virtual void render(MCCamera * camera, MCRenderGroup renderGroup);
 
-    //! \return Reference to the objectGrid.
+    //! \return Reference to the objectGrid. The grid is empty if Broadphase::SweepAndPrune is used.
     MCObjectGrid & objectGrid() const;
 
-    //! \return The world renderer.
+    //! \return Reference to the sweep-and-prune broadphase. Broadphase::SweepAndPrune must be used.
+    MCSweepAndPrune & sweepAndPrune() const;
+
+    /*! \return The world renderer. The world must have been constructed with
+     *  an MCWorldRenderer. This is a part of the graphics library. */
     MCWorldRenderer & renderer() const;
 
+    //! \return true if the world has a renderer.
+    bool hasRenderer() const;
+
     //! Get minimum X
     float minX() const;
 
@@ -180,6 +309,45 @@ public:
      *  Lower loop count results in faster collision calculations, but lower accuracy. */
     void setResolverLoopCount(unsigned int resolverLoopCount = 5);
 
+    /*! Set how collisions are re-detected between the position resolver iterations.
+     *
+     *  ResolverMode::Full, the default, runs the broadphase and tests all possible
+     *  collisions on each iteration.
+     *
+     *  ResolverMode::Incremental re-tests only the pairs of the primary broadphase result
+     *  that have an object with contacts on the primary pass or an object displaced by the
+     *  previous iteration. Pairs that the primary broadphase didn't report, e.g. pairs that
+     *  start to overlap only due to the displacements, are detected on the next step.
+     *  The loop stops when the deepest resolved interpenetration is below depthTolerance. */
+    void setResolverMode(ResolverMode resolverMode, float depthTolerance = 0.0f);
+
+    //! \return the resolver mode.
+    ResolverMode resolverMode() const;
+
+    //! \return the statistics of the position resolver iterations of the latest step.
+    const ResolverStatistics & resolverStatistics() const;
+
+    /*! Move the child objects of the objects that have moved since the latest update.
+     *  While the world is stepping, moving an object only marks its children dirty, so an
+     *  object displaced many times by the collision resolver updates its children once.
+     *  The children are updated before each collision detection, before the trigger volumes
+     *  and at the end of the step. Call this in the middle of a step, e.g. in onStepTime(),
+     *  before using the transforms of child objects. Outside of stepTime() the children
+     *  are always updated immediately. */
+    void updateChildTransforms();
+
+    //! \return number of child transform updates avoided by the lazy updates on the latest step.
+    unsigned int avoidedChildTransformUpdates() const;
+
+    /*! Add a trigger volume that is not owned by an object. The volumes of
+     *  objects are added and removed together with the objects.
+     *  The volumes are evaluated once per step after processing the collisions. */
+    void addTriggerVolume(MCTriggerVolume & volume);
+
+    /*! Remove a trigger volume. The callback is not called for the objects inside.
+     *  This can be called from the callbacks of the volumes, also for the volume itself. */
+    void removeTriggerVolume(MCTriggerVolume & volume);
+
 protected:
 
     //! Get registered objects
@@ -198,17 +366,39 @@ private:
 
     void doRemoveObject(MCObject & object);
 
+    //! Update the object in the broadphase after it has moved or rotated.
+    void updateObjectInBroadphase(MCObject & object);
+
+    //! Remove the object from the broadphase when it starts to be removed.
+    void removeObjectFromBroadphase(MCObject & object);
+
     void detectCollisions();
 
+    //! Re-detect the collisions of the marked objects. Used by ResolverMode::Incremental.
+    void detectCollisionsOfMarkedObjects();
+
+    //! Mark the given object for the next resolver iteration.
+    void markObject(MCObject & object);
+
+    bool isMarked(MCObject & object) const;
+
     void generateImpulses();
 
-    void resolvePositions(float accuracy);
+    //! \return the deepest resolved interpenetration.
+    float resolvePositions(float accuracy);
+
+    void processTriggerVolumes();
 
-    MCContact * getDeepestInterpenetration(const std::vector<MCContact *> & contacts);
+    //! Remove the slots of the volumes removed while iterating the volumes.
+    void compactTriggerVolumes();
 
-    static MCWorld * m_instance;
+    /*! \return true if the objects of the state being restored and the given trigger
+     *  volumes of the state match the world. Marks the slots in m_stateMarks. */
+    bool canRestoreObjects(const std::vector<MCTriggerVolume *> & triggerVolumes);
 
-    MCWorldRenderer * m_renderer;
+    static thread_local MCWorld * m_instance;
+
+    MCWorldRendererBase * m_renderer;
 
     MCForceRegistry * m_forceRegistry;
 
@@ -216,11 +406,15 @@ private:
 
     MCImpulseGenerator * m_impulseGenerator;
 
+    MCIslandManager * m_islandManager;
+
+    MCPhysicsState * m_physicsState;
+
     MCObjectGrid * m_objectGrid;
 
-    static float m_metersPerUnit;
+    MCSweepAndPrune * m_sweepAndPrune;
 
-    static float m_metersPerUnitSquared;
+    float m_metersPerUnit;
 
     float m_minX, m_maxX, m_minY, m_maxY, m_minZ, m_maxZ;
 
@@ -228,6 +422,18 @@ private:
 
     MCWorld::ObjectVector m_removeObjs;
 
+    MCWorld::ObjectVector m_timerEventObjs;
+
+    //! Objects of the state being restored.
+    MCWorld::ObjectVector m_stateObjs;
+
+    //! Per physics slot: true if the object is in the state being restored.
+    std::vector<unsigned char> m_stateMarks;
+
+    std::vector<std::unique_ptr<MCRandomStream>> m_randomStreams;
+
+    uint64_t m_randomSeed;
+
     MCObject * m_leftWallObject;
 
     MCObject * m_rightWallObject;
@@ -242,7 +448,45 @@ private:
 
     float m_resolverStep;
 
+    ResolverMode m_resolverMode;
+
+    float m_resolverDepthTolerance;
+
+    ResolverStatistics m_resolverStatistics;
+
+    //! Broadphase result of the latest detection pass. Valid during processCollisions().
+    const std::vector<std::pair<MCObject *, MCObject *>> * m_possibleCollisions;
+
+    //! Pairs re-tested on an incremental resolver iteration.
+    std::vector<std::pair<MCObject *, MCObject *>> m_resolverPairs;
+
+    //! Per physics slot: the resolver iteration on which the object was last marked.
+    std::vector<unsigned int> m_resolverMarks;
+
+    unsigned int m_resolverIteration;
+
+    std::vector<MCTriggerVolume *> m_triggerVolumes;
+
+    //! Nonzero while m_triggerVolumes is iterated. Removed volumes leave an empty slot then.
+    unsigned int m_triggerVolumeLoopDepth;
+
+    //! Objects overlapping the trigger volume being evaluated.
+    MCWorld::ObjectVector m_triggerObjs;
+
+    //! Objects whose children wait for updateChildTransforms().
+    MCWorld::ObjectVector m_dirtyChildTransformObjs;
+
+    unsigned int m_avoidedChildTransformUpdates;
+
+    unsigned int m_stepCount;
+
+    bool m_isStepping;
+
+    float m_renderInterpolation;
+
     MCVector3dF m_gravity;
+
+    friend class MCObject;
 };
 
 #endif // MCWORLD_HH
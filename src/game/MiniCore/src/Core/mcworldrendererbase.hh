@@ -0,0 +1,56 @@
+// This file belongs to the "MiniCore" game engine.
+// Copyright (C) 2018 Jussi Lind <jussi.lind@iki.fi>
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+// MA  02110-1301, USA.
+//
+
+#ifndef MCWORLDRENDERERBASE_HH
+#define MCWORLDRENDERERBASE_HH
+
+#include "mcrendergroup.hh"
+
+class MCCamera;
+class MCObject;
+
+/*! \class MCWorldRendererBase
+ *  \brief Interface through which MCWorld keeps its renderer up-to-date.
+ *
+ *  MCWorld only knows about this interface, so that the physics can be used
+ *  without the graphics library. MCWorldRenderer implements it with OpenGL. */
+class MCWorldRendererBase
+{
+public:
+
+    //! Destructor.
+    virtual ~MCWorldRendererBase() {}
+
+    //! Called when the object is added to the world.
+    virtual void addObject(MCObject & object) = 0;
+
+    //! Called when the object is removed from the world.
+    virtual void removeObject(MCObject & object) = 0;
+
+    //! Called when all objects are removed from the world.
+    virtual void clear() = 0;
+
+    //! \see MCWorld::prepareRendering().
+    virtual void buildBatches(MCCamera * camera) = 0;
+
+    //! \see MCWorld::render().
+    virtual void render(MCCamera * camera, MCRenderGroup renderGroup) = 0;
+};
+
+#endif // MCWORLDRENDERERBASE_HH
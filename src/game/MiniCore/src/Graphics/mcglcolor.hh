@@ -20,60 +20,58 @@
 #ifndef MCGLCOLOR_HH
 #define MCGLCOLOR_HH
 
-#include <MCGLEW>
-
 class MCGLColor
 {
 public:
 
-    explicit MCGLColor(GLfloat r = 1.0f, GLfloat g = 1.0f, GLfloat b = 1.0f, GLfloat a = 1.0f)
+    explicit MCGLColor(float r = 1.0f, float g = 1.0f, float b = 1.0f, float a = 1.0f)
     : m_r(r), m_g(g), m_b(b), m_a(a)
     {
     }
 
-    inline GLfloat r() const
+    inline float r() const
     {
         return m_r;
     }
 
-    inline GLfloat g() const
+    inline float g() const
     {
         return m_g;
     }
 
-    inline GLfloat b() const
+    inline float b() const
     {
         return m_b;
     }
 
-    inline GLfloat a() const
+    inline float a() const
     {
         return m_a;
     }
 
-    inline void setR(GLfloat r)
+    inline void setR(float r)
     {
         m_r = r;
     }
 
-    inline void setG(GLfloat g)
+    inline void setG(float g)
     {
         m_g = g;
     }
 
-    inline void setB(GLfloat b)
+    inline void setB(float b)
     {
         m_b = b;
     }
 
-    inline void setA(GLfloat a)
+    inline void setA(float a)
     {
         m_a = a;
     }
 
 private:
 
-    GLfloat m_r, m_g, m_b, m_a;
+    float m_r, m_g, m_b, m_a;
 };
 
 #endif // MCGLCOLOR_HH
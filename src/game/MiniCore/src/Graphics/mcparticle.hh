@@ -21,7 +21,6 @@
 #define MCPARTICLE_HH
 
 #include "mcobject.hh"
-#include "mcrecycler.hh"
 #include "mcworldrenderer.hh"
 
 #include <functional>
@@ -18,13 +18,13 @@
 //
 
 #include "mcshapeview.hh"
+#include "mcglscene.hh"
+#include "mcglshaderprogram.hh"
 
 MCTypeRegistry MCShapeView::m_typeRegistry;
 
 MCShapeView::MCShapeView(const std::string & handle)
     : m_viewId(MCShapeView::m_typeRegistry.registerType(handle))
-    , m_shaderProgram(MCGLScene::instance().defaultShaderProgram())
-    , m_shadowShaderProgram(MCGLScene::instance().defaultShadowShaderProgram())
     , m_hasShadow(true)
     , m_scale(1.0f, 1.0f, 1.0f)
 {}
@@ -45,12 +45,13 @@ void MCShapeView::setShadowShaderProgram(MCGLShaderProgramPtr shaderProgram)
 
 MCGLShaderProgramPtr MCShapeView::shaderProgram() const
 {
-    return m_shaderProgram;
+    // The default is looked up on use, so that views can be created without a GL scene
+    return m_shaderProgram ? m_shaderProgram : MCGLScene::instance().defaultShaderProgram();
 }
 
 MCGLShaderProgramPtr MCShapeView::shadowShaderProgram() const
 {
-    return m_shadowShaderProgram;
+    return m_shadowShaderProgram ? m_shadowShaderProgram : MCGLScene::instance().defaultShadowShaderProgram();
 }
 
 void MCShapeView::setHasShadow(bool flag)
@@ -21,18 +21,19 @@
 #define MCSHAPEVIEW_HH
 
 #include "mcbbox3d.hh"
-#include "mcglscene.hh"
-#include "mcglshaderprogram.hh"
+#include "mcglcolor.hh"
 #include "mcmacros.hh"
 #include "mctyperegistry.hh"
-
-
 #include "mcvector3d.hh"
 
 #include <memory>
 
 class MCCamera;
 class MCGLObjectBase;
+class MCGLShaderProgram;
+
+// Forward declared so that this header can be used without OpenGL
+typedef std::shared_ptr<MCGLShaderProgram> MCGLShaderProgramPtr;
 
 /*! \class MCShapeView.
  *  \brief MCShapeView is an abstract base class (2d) for view objects.
@@ -58,10 +59,10 @@ public:
     //! Set the shader program that is used when rendering the (fake) 2d shadow.
     virtual void setShadowShaderProgram(MCGLShaderProgramPtr shaderProgram);
 
-    //! Return the default shader program.
+    //! Return the shader program. MCGLScene::defaultShaderProgram() if not set.
     MCGLShaderProgramPtr shaderProgram() const;
 
-    //! Return the default shadow shader program.
+    //! Return the shadow shader program. MCGLScene::defaultShadowShaderProgram() if not set.
     MCGLShaderProgramPtr shadowShaderProgram() const;
 
     /*! \brief Enable/disable shadow.
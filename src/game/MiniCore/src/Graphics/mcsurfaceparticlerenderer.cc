@@ -19,7 +19,6 @@
 
 #include "mcsurfaceparticlerenderer.hh"
 
-#include "mcmathutil.hh"
 #include "mcsurfaceparticle.hh"
 #include "mctrigonom.hh"
 
@@ -41,6 +40,9 @@ MCSurfaceParticleRenderer::MCSurfaceParticleRenderer(int maxBatchSize)
     , m_normals(new MCGLVertex[maxBatchSize * NUM_VERTICES_PER_PARTICLE])
     , m_texCoords(new MCGLTexCoord[maxBatchSize * NUM_VERTICES_PER_PARTICLE])
     , m_colors(new MCGLColor[maxBatchSize * NUM_VERTICES_PER_PARTICLE])
+    , m_angles(maxBatchSize)
+    , m_sines(maxBatchSize)
+    , m_cosines(maxBatchSize)
 {
     const int NUM_VERTICES = maxBatchSize * NUM_VERTICES_PER_PARTICLE;
     const int VERTEX_DATA_SIZE = sizeof(MCGLVertex) * NUM_VERTICES;
@@ -124,6 +126,13 @@ void MCSurfaceParticleRenderer::setBatch(MCRenderLayer::ObjectBatch & batch, MCC
     setHasShadow(particle->hasShadow());
     setAlphaBlend(particle->useAlphaBlend(), particle->alphaSrc(), particle->alphaDst());
 
+    // Rotations of all particles in one pass
+    for (int i = 0; i < batchSize(); i++)
+    {
+        m_angles[i] = batch.objects[i]->angle();
+    }
+    MCTrigonom::sinCos(m_angles.data(), m_sines.data(), m_cosines.data(), batchSize());
+
     int vertexIndex = 0;
     for (int i = 0; i < batchSize(); i++)
     {
@@ -150,6 +159,9 @@ void MCSurfaceParticleRenderer::setBatch(MCRenderLayer::ObjectBatch & batch, MCC
             camera->mapToCamera(x, y);
         }
 
+        const float sin = m_sines[i];
+        const float cos = m_cosines[i];
+
         for (int j = 0; j < NUM_VERTICES_PER_PARTICLE; j++)
         {
             float vertexX = vertices[j].x() * particle->radius();
@@ -174,8 +186,8 @@ void MCSurfaceParticleRenderer::setBatch(MCRenderLayer::ObjectBatch & batch, MCC
 
             m_vertices[vertexIndex] =
                 MCGLVertex(
-                    x + MCMathUtil::rotatedX(vertexX, vertexY, particle->angle()),
-                    y + MCMathUtil::rotatedY(vertexX, vertexY, particle->angle()),
+                    x + cos * vertexX - sin * vertexY,
+                    y + sin * vertexX + cos * vertexY,
                     z);
 
             m_normals[vertexIndex] = normals[j];
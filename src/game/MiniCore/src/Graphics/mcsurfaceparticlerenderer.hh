@@ -68,6 +68,13 @@ private:
 
     MCGLColor * m_colors;
 
+    //! Angles of the particles in the current batch.
+    std::vector<float> m_angles;
+
+    std::vector<float> m_sines;
+
+    std::vector<float> m_cosines;
+
     friend class MCWorldRenderer;
 };
 
@@ -20,8 +20,23 @@
 #include "mcglshaderprogram.hh"
 #include "mcsurfaceview.hh"
 #include "mccamera.hh"
+#include "mcobject.hh"
+#include "mcrectshape.hh"
 #include "mcsurface.hh"
 
+// Defined here so that MCObject doesn't depend on the graphics library
+MCObject::MCObject(MCSurface & surface, const std::string & typeName)
+    : MCObject(typeName)
+{
+    // Create an MCRectShape using surface with an MCSurfaceView
+    MCShapePtr rectShape(new MCRectShape(
+        MCShapeViewPtr(new MCSurfaceView(surface.handle(), &surface)),
+        surface.width(),
+        surface.height()));
+
+    setShape(rectShape);
+}
+
 MCSurfaceView::MCSurfaceView(const std::string & viewId, MCSurface * surface)
     : MCShapeView(viewId)
     , m_surface(surface)
@@ -25,12 +25,15 @@
 #include "mcsurfaceparticlerenderer.hh"
 #include "mcsurfaceparticlerendererlegacy.hh"
 #include "mcobject.hh"
+#include "mcobjectgrid.hh"
 #include "mcparticle.hh"
 #include "mcshape.hh"
 #include "mcshapeview.hh"
 #include "mcsurfaceview.hh"
+#include "mcsweepandprune.hh"
 
 #include <algorithm>
+#include <cassert>
 
 #include <MCGLEW>
 
@@ -50,9 +53,8 @@ void MCWorldRenderer::buildObjectBatches(MCCamera * camera)
     auto & batchVector = m_defaultLayer.objectBatches()[camera];
     static std::vector<MCObject *> childStack;
     childStack.clear();
-    for (auto && object : MCWorld::instance().objectGrid().getObjectsWithinBBox(camera->bbox()))
-    {
-        childStack.push_back(object);
+    auto addObject = [&] (MCObject & object) {
+        childStack.push_back(&object);
         while (childStack.size())
         {
             auto parent = childStack.back();
@@ -60,7 +62,7 @@ void MCWorldRenderer::buildObjectBatches(MCCamera * camera)
 
             if (parent->isRenderable() && parent->shape() && parent->shape()->view())
             {
-                const int objectViewId = object->typeId() * 1024 + parent->shape()->view()->viewId();
+                const int objectViewId = object.typeId() * 1024 + parent->shape()->view()->viewId();
                 auto batchIter = std::find_if(batchVector.begin(), batchVector.end(), [&](const MCRenderLayer::ObjectBatch & batch) {
                     return batch.objectViewId == objectViewId;
                 });
@@ -85,6 +87,16 @@ void MCWorldRenderer::buildObjectBatches(MCCamera * camera)
                 childStack.push_back(child.get());
             }
         }
+    };
+
+    MCWorld & world = MCWorld::instance();
+    if (world.broadphase() == MCWorld::Broadphase::SweepAndPrune)
+    {
+        world.sweepAndPrune().forEachObjectWithinBBox(camera->bbox(), addObject);
+    }
+    else
+    {
+        world.objectGrid().forEachObjectWithinBBox(camera->bbox(), addObject);
     }
 
     std::stable_sort(batchVector.begin(), batchVector.end(), [](const MCRenderLayer::ObjectBatch & l, const MCRenderLayer::ObjectBatch & r) {
@@ -409,9 +421,11 @@ void MCWorldRenderer::clear()
 {
     m_defaultLayer.clear();
 
+    // The world is being cleared, so particles die without being removed separately
     for (auto particle : m_particleSet)
     {
         particle->m_indexInRenderArray = -1;
+        particle->die();
     }
     m_particleSet.clear();
 }
@@ -420,3 +434,10 @@ MCWorldRenderer::~MCWorldRenderer()
 {
     delete m_surfaceParticleRenderer;
 }
+
+// Defined here so that only users of the graphics library can access the renderer
+MCWorldRenderer & MCWorld::renderer() const
+{
+    assert(m_renderer);
+    return static_cast<MCWorldRenderer &>(*m_renderer);
+}
@@ -25,6 +25,7 @@
 #include "mcrendergroup.hh"
 
 #include "mcworld.hh"
+#include "mcworldrendererbase.hh"
 
 #include <set>
 #include <vector>
@@ -34,14 +35,15 @@ class MCObject;
 class MCObjectRendererBase;
 class MCParticleRendererBase;
 
-//! Helper class used by MCWorld. Renders all objects in the scene.
-class MCWorldRenderer
+/*! Helper class used by MCWorld. Renders all objects in the scene.
+ *  Give it to MCWorld on construction to enable rendering. */
+class MCWorldRenderer : public MCWorldRendererBase
 {
 public:
 
     MCWorldRenderer();
 
-    ~MCWorldRenderer();
+    virtual ~MCWorldRenderer();
 
     //! \return the current OpenGL scene object.
     MCGLScene & glScene();
@@ -62,17 +64,20 @@ public:
     /*! Remove all particle visibility cameras. */
     void removeParticleVisibilityCameras();
 
-    void addObject(MCObject & object);
+    //! \reimp
+    virtual void addObject(MCObject & object) override;
 
-    void removeObject(MCObject & object);
+    //! \reimp
+    virtual void removeObject(MCObject & object) override;
 
     /*! Must be called before calls to render() or renderShadows() */
-    void buildBatches(MCCamera * camera);
+    virtual void buildBatches(MCCamera * camera) override;
 
     //! Render the given object group. \see MCRenderGroup.
-    void render(MCCamera * camera, MCRenderGroup renderGroup);
+    virtual void render(MCCamera * camera, MCRenderGroup renderGroup) override;
 
-    void clear();
+    //! \reimp
+    virtual void clear() override;
 
 private:
 
@@ -25,172 +25,135 @@
 #include "mccircleshape.hh"
 #include "mcrectshape.hh"
 #include "mccollisionevent.hh"
+#include "mcvectorbatch.hh"
+#include "mcworkerpool.hh"
+
+#include <algorithm>
+
+namespace
+{
+//! Pairs below this count per batch aren't worth a thread.
+const unsigned int MIN_PAIRS_PER_BATCH = 64;
+}
 
 MCCollisionDetector::MCCollisionDetector()
 : m_arePrimaryCollisionEventsEnabled(true)
-{}
+, m_workerPool(new MCWorkerPool(1))
+{
+    m_hitBuffers.resize(m_workerPool->threadCount());
+}
+
+MCCollisionDetector::~MCCollisionDetector()
+{
+}
+
+void MCCollisionDetector::setThreadCount(unsigned int threadCount)
+{
+    m_workerPool.reset(new MCWorkerPool(threadCount));
+    m_hitBuffers.resize(m_workerPool->threadCount());
+}
+
+unsigned int MCCollisionDetector::threadCount() const
+{
+    return m_workerPool->threadCount();
+}
 
 void MCCollisionDetector::enablePrimaryCollisionEvents(bool enable)
 {
     m_arePrimaryCollisionEventsEnabled = enable;
 }
 
-bool MCCollisionDetector::testRectAgainstRect(MCRectShape & rect1, MCRectShape & rect2)
+void MCCollisionDetector::testRectAgainstRect(
+    MCRectShape & rect1, MCRectShape & rect2, unsigned int pairIndex, bool isSecondPass, HitBuffer & hits) const
 {
     const MCOBBox<float> & obbox1(rect1.obbox());
+    const bool triggerObjectInvolved = rect1.parent().isTriggerObject() || rect2.parent().isTriggerObject();
 
-    bool collided = false;
-
-    // Loop thru all vertices of rect1 and generate contacts for colliding vertices.
+    // Test all vertices of rect1 at once and generate hits for colliding vertices.
+    const MCVector2dF vertices[4] = {obbox1.vertex(0), obbox1.vertex(1), obbox1.vertex(2), obbox1.vertex(3)};
+    const unsigned int mask = rect2.obbox().containsMask(vertices);
     for (unsigned int i = 0; i < 4; i++)
     {
-        if (rect2.contains(obbox1.vertex(i)))
+        const MCVector2dF & vertex = vertices[i];
+        if (mask & (1 << i))
         {
-            const bool triggerObjectInvolved = rect1.parent().isTriggerObject() || rect2.parent().isTriggerObject();
-
-            // Send collision event to owner of rect1
-            MCCollisionEvent ev1(rect2.parent(), obbox1.vertex(i), m_arePrimaryCollisionEventsEnabled);
-            MCObject::sendEvent(rect1.parent(), ev1);
-
-            // Send collision event to owner of rect2
-            MCCollisionEvent ev2(rect1.parent(), obbox1.vertex(i), m_arePrimaryCollisionEventsEnabled);
-            MCObject::sendEvent(rect2.parent(), ev2);
+            Hit hit = {pairIndex, isSecondPass, &rect1.parent(), &rect2.parent(), vertex, MCVector2dF(), 0};
 
-            if (!triggerObjectInvolved && (ev1.accepted() && ev2.accepted())) // Trigger objects should only trigger events
+            // Trigger objects should only trigger events, so the depth is not needed
+            if (!triggerObjectInvolved)
             {
-                MCVector2dF contactNormal;
-                MCVector2dF vertex = obbox1.vertex(i);
-                float depth = rect2.interpenetrationDepth(
-                    MCSegment<float>(vertex, rect1.location()), contactNormal);
-
-                {
-                    MCContact & contact = MCContact::create();
-                    contact.init(rect2.parent(), vertex, contactNormal, depth);
-                    rect1.parent().addContact(contact);
-                }
-
-                {
-                    MCContact & contact = MCContact::create();
-                    contact.init(rect1.parent(), vertex, -contactNormal, depth);
-                    rect2.parent().addContact(contact);
-                }
-
-                collided = true;
+                hit.m_depth = rect2.interpenetrationDepth(MCSegment<float>(vertex, rect1.location()), hit.m_normal);
             }
 
+            hits.push_back(hit);
+
             // Don't break here in the case of a collision, because we don't know
             // yet which contact is the deepest. MCImpulseGenerator handles that.
         }
     }
-
-    return collided;
 }
 
-bool MCCollisionDetector::testRectAgainstCircle(MCRectShape & rect, MCCircleShape & circle)
+void MCCollisionDetector::testRectAgainstCircle(
+    MCRectShape & rect, MCCircleShape & circle, unsigned int pairIndex, HitBuffer & hits) const
 {
-    bool collided = false;
-
     const MCOBBox<float> & obbox(rect.obbox());
+    const bool triggerObjectInvolved = rect.parent().isTriggerObject() || circle.parent().isTriggerObject();
 
-    // Loop through all vertices of the rect and find possible contact points with
-    // the circle. This algorithm is not perfectly accurate, but will do the job.
-    for (unsigned int i = 0; i < 5; i++)
+    // No point of the circle can be inside the rect
+    const MCVector2dF circleLocation(circle.location());
+    if (obbox.isSeparatedFrom(circleLocation, circle.radius()))
     {
-        MCVector2dF rectVertex;
-        if (i < 4)
-        {
-            rectVertex = obbox.vertex(i);
-        }
-        else
-        {
-            rectVertex = rect.location();
-        }
-
-        MCVector2dF circleVertex(rectVertex - MCVector2dF(circle.location()));
-        circleVertex.clampFast(circle.radius());
-        circleVertex += MCVector2dF(circle.location());
-        if (rect.contains(circleVertex))
-        {
-            const bool triggerObjectInvolved = rect.parent().isTriggerObject() || circle.parent().isTriggerObject();
+        return;
+    }
 
-            // Send collision event to owner of circle
-            MCCollisionEvent ev1(rect.parent(), circleVertex, m_arePrimaryCollisionEventsEnabled);
-            MCObject::sendEvent(circle.parent(), ev1);
+    // Find the points of the circle closest to the vertices and the center of the
+    // rect. This algorithm is not perfectly accurate, but will do the job.
+    MCVector2dF circleVertices[5] = {
+        obbox.vertex(0) - circleLocation, obbox.vertex(1) - circleLocation,
+        obbox.vertex(2) - circleLocation, obbox.vertex(3) - circleLocation,
+        MCVector2dF(rect.location()) - circleLocation};
+    MCVectorBatch::clampFast(circleVertices, circle.radius(), 5);
+    for (auto && circleVertex : circleVertices)
+    {
+        circleVertex += circleLocation;
+    }
 
-            // Send collision event to owner of rect
-            MCCollisionEvent ev2(circle.parent(), circleVertex, m_arePrimaryCollisionEventsEnabled);
-            MCObject::sendEvent(rect.parent(), ev2);
+    const unsigned int mask = obbox.containsMask(circleVertices) | (obbox.contains(circleVertices[4]) << 4);
+    for (unsigned int i = 0; i < 5; i++)
+    {
+        const MCVector2dF & circleVertex = circleVertices[i];
+        if (mask & (1 << i))
+        {
+            Hit hit = {pairIndex, false, &circle.parent(), &rect.parent(), circleVertex, MCVector2dF(), 0};
 
-            if (!triggerObjectInvolved && (ev1.accepted() && ev2.accepted())) // Trigger objects should only trigger events
+            // Trigger objects should only trigger events, so the depth is not needed
+            if (!triggerObjectInvolved)
             {
-                MCVector2dF contactNormal;
-                float depth = rect.interpenetrationDepth(
-                    MCSegment<float>(circleVertex, circle.location()), contactNormal);
-
-                {
-                    MCContact & contact = MCContact::create();
-                    contact.init(rect.parent(), circleVertex, contactNormal, depth);
-                    circle.parent().addContact(contact);
-                }
-
-                {
-                    MCContact & contact = MCContact::create();
-                    contact.init(circle.parent(), circleVertex, -contactNormal, depth);
-                    rect.parent().addContact(contact);
-                }
-
-                collided = true;
+                hit.m_depth = rect.interpenetrationDepth(MCSegment<float>(circleVertex, circle.location()), hit.m_normal);
             }
 
+            hits.push_back(hit);
+
             // Don't break here in the case of a collision, because we don't know
             // yet which contact is the deepest. MCImpulseGenerator handles that.
         }
     }
-
-    return collided;
 }
 
-bool MCCollisionDetector::testCircleAgainstCircle(MCCircleShape & circle1, MCCircleShape & circle2)
+void MCCollisionDetector::testCircleAgainstCircle(
+    MCCircleShape & circle1, MCCircleShape & circle2, unsigned int pairIndex, HitBuffer & hits) const
 {
-    bool collided = false;
     MCVector2dF contactNormal;
     const float depth = circle2.interpenetrationDepth(circle1, contactNormal);
-    const MCVector2dF contactPoint(MCVector2dF(circle1.location()) - contactNormal * circle1.radius());
-
     if (depth > 0)
     {
-        const bool triggerObjectInvolved = circle1.parent().isTriggerObject() || circle2.parent().isTriggerObject();
-
-        // Send collision event to owner of circle2
-        MCCollisionEvent ev1(circle1.parent(), contactPoint, m_arePrimaryCollisionEventsEnabled);
-        MCObject::sendEvent(circle2.parent(), ev1);
-
-        // Send collision event to owner of circle1
-        MCCollisionEvent ev2(circle2.parent(), contactPoint, m_arePrimaryCollisionEventsEnabled);
-        MCObject::sendEvent(circle1.parent(), ev2);
-
-        if (!triggerObjectInvolved && (ev1.accepted() && ev2.accepted())) // Trigger objects should only trigger events
-        {
-            {
-                MCContact & contact = MCContact::create();
-                contact.init(circle1.parent(), contactPoint, -contactNormal, depth);
-                circle2.parent().addContact(contact);
-            }
-
-            {
-                MCContact & contact = MCContact::create();
-                contact.init(circle1.parent(), contactPoint, contactNormal, depth);
-                circle1.parent().addContact(contact);
-            }
-
-            collided = true;
-        }
+        const MCVector2dF contactPoint(MCVector2dF(circle1.location()) - contactNormal * circle1.radius());
+        const Hit hit = {pairIndex, false, &circle2.parent(), &circle1.parent(), contactPoint, -contactNormal, depth};
+        hits.push_back(hit);
     }
-
-    return collided;
 }
 
-bool MCCollisionDetector::processPossibleCollision(MCObject & object1, MCObject & object2)
+void MCCollisionDetector::computeHits(MCObject & object1, MCObject & object2, unsigned int pairIndex, HitBuffer & hits) const
 {
     const unsigned int id1 = object1.shape()->instanceTypeId();
     const unsigned int id2 = object2.shape()->instanceTypeId();
@@ -198,52 +161,229 @@ bool MCCollisionDetector::processPossibleCollision(MCObject & object1, MCObject
     // Rect against rect
     if (id1 == MCRectShape::typeId() && id2 == MCRectShape::typeId())
     {
-        // We must test first object1 against object2 and then
-        // the other way around.
-        if (testRectAgainstRect(
-            // Static cast because we know the types now.
-            *static_cast<MCRectShape *>(object1.shape().get()),
-            *static_cast<MCRectShape *>(object2.shape().get())))
+        // Static cast because we know the types now.
+        MCRectShape & rect1 = *static_cast<MCRectShape *>(object1.shape().get());
+        MCRectShape & rect2 = *static_cast<MCRectShape *>(object2.shape().get());
+
+        // Neither pass can have hits
+        if (rect1.obbox().isSeparatedFrom(rect2.obbox()))
         {
-            return true;
+            return;
         }
-        else if (testRectAgainstRect(
-            // Static cast because we know the types now.
-            *static_cast<MCRectShape *>(object2.shape().get()),
-            *static_cast<MCRectShape *>(object1.shape().get())))
+
+        // We must test first object1 against object2 and then the other way around.
+        // The second pass is needed only if the first one doesn't create contacts.
+        // That can be known for sure only after the events have been sent, so if the first
+        // pass had hits, detectCollisions() does the second pass when needed.
+        const size_t firstPassEnd = hits.size();
+        testRectAgainstRect(rect1, rect2, pairIndex, false, hits);
+        if (hits.size() == firstPassEnd || object1.isTriggerObject() || object2.isTriggerObject())
         {
-            return true;
+            testRectAgainstRect(rect2, rect1, pairIndex, true, hits);
         }
     }
     // Rect against circle
     else if (id1 == MCRectShape::typeId() && id2 == MCCircleShape::typeId())
     {
         // Static cast because we know the types now.
-        return testRectAgainstCircle(
+        testRectAgainstCircle(
             *static_cast<MCRectShape *>(object1.shape().get()),
-            *static_cast<MCCircleShape *>(object2.shape().get()));
+            *static_cast<MCCircleShape *>(object2.shape().get()), pairIndex, hits);
     }
     // Circle against circle
     else if (id1 == MCCircleShape::typeId() && id2 == MCCircleShape::typeId())
     {
         // Static cast because we know the types now.
-        return testCircleAgainstCircle(
+        testCircleAgainstCircle(
             *static_cast<MCCircleShape *>(object1.shape().get()),
-            *static_cast<MCCircleShape *>(object2.shape().get()));
+            *static_cast<MCCircleShape *>(object2.shape().get()), pairIndex, hits);
+    }
+}
+
+bool MCCollisionDetector::processHit(const Hit & hit)
+{
+    MCObject & object1 = *hit.m_object1;
+    MCObject & object2 = *hit.m_object2;
+
+    const bool triggerObjectInvolved = object1.isTriggerObject() || object2.isTriggerObject();
+
+    // Send collision event to object1
+    MCCollisionEvent ev1(object2, hit.m_point, m_arePrimaryCollisionEventsEnabled);
+    MCObject::sendEvent(object1, ev1);
+
+    // Send collision event to object2
+    MCCollisionEvent ev2(object1, hit.m_point, m_arePrimaryCollisionEventsEnabled);
+    MCObject::sendEvent(object2, ev2);
+
+    if (!triggerObjectInvolved && (ev1.accepted() && ev2.accepted())) // Trigger objects should only trigger events
+    {
+        m_acceptedHits.push_back(hit);
+        return true;
     }
 
     return false;
 }
 
+void MCCollisionDetector::storeAcceptedHits()
+{
+    // All accepted hits of a pair come from the same pass, but split the spans
+    // by the object order to be sure.
+    size_t i = 0;
+    while (i < m_acceptedHits.size())
+    {
+        MCObject & object1 = *m_acceptedHits[i].m_object1;
+        MCObject & object2 = *m_acceptedHits[i].m_object2;
+
+        size_t end = i + 1;
+        while (end < m_acceptedHits.size() && m_acceptedHits[end].m_object1 == &object1)
+        {
+            end++;
+        }
+
+        const unsigned int count = static_cast<unsigned int>(end - i);
+
+        MCContact * contacts1 = m_contactArena.addContacts(object1, object2, count);
+        for (unsigned int j = 0; j < count; j++)
+        {
+            const Hit & hit = m_acceptedHits[i + j];
+            contacts1[j].init(object2, hit.m_point, hit.m_normal, hit.m_depth);
+        }
+
+        MCContact * contacts2 = m_contactArena.addContacts(object2, object1, count);
+        for (unsigned int j = 0; j < count; j++)
+        {
+            const Hit & hit = m_acceptedHits[i + j];
+            contacts2[j].init(object1, hit.m_point, -hit.m_normal, hit.m_depth);
+        }
+
+        i = end;
+    }
+
+    m_acceptedHits.clear();
+}
+
 unsigned int MCCollisionDetector::detectCollisions(MCObjectGrid & objectGrid)
 {
+    return detectCollisions(objectGrid.getPossibleCollisions());
+}
+
+unsigned int MCCollisionDetector::detectCollisions(const MCObjectGrid::CollisionVector & possibleCollisions)
+{
+    // Phase 1: compute the hits in parallel. Each batch is a contiguous range of pairs,
+    // so the hits are in the order of the pairs when the batches are read in order.
+    const unsigned int pairCount = static_cast<unsigned int>(possibleCollisions.size());
+    const unsigned int batchCount = std::max(1u,
+        std::min(m_workerPool->threadCount(), pairCount / MIN_PAIRS_PER_BATCH));
+
+    m_workerPool->run(batchCount, [&](unsigned int batchIndex) {
+        HitBuffer & hits = m_hitBuffers[batchIndex];
+        hits.clear();
+
+        const unsigned int begin = static_cast<unsigned long>(pairCount) * batchIndex / batchCount;
+        const unsigned int end = static_cast<unsigned long>(pairCount) * (batchIndex + 1) / batchCount;
+        for (unsigned int i = begin; i < end; i++)
+        {
+            computeHits(*possibleCollisions[i].first, *possibleCollisions[i].second, i, hits);
+        }
+    });
+
+    // Phase 2: send the events and create the contacts serially.
     unsigned int numCollisions = 0;
 
-    for (auto && iter : objectGrid.getPossibleCollisions())
+    for (unsigned int batchIndex = 0; batchIndex < batchCount; batchIndex++)
     {
-        numCollisions += processPossibleCollision(*iter.first, *iter.second);
+        const HitBuffer & hits = m_hitBuffers[batchIndex];
+
+        size_t i = 0;
+        while (i < hits.size())
+        {
+            const unsigned int pairIndex = hits[i].m_pairIndex;
+            bool hadFirstPass = false;
+            bool firstPassCollided = false;
+            bool collided = false;
+
+            for (; i < hits.size() && hits[i].m_pairIndex == pairIndex; i++)
+            {
+                const Hit & hit = hits[i];
+                if (!hit.m_isSecondPass)
+                {
+                    hadFirstPass = true;
+                    firstPassCollided |= processHit(hit);
+                }
+                else if (!firstPassCollided)
+                {
+                    collided |= processHit(hit);
+                }
+            }
+
+            MCObject & object1 = *possibleCollisions[pairIndex].first;
+            MCObject & object2 = *possibleCollisions[pairIndex].second;
+
+            // The first pass of a rect-rect pair had hits, but the events didn't create contacts.
+            if (hadFirstPass && !firstPassCollided &&
+                object1.shape()->instanceTypeId() == MCRectShape::typeId() &&
+                object2.shape()->instanceTypeId() == MCRectShape::typeId() &&
+                !object1.isTriggerObject() && !object2.isTriggerObject())
+            {
+                m_secondPassHits.clear();
+                testRectAgainstRect(
+                    *static_cast<MCRectShape *>(object2.shape().get()),
+                    *static_cast<MCRectShape *>(object1.shape().get()), pairIndex, true, m_secondPassHits);
+
+                for (auto && hit : m_secondPassHits)
+                {
+                    collided |= processHit(hit);
+                }
+            }
+
+            storeAcceptedHits();
+
+            numCollisions += firstPassCollided || collided;
+
+            // Contact states are tracked only on the primary pass of each step
+            if (m_arePrimaryCollisionEventsEnabled)
+            {
+                m_pairCache.setTouching(object1, object2);
+            }
+        }
     }
 
     return numCollisions;
 }
 
+void MCCollisionDetector::processContactEvents()
+{
+    m_pairCache.update();
+}
+
+void MCCollisionDetector::removeObject(MCObject & object)
+{
+    m_pairCache.remove(object);
+    m_contactArena.removeObject(object);
+}
+
+void MCCollisionDetector::clear()
+{
+    m_pairCache.clear();
+    m_contactArena.reset();
+}
+
+MCContactArena & MCCollisionDetector::contactArena()
+{
+    return m_contactArena;
+}
+
+const MCPairCache & MCCollisionDetector::pairCache() const
+{
+    return m_pairCache;
+}
+
+void MCCollisionDetector::saveState(MCStateBuffer & state) const
+{
+    m_pairCache.saveState(state);
+}
+
+void MCCollisionDetector::restoreState(MCStateBuffer & state)
+{
+    m_pairCache.restoreState(state);
+}
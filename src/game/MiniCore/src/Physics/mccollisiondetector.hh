@@ -20,18 +20,29 @@
 #ifndef MCCOLLISIONDETECTOR_HH
 #define MCCOLLISIONDETECTOR_HH
 
+#include "mccontactarena.hh"
 #include "mcmacros.hh"
+#include "mcobjectgrid.hh"
+#include "mcpaircache.hh"
+#include "mcvector2d.hh"
 
-
-
+#include <memory>
 #include <vector>
 
 class MCCircleShape;
 class MCObject;
-class MCObjectGrid;
 class MCRectShape;
-
-//! Collision detector and contact generator.
+class MCStateBuffer;
+class MCWorkerPool;
+
+/*! Collision detector and contact generator.
+ *
+ *  Detection runs in two phases. First the possible collisions are split into
+ *  batches and the contact geometry is computed for each batch on a worker pool.
+ *  The workers only read the shapes and write to per-batch buffers. Then the
+ *  buffers are merged serially in the order of the possible collisions: collision
+ *  events are sent and the contacts are stored to MCContactArena. The result
+ *  doesn't depend on the number of threads. */
 class MCCollisionDetector
 {
 public:
@@ -39,27 +50,105 @@ public:
     MCCollisionDetector();
 
     //! Destructor.
-    virtual ~MCCollisionDetector() {};
+    virtual ~MCCollisionDetector();
+
+    /*! Set the number of threads used for the contact geometry.
+     *  0 means std::thread::hardware_concurrency(). 1 disables threading.
+     *  The default is 1, because each world has a detector of its own and
+     *  several worlds with a thread per core would oversubscribe the machine. */
+    void setThreadCount(unsigned int threadCount);
 
-    //! Detect collisions and generate contacts. Contacts are stored to MCObject.
+    //! \return the number of threads used for the contact geometry.
+    unsigned int threadCount() const;
+
+    //! Detect collisions and generate contacts. Contacts are stored to contactArena().
     unsigned int detectCollisions(MCObjectGrid & objectGrid);
 
+    /*! Detect collisions and generate contacts for the given broadphase result.
+     *  Contacts are stored to contactArena(). */
+    unsigned int detectCollisions(const MCObjectGrid::CollisionVector & possibleCollisions);
+
     /*! Turn primary collision events on/off. This is used by MCWorld when iterating
      *  the collision resolution. */
     void enablePrimaryCollisionEvents(bool enable);
 
+    /*! Send MCContactEvents for the pairs that touched on the primary detection pass.
+     *  MCWorld calls this once per step. */
+    void processContactEvents();
+
+    //! Forget the cached pairs and the contacts of the given object.
+    void removeObject(MCObject & object);
+
+    //! Forget all cached pairs and contacts.
+    void clear();
+
+    //! \return the contacts of the current step.
+    MCContactArena & contactArena();
+
+    //! \return the cache of touching pairs.
+    const MCPairCache & pairCache() const;
+
+    //! Save the touching pairs into the given buffer. Contacts live only during a step.
+    void saveState(MCStateBuffer & state) const;
+
+    //! Restore the touching pairs saved with saveState().
+    void restoreState(MCStateBuffer & state);
+
 private:
 
-    bool processPossibleCollision(MCObject & object1, MCObject & object2);
+    /*! A contact point found in the parallel phase. Events are sent first to m_object1
+     *  and then to m_object2. m_object1 gets the contact with m_normal and m_object2
+     *  the contact with -m_normal. */
+    struct Hit
+    {
+        //! Index of the pair in the possible collisions.
+        unsigned int m_pairIndex;
+
+        //! Rect-rect pairs are tested both ways. The second pass is used only if the first one didn't collide.
+        bool m_isSecondPass;
+
+        MCObject * m_object1;
 
-    bool testRectAgainstRect(MCRectShape & object1, MCRectShape & object2);
+        MCObject * m_object2;
 
-    bool testRectAgainstCircle(MCRectShape & object1, MCCircleShape & object2);
+        MCVector2dF m_point;
 
-    bool testCircleAgainstCircle(MCCircleShape & object1, MCCircleShape & object2);
+        MCVector2dF m_normal;
+
+        float m_depth;
+    };
+
+    typedef std::vector<Hit> HitBuffer;
+
+    void computeHits(MCObject & object1, MCObject & object2, unsigned int pairIndex, HitBuffer & hits) const;
+
+    void testRectAgainstRect(MCRectShape & rect1, MCRectShape & rect2, unsigned int pairIndex, bool isSecondPass, HitBuffer & hits) const;
+
+    void testRectAgainstCircle(MCRectShape & rect, MCCircleShape & circle, unsigned int pairIndex, HitBuffer & hits) const;
+
+    void testCircleAgainstCircle(MCCircleShape & circle1, MCCircleShape & circle2, unsigned int pairIndex, HitBuffer & hits) const;
+
+    //! Send the collision events of the given hit. \return true if the hit was accepted as a contact.
+    bool processHit(const Hit & hit);
+
+    //! Store the accepted hits of the current pair to the contact arena.
+    void storeAcceptedHits();
 
     bool m_arePrimaryCollisionEventsEnabled;
 
+    //! One buffer per batch.
+    std::vector<HitBuffer> m_hitBuffers;
+
+    HitBuffer m_secondPassHits;
+
+    HitBuffer m_acceptedHits;
+
+    MCContactArena m_contactArena;
+
+    std::unique_ptr<MCWorkerPool> m_workerPool;
+
+    MCPairCache m_pairCache;
+
     DISABLE_COPY(MCCollisionDetector);
     DISABLE_ASSI(MCCollisionDetector);
 };
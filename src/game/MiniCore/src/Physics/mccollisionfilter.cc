@@ -0,0 +1,77 @@
+// This file belongs to the "MiniCore" game engine.
+// Copyright (C) 2018 Jussi Lind <jussi.lind@iki.fi>
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+// MA  02110-1301, USA.
+//
+
+#include "mccollisionfilter.hh"
+#include "mcobject.hh"
+#include "mcphysicscomponent.hh"
+
+namespace {
+
+const int BIT_COUNT = 32;
+
+inline bool inBitRange(int value)
+{
+    return value >= 0 && value < BIT_COUNT;
+}
+
+} // namespace
+
+void MCCollisionFilter::update(MCObject & object)
+{
+    MCPhysicsComponent & physicsComponent = object.physicsComponent();
+
+    m_object = &object;
+    m_parent = &object.parent();
+
+    m_flags = 0;
+    if ((object.isPhysicsObject() || object.isTriggerObject()) && !object.bypassCollisions())
+    {
+        m_flags |= Collides;
+    }
+
+    if (!physicsComponent.isSleeping())
+    {
+        m_flags |= Awake;
+    }
+
+    // A tag outside the range can only match a never-collide-with tag outside the range,
+    // so the never-collide-with tag alone doesn't need the fallback.
+    const int tag = physicsComponent.collisionTag();
+    m_categoryBits = inBitRange(tag) ? 1u << tag : 0;
+
+    const int neverCollideWithTag = physicsComponent.neverCollideWithTag();
+    m_maskBits = inBitRange(neverCollideWithTag) ? ~(1u << neverCollideWithTag) : ~0u;
+
+    const int layer = object.collisionLayer();
+    m_layerBits = layer == -1 ? ~0u : (inBitRange(layer) ? 1u << layer : 0);
+
+    if (!inBitRange(tag) || (layer != -1 && !inBitRange(layer)))
+    {
+        m_flags |= OutOfRange;
+    }
+}
+
+bool MCCollisionFilter::acceptsOutOfRange(const MCCollisionFilter & filter1, const MCCollisionFilter & filter2)
+{
+    MCObject & obj1 = *filter1.m_object;
+    MCObject & obj2 = *filter2.m_object;
+    return obj1.physicsComponent().neverCollideWithTag() != obj2.physicsComponent().collisionTag() &&
+        obj2.physicsComponent().neverCollideWithTag() != obj1.physicsComponent().collisionTag() &&
+        (obj1.collisionLayer() == obj2.collisionLayer() || obj1.collisionLayer() == -1 || obj2.collisionLayer() == -1);
+}
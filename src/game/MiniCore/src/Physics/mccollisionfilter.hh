@@ -0,0 +1,95 @@
+// This file belongs to the "MiniCore" game engine.
+// Copyright (C) 2018 Jussi Lind <jussi.lind@iki.fi>
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+// MA  02110-1301, USA.
+//
+
+#ifndef MCCOLLISIONFILTER_HH
+#define MCCOLLISIONFILTER_HH
+
+#include <cstdint>
+
+class MCObject;
+
+/*! Compact collision filter of an object. MCObject keeps it up to date when the
+ *  properties affecting collisions change, so the broadphases can reject pairs
+ *  with a few bitwise operations without touching the objects.
+ *
+ *  Collision tags and layers in the range [0, 31] are mapped to bits. Pairs with
+ *  other values fall back to comparing the values of the objects. */
+struct MCCollisionFilter
+{
+    //! Bits of m_flags.
+    enum Flag : uint32_t
+    {
+        //! A physics or a trigger object without bypassed collisions.
+        Collides = 1,
+
+        //! Not sleeping.
+        Awake = 2,
+
+        //! The collision tag or the layer is not in the bit range.
+        OutOfRange = 4
+    };
+
+    //! Update from the given object and its physics component.
+    void update(MCObject & object);
+
+    /*! \return true if objects with the given filters are allowed to collide.
+     *  The shapes are not tested. */
+    static bool accepts(const MCCollisionFilter & filter1, const MCCollisionFilter & filter2)
+    {
+        if (!(filter1.m_flags & filter2.m_flags & Collides) ||
+            !((filter1.m_flags | filter2.m_flags) & Awake) ||
+            filter1.m_parent == filter2.m_object ||
+            filter2.m_parent == filter1.m_object)
+        {
+            return false;
+        }
+
+        if ((filter1.m_flags | filter2.m_flags) & OutOfRange)
+        {
+            return acceptsOutOfRange(filter1, filter2);
+        }
+
+        return (filter1.m_categoryBits & filter2.m_maskBits) &&
+            (filter2.m_categoryBits & filter1.m_maskBits) &&
+            (filter1.m_layerBits & filter2.m_layerBits);
+    }
+
+    //! The object.
+    MCObject * m_object = nullptr;
+
+    //! The parent object. This is the object itself if it doesn't have a parent.
+    MCObject * m_parent = nullptr;
+
+    //! Bit of the collision tag.
+    uint32_t m_categoryBits = 0;
+
+    //! All bits except the bit of the never-collide-with tag.
+    uint32_t m_maskBits = 0;
+
+    //! Bit of the collision layer. All bits for layer -1 that collides with all layers.
+    uint32_t m_layerBits = 0;
+
+    uint32_t m_flags = 0;
+
+private:
+
+    static bool acceptsOutOfRange(const MCCollisionFilter & filter1, const MCCollisionFilter & filter2);
+};
+
+#endif // MCCOLLISIONFILTER_HH
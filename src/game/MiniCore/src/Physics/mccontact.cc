@@ -21,8 +21,6 @@
 #include "mcobject.hh"
 #include <cassert>
 
-MCRecycler<MCContact> MCContact::m_recycler;
-
 MCContact::MCContact()
 : m_pObject(nullptr)
 , m_interpenetrationDepth(0.0)
@@ -59,17 +57,3 @@ float MCContact::interpenetrationDepth() const
 {
     return m_interpenetrationDepth;
 }
-
-MCContact & MCContact::create()
-{
-    return *MCContact::m_recycler.newObject();
-}
-
-void MCContact::free()
-{
-    return MCContact::m_recycler.freeObject(this);
-}
-
-MCContact::~MCContact()
-{
-}
@@ -21,27 +21,21 @@
 #define MCCONTACT_HH
 
 #include "mcvector2d.hh"
-#include "mcrecycler.hh"
-#include "mcmacros.hh"
 
 class MCObject;
 
 /*! \class MCContact
  *  \brief MCContact is a class representing a collision contact.
  *
- * MCContact is added to object (A) to notify a contact with object(B) using
- * MCObject::addContact(MCContact * p). MCWorld then processes the contacts
- * on every world update.
+ * MCContact is stored to MCContactArena to notify a contact of object (A) with
+ * object (B). MCWorld then processes the contacts on every world update.
  */
 class MCContact
 {
 public:
 
-    //! Return a new (empty) contact
-    static MCContact & create();
-
-    //! Move contact to the list of free contacts
-    void free();
+    //! Constructor.
+    MCContact();
 
     /*! \brief Init the contact.
      *  \param object The contacting object
@@ -68,21 +62,10 @@ public:
 
 private:
 
-    //! Constructor disabled: use MCContact::create()
-    MCContact();
-
-    //! Destructor disabled: use MCContact::free()
-    ~MCContact();
-
-    DISABLE_COPY(MCContact);
-    DISABLE_ASSI(MCContact);
-
     MCObject * m_pObject;
     MCVector2d<float> m_contactPoint;
     MCVector2d<float> m_contactNormal;
     float m_interpenetrationDepth;
-    static MCRecycler<MCContact> m_recycler;
-    friend class MCRecycler<MCContact>;
 };
 
 #endif // MCCONTACT_HH
@@ -0,0 +1,126 @@
+// This file belongs to the "MiniCore" game engine.
+// Copyright (C) 2018 Jussi Lind <jussi.lind@iki.fi>
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+// MA  02110-1301, USA.
+//
+
+#include "mccontactarena.hh"
+#include "mcobject.hh"
+
+#include <cassert>
+
+std::atomic<unsigned int> MCContactArena::m_generationCounter(0);
+
+MCContactArena::MCContactArena()
+: m_generation(++m_generationCounter)
+{
+}
+
+bool MCContactArena::hasSpans(const MCObject & object) const
+{
+    return object.m_contactArenaGeneration == m_generation && object.m_firstContactSpan >= 0;
+}
+
+MCContact * MCContactArena::addContacts(MCObject & object, MCObject & otherObject, unsigned int count)
+{
+    const int index = static_cast<int>(m_spans.size());
+    const unsigned int begin = static_cast<unsigned int>(m_contacts.size());
+
+    const Span span = {&object, &otherObject, begin, begin + count, -1, false};
+    m_spans.push_back(span);
+    m_contacts.resize(begin + count);
+
+    // Append to the span list of the object
+    if (hasSpans(object))
+    {
+        m_spans[object.m_lastContactSpan].m_next = index;
+    }
+    else
+    {
+        object.m_contactArenaGeneration = m_generation;
+        object.m_firstContactSpan = index;
+    }
+
+    object.m_lastContactSpan = index;
+
+    return &m_contacts[begin];
+}
+
+int MCContactArena::firstSpan(const MCObject & object) const
+{
+    return hasSpans(object) ? object.m_firstContactSpan : -1;
+}
+
+const MCContactArena::Span & MCContactArena::span(int index) const
+{
+    assert(index >= 0 && index < static_cast<int>(m_spans.size()));
+    return m_spans[index];
+}
+
+const MCContact * MCContactArena::begin(const Span & span) const
+{
+    return m_contacts.data() + span.m_begin;
+}
+
+const MCContact * MCContactArena::end(const Span & span) const
+{
+    return m_contacts.data() + span.m_end;
+}
+
+void MCContactArena::deleteContacts(MCObject & object)
+{
+    for (int i = firstSpan(object); i >= 0; i = m_spans[i].m_next)
+    {
+        m_spans[i].m_isDeleted = true;
+    }
+}
+
+void MCContactArena::deleteContacts(MCObject & object, MCObject & otherObject)
+{
+    for (int i = firstSpan(object); i >= 0; i = m_spans[i].m_next)
+    {
+        if (m_spans[i].m_otherObject == &otherObject)
+        {
+            m_spans[i].m_isDeleted = true;
+        }
+    }
+}
+
+void MCContactArena::removeObject(MCObject & object)
+{
+    // Spans are always added for both objects of a pair, so the other
+    // objects having contacts with this object are found via its own spans.
+    for (int i = firstSpan(object); i >= 0; i = m_spans[i].m_next)
+    {
+        m_spans[i].m_isDeleted = true;
+        deleteContacts(*m_spans[i].m_otherObject, object);
+    }
+}
+
+void MCContactArena::reset()
+{
+    // The elements have no-op destructors, so clearing doesn't touch the memory.
+    m_contacts.clear();
+    m_spans.clear();
+
+    // Invalidates the span lists stored in the objects.
+    m_generation = ++m_generationCounter;
+}
+
+unsigned int MCContactArena::contactCount() const
+{
+    return static_cast<unsigned int>(m_contacts.size());
+}
@@ -0,0 +1,116 @@
+// This file belongs to the "MiniCore" game engine.
+// Copyright (C) 2018 Jussi Lind <jussi.lind@iki.fi>
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+// MA  02110-1301, USA.
+//
+
+#ifndef MCCONTACTARENA_HH
+#define MCCONTACTARENA_HH
+
+#include "mccontact.hh"
+#include "mcmacros.hh"
+
+#include <atomic>
+#include <vector>
+
+class MCObject;
+
+/*! \class MCContactArena
+ *  \brief Step-scoped storage for collision contacts.
+ *
+ *  Contacts are stored in a flat array. The contacts of an object with another object
+ *  found on one detection pass form a contiguous span. The spans of an object are linked
+ *  in the order they were added, and the list head is stored in MCObject.
+ *
+ *  Nothing is freed during a step: deleted spans are only flagged. MCWorld resets the
+ *  arena in O(1) at the end of each step, and the memory is reused on the next step. */
+class MCContactArena
+{
+public:
+
+    //! Contacts of m_object with m_otherObject.
+    struct Span
+    {
+        MCObject * m_object;
+
+        MCObject * m_otherObject;
+
+        //! Index of the first contact.
+        unsigned int m_begin;
+
+        //! Index after the last contact.
+        unsigned int m_end;
+
+        //! Index of the next span of m_object or -1.
+        int m_next;
+
+        bool m_isDeleted;
+    };
+
+    //! Constructor.
+    MCContactArena();
+
+    /*! Add a span of count contacts of object with otherObject. A span of
+     *  otherObject with object must be added as well.
+     *  \return pointer to the first contact of the span. The contacts must be initialized
+     *          with MCContact::init() before the next call. */
+    MCContact * addContacts(MCObject & object, MCObject & otherObject, unsigned int count);
+
+    //! \return index of the first span of the given object or -1 if it has no contacts.
+    int firstSpan(const MCObject & object) const;
+
+    //! \return the span of the given index.
+    const Span & span(int index) const;
+
+    //! \return the first contact of the given span.
+    const MCContact * begin(const Span & span) const;
+
+    //! \return pointer after the last contact of the given span.
+    const MCContact * end(const Span & span) const;
+
+    //! Delete current contacts of the given object.
+    void deleteContacts(MCObject & object);
+
+    //! Delete the contacts of the given object with otherObject.
+    void deleteContacts(MCObject & object, MCObject & otherObject);
+
+    //! Delete all contacts of the given object and all contacts of other objects with it.
+    void removeObject(MCObject & object);
+
+    //! Delete all contacts in O(1). The memory is kept for reuse.
+    void reset();
+
+    //! \return total number of contacts added since the last reset.
+    unsigned int contactCount() const;
+
+private:
+
+    bool hasSpans(const MCObject & object) const;
+
+    std::vector<MCContact> m_contacts;
+
+    std::vector<Span> m_spans;
+
+    unsigned int m_generation;
+
+    //! Generations are unique over all arenas, so stale list heads never match.
+    static std::atomic<unsigned int> m_generationCounter;
+
+    DISABLE_COPY(MCContactArena);
+    DISABLE_ASSI(MCContactArena);
+};
+
+#endif // MCCONTACTARENA_HH
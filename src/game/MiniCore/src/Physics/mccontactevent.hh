@@ -0,0 +1,77 @@
+// This file belongs to the "MiniCore" game engine.
+// Copyright (C) 2018 Jussi Lind <jussi.lind@iki.fi>
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+// MA  02110-1301, USA.
+//
+
+#ifndef MCCONTACTEVENT_HH
+#define MCCONTACTEVENT_HH
+
+#include "mcevent.hh"
+
+class MCObject;
+
+/*! \class MCContactEvent
+ *  \brief Event sent once per step for each pair of touching objects.
+ *
+ *  Unlike MCCollisionEvent, which is sent for every contact point on every
+ *  collision test, MCContactEvent tells whether the contact begun on this step,
+ *  still persists or has ended. Trigger objects are included.
+ */
+class MCContactEvent : public MCEvent
+{
+public:
+
+    enum class Type
+    {
+        Begin,
+        Persist,
+        End
+    };
+
+    /*! Constructor.
+     * \param otherObject The other object of the pair.
+     * \param type The contact state. */
+    MCContactEvent(MCObject & otherObject, Type type);
+
+    //! Destructor.
+    ~MCContactEvent();
+
+    //! Get the other object of the pair.
+    MCObject & otherObject() const;
+
+    //! Get the contact state.
+    Type type() const;
+
+    //! Return the typeId.
+    static unsigned int typeId();
+
+    //! \reimp
+    virtual unsigned int instanceTypeId() const;
+
+private:
+
+    DISABLE_COPY(MCContactEvent);
+    DISABLE_ASSI(MCContactEvent);
+
+    MCObject & m_otherObject;
+
+    Type m_type;
+
+    static unsigned int m_typeId;
+};
+
+#endif // MCCONTACTEVENT_HH
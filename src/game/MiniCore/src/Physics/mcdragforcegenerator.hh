@@ -44,6 +44,8 @@ private:
 
     DISABLE_COPY(MCDragForceGenerator);
     DISABLE_ASSI(MCDragForceGenerator);
+
+    friend class MCForceRegistry;
     float m_coeff1, m_coeff2;
 };
 
@@ -17,78 +17,679 @@
 // MA  02110-1301, USA.
 //
 
-#include "mcobject.hh"
 #include "mcforceregistry.hh"
+#include "mcdragforcegenerator.hh"
+#include "mcfrictiongenerator.hh"
+#include "mcgravitygenerator.hh"
+#include "mcobject.hh"
+#include "mcphysicscomponent.hh"
+#include "mcphysicsstate.hh"
+#include "mcstatebuffer.hh"
 
 #include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <limits>
+#include <typeinfo>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+namespace {
+
+#ifdef __SSE2__
+inline __m128 loadMask(const unsigned int * mask)
+{
+    return _mm_castsi128_ps(_mm_loadu_si128(reinterpret_cast<const __m128i *>(mask)));
+}
+
+inline __m128 abs(__m128 value)
+{
+    return _mm_andnot_ps(_mm_set1_ps(-0.0f), value);
+}
+
+inline __m128 negate(__m128 value)
+{
+    return _mm_xor_ps(_mm_set1_ps(-0.0f), value);
+}
+
+//! \return a where the mask is set and b elsewhere.
+inline __m128 select(__m128 mask, __m128 a, __m128 b)
+{
+    return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b));
+}
+#endif
+
+} // namespace
 
 MCForceRegistry::MCForceRegistry()
-: m_registryHash()
 {}
 
-void MCForceRegistry::update()
+MCForceRegistry::ObjectRecord & MCForceRegistry::objectRecord(MCObject & object)
+{
+    auto iter = m_objectIndices.find(&object);
+    if (iter != m_objectIndices.end())
+    {
+        return m_objectRecords[iter->second];
+    }
+
+    m_objectIndices[&object] = static_cast<unsigned int>(m_objectRecords.size());
+    m_objectRecords.push_back(ObjectRecord());
+    m_objectRecords.back().m_object = &object;
+    return m_objectRecords.back();
+}
+
+MCForceRegistry::Entry & MCForceRegistry::entry(const Binding & binding)
+{
+    switch (binding.m_type)
+    {
+    case Type::Friction:
+        return m_friction.m_entries[binding.m_index];
+    case Type::Drag:
+        return m_drag.m_entries[binding.m_index];
+    case Type::Gravity:
+        return m_gravity.m_entries[binding.m_index];
+    case Type::Generic:
+    default:
+        return m_generic.m_entries[binding.m_index];
+    }
+}
+
+template <typename Params>
+unsigned int MCForceRegistry::addEntry(Batch<Params> & batch, const Entry & entry, const Params & params)
 {
-    auto iter = m_registryHash.begin();
-    while (iter != m_registryHash.end())
+    batch.m_entries.push_back(entry);
+    batch.m_params.push_back(params);
+    return static_cast<unsigned int>(batch.m_entries.size()) - 1;
+}
+
+void MCForceRegistry::addForceGenerator(MCForceGeneratorPtr generator, MCObject & object)
+{
+    ObjectRecord & record = objectRecord(object);
+    for (auto && binding : record.m_bindings)
     {
-        Registry & registry = iter->second;
-        for (unsigned int i = 0; i < registry.size(); i++)
+        if (entry(binding).m_generator == generator)
         {
-            if (iter->first->index() != -1)
-            {
-                if (registry[i]->enabled())
-                {
-                    registry[i]->updateForce(*iter->first);
-                }
-            }
+            return;
         }
+    }
+
+    const Entry newEntry = {&object, generator, m_objectIndices[&object]};
 
-        iter++;
+    // Exact type match, because subclasses may override updateForce().
+    Binding binding;
+    const std::type_info & type = typeid(*generator);
+    if (type == typeid(MCFrictionGenerator))
+    {
+        const MCFrictionGenerator & friction = static_cast<const MCFrictionGenerator &>(*generator);
+        const FrictionParams params = {friction.m_coeffLinTot, friction.m_coeffRotTot};
+        binding.m_type = Type::Friction;
+        binding.m_index = addEntry(m_friction, newEntry, params);
+    }
+    else if (type == typeid(MCDragForceGenerator))
+    {
+        const MCDragForceGenerator & drag = static_cast<const MCDragForceGenerator &>(*generator);
+        const DragParams params = {drag.m_coeff1, drag.m_coeff2};
+        binding.m_type = Type::Drag;
+        binding.m_index = addEntry(m_drag, newEntry, params);
+    }
+    else if (type == typeid(MCGravityGenerator))
+    {
+        const MCGravityGenerator & gravity = static_cast<const MCGravityGenerator &>(*generator);
+        const GravityParams params = {gravity.m_g};
+        binding.m_type = Type::Gravity;
+        binding.m_index = addEntry(m_gravity, newEntry, params);
+    }
+    else
+    {
+        binding.m_type = Type::Generic;
+        binding.m_index = addEntry(m_generic, newEntry, GenericParams());
     }
+
+    record.m_bindings.push_back(binding);
 }
 
-void MCForceRegistry::addForceGenerator(MCForceGeneratorPtr generator, MCObject & object)
+void MCForceRegistry::addFriction(float coeffLin, float coeffRot, MCObject & object)
 {
-    MCForceRegistry::Registry & registry = m_registryHash[&object];
-    if (std::find(registry.begin(), registry.end(), generator) == registry.end())
+    // Use the gravity of the world the object is in
+    assert(object.world());
+    const MCWorld & world = *object.world();
+
+    FrictionParams params;
+    MCFrictionGenerator::totalCoefficients(coeffLin, coeffRot, world.gravity().k(), params.m_coeffLinTot, params.m_coeffRotTot);
+
+    ObjectRecord & record = objectRecord(object);
+    for (auto && binding : record.m_bindings)
     {
-        registry.push_back(generator);
+        if (binding.m_type == Type::Friction && !entry(binding).m_generator)
+        {
+            m_friction.m_params[binding.m_index] = params;
+            return;
+        }
     }
+
+    const Entry newEntry = {&object, MCForceGeneratorPtr(), m_objectIndices[&object]};
+    Binding binding;
+    binding.m_type = Type::Friction;
+    binding.m_index = addEntry(m_friction, newEntry, params);
+    record.m_bindings.push_back(binding);
 }
 
-void MCForceRegistry::removeForceGenerator(MCForceGeneratorPtr generator, MCObject & object)
+void MCForceRegistry::removeFriction(MCObject & object)
 {
-    auto iter = m_registryHash.find(&object);
-    if (iter != m_registryHash.end())
+    auto iter = m_objectIndices.find(&object);
+    if (iter != m_objectIndices.end())
     {
-        Registry & registry = iter->second;
-        for (unsigned int i = 0; i < registry.size(); i++)
+        const unsigned int objectIndex = iter->second;
+        const ObjectRecord & record = m_objectRecords[objectIndex];
+        for (unsigned int i = 0; i < record.m_bindings.size(); i++)
         {
-            if (registry[i] == generator && iter->first == &object)
+            if (record.m_bindings[i].m_type == Type::Friction && !entry(record.m_bindings[i]).m_generator)
             {
-                registry[i] = registry.back();
-                registry.pop_back();
+                removeBinding(objectIndex, i);
                 break;
             }
         }
+    }
+}
 
-        if (!registry.size())
+void MCForceRegistry::removeForceGenerator(MCForceGeneratorPtr generator, MCObject & object)
+{
+    auto iter = m_objectIndices.find(&object);
+    if (iter != m_objectIndices.end())
+    {
+        const unsigned int objectIndex = iter->second;
+        const ObjectRecord & record = m_objectRecords[objectIndex];
+        for (unsigned int i = 0; i < record.m_bindings.size(); i++)
         {
-            m_registryHash.erase(iter);
+            if (entry(record.m_bindings[i]).m_generator == generator)
+            {
+                removeBinding(objectIndex, i);
+                break;
+            }
         }
     }
 }
 
 void MCForceRegistry::removeForceGenerators(MCObject & object)
 {
-    auto iter = m_registryHash.find(&object);
-    if (iter != m_registryHash.end())
+    auto iter = m_objectIndices.find(&object);
+    if (iter != m_objectIndices.end())
+    {
+        // The record is removed with the last binding
+        const unsigned int objectIndex = iter->second;
+        for (size_t i = m_objectRecords[objectIndex].m_bindings.size(); i > 0; i--)
+        {
+            removeBinding(objectIndex, static_cast<unsigned int>(i) - 1);
+        }
+    }
+}
+
+void MCForceRegistry::removeBinding(unsigned int objectIndex, unsigned int bindingIndex)
+{
+    ObjectRecord & record = m_objectRecords[objectIndex];
+    const Binding binding = record.m_bindings[bindingIndex];
+
+    // Keep the order of the other bindings the same as with the old per-object vectors
+    record.m_bindings[bindingIndex] = record.m_bindings.back();
+    record.m_bindings.pop_back();
+
+    removeEntry(binding);
+
+    if (record.m_bindings.empty())
+    {
+        m_objectIndices.erase(record.m_object);
+
+        if (objectIndex + 1 < m_objectRecords.size())
+        {
+            record = std::move(m_objectRecords.back());
+            m_objectIndices[record.m_object] = objectIndex;
+            for (auto && movedBinding : record.m_bindings)
+            {
+                entry(movedBinding).m_objectIndex = objectIndex;
+            }
+        }
+
+        m_objectRecords.pop_back();
+    }
+}
+
+void MCForceRegistry::removeEntry(const Binding & binding)
+{
+    switch (binding.m_type)
+    {
+    case Type::Friction:
+        removeEntry(m_friction, binding.m_type, binding.m_index);
+        break;
+    case Type::Drag:
+        removeEntry(m_drag, binding.m_type, binding.m_index);
+        break;
+    case Type::Gravity:
+        removeEntry(m_gravity, binding.m_type, binding.m_index);
+        break;
+    case Type::Generic:
+        removeEntry(m_generic, binding.m_type, binding.m_index);
+        break;
+    }
+}
+
+template <typename Params>
+void MCForceRegistry::removeEntry(Batch<Params> & batch, Type type, unsigned int index)
+{
+    const unsigned int last = static_cast<unsigned int>(batch.m_entries.size()) - 1;
+    if (index != last)
+    {
+        batch.m_entries[index] = std::move(batch.m_entries[last]);
+        batch.m_params[index] = batch.m_params[last];
+        relinkEntry(type, last, index);
+    }
+
+    batch.m_entries.pop_back();
+    batch.m_params.pop_back();
+}
+
+void MCForceRegistry::relinkEntry(Type type, unsigned int oldIndex, unsigned int newIndex)
+{
+    Binding probe;
+    probe.m_type = type;
+    probe.m_index = newIndex;
+
+    ObjectRecord & record = m_objectRecords[entry(probe).m_objectIndex];
+    for (auto && binding : record.m_bindings)
+    {
+        if (binding.m_type == type && binding.m_index == oldIndex)
+        {
+            binding.m_index = newIndex;
+            return;
+        }
+    }
+
+    assert(false);
+}
+
+template <typename Params>
+size_t MCForceRegistry::gatherInputs(Batch<Params> & batch)
+{
+    const size_t count = batch.m_entries.size();
+    m_inputs.m_velocityX.resize(count);
+    m_inputs.m_velocityY.resize(count);
+    m_inputs.m_velocityZ.resize(count);
+    m_inputs.m_angularVelocity.resize(count);
+    m_inputs.m_mass.resize(count);
+    m_inputs.m_awakeMask.resize(count);
+    for (size_t i = 0; i < count; i++)
+    {
+        const MCPhysicsComponent & physicsComponent = batch.m_entries[i].m_object->physicsComponent();
+        const MCPhysicsState & state = *physicsComponent.m_state;
+        const int slot = physicsComponent.m_slot;
+        m_inputs.m_velocityX[i] = state.m_velocityX[slot];
+        m_inputs.m_velocityY[i] = state.m_velocityY[slot];
+        m_inputs.m_velocityZ[i] = state.m_velocityZ[slot];
+        m_inputs.m_angularVelocity[i] = state.m_angularVelocity[slot];
+        m_inputs.m_mass[i] = state.m_mass[slot];
+        m_inputs.m_awakeMask[i] = state.m_activeMask[slot];
+    }
+
+    batch.m_forceX.resize(count);
+    batch.m_forceY.resize(count);
+    batch.m_forceZ.resize(count);
+
+    return count;
+}
+
+void MCForceRegistry::computeFrictionForce(size_t index)
+{
+    // See MCFrictionGenerator::updateForce(). The operations are the same and
+    // in the same order, so that the results are bit-exact.
+    if (!m_inputs.m_awakeMask[index])
+    {
+        m_friction.m_forceX[index] = 0;
+        m_friction.m_forceY[index] = 0;
+        m_friction.m_forceZ[index] = 0;
+        m_frictionAngularImpulses[index] = 0;
+        return;
+    }
+
+    const FrictionParams & params = m_friction.m_params[index];
+    const MCVector3dF velocity(m_inputs.m_velocityX[index], m_inputs.m_velocityY[index], m_inputs.m_velocityZ[index]);
+    const float mass = m_inputs.m_mass[index];
+
+    // Simulated friction caused by linear motion.
+    const float length = velocity.lengthFast();
+    const MCVector2d<float> v(velocity.normalizedFast());
+    const float scale = length >= 1.0f ? 1.0f : length; // Multiplying by 1 is exact
+    const MCVector2d<float> force(-v * scale * params.m_coeffLinTot * mass);
+    m_friction.m_forceX[index] = force.i();
+    m_friction.m_forceY[index] = force.j();
+    m_friction.m_forceZ[index] = 0;
+
+    // Simulated friction caused by angular torque.
+    m_frictionAngularImpulses[index] = -m_inputs.m_angularVelocity[index] * params.m_coeffRotTot;
+}
+
+void MCForceRegistry::computeFrictionForces()
+{
+    const size_t count = gatherInputs(m_friction);
+    m_frictionAngularImpulses.resize(count);
+
+#ifdef __SSE2__
+    const size_t simdCount = count - count % 4;
+    computeFrictionForcesSse(simdCount);
+#else
+    const size_t simdCount = 0;
+#endif
+
+    for (size_t i = simdCount; i < count; i++)
+    {
+        computeFrictionForce(i);
+    }
+}
+
+void MCForceRegistry::computeDragForce(size_t index)
+{
+    // See MCDragForceGenerator::updateForce().
+    if (!m_inputs.m_awakeMask[index])
+    {
+        m_drag.m_forceX[index] = 0;
+        m_drag.m_forceY[index] = 0;
+        m_drag.m_forceZ[index] = 0;
+        return;
+    }
+
+    const DragParams & params = m_drag.m_params[index];
+
+    MCVector3d<float> force(m_inputs.m_velocityX[index], m_inputs.m_velocityY[index], m_inputs.m_velocityZ[index]);
+    float v = force.length();
+    v = params.m_coeff1 * v + params.m_coeff2 * v * v;
+    force.normalize();
+    force *= -v;
+    m_drag.m_forceX[index] = force.i();
+    m_drag.m_forceY[index] = force.j();
+    m_drag.m_forceZ[index] = force.k();
+}
+
+void MCForceRegistry::computeDragForces()
+{
+    const size_t count = gatherInputs(m_drag);
+
+#ifdef __SSE2__
+    const size_t simdCount = count - count % 4;
+    computeDragForcesSse(simdCount);
+#else
+    const size_t simdCount = 0;
+#endif
+
+    for (size_t i = simdCount; i < count; i++)
+    {
+        computeDragForce(i);
+    }
+}
+
+void MCForceRegistry::computeGravityForce(size_t index)
+{
+    // See MCGravityGenerator::updateForce().
+    const MCVector3dF & g = m_gravity.m_params[index].m_g;
+    const float mass = m_inputs.m_awakeMask[index] ? m_inputs.m_mass[index] : 0;
+
+    // G = m * g
+    m_gravity.m_forceX[index] = g.i() * mass;
+    m_gravity.m_forceY[index] = g.j() * mass;
+    m_gravity.m_forceZ[index] = g.k() * mass;
+}
+
+void MCForceRegistry::computeGravityForces()
+{
+    const size_t count = gatherInputs(m_gravity);
+
+#ifdef __SSE2__
+    const size_t simdCount = count - count % 4;
+    computeGravityForcesSse(simdCount);
+#else
+    const size_t simdCount = 0;
+#endif
+
+    for (size_t i = simdCount; i < count; i++)
+    {
+        computeGravityForce(i);
+    }
+}
+
+#ifdef __SSE2__
+void MCForceRegistry::computeFrictionForcesSse(size_t end)
+{
+    // Same operations as in computeFrictionForce(). Instead of branching, the operands
+    // are selected with masks, so that the results stay bit-exact.
+    const __m128 one = _mm_set1_ps(1.0f);
+    const __m128 two = _mm_set1_ps(2.0f);
+    const __m128 epsilon = _mm_set1_ps(std::numeric_limits<float>::epsilon());
+
+    for (size_t i = 0; i + 4 <= end; i += 4)
     {
-        m_registryHash.erase(iter);
+        const __m128 awake = loadMask(&m_inputs.m_awakeMask[i]);
+        const __m128 vx = _mm_loadu_ps(&m_inputs.m_velocityX[i]);
+        const __m128 vy = _mm_loadu_ps(&m_inputs.m_velocityY[i]);
+        const __m128 vz = _mm_loadu_ps(&m_inputs.m_velocityZ[i]);
+
+        // MCVector3d::lengthFast()
+        const __m128 ax = abs(vx);
+        const __m128 ay = abs(vy);
+        const __m128 az = abs(vz);
+        const __m128 lengthXY = _mm_sub_ps(_mm_add_ps(ax, ay), _mm_div_ps(_mm_min_ps(ax, ay), two));
+        const __m128 length = _mm_sub_ps(_mm_add_ps(lengthXY, az), _mm_div_ps(_mm_min_ps(lengthXY, az), two));
+
+        // MCVector3d::normalizedFast() returns a zero vector for a zero vector
+        const __m128 isZero = _mm_and_ps(_mm_and_ps(_mm_cmple_ps(ax, epsilon), _mm_cmple_ps(ay, epsilon)), _mm_cmple_ps(az, epsilon));
+        const __m128 divisor = select(isZero, one, length);
+        const __m128 nx = _mm_div_ps(_mm_andnot_ps(isZero, vx), divisor);
+        const __m128 ny = _mm_div_ps(_mm_andnot_ps(isZero, vy), divisor);
+
+        const __m128 scale = select(_mm_cmpge_ps(length, one), one, length);
+        const __m128 coeffLin = _mm_set_ps(
+            m_friction.m_params[i + 3].m_coeffLinTot, m_friction.m_params[i + 2].m_coeffLinTot,
+            m_friction.m_params[i + 1].m_coeffLinTot, m_friction.m_params[i].m_coeffLinTot);
+        const __m128 mass = _mm_loadu_ps(&m_inputs.m_mass[i]);
+
+        _mm_storeu_ps(&m_friction.m_forceX[i], _mm_and_ps(awake, _mm_mul_ps(_mm_mul_ps(_mm_mul_ps(negate(nx), scale), coeffLin), mass)));
+        _mm_storeu_ps(&m_friction.m_forceY[i], _mm_and_ps(awake, _mm_mul_ps(_mm_mul_ps(_mm_mul_ps(negate(ny), scale), coeffLin), mass)));
+        _mm_storeu_ps(&m_friction.m_forceZ[i], _mm_setzero_ps());
+
+        const __m128 coeffRot = _mm_set_ps(
+            m_friction.m_params[i + 3].m_coeffRotTot, m_friction.m_params[i + 2].m_coeffRotTot,
+            m_friction.m_params[i + 1].m_coeffRotTot, m_friction.m_params[i].m_coeffRotTot);
+        _mm_storeu_ps(&m_frictionAngularImpulses[i],
+            _mm_and_ps(awake, _mm_mul_ps(negate(_mm_loadu_ps(&m_inputs.m_angularVelocity[i])), coeffRot)));
+    }
+}
+
+void MCForceRegistry::computeDragForcesSse(size_t end)
+{
+    // Same operations as in computeDragForce().
+    const __m128 one = _mm_set1_ps(1.0f);
+    const __m128 epsilon = _mm_set1_ps(std::numeric_limits<float>::epsilon());
+
+    for (size_t i = 0; i + 4 <= end; i += 4)
+    {
+        const __m128 awake = loadMask(&m_inputs.m_awakeMask[i]);
+        const __m128 vx = _mm_loadu_ps(&m_inputs.m_velocityX[i]);
+        const __m128 vy = _mm_loadu_ps(&m_inputs.m_velocityY[i]);
+        const __m128 vz = _mm_loadu_ps(&m_inputs.m_velocityZ[i]);
+
+        const __m128 length = _mm_sqrt_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(vx, vx), _mm_mul_ps(vy, vy)), _mm_mul_ps(vz, vz)));
+        const __m128 coeff1 = _mm_set_ps(m_drag.m_params[i + 3].m_coeff1, m_drag.m_params[i + 2].m_coeff1,
+            m_drag.m_params[i + 1].m_coeff1, m_drag.m_params[i].m_coeff1);
+        const __m128 coeff2 = _mm_set_ps(m_drag.m_params[i + 3].m_coeff2, m_drag.m_params[i + 2].m_coeff2,
+            m_drag.m_params[i + 1].m_coeff2, m_drag.m_params[i].m_coeff2);
+        const __m128 v = negate(_mm_add_ps(_mm_mul_ps(coeff1, length), _mm_mul_ps(_mm_mul_ps(coeff2, length), length)));
+
+        // MCVector3d::normalize() doesn't touch a zero vector. Dividing by 1 is exact.
+        const __m128 isZero = _mm_and_ps(_mm_and_ps(_mm_cmple_ps(abs(vx), epsilon), _mm_cmple_ps(abs(vy), epsilon)), _mm_cmple_ps(abs(vz), epsilon));
+        const __m128 divisor = select(isZero, one, length);
+
+        _mm_storeu_ps(&m_drag.m_forceX[i], _mm_and_ps(awake, _mm_mul_ps(_mm_div_ps(vx, divisor), v)));
+        _mm_storeu_ps(&m_drag.m_forceY[i], _mm_and_ps(awake, _mm_mul_ps(_mm_div_ps(vy, divisor), v)));
+        _mm_storeu_ps(&m_drag.m_forceZ[i], _mm_and_ps(awake, _mm_mul_ps(_mm_div_ps(vz, divisor), v)));
+    }
+}
+
+void MCForceRegistry::computeGravityForcesSse(size_t end)
+{
+    // Same operations as in computeGravityForce().
+    for (size_t i = 0; i + 4 <= end; i += 4)
+    {
+        const __m128 mass = _mm_and_ps(loadMask(&m_inputs.m_awakeMask[i]), _mm_loadu_ps(&m_inputs.m_mass[i]));
+        const MCVector3dF & g0 = m_gravity.m_params[i].m_g;
+        const MCVector3dF & g1 = m_gravity.m_params[i + 1].m_g;
+        const MCVector3dF & g2 = m_gravity.m_params[i + 2].m_g;
+        const MCVector3dF & g3 = m_gravity.m_params[i + 3].m_g;
+        _mm_storeu_ps(&m_gravity.m_forceX[i], _mm_mul_ps(_mm_set_ps(g3.i(), g2.i(), g1.i(), g0.i()), mass));
+        _mm_storeu_ps(&m_gravity.m_forceY[i], _mm_mul_ps(_mm_set_ps(g3.j(), g2.j(), g1.j(), g0.j()), mass));
+        _mm_storeu_ps(&m_gravity.m_forceZ[i], _mm_mul_ps(_mm_set_ps(g3.k(), g2.k(), g1.k(), g0.k()), mass));
+    }
+}
+#endif
+
+void MCForceRegistry::applyBatchedForces(ObjectRecord & record)
+{
+    MCObject & object = *record.m_object;
+    if (object.index() == -1)
+    {
+        return;
+    }
+
+    MCPhysicsComponent & physicsComponent = object.physicsComponent();
+    for (auto && binding : record.m_bindings)
+    {
+        const Entry & bindingEntry = entry(binding);
+        if (bindingEntry.m_generator && !bindingEntry.m_generator->enabled())
+        {
+            continue;
+        }
+
+        switch (binding.m_type)
+        {
+        case Type::Friction:
+            physicsComponent.addForce(batchForce(m_friction, binding.m_index));
+            if (object.shape())
+            {
+                physicsComponent.addAngularImpulse(m_frictionAngularImpulses[binding.m_index]);
+            }
+            break;
+        case Type::Drag:
+            physicsComponent.addForce(batchForce(m_drag, binding.m_index));
+            break;
+        case Type::Gravity:
+            if (!physicsComponent.isStationary())
+            {
+                physicsComponent.addForce(batchForce(m_gravity, binding.m_index));
+            }
+            break;
+        case Type::Generic:
+            break;
+        }
+    }
+}
+
+void MCForceRegistry::applyGenericForces(ObjectRecord & record)
+{
+    MCObject & object = *record.m_object;
+    for (auto && binding : record.m_bindings)
+    {
+        // A generator may remove the object from the world
+        if (object.index() == -1)
+        {
+            return;
+        }
+
+        if (binding.m_type == Type::Generic)
+        {
+            const Entry & bindingEntry = entry(binding);
+            if (bindingEntry.m_generator->enabled())
+            {
+                bindingEntry.m_generator->updateForce(object);
+            }
+        }
+    }
+}
+
+void MCForceRegistry::update()
+{
+    // The built-in forces only depend on the state before the update, so they
+    // can be computed type by type before adding them to the objects. Generic
+    // generators run last, because they may also modify the velocities.
+    computeFrictionForces();
+    computeDragForces();
+    computeGravityForces();
+
+    for (auto && record : m_objectRecords)
+    {
+        applyBatchedForces(record);
+    }
+
+    if (!m_generic.m_entries.empty())
+    {
+        for (auto && record : m_objectRecords)
+        {
+            applyGenericForces(record);
+        }
     }
 }
 
 void MCForceRegistry::clear()
 {
-    m_registryHash.clear();
+    m_objectRecords.clear();
+    m_objectIndices.clear();
+    m_friction = Batch<FrictionParams>();
+    m_frictionAngularImpulses.clear();
+    m_drag = Batch<DragParams>();
+    m_gravity = Batch<GravityParams>();
+    m_generic = Batch<GenericParams>();
+}
+
+template <typename Params>
+void MCForceRegistry::saveEnableFlags(const Batch<Params> & batch, MCStateBuffer & state) const
+{
+    state.write(static_cast<unsigned int>(batch.m_entries.size()));
+    for (auto && entry : batch.m_entries)
+    {
+        state.write(entry.m_generator ? entry.m_generator->enabled() : true);
+    }
+}
+
+template <typename Params>
+void MCForceRegistry::restoreEnableFlags(Batch<Params> & batch, MCStateBuffer & state)
+{
+    unsigned int entryCount = 0;
+    state.read(entryCount);
+    if (entryCount != batch.m_entries.size())
+    {
+        state.invalidate();
+        return;
+    }
+
+    for (auto && entry : batch.m_entries)
+    {
+        bool enabled = true;
+        state.read(enabled);
+        if (entry.m_generator)
+        {
+            entry.m_generator->enable(enabled);
+        }
+    }
+}
+
+void MCForceRegistry::saveState(MCStateBuffer & state) const
+{
+    saveEnableFlags(m_friction, state);
+    saveEnableFlags(m_drag, state);
+    saveEnableFlags(m_gravity, state);
+    saveEnableFlags(m_generic, state);
+}
+
+void MCForceRegistry::restoreState(MCStateBuffer & state)
+{
+    restoreEnableFlags(m_friction, state);
+    restoreEnableFlags(m_drag, state);
+    restoreEnableFlags(m_gravity, state);
+    restoreEnableFlags(m_generic, state);
 }
@@ -22,16 +22,29 @@
 
 #include "mcmacros.hh"
 #include "mcforcegenerator.hh"
+#include "mcvector3d.hh"
 
-#include <map>
 #include <memory>
-#include <set>
+#include <unordered_map>
 #include <vector>
 
 class MCObject;
+class MCStateBuffer;
 
 /*! \class MCForceRegistry
  *  \brief MCForceRegistry stores object-force -pairs
+ *
+ *  The pairs are stored densely and grouped by the generator type. MCFrictionGenerator,
+ *  MCDragForceGenerator and MCGravityGenerator are not called via updateForce(): the
+ *  velocities and masses are gathered from MCPhysicsState and the forces are computed
+ *  type by type in tight loops over the gathered arrays. The forces are then added to
+ *  each object in the order the generators were added to it.
+ *
+ *  Other generators are called via updateForce() after the built-in forces of all
+ *  objects have been added, so the built-in forces always depend only on the state
+ *  before update(), even if another generator modifies the velocity. The result is
+ *  exactly the same as calling updateForce() first for the built-in generators and
+ *  then for the other generators of each object in the order they were added.
  */
 class MCForceRegistry
 {
@@ -45,6 +58,18 @@ public:
      * \param object Target object. */
     void addForceGenerator(MCForceGeneratorPtr generator, MCObject & object);
 
+    /*! Add friction to given object without a generator object. This works like
+     *  adding an MCFrictionGenerator, but can't be disabled. Replaces the friction
+     *  previously added with this method. The object must be in a world, because
+     *  the gravity of that world is used.
+     * \param coeffLin Linear friction coefficient.
+     * \param coeffRot Rotational friction coefficient.
+     * \param object Target object. */
+    void addFriction(float coeffLin, float coeffRot, MCObject & object);
+
+    //! Remove the friction added with addFriction().
+    void removeFriction(MCObject & object);
+
     /*! Remove given force generator to given object
      * \param generator Force generator to be matched.
      * \param object Object to be matched */
@@ -60,15 +85,189 @@ public:
     //! Clear registry
     void clear();
 
+    /*! Save the enable flags of the force generators into the given buffer.
+     *  The generators themselves are not saved. */
+    void saveState(MCStateBuffer & state) const;
+
+    /*! Restore the enable flags saved with saveState(). The same generators
+     *  must be registered as when the state was saved. */
+    void restoreState(MCStateBuffer & state);
+
 private:
 
     DISABLE_COPY(MCForceRegistry);
     DISABLE_ASSI(MCForceRegistry);
 
-    // Prefer map and set here for iteration performance.
-    typedef std::vector<MCForceGeneratorPtr> Registry;
-    typedef std::map<MCObject *, Registry> RegistryHash;
-    RegistryHash m_registryHash;
+    enum class Type
+    {
+        Friction,
+        Drag,
+        Gravity,
+        Generic
+    };
+
+    //! Generator of an object. Index points to the batch of the type.
+    struct Binding
+    {
+        Type m_type;
+
+        unsigned int m_index;
+    };
+
+    //! Generators of an object in the order they were added.
+    struct ObjectRecord
+    {
+        MCObject * m_object;
+
+        std::vector<Binding> m_bindings;
+    };
+
+    struct Entry
+    {
+        MCObject * m_object;
+
+        //! Null for the frictions added with addFriction().
+        MCForceGeneratorPtr m_generator;
+
+        //! Index of the ObjectRecord of m_object.
+        unsigned int m_objectIndex;
+    };
+
+    struct FrictionParams
+    {
+        float m_coeffLinTot;
+
+        float m_coeffRotTot;
+    };
+
+    struct DragParams
+    {
+        float m_coeff1;
+
+        float m_coeff2;
+    };
+
+    struct GravityParams
+    {
+        MCVector3dF m_g;
+    };
+
+    struct GenericParams
+    {
+    };
+
+    //! Motion state of the entries of a batch gathered from MCPhysicsState.
+    struct Inputs
+    {
+        std::vector<float> m_velocityX;
+
+        std::vector<float> m_velocityY;
+
+        std::vector<float> m_velocityZ;
+
+        std::vector<float> m_angularVelocity;
+
+        std::vector<float> m_mass;
+
+        //! All bits set if the object is awake. Sleeping and stationary objects get zero forces.
+        std::vector<unsigned int> m_awakeMask;
+    };
+
+    //! Entries and params of one generator type and the forces computed by update().
+    template <typename Params>
+    struct Batch
+    {
+        std::vector<Entry> m_entries;
+
+        std::vector<Params> m_params;
+
+        std::vector<float> m_forceX;
+
+        std::vector<float> m_forceY;
+
+        std::vector<float> m_forceZ;
+    };
+
+    ObjectRecord & objectRecord(MCObject & object);
+
+    Entry & entry(const Binding & binding);
+
+
+    //! Remove the binding at given index of the object record.
+    void removeBinding(unsigned int objectIndex, unsigned int bindingIndex);
+
+    //! Swap-remove the entry of the binding from its batch.
+    void removeEntry(const Binding & binding);
+
+    template <typename Params>
+    unsigned int addEntry(Batch<Params> & batch, const Entry & entry, const Params & params);
+
+    template <typename Params>
+    void removeEntry(Batch<Params> & batch, Type type, unsigned int index);
+
+    //! Update the binding that points to the entry moved from oldIndex.
+    void relinkEntry(Type type, unsigned int oldIndex, unsigned int newIndex);
+
+    //! Gather the motion state of the objects of the given entries into m_inputs and
+    //! resize the force arrays of the batch. \return number of entries.
+    template <typename Params>
+    size_t gatherInputs(Batch<Params> & batch);
+
+    void computeFrictionForces();
+
+    //! Scalar version of computeFrictionForces() for one entry.
+    void computeFrictionForce(size_t index);
+
+    void computeFrictionForcesSse(size_t end);
+
+    void computeDragForces();
+
+    //! Scalar version of computeDragForces() for one entry.
+    void computeDragForce(size_t index);
+
+    void computeDragForcesSse(size_t end);
+
+    void computeGravityForces();
+
+    //! Scalar version of computeGravityForces() for one entry.
+    void computeGravityForce(size_t index);
+
+    void computeGravityForcesSse(size_t end);
+
+    template <typename Params>
+    MCVector3dF batchForce(const Batch<Params> & batch, unsigned int index) const
+    {
+        return MCVector3dF(batch.m_forceX[index], batch.m_forceY[index], batch.m_forceZ[index]);
+    }
+
+    //! Add the forces computed by the batches to the object of the record.
+    void applyBatchedForces(ObjectRecord & record);
+
+    //! Call updateForce() of the generic generators of the record.
+    void applyGenericForces(ObjectRecord & record);
+
+    template <typename Params>
+    void saveEnableFlags(const Batch<Params> & batch, MCStateBuffer & state) const;
+
+    template <typename Params>
+    void restoreEnableFlags(Batch<Params> & batch, MCStateBuffer & state);
+
+    std::vector<ObjectRecord> m_objectRecords;
+
+    std::unordered_map<MCObject *, unsigned int> m_objectIndices;
+
+    Inputs m_inputs;
+
+    Batch<FrictionParams> m_friction;
+
+    //! Angular impulses computed by computeFrictionForces().
+    std::vector<float> m_frictionAngularImpulses;
+
+    Batch<DragParams> m_drag;
+
+    Batch<GravityParams> m_gravity;
+
+    Batch<GenericParams> m_generic;
 };
 
 #endif // MCFORCEREGISTRY_HH
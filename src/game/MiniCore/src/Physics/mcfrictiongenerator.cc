@@ -27,10 +27,16 @@
 
 static const float ROTATION_DECAY = 0.01f;
 
-MCFrictionGenerator::MCFrictionGenerator(float coeffLin, float coeffRot)
-    : m_coeffLinTot(std::fabs(coeffLin * MCWorld::instance().gravity().k()))
-    , m_coeffRotTot(std::fabs(coeffRot * MCWorld::instance().gravity().k() * ROTATION_DECAY))
-{}
+MCFrictionGenerator::MCFrictionGenerator(float coeffLin, float coeffRot, const MCWorld & world)
+{
+    totalCoefficients(coeffLin, coeffRot, world.gravity().k(), m_coeffLinTot, m_coeffRotTot);
+}
+
+void MCFrictionGenerator::totalCoefficients(float coeffLin, float coeffRot, float gravity, float & coeffLinTot, float & coeffRotTot)
+{
+    coeffLinTot = std::fabs(coeffLin * gravity);
+    coeffRotTot = std::fabs(coeffRot * gravity * ROTATION_DECAY);
+}
 
 void MCFrictionGenerator::updateForce(MCObject & object)
 {
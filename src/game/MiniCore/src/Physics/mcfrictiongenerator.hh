@@ -42,8 +42,9 @@ public:
 
     /*! Constructor.
      * \param coeffLin Linear friction coefficient.
-     * \param coeffRot Rotational friction coefficient. */
-    explicit MCFrictionGenerator(float coeffLin, float coeffRot);
+     * \param coeffRot Rotational friction coefficient.
+     * \param world The world whose gravity is used. */
+    MCFrictionGenerator(float coeffLin, float coeffRot, const MCWorld & world);
 
     //! Destructor.
     virtual ~MCFrictionGenerator();
@@ -51,11 +52,18 @@ public:
     //! \reimp
     virtual void updateForce(MCObject & object) override;
 
+    /*! Compute the total coefficients used by updateForce(). MCForceRegistry uses
+     *  this for frictions that are added without a generator object.
+     *  \param gravity Z-component of the gravity. */
+    static void totalCoefficients(float coeffLin, float coeffRot, float gravity, float & coeffLinTot, float & coeffRotTot);
+
 private:
 
     DISABLE_COPY(MCFrictionGenerator);
     DISABLE_ASSI(MCFrictionGenerator);
 
+    friend class MCForceRegistry;
+
     float m_coeffLinTot;
 
     float m_coeffRotTot;
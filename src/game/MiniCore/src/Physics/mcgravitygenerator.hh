@@ -44,6 +44,8 @@ private:
 
     DISABLE_COPY(MCGravityGenerator);
     DISABLE_ASSI(MCGravityGenerator);
+
+    friend class MCForceRegistry;
     MCVector3d<float> m_g;
 };
 
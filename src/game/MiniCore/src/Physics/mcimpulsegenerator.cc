@@ -19,20 +19,29 @@
 
 #include "mcimpulsegenerator.hh"
 #include "mccontact.hh"
+#include "mccontactarena.hh"
 #include "mcobject.hh"
 #include "mcphysicscomponent.hh"
 #include "mcmathutil.hh"
 #include "mcshape.hh"
 
+#include <algorithm>
+
 MCImpulseGenerator::MCImpulseGenerator()
+    : m_metersPerUnit(1.0f)
 {}
 
-MCContact * MCImpulseGenerator::getDeepestInterpenetration(
-    const std::vector<MCContact *> & contacts)
+void MCImpulseGenerator::setMetersPerUnit(float metersPerUnit)
+{
+    m_metersPerUnit = metersPerUnit;
+}
+
+const MCContact * MCImpulseGenerator::getDeepestInterpenetration(
+    const MCContact * begin, const MCContact * end)
 {
     float maxDepth = 0;
-    MCContact * bestContact = nullptr;
-    for (MCContact * contact : contacts)
+    const MCContact * bestContact = nullptr;
+    for (const MCContact * contact = begin; contact != end; contact++)
     {
         if (contact->interpenetrationDepth() > maxDepth)
         {
@@ -43,6 +52,29 @@ MCContact * MCImpulseGenerator::getDeepestInterpenetration(
     return bestContact;
 }
 
+const MCContact * MCImpulseGenerator::getDeepestInterpenetration(
+    const MCContactArena & contactArena, int firstSpan, const MCObject & otherObject)
+{
+    // The grid reports a pair in both orders, so the contacts with the same
+    // object may be split over several spans.
+    float maxDepth = 0;
+    const MCContact * bestContact = nullptr;
+    for (int i = firstSpan; i >= 0; i = contactArena.span(i).m_next)
+    {
+        const MCContactArena::Span & span = contactArena.span(i);
+        if (!span.m_isDeleted && span.m_otherObject == &otherObject)
+        {
+            const MCContact * contact = getDeepestInterpenetration(contactArena.begin(span), contactArena.end(span));
+            if (contact && contact->interpenetrationDepth() > maxDepth)
+            {
+                maxDepth = contact->interpenetrationDepth();
+                bestContact = contact;
+            }
+        }
+    }
+    return bestContact;
+}
+
 void MCImpulseGenerator::displace(
      MCObject & pa, MCObject & pb, const MCVector3dF & displacement)
 {
@@ -53,6 +85,8 @@ void MCImpulseGenerator::displace(
         const float massScaling = invMassA / (invMassA + invMassB);
 
         pa.displace(displacement * massScaling);
+
+        m_displacedObjects.push_back(&pa);
     }
 }
 
@@ -74,21 +108,27 @@ void MCImpulseGenerator::generateImpulsesFromContact(
         pa.physicsComponent().addImpulse(linearImpulse * effRestitution * massScaling, true);
 
         // Angular component
-        const MCVector3dF armA = (contactPoint - pa.location()) * MCWorld::metersPerUnit();
+        const MCVector3dF armA = (contactPoint - pa.location()) * m_metersPerUnit;
         const MCVector3dF rotationalImpulse = linearImpulse % armA;
         const float calibration = 0.5;
         pa.physicsComponent().addAngularImpulse(-rotationalImpulse.k() * effRestitution * massScaling * calibration, true);
     }
 }
 
-void MCImpulseGenerator::resolvePositions(std::vector<MCObject *> & objs, float accuracy)
+float MCImpulseGenerator::resolvePositions(std::vector<MCObject *> & objs, MCContactArena & contactArena, float accuracy)
 {
+    float maxDepth = 0;
     for (MCObject * object : objs)
     {
-        auto iter(object->contacts().begin());
-        for (; iter != object->contacts().end(); iter++)
+        for (int i = contactArena.firstSpan(*object); i >= 0; i = contactArena.span(i).m_next)
         {
-            const MCContact * contact = getDeepestInterpenetration(iter->second);
+            const MCContactArena::Span & span = contactArena.span(i);
+            if (span.m_isDeleted)
+            {
+                continue;
+            }
+
+            const MCContact * contact = getDeepestInterpenetration(contactArena, i, *span.m_otherObject);
             if (contact)
             {
                 MCObject & pa(*object);
@@ -97,26 +137,45 @@ void MCImpulseGenerator::resolvePositions(std::vector<MCObject *> & objs, float
                 const MCVector3dF displacement(
                     contact->contactNormal() * contact->interpenetrationDepth() * accuracy);
 
+                maxDepth = std::max(maxDepth, contact->interpenetrationDepth());
+
                 displace(pa, pb, displacement);
                 displace(pb, pa, -displacement);
 
-                pb.deleteContacts(pa);
-                pa.deleteContacts(pb);
+                contactArena.deleteContacts(pb, pa);
+                contactArena.deleteContacts(pa, pb);
             }
         }
 
-        object->deleteContacts();
+        contactArena.deleteContacts(*object);
     }
+
+    return maxDepth;
 }
 
-void MCImpulseGenerator::generateImpulsesFromDeepestContacts(std::vector<MCObject *> & objs)
+const std::vector<MCObject *> & MCImpulseGenerator::displacedObjects() const
+{
+    return m_displacedObjects;
+}
+
+void MCImpulseGenerator::clearDisplacedObjects()
+{
+    m_displacedObjects.clear();
+}
+
+void MCImpulseGenerator::generateImpulsesFromDeepestContacts(std::vector<MCObject *> & objs, MCContactArena & contactArena)
 {
     for (MCObject * object : objs)
     {
-        auto iter(object->contacts().begin());
-        for (; iter != object->contacts().end(); iter++)
+        for (int i = contactArena.firstSpan(*object); i >= 0; i = contactArena.span(i).m_next)
         {
-            const MCContact * contact = getDeepestInterpenetration(iter->second);
+            const MCContactArena::Span & span = contactArena.span(i);
+            if (span.m_isDeleted)
+            {
+                continue;
+            }
+
+            const MCContact * contact = getDeepestInterpenetration(contactArena, i, *span.m_otherObject);
             if (contact)
             {
                 MCObject & pa(*object);
@@ -139,12 +198,12 @@ void MCImpulseGenerator::generateImpulsesFromDeepestContacts(std::vector<MCObjec
                 }
 
                 // Remove contact with pa from pb, because it was already handled here.
-                pb.deleteContacts(pa);
+                contactArena.deleteContacts(pb, pa);
 
                 break;
             }
         }
 
-        object->deleteContacts();
+        contactArena.deleteContacts(*object);
     }
 }
@@ -27,6 +27,7 @@
 
 class MCObject;
 class MCContact;
+class MCContactArena;
 
 //! Generates impulses due to detected collisions.
 class MCImpulseGenerator
@@ -39,13 +40,24 @@ public:
     //! Destructor.
     ~MCImpulseGenerator() {};
 
+    //! Set how many meters equal one unit. Used to scale the contact arms.
+    void setMetersPerUnit(float metersPerUnit);
+
     //! Generate impulses to the given objects according to current contacts.
     //! Delete contacts.
-    void generateImpulsesFromDeepestContacts(std::vector<MCObject *> & objs);
+    void generateImpulsesFromDeepestContacts(std::vector<MCObject *> & objs, MCContactArena & contactArena);
 
     //! Resolve positions of the given objects according to current contacts.
     //! Delete contacts.
-    void resolvePositions(std::vector<MCObject *> & objs, float accuracy);
+    //! \return the deepest interpenetration that was resolved.
+    float resolvePositions(std::vector<MCObject *> & objs, MCContactArena & contactArena, float accuracy);
+
+    //! \return objects displaced by resolvePositions() since the last call to clearDisplacedObjects().
+    //! An object may be listed more than once.
+    const std::vector<MCObject *> & displacedObjects() const;
+
+    //! Clear the list of displaced objects.
+    void clearDisplacedObjects();
 
 private:
 
@@ -56,7 +68,15 @@ private:
 
     void displace(MCObject & pa, MCObject & pb, const MCVector3dF & displacement);
 
-    MCContact * getDeepestInterpenetration(const std::vector<MCContact *> & contacts);
+    const MCContact * getDeepestInterpenetration(const MCContact * begin, const MCContact * end);
+
+    //! \return the deepest contact with otherObject over the live spans starting from firstSpan.
+    const MCContact * getDeepestInterpenetration(
+        const MCContactArena & contactArena, int firstSpan, const MCObject & otherObject);
+
+    float m_metersPerUnit;
+
+    std::vector<MCObject *> m_displacedObjects;
 };
 
 #endif // MCIMPULSEGENERATOR_HH
@@ -0,0 +1,352 @@
+// This file belongs to the "MiniCore" game engine.
+// Copyright (C) 2018 Jussi Lind <jussi.lind@iki.fi>
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+// MA  02110-1301, USA.
+//
+
+#include "mcislandmanager.hh"
+#include "mcobject.hh"
+#include "mcpaircache.hh"
+#include "mcphysicscomponent.hh"
+#include "mcstatebuffer.hh"
+
+#include <algorithm>
+#include <cassert>
+
+MCIslandManager::MCIslandManager()
+: m_sleepStepCount(2)
+, m_objectCount(0)
+, m_wokenIslandCount(0)
+{
+}
+
+void MCIslandManager::setSleepStepCount(unsigned int steps)
+{
+    m_sleepStepCount = steps;
+}
+
+unsigned int MCIslandManager::sleepStepCount() const
+{
+    return m_sleepStepCount;
+}
+
+int MCIslandManager::node(MCObject & object) const
+{
+    if (object.isTriggerObject())
+    {
+        return -1;
+    }
+
+    const MCPhysicsComponent & physicsComponent = object.physicsComponent();
+    if (physicsComponent.isStationary())
+    {
+        return -1;
+    }
+
+    if (physicsComponent.isSleeping())
+    {
+        // Bodies put to sleep by other means act like stationary objects
+        return physicsComponent.m_island >= 0 ? m_objectCount + physicsComponent.m_island : -1;
+    }
+
+    const int index = object.index();
+    return index >= 0 && index < m_objectCount ? index : -1;
+}
+
+int MCIslandManager::find(int node)
+{
+    // Path halving
+    while (m_parents[node] != node)
+    {
+        m_parents[node] = m_parents[m_parents[node]];
+        node = m_parents[node];
+    }
+    return node;
+}
+
+void MCIslandManager::unite(int node1, int node2)
+{
+    node1 = find(node1);
+    node2 = find(node2);
+    if (node1 != node2)
+    {
+        // Keep the smaller index as the root so that the result doesn't depend on the pair order
+        const int root = std::min(node1, node2);
+        const int child = std::max(node1, node2);
+        m_parents[child] = root;
+        m_sizes[root] += m_sizes[child];
+        m_isResting[root] &= m_isResting[child];
+    }
+}
+
+bool MCIslandManager::isResting(const MCPhysicsComponent & physicsComponent) const
+{
+    return physicsComponent.isResting(static_cast<int>(m_sleepStepCount));
+}
+
+int MCIslandManager::allocateIsland()
+{
+    m_stats.m_sleepingIslandCount++;
+
+    if (!m_freeIslands.empty())
+    {
+        const int island = m_freeIslands.back();
+        m_freeIslands.pop_back();
+        return island;
+    }
+
+    m_sleepingIslands.push_back(std::vector<MCObject *>());
+    return static_cast<int>(m_sleepingIslands.size()) - 1;
+}
+
+void MCIslandManager::freeIsland(int island)
+{
+    assert(m_sleepingIslands[island].empty());
+
+    m_stats.m_sleepingIslandCount--;
+    m_freeIslands.push_back(island);
+}
+
+void MCIslandManager::mergeIsland(int source, int target)
+{
+    std::vector<MCObject *> & sourceObjects = m_sleepingIslands[source];
+    std::vector<MCObject *> & targetObjects = m_sleepingIslands[target];
+    for (MCObject * object : sourceObjects)
+    {
+        object->physicsComponent().m_island = target;
+        targetObjects.push_back(object);
+    }
+
+    sourceObjects.clear();
+    freeIsland(source);
+}
+
+void MCIslandManager::update(const std::vector<MCObject *> & objects, const MCPairCache & pairCache)
+{
+    m_stats.m_islandCount = 0;
+    m_stats.m_largestIslandSize = 0;
+    m_stats.m_fellAsleepCount = 0;
+    m_stats.m_wokenIslandCount = m_wokenIslandCount;
+    m_wokenIslandCount = 0;
+
+    // Awake objects are nodes [0, objectCount) and sleeping islands the nodes after them.
+    // Sizes and resting flags are kept up to date for the roots while uniting.
+    m_objectCount = static_cast<int>(objects.size());
+    const int nodeCount = m_objectCount + static_cast<int>(m_sleepingIslands.size());
+    m_parents.resize(nodeCount);
+    m_isResting.resize(nodeCount);
+    m_sizes.resize(nodeCount);
+
+    bool hasRestingObjects = false;
+    for (int i = 0; i < m_objectCount; i++)
+    {
+        m_parents[i] = i;
+        if (node(*objects[i]) == i)
+        {
+            m_sizes[i] = 1;
+            m_isResting[i] = isResting(objects[i]->physicsComponent());
+            hasRestingObjects |= m_isResting[i];
+        }
+        else
+        {
+            m_sizes[i] = 0;
+            m_isResting[i] = 0;
+        }
+    }
+
+    for (int i = m_objectCount; i < nodeCount; i++)
+    {
+        m_parents[i] = i;
+        m_sizes[i] = 0;
+        m_isResting[i] = 1;
+    }
+
+    pairCache.forEachPair([this] (MCObject & object1, MCObject & object2) {
+        const int node1 = node(object1);
+        const int node2 = node(object2);
+        if (node1 >= 0 && node2 >= 0)
+        {
+            unite(node1, node2);
+        }
+    });
+
+    for (int i = 0; i < nodeCount; i++)
+    {
+        if (m_parents[i] == i && m_sizes[i])
+        {
+            m_stats.m_islandCount++;
+            m_stats.m_largestIslandSize = std::max(m_stats.m_largestIslandSize, m_sizes[i]);
+        }
+    }
+
+    if (!hasRestingObjects)
+    {
+        return;
+    }
+
+    m_targets.assign(nodeCount, -1);
+
+    // Sleeping islands touched by a resting island are merged with it
+    for (int island = 0; island < static_cast<int>(m_sleepingIslands.size()); island++)
+    {
+        const int root = find(m_objectCount + island);
+        if (!m_sleepingIslands[island].empty() && m_sizes[root] && m_isResting[root])
+        {
+            if (m_targets[root] < 0)
+            {
+                m_targets[root] = island;
+            }
+            else
+            {
+                mergeIsland(island, m_targets[root]);
+            }
+        }
+    }
+
+    m_fallingAsleep.clear();
+    for (int i = 0; i < m_objectCount; i++)
+    {
+        // Objects that are not in any island are roots that are not resting
+        const int root = find(i);
+        if (m_isResting[root])
+        {
+            if (m_targets[root] < 0)
+            {
+                m_targets[root] = allocateIsland();
+            }
+
+            objects[i]->physicsComponent().m_island = m_targets[root];
+            m_sleepingIslands[m_targets[root]].push_back(objects[i]);
+            m_fallingAsleep.push_back(objects[i]);
+        }
+    }
+
+    // This modifies the object vector, so it's done only after the islands are complete
+    for (MCObject * object : m_fallingAsleep)
+    {
+        object->physicsComponent().toggleSleep(true);
+        object->physicsComponent().reset();
+    }
+
+    m_stats.m_fellAsleepCount = static_cast<unsigned int>(m_fallingAsleep.size());
+    m_stats.m_sleepingObjectCount += m_stats.m_fellAsleepCount;
+}
+
+void MCIslandManager::wakeIsland(int island)
+{
+    assert(island >= 0 && island < static_cast<int>(m_sleepingIslands.size()));
+
+    // Detach the bodies first, so that waking them up doesn't recurse back here
+    std::vector<MCObject *> objects;
+    objects.swap(m_sleepingIslands[island]);
+    for (MCObject * object : objects)
+    {
+        object->physicsComponent().m_island = -1;
+    }
+
+    freeIsland(island);
+    m_stats.m_sleepingObjectCount -= static_cast<unsigned int>(objects.size());
+    m_wokenIslandCount++;
+
+    for (MCObject * object : objects)
+    {
+        object->physicsComponent().toggleSleep(false);
+    }
+}
+
+void MCIslandManager::wakeAll()
+{
+    for (int island = 0; island < static_cast<int>(m_sleepingIslands.size()); island++)
+    {
+        if (!m_sleepingIslands[island].empty())
+        {
+            wakeIsland(island);
+        }
+    }
+}
+
+void MCIslandManager::removeObject(MCObject & object)
+{
+    MCPhysicsComponent & physicsComponent = object.physicsComponent();
+    const int island = physicsComponent.m_island;
+    if (island >= 0)
+    {
+        std::vector<MCObject *> & objects = m_sleepingIslands[island];
+        auto iter = std::find(objects.begin(), objects.end(), &object);
+        assert(iter != objects.end());
+        *iter = objects.back();
+        objects.pop_back();
+
+        physicsComponent.m_island = -1;
+        m_stats.m_sleepingObjectCount--;
+
+        if (objects.empty())
+        {
+            freeIsland(island);
+        }
+    }
+}
+
+void MCIslandManager::clear()
+{
+    for (auto && objects : m_sleepingIslands)
+    {
+        for (MCObject * object : objects)
+        {
+            object->physicsComponent().m_island = -1;
+        }
+    }
+
+    m_sleepingIslands.clear();
+    m_freeIslands.clear();
+    m_wokenIslandCount = 0;
+    m_stats = Stats();
+}
+
+const MCIslandManager::Stats & MCIslandManager::stats() const
+{
+    return m_stats;
+}
+
+void MCIslandManager::saveState(MCStateBuffer & state) const
+{
+    state.write(static_cast<unsigned int>(m_sleepingIslands.size()));
+    for (auto && objects : m_sleepingIslands)
+    {
+        state.writeVector(objects);
+    }
+
+    state.writeVector(m_freeIslands);
+    state.write(m_wokenIslandCount);
+    state.write(m_stats);
+}
+
+void MCIslandManager::restoreState(MCStateBuffer & state)
+{
+    unsigned int islandCount = 0;
+    state.read(islandCount);
+
+    // Keep the capacities of the islands
+    m_sleepingIslands.resize(islandCount);
+    for (auto && objects : m_sleepingIslands)
+    {
+        state.readVector(objects);
+    }
+
+    state.readVector(m_freeIslands);
+    state.read(m_wokenIslandCount);
+    state.read(m_stats);
+}
@@ -0,0 +1,156 @@
+// This file belongs to the "MiniCore" game engine.
+// Copyright (C) 2018 Jussi Lind <jussi.lind@iki.fi>
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+// MA  02110-1301, USA.
+//
+
+#ifndef MCISLANDMANAGER_HH
+#define MCISLANDMANAGER_HH
+
+#include "mcmacros.hh"
+
+#include <vector>
+
+class MCObject;
+class MCPairCache;
+class MCPhysicsComponent;
+class MCStateBuffer;
+
+/*! \class MCIslandManager
+ *  \brief Puts groups of touching bodies to sleep and wakes them up together.
+ *
+ *  On each step the awake bodies are grouped into islands by the pairs that touched
+ *  on that step. Stationary objects and trigger objects don't connect islands. An
+ *  island is put to sleep when all of its bodies have been below their sleep limits
+ *  for sleepStepCount() steps. A sleeping body that is touched by a resting island
+ *  joins that island, and waking up any body of a sleeping island wakes up the
+ *  whole island.
+ *
+ *  MCWorld owns the island manager. */
+class MCIslandManager
+{
+public:
+
+    //! Island statistics. \see stats().
+    struct Stats
+    {
+        //! Number of islands of awake bodies found on the latest step.
+        unsigned int m_islandCount = 0;
+
+        //! Number of bodies in the largest island found on the latest step.
+        unsigned int m_largestIslandSize = 0;
+
+        //! Number of bodies put to sleep on the latest step.
+        unsigned int m_fellAsleepCount = 0;
+
+        //! Number of sleeping islands woken up during the latest step.
+        unsigned int m_wokenIslandCount = 0;
+
+        //! Current number of sleeping islands.
+        unsigned int m_sleepingIslandCount = 0;
+
+        //! Current number of bodies in sleeping islands.
+        unsigned int m_sleepingObjectCount = 0;
+    };
+
+    //! Constructor.
+    MCIslandManager();
+
+    /*! Set the number of steps all bodies of an island must have been below
+     *  their sleep limits before the island is put to sleep. The default is 2. */
+    void setSleepStepCount(unsigned int steps);
+
+    //! \return the number of resting steps required before sleeping.
+    unsigned int sleepStepCount() const;
+
+    /*! Build the islands of the given awake objects and put the resting islands to sleep.
+     *  \param objects The integrated objects. Objects that fall asleep are removed from the
+     *         vector via MCWorld::removeObjectFromIntegration().
+     *  \param pairCache The pairs that touched on the current step. */
+    void update(const std::vector<MCObject *> & objects, const MCPairCache & pairCache);
+
+    //! Wake up all bodies of the given sleeping island.
+    void wakeIsland(int island);
+
+    //! Wake up all bodies of all sleeping islands.
+    void wakeAll();
+
+    //! Remove the given object from its sleeping island.
+    void removeObject(MCObject & object);
+
+    //! Forget all sleeping islands. The bodies stay asleep.
+    void clear();
+
+    //! \return island statistics.
+    const Stats & stats() const;
+
+    /*! Save the sleeping islands into the given buffer. The island indices of
+     *  the bodies are saved by the bodies. */
+    void saveState(MCStateBuffer & state) const;
+
+    //! Restore the sleeping islands saved with saveState().
+    void restoreState(MCStateBuffer & state);
+
+private:
+
+    DISABLE_COPY(MCIslandManager);
+    DISABLE_ASSI(MCIslandManager);
+
+    //! \return the node of the given object or -1 if it doesn't belong to any island.
+    int node(MCObject & object) const;
+
+    int find(int node);
+
+    void unite(int node1, int node2);
+
+    bool isResting(const MCPhysicsComponent & physicsComponent) const;
+
+    int allocateIsland();
+
+    void freeIsland(int island);
+
+    //! Move the bodies of the sleeping island source to the sleeping island target.
+    void mergeIsland(int source, int target);
+
+    unsigned int m_sleepStepCount;
+
+    //! Number of awake objects on the current update. Sleeping islands are nodes after them.
+    int m_objectCount;
+
+    //! Union-find forest of the current update.
+    std::vector<int> m_parents;
+
+    //! Per root: true if all bodies of the island are resting.
+    std::vector<unsigned char> m_isResting;
+
+    //! Per root: number of awake bodies in the island.
+    std::vector<unsigned int> m_sizes;
+
+    //! Per root: sleeping island the island is put to or -1.
+    std::vector<int> m_targets;
+
+    std::vector<MCObject *> m_fallingAsleep;
+
+    std::vector<std::vector<MCObject *>> m_sleepingIslands;
+
+    std::vector<int> m_freeIslands;
+
+    unsigned int m_wokenIslandCount;
+
+    Stats m_stats;
+};
+
+#endif // MCISLANDMANAGER_HH
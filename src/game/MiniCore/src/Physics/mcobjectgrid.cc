@@ -20,9 +20,21 @@
 #include "mcobjectgrid.hh"
 #include "mcphysicscomponent.hh"
 #include "mcshape.hh"
+#include "mcstatebuffer.hh"
 
 #include <algorithm>
 
+namespace {
+
+const unsigned int END_OF_CELLS = ~0u;
+
+inline bool mayIntersect(MCObject & obj1, MCObject & obj2)
+{
+    return obj1.shape()->mayIntersect(*obj2.shape().get());
+}
+
+} // namespace
+
 MCObjectGrid::MCObjectGrid(
     float x1, float y1, float x2, float y2,
     float leafMaxW, float leafMaxH)
@@ -39,33 +51,49 @@ MCObjectGrid::MCObjectGrid(
 
 MCObjectGrid::~MCObjectGrid()
 {
-    for (GridCell * cell : m_matrix)
-    {
-        delete cell;
-    }
 }
 
-void MCObjectGrid::setIndexRange(const MCBBox<float> & bbox)
+void MCObjectGrid::indexRange(
+    const MCBBox<float> & bbox, unsigned int & i0, unsigned int & i1, unsigned int & j0, unsigned int & j1) const
 {
     int temp = static_cast<int>(bbox.x1() * m_helpHor);
     if (temp >= static_cast<int>(m_horSize)) temp = m_horSize - 1;
     else if (temp < 0) temp = 0;
-    m_i0 = static_cast<unsigned int>(temp);
+    i0 = static_cast<unsigned int>(temp);
 
     temp = static_cast<int>(bbox.x2() * m_helpHor);
     if (temp >= static_cast<int>(m_horSize)) temp = m_horSize - 1;
     else if (temp < 0) temp = 0;
-    m_i1 = static_cast<unsigned int>(temp);
+    i1 = static_cast<unsigned int>(temp);
 
     temp = static_cast<int>(bbox.y1() * m_helpVer);
     if (temp >= static_cast<int>(m_verSize)) temp = m_verSize - 1;
     else if (temp < 0) temp = 0;
-    m_j0 = static_cast<unsigned int>(temp);
+    j0 = static_cast<unsigned int>(temp);
 
     temp = static_cast<int>(bbox.y2() * m_helpVer);
     if (temp >= static_cast<int>(m_verSize)) temp = m_verSize - 1;
     else if (temp < 0) temp = 0;
-    m_j1 = static_cast<unsigned int>(temp);
+    j1 = static_cast<unsigned int>(temp);
+}
+
+void MCObjectGrid::setIndexRange(const MCBBox<float> & bbox)
+{
+    indexRange(bbox, m_i0, m_i1, m_j0, m_j1);
+}
+
+void MCObjectGrid::markDirty(GridCell & cell)
+{
+    if (!cell.m_isDirty)
+    {
+        cell.m_isDirty = true;
+        m_dirtyCellCache.push_back(&cell);
+    }
+}
+
+std::vector<MCObject *> & MCObjectGrid::cellObjects(GridCell & cell, const MCObject & object)
+{
+    return object.m_isStaticInGrid ? cell.m_staticObjects : cell.m_objects;
 }
 
 void MCObjectGrid::insert(MCObject & object)
@@ -75,6 +103,8 @@ void MCObjectGrid::insert(MCObject & object)
         return;
     }
 
+    object.m_isStaticInGrid = object.physicsComponent().isStationary();
+
     setIndexRange(object.shape()->bbox());
     object.cacheIndexRange(m_i0, m_i1, m_j0, m_j1);
 
@@ -83,9 +113,13 @@ void MCObjectGrid::insert(MCObject & object)
         for (unsigned int i = m_i0; i <= m_i1; i++)
         {
             const int index = j * m_horSize + i;
-            GridCell * cell = m_matrix[index];
-            cell->m_objects.insert(&object);
-            m_dirtyCellCache.insert(cell);
+            GridCell & cell = m_matrix[index];
+            auto & objects = cellObjects(cell, object);
+            if (std::find(objects.begin(), objects.end(), &object) == objects.end())
+            {
+                objects.push_back(&object);
+            }
+            markDirty(cell);
         }
     }
 }
@@ -105,34 +139,110 @@ bool MCObjectGrid::remove(MCObject & object)
         for (unsigned int i = m_i0; i <= m_i1; i++)
         {
             const int index = j * m_horSize + i;
-            GridCell * cell = m_matrix[index];
-            const auto iter = cell->m_objects.find(&object);
-            if (iter != cell->m_objects.end())
+            auto & objects = cellObjects(m_matrix[index], object);
+            const auto iter = std::find(objects.begin(), objects.end(), &object);
+            if (iter != objects.end())
             {
-                cell->m_objects.erase(iter);
+                // Order within a cell doesn't matter: swap with the last one (O(1))
+                *iter = objects.back();
+                objects.pop_back();
                 removed = true;
 
-                if (!cell->m_objects.size())
-                {
-                    m_dirtyCellCache.erase(cell);
-                }
+                // Empty cells are dropped from the dirty list by getPossibleCollisions()
             }
         }
     }
     return removed;
 }
 
-void MCObjectGrid::removeAll()
+bool MCObjectGrid::update(MCObject & object)
 {
-    for (unsigned int j = 0; j < m_verSize; j++)
+    if (!object.shape())
+    {
+        return false;
+    }
+
+    unsigned int i0, i1, j0, j1;
+    object.restoreIndexRange(&i0, &i1, &j0, &j1);
+
+    // An inserted object is always in all cells of its cached range,
+    // so checking the first cell is enough.
+    const auto & firstCell = cellObjects(m_matrix[j0 * m_horSize + i0], object);
+    if (std::find(firstCell.begin(), firstCell.end(), &object) == firstCell.end())
+    {
+        return false;
+    }
+
+    if (object.m_isStaticInGrid != object.physicsComponent().isStationary())
+    {
+        remove(object);
+        insert(object);
+        return true;
+    }
+
+    setIndexRange(object.shape()->bbox());
+
+    if (m_i0 == i0 && m_i1 == i1 && m_j0 == j0 && m_j1 == j1)
     {
-        for (unsigned int i = 0; i < m_horSize; i++)
+        // The object still needs to be tested against the objects of its cells
+        for (unsigned int j = m_j0; j <= m_j1; j++)
         {
-            const int index = j * m_horSize + i;
-            m_matrix[index]->m_objects.clear();
+            for (unsigned int i = m_i0; i <= m_i1; i++)
+            {
+                markDirty(m_matrix[j * m_horSize + i]);
+            }
+        }
+
+        m_avoidedReinsertions++;
+        return true;
+    }
+
+    // Remove from the cells that were left
+    for (unsigned int j = j0; j <= j1; j++)
+    {
+        for (unsigned int i = i0; i <= i1; i++)
+        {
+            if (i < m_i0 || i > m_i1 || j < m_j0 || j > m_j1)
+            {
+                auto & objects = cellObjects(m_matrix[j * m_horSize + i], object);
+                const auto iter = std::find(objects.begin(), objects.end(), &object);
+                if (iter != objects.end())
+                {
+                    *iter = objects.back();
+                    objects.pop_back();
+                }
+            }
+        }
+    }
+
+    // Add to the cells that were entered
+    for (unsigned int j = m_j0; j <= m_j1; j++)
+    {
+        for (unsigned int i = m_i0; i <= m_i1; i++)
+        {
+            GridCell & cell = m_matrix[j * m_horSize + i];
+            if (i < i0 || i > i1 || j < j0 || j > j1)
+            {
+                cellObjects(cell, object).push_back(&object);
+            }
+            markDirty(cell);
         }
     }
 
+    object.cacheIndexRange(m_i0, m_i1, m_j0, m_j1);
+
+    return true;
+}
+
+void MCObjectGrid::removeAll()
+{
+    for (GridCell & cell : m_matrix)
+    {
+        cell.m_objects.clear();
+        cell.m_staticObjects.clear();
+        cell.m_isDirty = false;
+    }
+
     m_dirtyCellCache.clear();
 }
 
@@ -140,71 +250,113 @@ void MCObjectGrid::build()
 {
     m_dirtyCellCache.clear();
 
-    for (GridCell * cell : m_matrix)
-    {
-        delete cell;
-    }
-
     m_matrix.clear();
+    m_matrix.resize(m_horSize * m_verSize);
+}
 
-    for (unsigned int j = 0; j < m_verSize; j++)
+void MCObjectGrid::gatherEntries(const std::vector<MCObject *> & objects, std::vector<CellEntry> & entries) const
+{
+    entries.clear();
+    for (auto * obj : objects)
     {
-        for (unsigned int i = 0; i < m_horSize; i++)
-        {
-            m_matrix.push_back(new GridCell);
-        }
+        entries.push_back({obj->collisionFilter(), obj->m_i0, obj->m_j0});
     }
 }
 
 const MCObjectGrid::CollisionVector & MCObjectGrid::getPossibleCollisions()
 {
-    static MCObjectGrid::CollisionVector collisions;
-    collisions.clear();
+    m_collisions.clear();
+    m_testedPairs = 0;
 
     // Optimization: ignore collisions between sleeping objects.
-    // Note that stationary objects are also sleeping objects.
+    // Note that stationary objects are also sleeping objects, so static
+    // objects are never tested against each other.
 
-    auto cellIter = m_dirtyCellCache.begin();
-    while (cellIter != m_dirtyCellCache.end())
+    // Cells that didn't produce any collisions are dropped from the dirty list
+    // by compacting it in-place.
+    size_t dirtyCount = 0;
+    for (GridCell * cell : m_dirtyCellCache)
     {
         bool hadCollisions = false;
-        auto & objects = (*cellIter)->m_objects;
+        auto & objects = cell->m_objects;
+        auto & staticObjects = cell->m_staticObjects;
+
+        const unsigned int cellIndex = static_cast<unsigned int>(cell - m_matrix.data());
+        const unsigned int i = cellIndex % m_horSize;
+        const unsigned int j = cellIndex / m_horSize;
 
-        const auto end = objects.end();
-        for (auto && objIter1 = objects.begin(); objIter1 != end; objIter1++)
+        // Gather the filters of the cell so that the pair loop doesn't touch the objects
+        gatherEntries(objects, m_cellEntries);
+        const size_t size = m_cellEntries.size();
+        if (size && !staticObjects.empty())
+        {
+            gatherEntries(staticObjects, m_staticCellEntries);
+        }
+        else
         {
-            auto * obj1 = *objIter1;
-            for (auto && objIter2 = std::next(objIter1); objIter2 != end; objIter2++)
+            m_staticCellEntries.clear();
+        }
+
+        const size_t staticSize = m_staticCellEntries.size();
+        m_testedPairs += static_cast<unsigned int>(size * (size - 1) / 2 + size * staticSize);
+
+        for (size_t index1 = 0; index1 < size; index1++)
+        {
+            const CellEntry & entry1 = m_cellEntries[index1];
+            for (size_t index2 = index1 + 1; index2 < size; index2++)
             {
-                auto * obj2 = *objIter2; // Note that ob1 != obj2 always holds
-                if (&obj1->parent() != obj2 &&
-                    &obj2->parent() != obj1 &&
-                    (!obj1->physicsComponent().isSleeping() || !obj2->physicsComponent().isSleeping()) &&
-                    (obj1->isPhysicsObject() || obj1->isTriggerObject()) && !obj1->bypassCollisions() &&
-                    (obj2->isPhysicsObject() || obj2->isTriggerObject()) && !obj2->bypassCollisions() &&
-                    obj1->physicsComponent().neverCollideWithTag() != obj2->physicsComponent().collisionTag() &&
-                    obj2->physicsComponent().neverCollideWithTag() != obj1->physicsComponent().collisionTag() &&
-                    (obj1->collisionLayer() == obj2->collisionLayer() || obj1->collisionLayer() == -1 || obj2->collisionLayer() == -1) &&
-                    obj1->shape()->mayIntersect(*obj2->shape().get()))
+                const CellEntry & entry2 = m_cellEntries[index2];
+
+                // Objects spanning multiple cells share more than one cell. Report the pair
+                // only in the first shared cell so that it's not reported multiple times.
+                if (i != std::max(entry1.m_i0, entry2.m_i0) || j != std::max(entry1.m_j0, entry2.m_j0))
                 {
-                    collisions.push_back({obj1, obj2});
-                    collisions.push_back({obj2, obj1});
+                    continue;
+                }
+
+                auto * obj1 = objects[index1];
+                auto * obj2 = objects[index2]; // Note that ob1 != obj2 always holds
+                if (MCCollisionFilter::accepts(entry1.m_filter, entry2.m_filter) && mayIntersect(*obj1, *obj2))
+                {
+                    m_collisions.push_back({obj1, obj2});
+                    m_collisions.push_back({obj2, obj1});
+                    hadCollisions = true;
+                }
+            }
+
+            // Dynamic vs. static
+            for (size_t index2 = 0; index2 < staticSize; index2++)
+            {
+                const CellEntry & entry2 = m_staticCellEntries[index2];
+                if (i != std::max(entry1.m_i0, entry2.m_i0) || j != std::max(entry1.m_j0, entry2.m_j0))
+                {
+                    continue;
+                }
+
+                auto * obj1 = objects[index1];
+                auto * obj2 = staticObjects[index2];
+                if (MCCollisionFilter::accepts(entry1.m_filter, entry2.m_filter) && mayIntersect(*obj1, *obj2))
+                {
+                    m_collisions.push_back({obj1, obj2});
+                    m_collisions.push_back({obj2, obj1});
                     hadCollisions = true;
                 }
             }
         }
 
-        if (!hadCollisions)
+        if (hadCollisions)
         {
-            cellIter = m_dirtyCellCache.erase(cellIter);
+            m_dirtyCellCache[dirtyCount++] = cell;
         }
         else
         {
-            cellIter++;
+            cell->m_isDirty = false;
         }
     }
 
-    return collisions;
+    m_dirtyCellCache.resize(dirtyCount);
+
+    return m_collisions;
 }
 
 const MCObjectGrid::ObjectSet & MCObjectGrid::getObjectsWithinDistance(const MCVector2dF & p, float d)
@@ -219,33 +371,131 @@ const MCObjectGrid::ObjectSet & MCObjectGrid::getObjectsWithinDistance(float x,
 
 const MCObjectGrid::ObjectSet & MCObjectGrid::getObjectsWithinBBox(const MCBBox<float> & bbox)
 {
-    setIndexRange(bbox);
+    m_resultObjs.clear();
 
-    static ObjectSet resultObjs;
-    resultObjs.clear();
+    forEachObjectWithinBBox(bbox, [this] (MCObject & object) {
+        m_resultObjs.insert(&object);
+    });
 
-    for (unsigned int j = m_j0; j <= m_j1; j++)
+    return m_resultObjs;
+}
+
+void MCObjectGrid::getObjectsWithinBBox(const MCBBox<float> & bbox, ObjectVector & result) const
+{
+    result.clear();
+
+    forEachObjectWithinBBox(bbox, [&result] (MCObject & object) {
+        result.push_back(&object);
+    });
+}
+
+void MCObjectGrid::getObjectsWithinDistance(const MCVector2dF & p, float d, ObjectVector & result) const
+{
+    getObjectsWithinBBox(MCBBox<float>(p.i() - d, p.j() - d, p.i() + d, p.j() + d), result);
+}
+
+const MCBBox<float> & MCObjectGrid::bbox() const
+{
+    return m_bbox;
+}
+
+bool MCObjectGrid::mayCollide(MCObject & obj1, MCObject & obj2)
+{
+    return MCCollisionFilter::accepts(obj1.collisionFilter(), obj2.collisionFilter()) && mayIntersect(obj1, obj2);
+}
+
+unsigned int MCObjectGrid::avoidedReinsertions() const
+{
+    return m_avoidedReinsertions;
+}
+
+bool MCObjectGrid::isStatic(const MCObject & object)
+{
+    return object.m_isStaticInGrid;
+}
+
+unsigned int MCObjectGrid::testedPairs() const
+{
+    return m_testedPairs;
+}
+
+void MCObjectGrid::saveState(MCStateBuffer & state) const
+{
+    state.write(static_cast<unsigned int>(m_matrix.size()));
+
+    // Only the non-empty cells are stored
+    for (unsigned int index = 0; index < m_matrix.size(); index++)
     {
-        for (unsigned int i = m_i0; i <= m_i1; i++)
+        const GridCell & cell = m_matrix[index];
+        if (!cell.m_objects.empty() || !cell.m_staticObjects.empty())
         {
-            const int index = j * m_horSize + i;
-            for (auto && obj : m_matrix[index]->m_objects)
-            {
-                if (obj->shape()->view())
-                {
-                    if (bbox.intersects(obj->shape()->view()->bbox().translated(MCVector2dF(obj->location()))))
-                    {
-                        resultObjs.insert(obj);
-                    }
-                }
-            }
+            state.write(index);
+            state.writeVector(cell.m_objects);
+            state.writeVector(cell.m_staticObjects);
         }
     }
 
-    return resultObjs;
+    state.write(END_OF_CELLS);
+
+    state.write(static_cast<unsigned int>(m_dirtyCellCache.size()));
+    for (GridCell * cell : m_dirtyCellCache)
+    {
+        state.write(static_cast<unsigned int>(cell - m_matrix.data()));
+    }
 }
 
-const MCBBox<float> & MCObjectGrid::bbox() const
+void MCObjectGrid::restoreState(MCStateBuffer & state)
 {
-    return m_bbox;
+    unsigned int cellCount = 0;
+    state.read(cellCount);
+    if (cellCount != m_matrix.size())
+    {
+        state.invalidate();
+        return;
+    }
+
+    for (GridCell & cell : m_matrix)
+    {
+        cell.m_objects.clear();
+        cell.m_staticObjects.clear();
+        cell.m_isDirty = false;
+    }
+
+    unsigned int index = END_OF_CELLS;
+    while (state.read(index) && index != END_OF_CELLS)
+    {
+        if (index >= cellCount)
+        {
+            state.invalidate();
+            return;
+        }
+
+        GridCell & cell = m_matrix[index];
+        state.readVector(cell.m_objects);
+        state.readVector(cell.m_staticObjects);
+
+        for (auto * obj : cell.m_objects)
+        {
+            obj->m_isStaticInGrid = false;
+        }
+
+        for (auto * obj : cell.m_staticObjects)
+        {
+            obj->m_isStaticInGrid = true;
+        }
+    }
+
+    unsigned int dirtyCount = 0;
+    state.read(dirtyCount);
+    m_dirtyCellCache.clear();
+    for (unsigned int i = 0; i < dirtyCount && state.read(index); i++)
+    {
+        if (index >= cellCount)
+        {
+            state.invalidate();
+            return;
+        }
+
+        markDirty(m_matrix[index]);
+    }
 }
@@ -21,28 +21,47 @@
 #define MCOBJECTGRID_HH
 
 #include "mcbbox.hh"
+#include "mccollisionfilter.hh"
 #include "mcmacros.hh"
 #include "mcobject.hh"
 
+#include <algorithm>
 #include <map>
 #include <set>
 #include <vector>
 
+class MCObject;
+class MCStateBuffer;
+
 /*! A grid used for fast collision detection.
  *  The tree stores objects inherited from MCObject -class.
  *  A (2d) collision test for a given object can be requested against all
- *  objects of a given typeid. */
+ *  objects of a given typeid.
+ *
+ *  Objects that are stationary when inserted are stored as static geometry in
+ *  separate per-cell arrays. Static objects never collide with each other, so they
+ *  are only tested against the dynamic objects of the dirty cells and never
+ *  against each other. The static arrays are built as the objects are inserted,
+ *  e.g. once when a track is loaded. */
 class MCObjectGrid
 {
 public:
 
     typedef std::set<MCObject *> ObjectSet;
+    typedef std::vector<MCObject *> ObjectVector;
     typedef std::vector<std::pair<MCObject *, MCObject *> > CollisionVector;
 
-    //! Container for objects.
+    /*! Container for objects. Objects are stored in contiguous arrays that keep
+     *  their capacity, so inserts and removes don't allocate in the steady state. */
     struct GridCell
     {
-        ObjectSet m_objects;
+        //! Dynamic objects.
+        std::vector<MCObject *> m_objects;
+
+        //! Static objects, see isStatic().
+        std::vector<MCObject *> m_staticObjects;
+
+        bool m_isDirty = false;
     };
 
     /*! Constructor.
@@ -55,27 +74,96 @@ public:
     //! Destructor.
     ~MCObjectGrid();
 
-    /*! Insert an object into the tree (O(1)).
+    /*! Insert an object into the tree. Stationary objects are inserted
+     *  as static geometry. Each covered cell is searched for the object first,
+     *  so this is linear in the number of objects in the covered cells.
      *  \param object is the object to be inserted. */
     void insert(MCObject & object);
 
-    /*! Remove an object from the tree (O(1)).
+    /*! Remove an object from the tree. The object is searched from each covered
+     *  cell and then swapped with the last one, so this is linear in the number of
+     *  objects in the covered cells, but nothing is shifted.
      *  \param object is the object to be removed.
      *  \return true if was removed. */
     bool remove(MCObject & object);
 
+    /*! Update the cells of an object that has moved or rotated. Only the cells that
+     *  the object entered or left are touched and nothing is re-inserted if the object
+     *  still covers the same cells. An object that has become stationary or non-stationary
+     *  is moved between the static and the dynamic objects.
+     *  \param object is the object to be updated.
+     *  \return false if the object wasn't in the grid. */
+    bool update(MCObject & object);
+
     //! Remove all objects.
     void removeAll();
 
-    //! Get objects within given distance.
+    /*! Get objects within given distance. The returned set is shared by all calls and
+     *  it's cleared by the next call, so use the reentrant overloads when possible. */
     const ObjectSet & getObjectsWithinDistance(const MCVector2dF & p, float d);
 
-    //! Get objects within given distance.
+    //! \see getObjectsWithinDistance(const MCVector2dF &, float).
     const ObjectSet & getObjectsWithinDistance(float x, float y, float d);
 
-    //! Get all objects of given type overlapping given BBox.
+    /*! Get all objects overlapping given BBox. The returned set is shared by all calls and
+     *  it's cleared by the next call, so use the reentrant overloads when possible. */
     const ObjectSet & getObjectsWithinBBox(const MCBBox<float> & bbox);
 
+    /*! Get objects within given distance into the given vector. The vector is cleared
+     *  first and it keeps its capacity, so reusing it doesn't allocate in the steady state.
+     *  This doesn't modify the grid, so it can be called from multiple threads at the same
+     *  time as long as the grid isn't updated. */
+    void getObjectsWithinDistance(const MCVector2dF & p, float d, ObjectVector & result) const;
+
+    //! Get all objects overlapping given BBox into the given vector. \see getObjectsWithinDistance().
+    void getObjectsWithinBBox(const MCBBox<float> & bbox, ObjectVector & result) const;
+
+    /*! Call function(MCObject &) once for each object overlapping given BBox. Objects are
+     *  tested with the bounding boxes of their views, so objects without a view are skipped.
+     *  Nothing is allocated and the grid is not modified, so this is reentrant and can be
+     *  called from multiple threads at the same time as long as the grid isn't updated. */
+    template <typename Function>
+    void forEachObjectWithinBBox(const MCBBox<float> & bbox, Function function) const
+    {
+        unsigned int i0, i1, j0, j1;
+        indexRange(bbox, i0, i1, j0, j1);
+
+        for (unsigned int j = j0; j <= j1; j++)
+        {
+            for (unsigned int i = i0; i <= i1; i++)
+            {
+                const GridCell & cell = m_matrix[j * m_horSize + i];
+                visitObjectsWithinBBox(cell.m_objects, bbox, i, j, i0, j0, function);
+                visitObjectsWithinBBox(cell.m_staticObjects, bbox, i, j, i0, j0, function);
+            }
+        }
+    }
+
+    /*! Call function(MCObject &) once for each dynamic object whose shape overlaps given
+     *  BBox. Static objects are not visited. \see forEachObjectWithinBBox(). */
+    template <typename Function>
+    void forEachDynamicObjectWithinBBox(const MCBBox<float> & bbox, Function function) const
+    {
+        unsigned int i0, i1, j0, j1;
+        indexRange(bbox, i0, i1, j0, j1);
+
+        for (unsigned int j = j0; j <= j1; j++)
+        {
+            for (unsigned int i = i0; i <= i1; i++)
+            {
+                for (auto && obj : m_matrix[j * m_horSize + i].m_objects)
+                {
+                    // Visit only in the first cell shared with the query range
+                    if (i == std::max(i0, obj->m_i0) && j == std::max(j0, obj->m_j0) &&
+                        bbox.intersects(obj->shape()->bbox()))
+                    {
+                        function(*obj);
+                    }
+                }
+            }
+        }
+    }
+
     /*! Get possible collisions. Collisions between sleeping objects are ignored,
      *  because that gives a huge performance boost.
      *  \return possible collisions. */
@@ -84,15 +172,77 @@ public:
     //! Get bounding box
     const MCBBox<float> & bbox() const;
 
+    /*! \return true if the given objects are allowed to collide and their shapes
+     *  may intersect. This is the filter used by all broadphases. */
+    static bool mayCollide(MCObject & obj1, MCObject & obj2);
+
+    //! \return number of update() calls that didn't need to touch any cells.
+    unsigned int avoidedReinsertions() const;
+
+    //! \return true if the given object is stored as static geometry.
+    static bool isStatic(const MCObject & object);
+
+    //! \return number of object pairs examined by the latest getPossibleCollisions() call.
+    unsigned int testedPairs() const;
+
+    /*! Save the contents of the cells, including the static objects, into the given buffer.
+     *  The order of the objects in the cells is kept, because it defines the order of the collisions. */
+    void saveState(MCStateBuffer & state) const;
+
+    /*! Restore the contents of the cells saved with saveState(). The cached
+     *  index ranges of the objects must be restored separately. */
+    void restoreState(MCStateBuffer & state);
+
 private:
 
     DISABLE_COPY(MCObjectGrid);
     DISABLE_ASSI(MCObjectGrid);
 
+    //! Collision filter and the first cell of an object in the cell being processed.
+    struct CellEntry
+    {
+        MCCollisionFilter m_filter;
+
+        unsigned int m_i0;
+
+        unsigned int m_j0;
+    };
+
+    template <typename Function>
+    static void visitObjectsWithinBBox(
+        const std::vector<MCObject *> & objects, const MCBBox<float> & bbox,
+        unsigned int i, unsigned int j, unsigned int i0, unsigned int j0, Function & function)
+    {
+        for (auto && obj : objects)
+        {
+            // An object is in all cells of its index range. Visit it only in the first
+            // cell shared with the query range so that it's not reported multiple times.
+            if (i != std::max(i0, obj->m_i0) || j != std::max(j0, obj->m_j0))
+            {
+                continue;
+            }
+
+            if (obj->shape()->view() &&
+                bbox.intersects(obj->shape()->view()->bbox().translated(MCVector2dF(obj->location()))))
+            {
+                function(*obj);
+            }
+        }
+    }
+
+    void indexRange(
+        const MCBBox<float> & bbox, unsigned int & i0, unsigned int & i1, unsigned int & j0, unsigned int & j1) const;
+
     void setIndexRange(const MCBBox<float> & bbox);
 
     void build();
 
+    void markDirty(GridCell & cell);
+
+    static std::vector<MCObject *> & cellObjects(GridCell & cell, const MCObject & object);
+
+    void gatherEntries(const std::vector<MCObject *> & objects, std::vector<CellEntry> & entries) const;
+
     MCBBox<float> m_bbox;
 
     float m_leafMaxW;
@@ -109,10 +259,22 @@ private:
 
     float m_helpVer;
 
-    std::vector<GridCell *> m_matrix;
+    std::vector<GridCell> m_matrix;
 
-    typedef std::set<GridCell *> DirtyCellCache;
+    typedef std::vector<GridCell *> DirtyCellCache;
     DirtyCellCache m_dirtyCellCache;
+
+    CollisionVector m_collisions;
+
+    std::vector<CellEntry> m_cellEntries;
+
+    std::vector<CellEntry> m_staticCellEntries;
+
+    ObjectSet m_resultObjs;
+
+    unsigned int m_avoidedReinsertions = 0;
+
+    unsigned int m_testedPairs = 0;
 };
 
 #endif // MCOBJECTGRID_HH
@@ -0,0 +1,365 @@
+// This file belongs to the "MiniCore" game engine.
+// Copyright (C) 2018 Jussi Lind <jussi.lind@iki.fi>
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+// MA  02110-1301, USA.
+//
+
+#include "mcpaircache.hh"
+#include "mccontactevent.hh"
+#include "mcobject.hh"
+#include "mcphysicscomponent.hh"
+#include "mcstatebuffer.hh"
+
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <utility>
+
+namespace {
+
+const size_t INITIAL_CAPACITY = 64;
+
+inline void orderPair(MCObject *& object1, MCObject *& object2)
+{
+    if (std::less<MCObject *>()(object2, object1))
+    {
+        std::swap(object1, object2);
+    }
+}
+
+inline size_t hashPair(MCObject * object1, MCObject * object2)
+{
+    const size_t h1 = reinterpret_cast<std::uintptr_t>(object1) >> 3;
+    const size_t h2 = reinterpret_cast<std::uintptr_t>(object2) >> 3;
+    return h1 * 2654435761u ^ h2 * 40503u;
+}
+
+inline bool idLess(const MCObject * object1a, const MCObject * object2a, const MCObject * object1b, const MCObject * object2b)
+{
+    return object1a->id() < object1b->id() || (object1a->id() == object1b->id() && object2a->id() < object2b->id());
+}
+
+inline void orderById(MCObject *& object1, MCObject *& object2)
+{
+    if (object2->id() < object1->id())
+    {
+        std::swap(object1, object2);
+    }
+}
+
+} // namespace
+
+MCPairCache::MCPairCache()
+: m_pairs(INITIAL_CAPACITY)
+, m_oldPairs(INITIAL_CAPACITY)
+{
+}
+
+size_t MCPairCache::findSlot(const std::vector<Pair> & pairs, MCObject * object1, MCObject * object2) const
+{
+    // Linear probing. The capacity is always a power of two and the table
+    // is never full, so this terminates.
+    const size_t mask = pairs.size() - 1;
+    size_t slot = hashPair(object1, object2) & mask;
+    while (pairs[slot].m_object1 && (pairs[slot].m_object1 != object1 || pairs[slot].m_object2 != object2))
+    {
+        slot = (slot + 1) & mask;
+    }
+    return slot;
+}
+
+void MCPairCache::rehash(size_t capacity)
+{
+    m_oldPairs.swap(m_pairs);
+    m_pairs.assign(capacity, Pair());
+    for (auto && pair : m_oldPairs)
+    {
+        if (pair.m_object1)
+        {
+            m_pairs[findSlot(m_pairs, pair.m_object1, pair.m_object2)] = pair;
+        }
+    }
+}
+
+void MCPairCache::insert(MCObject * object1, MCObject * object2)
+{
+    orderPair(object1, object2);
+
+    Pair & pair = m_pairs[findSlot(m_pairs, object1, object2)];
+    pair.m_object1 = object1;
+    pair.m_object2 = object2;
+    pair.m_wasTouching = true;
+    m_pairCount++;
+}
+
+void MCPairCache::sortOrderedPairs()
+{
+    for (auto && pair : m_orderedPairs)
+    {
+        orderById(pair.m_object1, pair.m_object2);
+    }
+
+    std::sort(m_orderedPairs.begin(), m_orderedPairs.end(), [] (const Pair & a, const Pair & b) {
+        return idLess(a.m_object1, a.m_object2, b.m_object1, b.m_object2);
+    });
+}
+
+bool MCPairCache::isRemoved(const MCObject * object) const
+{
+    return std::find(m_removedObjects.begin(), m_removedObjects.end(), object) != m_removedObjects.end();
+}
+
+void MCPairCache::endSending()
+{
+    // The removed objects may be deleted once the outermost handler has returned
+    if (!--m_sendDepth)
+    {
+        m_removedObjects.clear();
+    }
+}
+
+bool MCPairCache::setTouching(MCObject & object1, MCObject & object2)
+{
+    // Keep the load factor below 0.5
+    if ((m_pairCount + 1) * 2 > m_pairs.size())
+    {
+        rehash(m_pairs.size() * 2);
+    }
+
+    MCObject * p1 = &object1;
+    MCObject * p2 = &object2;
+    orderPair(p1, p2);
+
+    Pair & pair = m_pairs[findSlot(m_pairs, p1, p2)];
+    if (!pair.m_object1)
+    {
+        pair.m_object1 = p1;
+        pair.m_object2 = p2;
+        pair.m_wasTouching = false;
+        m_pairCount++;
+    }
+
+    pair.m_isTouching = true;
+
+    return pair.m_wasTouching;
+}
+
+bool MCPairCache::isTouching(MCObject & object1, MCObject & object2) const
+{
+    MCObject * p1 = &object1;
+    MCObject * p2 = &object2;
+    orderPair(p1, p2);
+
+    const Pair & pair = m_pairs[findSlot(m_pairs, p1, p2)];
+    return pair.m_object1 && pair.m_isTouching;
+}
+
+void MCPairCache::update()
+{
+    // Collect the events in the order of object ids. The table is ordered by addresses.
+    m_events.clear();
+    for (auto && pair : m_pairs)
+    {
+        if (pair.m_object1)
+        {
+            Event event;
+            event.m_pair = pair;
+            orderById(event.m_pair.m_object1, event.m_pair.m_object2);
+
+            // The detector doesn't test pairs of sleeping objects, so not touching doesn't mean that the contact ended
+            event.m_isDormant = pair.m_wasTouching && !pair.m_isTouching &&
+                pair.m_object1->physicsComponent().isSleeping() && pair.m_object2->physicsComponent().isSleeping();
+
+            m_events.push_back(event);
+        }
+    }
+
+    std::sort(m_events.begin(), m_events.end(), [] (const Event & a, const Event & b) {
+        return idLess(a.m_pair.m_object1, a.m_pair.m_object2, b.m_pair.m_object1, b.m_pair.m_object2);
+    });
+
+    // Store the surviving pairs before sending the events, so that event handlers
+    // can safely modify the cache.
+    m_pairs.assign(m_pairs.size(), Pair());
+    m_pairCount = 0;
+    m_orderedPairs.clear();
+
+    for (auto && event : m_events)
+    {
+        if (event.m_pair.m_isTouching || event.m_isDormant)
+        {
+            insert(event.m_pair.m_object1, event.m_pair.m_object2);
+
+            Pair pair;
+            pair.m_object1 = event.m_pair.m_object1;
+            pair.m_object2 = event.m_pair.m_object2;
+            pair.m_wasTouching = true;
+            m_orderedPairs.push_back(pair);
+        }
+    }
+
+    // The handlers may remove and delete objects, so the objects are checked before each event.
+    // m_events isn't modified until the next update().
+    m_isDispatching = true;
+    m_sendDepth++;
+    for (auto && event : m_events)
+    {
+        if (event.m_isDormant)
+        {
+            continue;
+        }
+
+        MCObject * object1 = event.m_pair.m_object1;
+        MCObject * object2 = event.m_pair.m_object2;
+
+        const MCContactEvent::Type type =
+            !event.m_pair.m_wasTouching ? MCContactEvent::Type::Begin :
+            event.m_pair.m_isTouching ? MCContactEvent::Type::Persist : MCContactEvent::Type::End;
+
+        const bool isPersist = type == MCContactEvent::Type::Persist;
+
+        // An event is marked sent before the handler is called, because the handler
+        // may remove the other object, see remove()
+        event.m_isSent1 = true;
+        if ((!isPersist || object1->receivesPersistContactEvents()) && !isRemoved(object1) && !isRemoved(object2))
+        {
+            MCContactEvent ev1(*object2, type);
+            MCObject::sendEvent(*object1, ev1);
+        }
+
+        event.m_isSent2 = true;
+        if ((!isPersist || object2->receivesPersistContactEvents()) && !isRemoved(object1) && !isRemoved(object2))
+        {
+            MCContactEvent ev2(*object1, type);
+            MCObject::sendEvent(*object2, ev2);
+        }
+    }
+    m_isDispatching = false;
+    endSending();
+}
+
+void MCPairCache::remove(MCObject & object)
+{
+    // Find the objects that see a contact with the removed object. During update()
+    // that depends on whether the event of the pair has already been sent.
+    std::vector<MCObject *> touchingObjects;
+    if (m_isDispatching)
+    {
+        for (auto && event : m_events)
+        {
+            const bool isFirst = event.m_pair.m_object1 == &object;
+            if (isFirst || event.m_pair.m_object2 == &object)
+            {
+                MCObject * otherObject = isFirst ? event.m_pair.m_object2 : event.m_pair.m_object1;
+                const bool isSent = (isFirst ? event.m_isSent2 : event.m_isSent1) && !event.m_isDormant;
+                if ((isSent ? event.m_pair.m_isTouching : event.m_pair.m_wasTouching) && !isRemoved(otherObject))
+                {
+                    touchingObjects.push_back(otherObject);
+                }
+            }
+        }
+    }
+    else
+    {
+        for (auto && pair : m_pairs)
+        {
+            if (pair.m_wasTouching && (pair.m_object1 == &object || pair.m_object2 == &object))
+            {
+                touchingObjects.push_back(pair.m_object1 == &object ? pair.m_object2 : pair.m_object1);
+            }
+        }
+
+        std::sort(touchingObjects.begin(), touchingObjects.end(), [] (const MCObject * a, const MCObject * b) {
+            return a->id() < b->id();
+        });
+    }
+
+    bool found = false;
+    for (auto && pair : m_pairs)
+    {
+        if (pair.m_object1 == &object || pair.m_object2 == &object)
+        {
+            pair = Pair();
+            m_pairCount--;
+            found = true;
+        }
+    }
+
+    // Removal breaks the probe sequences
+    if (found)
+    {
+        rehash(m_pairs.size());
+
+        m_orderedPairs.erase(std::remove_if(m_orderedPairs.begin(), m_orderedPairs.end(), [&object] (const Pair & pair) {
+            return pair.m_object1 == &object || pair.m_object2 == &object;
+        }), m_orderedPairs.end());
+    }
+
+    m_removedObjects.push_back(&object);
+    m_sendDepth++;
+    for (MCObject * otherObject : touchingObjects)
+    {
+        // A handler may have removed the object
+        if (!isRemoved(otherObject))
+        {
+            MCContactEvent event(object, MCContactEvent::Type::End);
+            MCObject::sendEvent(*otherObject, event);
+        }
+    }
+    endSending();
+}
+
+void MCPairCache::clear()
+{
+    m_pairs.assign(m_pairs.size(), Pair());
+    m_pairCount = 0;
+    m_orderedPairs.clear();
+}
+
+size_t MCPairCache::pairCount() const
+{
+    return m_pairCount;
+}
+
+void MCPairCache::saveState(MCStateBuffer & state) const
+{
+    state.writeVector(m_pairs);
+    state.write(m_pairCount);
+}
+
+void MCPairCache::restoreState(MCStateBuffer & state)
+{
+    state.readVector(m_pairs);
+    state.read(m_pairCount);
+
+    if (m_pairs.empty())
+    {
+        // Invalid state
+        m_pairs.assign(INITIAL_CAPACITY, Pair());
+        m_pairCount = 0;
+    }
+
+    m_orderedPairs.clear();
+    for (auto && pair : m_pairs)
+    {
+        if (pair.m_object1)
+        {
+            m_orderedPairs.push_back(pair);
+        }
+    }
+
+    sortOrderedPairs();
+}
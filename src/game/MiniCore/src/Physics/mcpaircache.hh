@@ -0,0 +1,146 @@
+// This file belongs to the "MiniCore" game engine.
+// Copyright (C) 2018 Jussi Lind <jussi.lind@iki.fi>
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+// MA  02110-1301, USA.
+//
+
+#ifndef MCPAIRCACHE_HH
+#define MCPAIRCACHE_HH
+
+#include "mcmacros.hh"
+
+#include <cstddef>
+#include <vector>
+
+class MCObject;
+class MCStateBuffer;
+
+/*! Frame-to-frame cache of touching object pairs. MCCollisionDetector marks the
+ *  pairs that touch during the primary detection pass and update() then sends
+ *  MCContactEvents for contacts that begun, persist or ended.
+ *
+ *  Pairs are looked up from an open addressing hash table that keeps its capacity,
+ *  so the cache doesn't allocate in the steady state. A pair is the same
+ *  regardless of the order of the objects. Events are sent and pairs are iterated
+ *  in the order of MCObject::id(), so the results don't depend on memory addresses.
+ *
+ *  A pair of sleeping objects isn't tested by the detector, so such a pair is
+ *  kept as it was without sending End until one of the objects wakes up. */
+class MCPairCache
+{
+public:
+
+    //! Constructor.
+    MCPairCache();
+
+    /*! Mark the pair as touching on the current step.
+     *  \return true if the pair was already touching on the previous step. */
+    bool setTouching(MCObject & object1, MCObject & object2);
+
+    //! \return true if the pair has been marked touching on the current step.
+    bool isTouching(MCObject & object1, MCObject & object2) const;
+
+    /*! Finish the current step: send Begin and End events to both objects of a pair,
+     *  Persist events to the objects that receive them, and drop the pairs that have
+     *  stopped touching. The event handlers may remove objects, and the remaining
+     *  events of the removed objects are not sent. */
+    void update();
+
+    /*! Drop all pairs of the given object. The objects that have got a Begin event
+     *  but no End event for a pair with the given object get the End event here. */
+    void remove(MCObject & object);
+
+    //! Drop all pairs without sending events.
+    void clear();
+
+    //! \return number of cached pairs.
+    size_t pairCount() const;
+
+    //! Save the cached pairs into the given buffer.
+    void saveState(MCStateBuffer & state) const;
+
+    //! Restore the cached pairs saved with saveState().
+    void restoreState(MCStateBuffer & state);
+
+    /*! Call function(object1, object2) for each pair kept by the latest update()
+     *  in the order of object ids. */
+    template <typename Function>
+    void forEachPair(Function function) const
+    {
+        for (auto && pair : m_orderedPairs)
+        {
+            function(*pair.m_object1, *pair.m_object2);
+        }
+    }
+
+private:
+
+    DISABLE_COPY(MCPairCache);
+    DISABLE_ASSI(MCPairCache);
+
+    struct Pair
+    {
+        MCObject * m_object1 = nullptr;
+
+        MCObject * m_object2 = nullptr;
+
+        bool m_isTouching = false;
+
+        bool m_wasTouching = false;
+    };
+
+    struct Event
+    {
+        Pair m_pair;
+
+        bool m_isDormant = false;
+
+        bool m_isSent1 = false;
+
+        bool m_isSent2 = false;
+    };
+
+    size_t findSlot(const std::vector<Pair> & pairs, MCObject * object1, MCObject * object2) const;
+
+    void rehash(size_t capacity);
+
+    void insert(MCObject * object1, MCObject * object2);
+
+    void sortOrderedPairs();
+
+    bool isRemoved(const MCObject * object) const;
+
+    void endSending();
+
+    std::vector<Pair> m_pairs;
+
+    std::vector<Pair> m_oldPairs;
+
+    std::vector<Pair> m_orderedPairs;
+
+    std::vector<Event> m_events;
+
+    size_t m_pairCount = 0;
+
+    //! Objects removed while events are being sent. Their remaining events are skipped.
+    std::vector<MCObject *> m_removedObjects;
+
+    int m_sendDepth = 0;
+
+    bool m_isDispatching = false;
+};
+
+#endif // MCPAIRCACHE_HH
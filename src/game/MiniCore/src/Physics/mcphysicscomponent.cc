@@ -18,19 +18,20 @@
 //
 
 #include "mcphysicscomponent.hh"
+#include "mcislandmanager.hh"
+#include "mcphysicsstate.hh"
+#include "mcstatebuffer.hh"
 #include "mctrigonom.hh"
+#include "mcworld.hh"
+
+#include <cassert>
+#include <cmath>
+#include <limits>
 
 MCPhysicsComponent::MCPhysicsComponent()
-    : m_maxSpeed(1000.0f)
-    , m_linearDamping(0.999f)
-    , m_angularAcceleration(0)
-    , m_angularVelocity(0)
-    , m_angularDamping(0.999f)
-    , m_angularImpulse(0)
-    , m_torque(0)
-    , m_invMass(std::numeric_limits<float>::max())
-    , m_mass(0)
-    , m_invMomentOfInertia(std::numeric_limits<float>::max())
+    : m_state(&MCPhysicsState::detachedState())
+    , m_slot(m_state->allocate(*this))
+    , m_maxSpeed(1000.0f)
     , m_momentOfInertia(0)
     , m_restitution(0.5f)
     , m_xyFriction(0.0f)
@@ -41,21 +42,35 @@ MCPhysicsComponent::MCPhysicsComponent()
     , m_linearSleepLimit(0.01f)
     , m_angularSleepLimit(0.01f)
     , m_sleepCount(0)
+    , m_island(-1)
     , m_collisionTag(0)
     , m_neverCollideWithTag(-1)
 {
+    m_state->m_linearDamping[m_slot] = 0.999f;
+    m_state->m_angularDamping[m_slot] = 0.999f;
+    m_state->m_invMass[m_slot] = std::numeric_limits<float>::max();
+    m_state->m_invMomentOfInertia[m_slot] = std::numeric_limits<float>::max();
+
+    updateActivity();
 }
 
 void MCPhysicsComponent::addImpulse(const MCVector3dF & impulse, bool)
 {
-    m_linearImpulse += impulse;
+    MCPhysicsState & state = *m_state;
+    state.m_linearImpulseX[m_slot] += impulse.i();
+    state.m_linearImpulseY[m_slot] += impulse.j();
+    state.m_linearImpulseZ[m_slot] += impulse.k();
 
     toggleSleep(false);
 }
 
 void MCPhysicsComponent::addImpulse(const MCVector3dF & impulse, const MCVector3dF & pos, bool isCollision)
 {
-    m_linearImpulse += impulse;
+    MCPhysicsState & state = *m_state;
+    state.m_linearImpulseX[m_slot] += impulse.i();
+    state.m_linearImpulseY[m_slot] += impulse.j();
+    state.m_linearImpulseZ[m_slot] += impulse.k();
+
     const float r = (pos - object().location()).lengthFast();
     if (r > 0) {
         addAngularImpulse((-(impulse % (pos - object().location())).k()) / r, isCollision);
@@ -65,21 +80,25 @@ void MCPhysicsComponent::addImpulse(const MCVector3dF & impulse, const MCVector3
 
 void MCPhysicsComponent::addAngularImpulse(float impulse, bool)
 {
-    m_angularImpulse += impulse;
+    m_state->m_angularImpulse[m_slot] += impulse;
 
     toggleSleep(false);
 }
 
 void MCPhysicsComponent::setVelocity(const MCVector3dF & newVelocity)
 {
-    m_velocity = newVelocity;
+    MCPhysicsState & state = *m_state;
+    state.m_velocityX[m_slot] = newVelocity.i();
+    state.m_velocityY[m_slot] = newVelocity.j();
+    state.m_velocityZ[m_slot] = newVelocity.k();
 
     toggleSleep(false);
 }
 
-const MCVector3dF & MCPhysicsComponent::velocity() const
+MCVector3dF MCPhysicsComponent::velocity() const
 {
-    return m_velocity;
+    const MCPhysicsState & state = *m_state;
+    return MCVector3dF(state.m_velocityX[m_slot], state.m_velocityY[m_slot], state.m_velocityZ[m_slot]);
 }
 
 float MCPhysicsComponent::speed() const
@@ -94,31 +113,38 @@ void MCPhysicsComponent::setMaxSpeed(float MaxSpeed)
 
 void MCPhysicsComponent::setAngularVelocity(float newVelocity)
 {
-    m_angularVelocity = newVelocity;
+    m_state->m_angularVelocity[m_slot] = newVelocity;
 
     toggleSleep(false);
 }
 
 float MCPhysicsComponent::angularVelocity() const
 {
-    return m_angularVelocity;
+    return m_state->m_angularVelocity[m_slot];
 }
 
 void MCPhysicsComponent::setAcceleration(const MCVector3dF & newAcceleration)
 {
-    m_acceleration = newAcceleration;
+    MCPhysicsState & state = *m_state;
+    state.m_accelerationX[m_slot] = newAcceleration.i();
+    state.m_accelerationY[m_slot] = newAcceleration.j();
+    state.m_accelerationZ[m_slot] = newAcceleration.k();
 
     toggleSleep(false);
 }
 
-const MCVector3dF & MCPhysicsComponent::acceleration() const
+MCVector3dF MCPhysicsComponent::acceleration() const
 {
-    return m_acceleration;
+    const MCPhysicsState & state = *m_state;
+    return MCVector3dF(state.m_accelerationX[m_slot], state.m_accelerationY[m_slot], state.m_accelerationZ[m_slot]);
 }
 
 void MCPhysicsComponent::addForce(const MCVector3dF & force)
 {
-    m_forces += force;
+    MCPhysicsState & state = *m_state;
+    state.m_forceX[m_slot] += force.i();
+    state.m_forceY[m_slot] += force.j();
+    state.m_forceZ[m_slot] += force.k();
 
     toggleSleep(false);
 }
@@ -126,68 +152,87 @@ void MCPhysicsComponent::addForce(const MCVector3dF & force)
 void MCPhysicsComponent::addForce(const MCVector3dF & force, const MCVector3dF & pos)
 {
     addTorque(-(force % (pos - object().location())).k());
-    m_forces += force;
-
-    toggleSleep(false);
+    addForce(force);
 }
 
 void MCPhysicsComponent::addTorque(float torque)
 {
-    m_torque += torque;
+    m_state->m_torque[m_slot] += torque;
 
     toggleSleep(false);
 }
 
+void MCPhysicsComponent::setLinearImpulse(const MCVector3dF & linearImpulse)
+{
+    MCPhysicsState & state = *m_state;
+    state.m_linearImpulseX[m_slot] = linearImpulse.i();
+    state.m_linearImpulseY[m_slot] = linearImpulse.j();
+    state.m_linearImpulseZ[m_slot] = linearImpulse.k();
+}
+
+void MCPhysicsComponent::setForces(const MCVector3dF & forces)
+{
+    MCPhysicsState & state = *m_state;
+    state.m_forceX[m_slot] = forces.i();
+    state.m_forceY[m_slot] = forces.j();
+    state.m_forceZ[m_slot] = forces.k();
+}
+
 void MCPhysicsComponent::setMass(float newMass, bool stationary)
 {
     m_isStationary = stationary;
+    invalidateIntegration();
 
     if (!stationary)
     {
         if (newMass > 0)
         {
-            m_invMass = 1.0f / newMass;
+            m_state->m_invMass[m_slot] = 1.0f / newMass;
         }
         else
         {
-            m_invMass = std::numeric_limits<float>::max();
+            m_state->m_invMass[m_slot] = std::numeric_limits<float>::max();
         }
 
-        m_mass = newMass;
+        m_state->m_mass[m_slot] = newMass;
 
         // This is just a default guess. The shape should set the "correct" value.
         setMomentOfInertia(newMass * 10.0f);
     }
     else
     {
-        m_invMass  = 0;
-        m_mass     = std::numeric_limits<float>::max();
+        m_state->m_invMass[m_slot] = 0;
+        m_state->m_mass[m_slot] = std::numeric_limits<float>::max();
 
         m_isSleeping = true;
 
         setMomentOfInertia(std::numeric_limits<float>::max());
     }
+
+    updateActivity();
 }
 
 float MCPhysicsComponent::invMass() const
 {
-    return m_invMass;
+    return m_state->m_invMass[m_slot];
 }
 
 float MCPhysicsComponent::mass() const
 {
-    return m_mass;
+    return m_state->m_mass[m_slot];
 }
 
 void MCPhysicsComponent::setMomentOfInertia(float newMomentOfInertia)
 {
+    invalidateIntegration();
+
     if (newMomentOfInertia > 0)
     {
-        m_invMomentOfInertia = 1.0f / newMomentOfInertia;
+        m_state->m_invMomentOfInertia[m_slot] = 1.0f / newMomentOfInertia;
     }
     else
     {
-        m_invMomentOfInertia = std::numeric_limits<float>::max();
+        m_state->m_invMomentOfInertia[m_slot] = std::numeric_limits<float>::max();
     }
 
     m_momentOfInertia = newMomentOfInertia;
@@ -200,7 +245,7 @@ float MCPhysicsComponent::momentOfInertia() const
 
 float MCPhysicsComponent::invMomentOfInertia() const
 {
-    return m_invMomentOfInertia;
+    return m_state->m_invMomentOfInertia[m_slot];
 }
 
 void MCPhysicsComponent::setRestitution(float newRestitution)
@@ -237,8 +282,9 @@ bool MCPhysicsComponent::isIntegrating() const
 
 void MCPhysicsComponent::resetZ()
 {
-    m_velocity.setK(0);
-    m_forces.setK(0);
+    m_state->m_velocityZ[m_slot] = 0;
+    m_state->m_forceZ[m_slot] = 0;
+    invalidateIntegration();
 }
 
 void MCPhysicsComponent::setSleepLimits(float linearSleepLimit, float angularSleepLimit)
@@ -251,6 +297,9 @@ void MCPhysicsComponent::toggleSleep(bool sleep)
 {
     m_sleepCount = 0;
 
+    // All modifications of the motion state end up here
+    invalidateIntegration();
+
     if (sleep && m_isSleepingPrevented)
     {
         return;
@@ -259,17 +308,26 @@ void MCPhysicsComponent::toggleSleep(bool sleep)
     if (sleep != m_isSleeping)
     {
         m_isSleeping = sleep;
+        updateActivity();
+
+        // Waking up any object of a sleeping island wakes up the whole island
+        if (!sleep && m_island >= 0)
+        {
+            assert(object().world());
+            object().world()->islandManager().wakeIsland(m_island);
+        }
 
         // Optimization: dynamically remove from the integration vector
-        if (!object().isParticle())
+        MCWorld * world = object().world();
+        if (world && !object().isParticle())
         {
             if (sleep)
             {
-                MCWorld::instance().removeObjectFromIntegration(object());
+                world->removeObjectFromIntegration(object());
             }
             else
             {
-                MCWorld::instance().restoreObjectToIntegration(object());
+                world->restoreObjectToIntegration(object());
             }
         }
     }
@@ -290,70 +348,106 @@ bool MCPhysicsComponent::isStationary() const
     return m_isStationary;
 }
 
+bool MCPhysicsComponent::hasAngularMotion() const
+{
+    // Access the member directly to avoid copying the shared pointer on each step
+    return object().m_shape && m_momentOfInertia > 0.0f;
+}
+
+bool MCPhysicsComponent::isResting(int steps) const
+{
+    // Forces and impulses restart the count, so pending ones keep the object awake
+    return !m_isSleepingPrevented && m_sleepCount >= steps;
+}
+
+void MCPhysicsComponent::invalidateIntegration()
+{
+    m_state->m_validMask[m_slot] = 0;
+}
+
+void MCPhysicsComponent::updateActivity()
+{
+    m_state->setActive(m_slot, !m_isSleeping && !m_isStationary);
+
+    updateCollisionFilter();
+}
+
+void MCPhysicsComponent::updateCollisionFilter()
+{
+    if (hasObject())
+    {
+        object().updateCollisionFilter();
+    }
+}
+
 void MCPhysicsComponent::integrate(float step)
 {
     // Integrate, if the object is not sleeping and it doesn't
     // have a parent object.
     if (!m_isSleeping && (&object().parent() == &object()))
     {
-        m_isIntegrating = true;
-
-        integrateLinear(step);
-        const float angleDiff = integrateAngular(step);
-        object().checkBoundaries();
-
-        const float speed = m_velocity.lengthFast();
-        if (speed < m_linearSleepLimit && m_angularVelocity < m_angularSleepLimit)
+        // Use the result of the batch integration if nothing has changed since
+        if (!m_state->m_validMask[m_slot] || m_state->step() != step)
         {
-            if (++m_sleepCount > 1)
-            {
-                toggleSleep(true);
-                reset();
-            }
-        }
-        else
-        {
-            m_velocity.clampFast(m_maxSpeed);
-
-            m_forces.setZero();
-            m_linearImpulse.setZero();
-            m_angularImpulse = 0.0f;
-
-            object().rotate(object().angle() + angleDiff, false);
-            object().translate(object().location() + m_velocity);
-
-            m_sleepCount = 0;
+            m_state->integrateSlot(m_slot, step);
         }
 
-        m_isIntegrating = false;
+        finishIntegration(step);
     }
 }
 
-void MCPhysicsComponent::integrateLinear(float step)
+void MCPhysicsComponent::finishIntegration(float step)
 {
-    MCVector3dF totAcceleration(m_acceleration);
-    totAcceleration += m_forces * m_invMass;
-    m_velocity += totAcceleration * step + m_linearImpulse;
-    m_velocity *= m_linearDamping;
-}
+    m_isIntegrating = true;
 
-float MCPhysicsComponent::integrateAngular(float step)
-{
-    if (object().shape() && m_momentOfInertia > 0.0f)
+    invalidateIntegration();
+
+    MCPhysicsState & state = *m_state;
+    state.m_velocityX[m_slot] = state.m_newVelocityX[m_slot];
+    state.m_velocityY[m_slot] = state.m_newVelocityY[m_slot];
+    state.m_velocityZ[m_slot] = state.m_newVelocityZ[m_slot];
+    state.m_torque[m_slot] = 0.0f;
+
+    float angleDiff = 0;
+    if (hasAngularMotion())
     {
-        float totAngularAcceleration(m_angularAcceleration);
-        totAngularAcceleration += m_torque * m_invMomentOfInertia;
-        m_angularVelocity += totAngularAcceleration * step + m_angularImpulse;
-        m_angularVelocity *= m_angularDamping;
+        state.m_angularVelocity[m_slot] = state.m_newAngularVelocity[m_slot];
+        angleDiff = MCTrigonom::radToDeg(state.m_angularVelocity[m_slot] * step);
+    }
 
-        m_torque = 0.0f;
+    // Note that the event handlers may move the component to another state
+    object().checkBoundaries();
 
-        return MCTrigonom::radToDeg(m_angularVelocity * step);
+    MCVector3dF velocity(this->velocity());
+    const float speed = velocity.lengthFast();
+    if (speed < m_linearSleepLimit && std::fabs(angularVelocity()) < m_angularSleepLimit)
+    {
+        // MCWorld puts the object to sleep with its island when the whole island is resting.
+        // The forces are kept until then.
+        if (m_sleepCount < std::numeric_limits<int>::max())
+        {
+            m_sleepCount++;
+        }
     }
+    else
+    {
+        velocity.clampFast(m_maxSpeed);
+
+        m_state->m_velocityX[m_slot] = velocity.i();
+        m_state->m_velocityY[m_slot] = velocity.j();
+        m_state->m_velocityZ[m_slot] = velocity.k();
 
-    m_torque = 0.0f;
+        setForces(MCVector3dF());
+        setLinearImpulse(MCVector3dF());
+        m_state->m_angularImpulse[m_slot] = 0.0f;
 
-    return 0;
+        object().rotate(object().angle() + angleDiff, false);
+        object().translate(object().location() + velocity);
+
+        m_sleepCount = 0;
+    }
+
+    m_isIntegrating = false;
 }
 
 void MCPhysicsComponent::stepTime(int step)
@@ -363,17 +457,25 @@ void MCPhysicsComponent::stepTime(int step)
 
 void MCPhysicsComponent::reset()
 {
+    invalidateIntegration();
+
     // Reset linear motion
-    m_forces.setZero();
-    m_velocity.setZero();
-    m_acceleration.setZero();
-    m_linearImpulse.setZero();
+    setForces(MCVector3dF());
+    setLinearImpulse(MCVector3dF());
+
+    MCPhysicsState & state = *m_state;
+    state.m_velocityX[m_slot] = 0.0f;
+    state.m_velocityY[m_slot] = 0.0f;
+    state.m_velocityZ[m_slot] = 0.0f;
+    state.m_accelerationX[m_slot] = 0.0f;
+    state.m_accelerationY[m_slot] = 0.0f;
+    state.m_accelerationZ[m_slot] = 0.0f;
 
     // Reset angular motion
-    m_torque = 0.0f;
-    m_angularAcceleration = 0.0f;
-    m_angularVelocity = 0.0f;
-    m_angularImpulse = 0.0f;
+    state.m_torque[m_slot] = 0.0f;
+    state.m_angularAcceleration[m_slot] = 0.0f;
+    state.m_angularVelocity[m_slot] = 0.0f;
+    state.m_angularImpulse[m_slot] = 0.0f;
 
     for (auto child: object().children())
     {
@@ -384,6 +486,7 @@ void MCPhysicsComponent::reset()
 void MCPhysicsComponent::setCollisionTag(int tag)
 {
     m_collisionTag = tag;
+    updateCollisionFilter();
 }
 
 int MCPhysicsComponent::collisionTag() const
@@ -394,6 +497,7 @@ int MCPhysicsComponent::collisionTag() const
 void MCPhysicsComponent::setNeverCollideWithTag(int tag)
 {
     m_neverCollideWithTag = tag;
+    updateCollisionFilter();
 }
 
 int MCPhysicsComponent::neverCollideWithTag() const
@@ -403,14 +507,37 @@ int MCPhysicsComponent::neverCollideWithTag() const
 
 void MCPhysicsComponent::setAngularDamping(float angularDamping)
 {
-    m_angularDamping = angularDamping;
+    m_state->m_angularDamping[m_slot] = angularDamping;
+    invalidateIntegration();
 }
 
 void MCPhysicsComponent::setLinearDamping(float linearDamping)
 {
-    m_linearDamping = linearDamping;
+    m_state->m_linearDamping[m_slot] = linearDamping;
+    invalidateIntegration();
 }
 
 MCPhysicsComponent::~MCPhysicsComponent()
 {
+    m_state->release(m_slot);
+}
+
+void MCPhysicsComponent::saveState(MCStateBuffer & state) const
+{
+    state.write(m_isSleeping);
+    state.write(m_sleepCount);
+    state.write(m_island);
+
+    m_state->saveSlot(m_slot, state);
+}
+
+void MCPhysicsComponent::restoreState(MCStateBuffer & state)
+{
+    state.read(m_isSleeping);
+    state.read(m_sleepCount);
+    state.read(m_island);
+
+    m_state->restoreSlot(m_slot, state);
+
+    updateActivity();
 }
@@ -23,9 +23,13 @@
 #include "mcobjectcomponent.hh"
 #include "mcvector3d.hh"
 
+class MCPhysicsState;
+class MCStateBuffer;
+
 /** Implements physics integrations of an MCObject.
  *  The physics component is attached to an object and it operates
- *  through the public interface. */
+ *  through the public interface. The motion state is stored in a slot
+ *  of MCPhysicsState so that MCWorld can integrate all bodies in one pass. */
 class MCPhysicsComponent : public MCObjectComponent
 {
 public:
@@ -54,7 +58,7 @@ public:
     void setVelocity(const MCVector3dF & newVelocity);
 
     //! Return current velocity.
-    const MCVector3dF & velocity() const;
+    MCVector3dF velocity() const;
 
     //! Return current speed.
     float speed() const;
@@ -77,7 +81,7 @@ public:
     void setAcceleration(const MCVector3dF & newAcceleration);
 
     //! Return constant acceleration.
-    const MCVector3dF & acceleration() const;
+    MCVector3dF acceleration() const;
 
     /*! Add a force (N) vector to the object for a single frame.
      *  \param force Force vector to be added. */
@@ -141,8 +145,10 @@ public:
     //! Return true, if the object is sleeping.
     bool isSleeping() const;
 
-    /*! Object goes to sleep if linear and angular velocities drops below
-     *  these values. The defaults are 0.01. */
+    /*! Object can sleep if linear and angular velocities drop below these values.
+     *  MCWorld puts the object to sleep together with the objects it touches once all
+     *  of them have been below their limits long enough. The defaults are 0.01.
+     *  \see MCIslandManager */
     void setSleepLimits(float linearSleepLimit, float angularSleepLimit);
 
     //! The object won't sleep if enabled.
@@ -186,43 +192,44 @@ public:
     //! \reimp
     virtual void reset() override;
 
-private:
-
-    void integrate(float step);
-
-    void integrateLinear(float step);
-
-    float integrateAngular(float step);
+    //! Save the motion and the sleep state into the given buffer.
+    void saveState(MCStateBuffer & state) const;
 
-    float m_damping;
+    //! Restore the motion and the sleep state saved with saveState().
+    void restoreState(MCStateBuffer & state);
 
-    MCVector3dF m_acceleration;
-
-    MCVector3dF m_velocity;
+private:
 
-    float m_maxSpeed;
+    void integrate(float step);
 
-    float m_linearDamping;
+    /*! Commit the new velocities computed by MCPhysicsState and move the object.
+     *  The new angular velocity is used only if the object has angular motion. */
+    void finishIntegration(float step);
 
-    MCVector3dF m_linearImpulse;
+    bool hasAngularMotion() const;
 
-    MCVector3dF m_forces;
+    /*! \return true if the object has been below the sleep limits for the given
+     *  number of steps and there are no pending impulses or forces. */
+    bool isResting(int steps) const;
 
-    float m_angularAcceleration; // Radians / s^2
+    void setLinearImpulse(const MCVector3dF & linearImpulse);
 
-    float m_angularVelocity; // Radians / s
+    void setForces(const MCVector3dF & forces);
 
-    float m_angularDamping;
+    //! Discard the result of the last MCPhysicsState::integrate() call for this slot.
+    void invalidateIntegration();
 
-    float m_angularImpulse;
+    //! Include the slot in MCPhysicsState::integrate() if the object is awake.
+    void updateActivity();
 
-    float m_torque;
+    //! Update the collision filter of the object after the sleep state or a tag has changed.
+    void updateCollisionFilter();
 
-    float m_invMass;
+    MCPhysicsState * m_state;
 
-    float m_mass;
+    int m_slot;
 
-    float m_invMomentOfInertia;
+    float m_maxSpeed;
 
     float m_momentOfInertia;
 
@@ -242,11 +249,23 @@ private:
 
     float m_angularSleepLimit;
 
+    //! Number of consecutive steps below the sleep limits.
     int m_sleepCount;
 
+    //! Sleeping island of MCIslandManager or -1.
+    int m_island;
+
     int m_collisionTag;
 
     int m_neverCollideWithTag;
+
+    friend class MCForceRegistry;
+
+    friend class MCIslandManager;
+
+    friend class MCPhysicsState;
+
+    friend class MCWorld;
 };
 
 #endif // MCPHYSICSCOMPONENT_HH
@@ -0,0 +1,278 @@
+// This file belongs to the "MiniCore" game engine.
+// Copyright (C) 2018 Jussi Lind <jussi.lind@iki.fi>
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+// MA  02110-1301, USA.
+//
+
+#include "mcphysicsstate.hh"
+#include "mcphysicscomponent.hh"
+#include "mcstatebuffer.hh"
+
+#include <cassert>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+namespace {
+
+// The outputs of integrate() are the last arrays. They are not a part of the saved state.
+const unsigned int OUTPUT_ARRAY_COUNT = 4;
+
+// The same operation order as in the original per-component integration, so that
+// the scalar and the SSE versions produce identical results.
+inline float integrateVelocity(
+    float velocity, float acceleration, float force, float invMass, float impulse, float damping, float step)
+{
+    const float totAcceleration = acceleration + force * invMass;
+    return (velocity + (totAcceleration * step + impulse)) * damping;
+}
+
+#ifdef __SSE2__
+inline __m128 integrateVelocity(
+    __m128 velocity, __m128 acceleration, __m128 force, __m128 invMass, __m128 impulse, __m128 damping, __m128 step)
+{
+    const __m128 totAcceleration = _mm_add_ps(acceleration, _mm_mul_ps(force, invMass));
+    return _mm_mul_ps(_mm_add_ps(velocity, _mm_add_ps(_mm_mul_ps(totAcceleration, step), impulse)), damping);
+}
+#endif
+
+} // namespace
+
+MCPhysicsState::MCPhysicsState()
+    : m_step(0)
+{
+}
+
+MCPhysicsState::~MCPhysicsState()
+{
+    detachAll();
+}
+
+MCPhysicsState & MCPhysicsState::detachedState()
+{
+    static thread_local MCPhysicsState state;
+    return state;
+}
+
+std::array<MCPhysicsState::Array *, 25> MCPhysicsState::arrays()
+{
+    return {{
+        &m_velocityX, &m_velocityY, &m_velocityZ,
+        &m_accelerationX, &m_accelerationY, &m_accelerationZ,
+        &m_forceX, &m_forceY, &m_forceZ,
+        &m_linearImpulseX, &m_linearImpulseY, &m_linearImpulseZ,
+        &m_invMass, &m_mass, &m_linearDamping,
+        &m_angularVelocity, &m_angularAcceleration, &m_angularImpulse, &m_torque,
+        &m_invMomentOfInertia, &m_angularDamping,
+        &m_newVelocityX, &m_newVelocityY, &m_newVelocityZ, &m_newAngularVelocity}};
+}
+
+int MCPhysicsState::allocate(MCPhysicsComponent & component)
+{
+    for (Array * array : arrays())
+    {
+        array->push_back(0);
+    }
+
+    m_activeMask.push_back(0);
+    m_validMask.push_back(0);
+    m_components.push_back(&component);
+
+    return static_cast<int>(m_components.size()) - 1;
+}
+
+void MCPhysicsState::release(int slot)
+{
+    assert(slot >= 0 && slot < static_cast<int>(m_components.size()));
+
+    // Swap with the last slot (O(1))
+    for (Array * array : arrays())
+    {
+        (*array)[slot] = array->back();
+        array->pop_back();
+    }
+
+    m_activeMask[slot] = m_activeMask.back();
+    m_activeMask.pop_back();
+    m_validMask[slot] = m_validMask.back();
+    m_validMask.pop_back();
+
+    m_components[slot] = m_components.back();
+    m_components[slot]->m_slot = slot;
+    m_components.pop_back();
+}
+
+void MCPhysicsState::attach(MCPhysicsComponent & component)
+{
+    MCPhysicsState & oldState = *component.m_state;
+    if (&oldState == this)
+    {
+        return;
+    }
+
+    const int oldSlot = component.m_slot;
+    const int newSlot = allocate(component);
+
+    const auto newArrays = arrays();
+    const auto oldArrays = oldState.arrays();
+    for (unsigned int i = 0; i < newArrays.size(); i++)
+    {
+        (*newArrays[i])[newSlot] = (*oldArrays[i])[oldSlot];
+    }
+
+    m_activeMask[newSlot] = oldState.m_activeMask[oldSlot];
+
+    oldState.release(oldSlot);
+
+    component.m_state = this;
+    component.m_slot = newSlot;
+}
+
+void MCPhysicsState::detachAll()
+{
+    MCPhysicsState & detachedState = MCPhysicsState::detachedState();
+    if (this != &detachedState)
+    {
+        while (!m_components.empty())
+        {
+            detachedState.attach(*m_components.back());
+        }
+    }
+}
+
+unsigned int MCPhysicsState::size() const
+{
+    return static_cast<unsigned int>(m_components.size());
+}
+
+MCPhysicsComponent & MCPhysicsState::component(unsigned int slot) const
+{
+    assert(slot < m_components.size());
+    return *m_components[slot];
+}
+
+void MCPhysicsState::saveSlot(int slot, MCStateBuffer & state) const
+{
+    const auto inputs = const_cast<MCPhysicsState *>(this)->arrays();
+    for (unsigned int i = 0; i < inputs.size() - OUTPUT_ARRAY_COUNT; i++)
+    {
+        state.write((*inputs[i])[slot]);
+    }
+}
+
+void MCPhysicsState::restoreSlot(int slot, MCStateBuffer & state)
+{
+    const auto inputs = arrays();
+    for (unsigned int i = 0; i < inputs.size() - OUTPUT_ARRAY_COUNT; i++)
+    {
+        state.read((*inputs[i])[slot]);
+    }
+
+    m_validMask[slot] = 0;
+}
+
+void MCPhysicsState::setActive(int slot, bool active)
+{
+    m_activeMask[slot] = active ? ~0u : 0u;
+}
+
+void MCPhysicsState::integrateSlot(int slot, float step)
+{
+    const float invMass = m_invMass[slot];
+    const float damping = m_linearDamping[slot];
+
+    m_newVelocityX[slot] = integrateVelocity(
+        m_velocityX[slot], m_accelerationX[slot], m_forceX[slot], invMass, m_linearImpulseX[slot], damping, step);
+    m_newVelocityY[slot] = integrateVelocity(
+        m_velocityY[slot], m_accelerationY[slot], m_forceY[slot], invMass, m_linearImpulseY[slot], damping, step);
+    m_newVelocityZ[slot] = integrateVelocity(
+        m_velocityZ[slot], m_accelerationZ[slot], m_forceZ[slot], invMass, m_linearImpulseZ[slot], damping, step);
+
+    m_newAngularVelocity[slot] = integrateVelocity(
+        m_angularVelocity[slot], m_angularAcceleration[slot], m_torque[slot],
+        m_invMomentOfInertia[slot], m_angularImpulse[slot], m_angularDamping[slot], step);
+}
+
+void MCPhysicsState::integrateScalar(unsigned int begin, unsigned int end)
+{
+    for (unsigned int i = begin; i < end; i++)
+    {
+        if (m_activeMask[i])
+        {
+            integrateSlot(i, m_step);
+        }
+    }
+}
+
+#ifdef __SSE2__
+void MCPhysicsState::integrateSse(unsigned int end)
+{
+    const __m128 step = _mm_set1_ps(m_step);
+
+    for (unsigned int i = 0; i + 4 <= end; i += 4)
+    {
+        const __m128 mask = _mm_castsi128_ps(
+            _mm_loadu_si128(reinterpret_cast<const __m128i *>(&m_activeMask[i])));
+
+        // Skip blocks of sleeping bodies
+        if (!_mm_movemask_ps(mask))
+        {
+            continue;
+        }
+
+        // Outputs of inactive slots are computed as well, but they are never marked valid
+        const __m128 invMass = _mm_loadu_ps(&m_invMass[i]);
+        const __m128 damping = _mm_loadu_ps(&m_linearDamping[i]);
+
+        _mm_storeu_ps(&m_newVelocityX[i], integrateVelocity(
+            _mm_loadu_ps(&m_velocityX[i]), _mm_loadu_ps(&m_accelerationX[i]), _mm_loadu_ps(&m_forceX[i]),
+            invMass, _mm_loadu_ps(&m_linearImpulseX[i]), damping, step));
+        _mm_storeu_ps(&m_newVelocityY[i], integrateVelocity(
+            _mm_loadu_ps(&m_velocityY[i]), _mm_loadu_ps(&m_accelerationY[i]), _mm_loadu_ps(&m_forceY[i]),
+            invMass, _mm_loadu_ps(&m_linearImpulseY[i]), damping, step));
+        _mm_storeu_ps(&m_newVelocityZ[i], integrateVelocity(
+            _mm_loadu_ps(&m_velocityZ[i]), _mm_loadu_ps(&m_accelerationZ[i]), _mm_loadu_ps(&m_forceZ[i]),
+            invMass, _mm_loadu_ps(&m_linearImpulseZ[i]), damping, step));
+        _mm_storeu_ps(&m_newAngularVelocity[i], integrateVelocity(
+            _mm_loadu_ps(&m_angularVelocity[i]), _mm_loadu_ps(&m_angularAcceleration[i]), _mm_loadu_ps(&m_torque[i]),
+            _mm_loadu_ps(&m_invMomentOfInertia[i]), _mm_loadu_ps(&m_angularImpulse[i]),
+            _mm_loadu_ps(&m_angularDamping[i]), step));
+    }
+}
+#endif
+
+void MCPhysicsState::integrate(float step)
+{
+    m_step = step;
+
+    const unsigned int count = size();
+
+#ifdef __SSE2__
+    const unsigned int simdCount = count - count % 4;
+    integrateSse(simdCount);
+    integrateScalar(simdCount, count);
+#else
+    integrateScalar(0, count);
+#endif
+
+    m_validMask = m_activeMask;
+}
+
+float MCPhysicsState::step() const
+{
+    return m_step;
+}
@@ -0,0 +1,178 @@
+// This file belongs to the "MiniCore" game engine.
+// Copyright (C) 2018 Jussi Lind <jussi.lind@iki.fi>
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+// MA  02110-1301, USA.
+//
+
+#ifndef MCPHYSICSSTATE_HH
+#define MCPHYSICSSTATE_HH
+
+#include "mcmacros.hh"
+
+#include <array>
+#include <vector>
+
+class MCPhysicsComponent;
+class MCStateBuffer;
+
+/*! \class MCPhysicsState
+ *  \brief Structure-of-arrays storage for the motion state of physics components.
+ *
+ *  Each MCPhysicsComponent owns a slot in exactly one state. The component only
+ *  stores the slot index and reads and writes its velocity, forces, impulses,
+ *  mass and damping from the arrays here. Components of objects that are
+ *  added to MCWorld live in the state of the world so that all awake bodies can
+ *  be integrated in one pass. Other components live in detachedState().
+ *
+ *  Integration is done in two parts: integrate() computes the new velocities of
+ *  all awake bodies into separate output arrays, and the component commits its
+ *  own result in MCPhysicsComponent::stepTime(), which also handles sleeping and
+ *  moves the object. If the motion state of a component is modified between the
+ *  two parts, the component integrates itself with the same arithmetic instead. */
+class MCPhysicsState
+{
+public:
+
+    //! Constructor.
+    MCPhysicsState();
+
+    //! Destructor. Moves the remaining components to detachedState().
+    ~MCPhysicsState();
+
+    /*! \return the state of the calling thread that holds the components not attached
+     *  to any other state. Objects must be destroyed in the thread that created them. */
+    static MCPhysicsState & detachedState();
+
+    //! Move the slot of the given component into this state.
+    void attach(MCPhysicsComponent & component);
+
+    //! Move all components of this state to detachedState().
+    void detachAll();
+
+    //! \return number of slots.
+    unsigned int size() const;
+
+    //! \return the component of the given slot.
+    MCPhysicsComponent & component(unsigned int slot) const;
+
+    //! Save the inputs of the given slot into the given buffer.
+    void saveSlot(int slot, MCStateBuffer & state) const;
+
+    //! Restore the inputs of the given slot saved with saveSlot().
+    void restoreSlot(int slot, MCStateBuffer & state);
+
+    //! Include the given slot in integrate() calls.
+    void setActive(int slot, bool active);
+
+    /*! Compute new velocities of all active slots in one pass. A result stays
+     *  valid until the component modifies its motion state.
+     *  \param step Time step in seconds. */
+    void integrate(float step);
+
+    //! \return time step of the last integrate() call.
+    float step() const;
+
+private:
+
+    DISABLE_COPY(MCPhysicsState);
+    DISABLE_ASSI(MCPhysicsState);
+
+    int allocate(MCPhysicsComponent & component);
+
+    void release(int slot);
+
+    //! Scalar version of integrate() for one slot.
+    void integrateSlot(int slot, float step);
+
+    void integrateScalar(unsigned int begin, unsigned int end);
+
+    void integrateSse(unsigned int end);
+
+    typedef std::vector<float> Array;
+
+    //! All arrays that are indexed by slot.
+    std::array<Array *, 25> arrays();
+
+    std::vector<MCPhysicsComponent *> m_components;
+
+    // Inputs
+
+    Array m_velocityX;
+
+    Array m_velocityY;
+
+    Array m_velocityZ;
+
+    Array m_accelerationX;
+
+    Array m_accelerationY;
+
+    Array m_accelerationZ;
+
+    Array m_forceX;
+
+    Array m_forceY;
+
+    Array m_forceZ;
+
+    Array m_linearImpulseX;
+
+    Array m_linearImpulseY;
+
+    Array m_linearImpulseZ;
+
+    Array m_invMass;
+
+    Array m_mass;
+
+    Array m_linearDamping;
+
+    Array m_angularVelocity;
+
+    Array m_angularAcceleration;
+
+    Array m_angularImpulse;
+
+    Array m_torque;
+
+    Array m_invMomentOfInertia;
+
+    Array m_angularDamping;
+
+    // Outputs of integrate()
+
+    Array m_newVelocityX;
+
+    Array m_newVelocityY;
+
+    Array m_newVelocityZ;
+
+    Array m_newAngularVelocity;
+
+    //! All bits set if the slot is integrated by integrate().
+    std::vector<unsigned int> m_activeMask;
+
+    //! All bits set if the outputs are valid for the current inputs.
+    std::vector<unsigned int> m_validMask;
+
+    float m_step;
+
+    friend class MCForceRegistry;
+
+    friend class MCPhysicsComponent;
+};
+
+#endif // MCPHYSICSSTATE_HH
@@ -18,9 +18,9 @@
 //
 
 #include "mcrectshape.hh"
-#include "mccamera.hh"
 #include "mcobject.hh"
 #include "mcmathutil.hh"
+#include "mcstatebuffer.hh"
 
 #include <cmath>
 
@@ -115,6 +115,28 @@ void MCRectShape::rotate(float a)
     m_obbox.rotate(a);
 }
 
+void MCRectShape::saveState(MCStateBuffer & state) const
+{
+    MCShape::saveState(state);
+
+    // The cached vertices depend on the rotations done so far
+    state.write(m_obbox.angle());
+    state.write(m_obbox.vertexVector(0));
+    state.write(m_obbox.vertexVector(1));
+}
+
+void MCRectShape::restoreState(MCStateBuffer & state)
+{
+    MCShape::restoreState(state);
+
+    float angle = 0;
+    state.read(angle);
+    MCVector2dF v0, v1;
+    state.read(v0);
+    state.read(v1);
+    m_obbox.setRotation(angle, v0, v1);
+}
+
 MCBBox<float> MCRectShape::bbox() const
 {
     return m_obbox.bbox();
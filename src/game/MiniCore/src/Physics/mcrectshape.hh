@@ -63,6 +63,12 @@ public:
     //! \reimp
     virtual MCVector2dF contactNormal(const MCSegmentF & p) const override;
 
+    //! \reimp
+    virtual void saveState(MCStateBuffer & state) const override;
+
+    //! \reimp
+    virtual void restoreState(MCStateBuffer & state) override;
+
     //! \brief Resize
     void resize(float width, float height);
 
@@ -18,15 +18,25 @@
 //
 
 #include "mcshape.hh"
-#include "mccamera.hh"
+#include "mcobject.hh"
+#include "mcstatebuffer.hh"
+#include "mcworld.hh"
+
+#include <cmath>
+#include <limits>
 
 unsigned int MCShape::m_typeCount = 0;
 
 MCVector3dF MCShape::m_defaultShadowOffset = MCVector3dF(2, -2, 0.5f);
 
+// Never equal to MCWorld::stepCount() in practice, so nothing is interpolated
+static const unsigned int NO_PREVIOUS_TRANSFORM = std::numeric_limits<unsigned int>::max();
+
 MCShape::MCShape(MCShapeViewPtr view)
     : m_parent(nullptr)
     , m_angle(0)
+    , m_previousAngle(0)
+    , m_previousTransformStep(NO_PREVIOUS_TRANSFORM)
     , m_radius(0)
 {
     if (view)
@@ -70,7 +80,11 @@ void MCShape::render(MCCamera * p)
 {
     if (m_view)
     {
-        m_view->render(m_location, m_angle, p);
+        MCVector3dF location;
+        float angle;
+        renderTransform(location, angle);
+
+        m_view->render(location, angle, p);
     }
 }
 
@@ -78,18 +92,24 @@ void MCShape::renderShadow(MCCamera * p)
 {
     if (m_view)
     {
+        MCVector3dF location;
+        float angle;
+        renderTransform(location, angle);
+
         const MCVector3dF shadowLocation(
-            m_shadowOffset.i() + m_location.i(),
-            m_shadowOffset.j() + m_location.j(),
+            m_shadowOffset.i() + location.i(),
+            m_shadowOffset.j() + location.j(),
             m_shadowOffset.k()
         );
 
-        m_view->renderShadow(shadowLocation, m_angle, p);
+        m_view->renderShadow(shadowLocation, angle, p);
     }
 }
 
 void MCShape::translate(const MCVector3dF & p)
 {
+    storePreviousTransform();
+
     m_location = p;
 }
 
@@ -115,9 +135,72 @@ const MCVector3dF & MCShape::shadowOffset() const
 
 void MCShape::rotate(float newAngle)
 {
+    storePreviousTransform();
+
     m_angle = newAngle;
 }
 
+const MCWorld * MCShape::world() const
+{
+    if (m_parent)
+    {
+        return m_parent->isRenderOnly() ? m_parent->parent().world() : m_parent->world();
+    }
+
+    return nullptr;
+}
+
+void MCShape::storePreviousTransform()
+{
+    if (const MCWorld * parentWorld = this->world())
+    {
+        const MCWorld & world = *parentWorld;
+        if (world.isStepping())
+        {
+            if (m_previousTransformStep != world.stepCount())
+            {
+                m_previousLocation = m_location;
+                m_previousAngle = m_angle;
+                m_previousTransformStep = world.stepCount();
+            }
+        }
+        else
+        {
+            // Moves between the steps are not interpolated
+            m_previousTransformStep = NO_PREVIOUS_TRANSFORM;
+        }
+    }
+}
+
+void MCShape::renderTransform(MCVector3dF & location, float & angle) const
+{
+    location = m_location;
+    angle = m_angle;
+
+    if (const MCWorld * parentWorld = this->world())
+    {
+        const MCWorld & world = *parentWorld;
+        const float alpha = world.renderInterpolation();
+        if (alpha < 1.0f && m_previousTransformStep == world.stepCount())
+        {
+            location = m_previousLocation + (m_location - m_previousLocation) * alpha;
+
+            // Rotate via the shorter direction
+            float angleDiff = std::fmod(m_angle - m_previousAngle, 360.0f);
+            if (angleDiff > 180.0f)
+            {
+                angleDiff -= 360.0f;
+            }
+            else if (angleDiff < -180.0f)
+            {
+                angleDiff += 360.0f;
+            }
+
+            angle = m_previousAngle + angleDiff * alpha;
+        }
+    }
+}
+
 float MCShape::angle() const
 {
     return m_angle;
@@ -140,3 +223,28 @@ bool MCShape::mayIntersect(MCShape & other)
         m_location.i() - m_radius > other.m_location.i() + other.m_radius ||
         m_location.j() - m_radius > other.m_location.j() + other.m_radius);
 }
+
+void MCShape::saveState(MCStateBuffer & state) const
+{
+    state.write(m_location);
+    state.write(m_angle);
+    state.write(m_previousLocation);
+    state.write(m_previousAngle);
+    state.write(m_previousTransformStep);
+}
+
+void MCShape::restoreState(MCStateBuffer & state)
+{
+    MCVector3dF location;
+    state.read(location);
+    float angle = 0;
+    state.read(angle);
+
+    // Derived shapes update their caches
+    translate(location);
+    rotate(angle);
+
+    state.read(m_previousLocation);
+    state.read(m_previousAngle);
+    state.read(m_previousTransformStep);
+}
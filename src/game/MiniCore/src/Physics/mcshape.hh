@@ -33,6 +33,8 @@
 #include <memory>
 
 class MCObject;
+class MCStateBuffer;
+class MCWorld;
 class MCCamera;
 
 /*! \class MCShape.
@@ -132,8 +134,25 @@ public:
     //! Fast intersection test
     bool mayIntersect(MCShape & other);
 
+    /*! Get the transform used for rendering. This is interpolated between the
+     *  transforms before and after the latest step of MCWorld if the shape
+     *  was moved on that step. \see MCWorld::setRenderInterpolation() */
+    void renderTransform(MCVector3dF & location, float & angle) const;
+
+    //! Save the transform into the given buffer.
+    virtual void saveState(MCStateBuffer & state) const;
+
+    //! Restore the transform saved with saveState().
+    virtual void restoreState(MCStateBuffer & state);
+
 private:
 
+    //! Store the transform before the first change on the current step of MCWorld.
+    void storePreviousTransform();
+
+    //! \return world of the parent object, or of its parent if the object is render-only.
+    const MCWorld * world() const;
+
     //! Disable copy constructor and assignment
     DISABLE_COPY(MCShape);
     DISABLE_ASSI(MCShape);
@@ -150,6 +169,14 @@ private:
 
     float m_angle;
 
+    MCVector3dF m_previousLocation;
+
+    float m_previousAngle;
+
+    //! MCWorld::stepCount() of the step the previous transform was stored on,
+    //! or a sentinel if it hasn't been stored since the last move between the steps.
+    unsigned int m_previousTransformStep;
+
     float m_radius;
 
     MCShapeViewPtr m_view;
@@ -0,0 +1,704 @@
+// This file belongs to the "MiniCore" game engine.
+// Copyright (C) 2018 Jussi Lind <jussi.lind@iki.fi>
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+// MA  02110-1301, USA.
+//
+
+#include "mcsweepandprune.hh"
+#include "mcobject.hh"
+#include "mcphysicscomponent.hh"
+#include "mcshape.hh"
+#include "mcstatebuffer.hh"
+
+#include <algorithm>
+
+namespace {
+
+const unsigned int REMOVED_PROXY = ~0u;
+
+//! Inserting more proxies than this at once re-sorts the arrays instead of sorting each proxy into place.
+const size_t BATCH_INSERT_COUNT = 32;
+
+const unsigned int END_OF_CELLS = ~0u;
+
+inline unsigned int clampedCellIndex(float value, float help, unsigned int size)
+{
+    const int index = static_cast<int>(value * help);
+    return index < 0 ? 0 : (index >= static_cast<int>(size) ? size - 1 : static_cast<unsigned int>(index));
+}
+
+} // namespace
+
+MCSweepAndPrune::MCSweepAndPrune(float x1, float y1, float x2, float y2, float cellW, float cellH)
+  : m_removedCount(0)
+  , m_maxDynamicWidth(0)
+  , m_viewArea(x1, y1, x2, y2)
+  , m_viewHorSize(std::max(1u, static_cast<unsigned int>((x2 - x1) / cellW)))
+  , m_viewVerSize(std::max(1u, static_cast<unsigned int>((y2 - y1) / cellH)))
+  , m_viewHelpHor(static_cast<float>(m_viewHorSize) / (x2 - x1))
+  , m_viewHelpVer(static_cast<float>(m_viewVerSize) / (y2 - y1))
+  , m_viewCells(m_viewHorSize * m_viewVerSize)
+{
+}
+
+void MCSweepAndPrune::viewCellRange(const MCBBox<float> & bbox, unsigned int (&range)[4]) const
+{
+    range[0] = clampedCellIndex(bbox.x1() - m_viewArea.x1(), m_viewHelpHor, m_viewHorSize);
+    range[1] = clampedCellIndex(bbox.x2() - m_viewArea.x1(), m_viewHelpHor, m_viewHorSize);
+    range[2] = clampedCellIndex(bbox.y1() - m_viewArea.y1(), m_viewHelpVer, m_viewVerSize);
+    range[3] = clampedCellIndex(bbox.y2() - m_viewArea.y1(), m_viewHelpVer, m_viewVerSize);
+}
+
+MCBBox<float> MCSweepAndPrune::viewBBox(const MCObject & object)
+{
+    // Objects without a view are never visited, but they may get a view later
+    return object.shape()->view() ?
+        object.shape()->view()->bbox().translated(MCVector2dF(object.location())) : object.shape()->bbox();
+}
+
+void MCSweepAndPrune::insertView(unsigned int proxyIndex)
+{
+    Proxy & proxy = m_proxies[proxyIndex];
+    viewCellRange(viewBBox(*proxy.m_object), proxy.m_viewCells);
+
+    for (unsigned int j = proxy.m_viewCells[2]; j <= proxy.m_viewCells[3]; j++)
+    {
+        for (unsigned int i = proxy.m_viewCells[0]; i <= proxy.m_viewCells[1]; i++)
+        {
+            m_viewCells[j * m_viewHorSize + i].push_back(proxyIndex);
+        }
+    }
+}
+
+void MCSweepAndPrune::removeView(unsigned int proxyIndex)
+{
+    const Proxy & proxy = m_proxies[proxyIndex];
+    for (unsigned int j = proxy.m_viewCells[2]; j <= proxy.m_viewCells[3]; j++)
+    {
+        for (unsigned int i = proxy.m_viewCells[0]; i <= proxy.m_viewCells[1]; i++)
+        {
+            // Order within a cell doesn't matter: swap with the last one (O(1))
+            auto & cell = m_viewCells[j * m_viewHorSize + i];
+            *std::find(cell.begin(), cell.end(), proxyIndex) = cell.back();
+            cell.pop_back();
+        }
+    }
+}
+
+void MCSweepAndPrune::updateView(unsigned int proxyIndex)
+{
+    const Proxy & proxy = m_proxies[proxyIndex];
+    unsigned int range[4];
+    viewCellRange(viewBBox(*proxy.m_object), range);
+    if (!std::equal(range, range + 4, proxy.m_viewCells))
+    {
+        removeView(proxyIndex);
+        insertView(proxyIndex);
+    }
+}
+
+void MCSweepAndPrune::insert(MCObject & object)
+{
+    if (!object.shape() || m_proxyIndices.count(&object))
+    {
+        return;
+    }
+
+    const unsigned int proxyIndex = static_cast<unsigned int>(m_proxies.size());
+
+    Proxy proxy = {};
+    proxy.m_object = &object;
+    proxy.m_isStatic = object.physicsComponent().isStationary();
+    proxy.m_isQueryOnly = object.bypassCollisions();
+    proxy.m_isMoved = !proxy.m_isQueryOnly;
+    m_proxies.push_back(proxy);
+    m_overlaps.emplace_back();
+    m_proxyIndices[&object] = proxyIndex;
+    insertView(proxyIndex);
+
+    if (!proxy.m_isQueryOnly)
+    {
+        m_insertedProxies.push_back(proxyIndex);
+    }
+}
+
+bool MCSweepAndPrune::update(MCObject & object)
+{
+    const auto iter = m_proxyIndices.find(&object);
+    if (iter == m_proxyIndices.end())
+    {
+        return false;
+    }
+
+    Proxy & proxy = m_proxies[iter->second];
+    if (proxy.m_isStatic != object.physicsComponent().isStationary() ||
+        proxy.m_isQueryOnly != object.bypassCollisions())
+    {
+        remove(object);
+        insert(object);
+    }
+    else
+    {
+        if (!proxy.m_isMoved && !proxy.m_isQueryOnly)
+        {
+            proxy.m_isMoved = true;
+            m_movedProxies.push_back(iter->second);
+        }
+
+        updateView(iter->second);
+    }
+
+    return true;
+}
+
+bool MCSweepAndPrune::remove(MCObject & object)
+{
+    const auto iter = m_proxyIndices.find(&object);
+    if (iter == m_proxyIndices.end())
+    {
+        return false;
+    }
+
+    // Only mark the slot free. The endpoints of removed proxies are skipped
+    // until compact() drops them.
+    removeView(iter->second);
+    m_proxies[iter->second].m_object = nullptr;
+    m_proxyIndices.erase(iter);
+    m_removedCount++;
+
+    return true;
+}
+
+void MCSweepAndPrune::removeAll()
+{
+    m_proxies.clear();
+    m_proxyIndices.clear();
+    m_overlaps.clear();
+    m_endPoints[0].clear();
+    m_endPoints[1].clear();
+    m_insertedProxies.clear();
+    m_movedProxies.clear();
+    m_hotProxies.clear();
+    m_collidingProxies.clear();
+    m_activeProxies.clear();
+    m_removedCount = 0;
+    m_maxDynamicWidth = 0;
+
+    for (auto && cell : m_viewCells)
+    {
+        cell.clear();
+    }
+}
+
+void MCSweepAndPrune::compact()
+{
+    // Compact only when at least half of the slots are free so that removal stays O(1) amortized
+    if (!m_removedCount || m_removedCount * 2 < m_proxies.size())
+    {
+        return;
+    }
+
+    // Move the live proxies to a dense range without changing their order
+    m_proxyRemap.resize(m_proxies.size());
+    unsigned int liveCount = 0;
+    for (unsigned int i = 0; i < m_proxies.size(); i++)
+    {
+        if (m_proxies[i].m_object)
+        {
+            if (liveCount != i)
+            {
+                m_proxies[liveCount] = m_proxies[i];
+                m_overlaps[liveCount] = std::move(m_overlaps[i]);
+                m_proxyIndices[m_proxies[liveCount].m_object] = liveCount;
+            }
+
+            m_proxyRemap[i] = liveCount++;
+        }
+        else
+        {
+            m_proxyRemap[i] = REMOVED_PROXY;
+        }
+    }
+
+    m_proxies.resize(liveCount);
+    m_overlaps.resize(liveCount);
+
+    const auto remap = [this] (std::vector<unsigned int> & proxyIndices) {
+        size_t count = 0;
+        for (unsigned int proxyIndex : proxyIndices)
+        {
+            if (m_proxyRemap[proxyIndex] != REMOVED_PROXY)
+            {
+                proxyIndices[count++] = m_proxyRemap[proxyIndex];
+            }
+        }
+        proxyIndices.resize(count);
+    };
+
+    for (auto && overlaps : m_overlaps)
+    {
+        remap(overlaps);
+    }
+
+    for (auto && cell : m_viewCells)
+    {
+        remap(cell);
+    }
+
+    remap(m_insertedProxies);
+    remap(m_movedProxies);
+    remap(m_collidingProxies);
+
+    // Removing doesn't change the order of the remaining endpoints
+    for (auto && endPoints : m_endPoints)
+    {
+        size_t count = 0;
+        for (auto && endPoint : endPoints)
+        {
+            const unsigned int proxyIndex = m_proxyRemap[endPoint.m_proxyIndex];
+            if (proxyIndex != REMOVED_PROXY)
+            {
+                endPoints[count] = endPoint;
+                endPoints[count].m_proxyIndex = proxyIndex;
+                count++;
+            }
+        }
+        endPoints.resize(count);
+    }
+
+    updateEndPointIndices();
+
+    m_removedCount = 0;
+}
+
+void MCSweepAndPrune::updateEndPointIndices()
+{
+    for (unsigned int axis = 0; axis < 2; axis++)
+    {
+        for (unsigned int index = 0; index < m_endPoints[axis].size(); index++)
+        {
+            setEndPointIndex(m_endPoints[axis][index], axis, index);
+        }
+    }
+}
+
+bool MCSweepAndPrune::endPointLess(const EndPoint & left, const EndPoint & right)
+{
+    // Min points go first on ties so that touching boxes overlap
+    return left.m_value < right.m_value || (left.m_value == right.m_value && left.m_isMin && !right.m_isMin);
+}
+
+bool MCSweepAndPrune::bboxesOverlap(const MCBBox<float> & bbox1, const MCBBox<float> & bbox2)
+{
+    return bbox1.x1() <= bbox2.x2() && bbox1.x2() >= bbox2.x1() && bbox1.y1() <= bbox2.y2() && bbox1.y2() >= bbox2.y1();
+}
+
+void MCSweepAndPrune::setBBox(Proxy & proxy, const MCBBox<float> & bbox)
+{
+    proxy.m_bbox = bbox;
+    if (!proxy.m_isStatic)
+    {
+        m_maxDynamicWidth = std::max(m_maxDynamicWidth, bbox.width());
+    }
+}
+
+void MCSweepAndPrune::setEndPointIndex(const EndPoint & endPoint, unsigned int axis, unsigned int index)
+{
+    Proxy & proxy = m_proxies[endPoint.m_proxyIndex];
+    (endPoint.m_isMin ? proxy.m_minIndex : proxy.m_maxIndex)[axis] = index;
+}
+
+void MCSweepAndPrune::insertEndPoints(unsigned int proxyIndex)
+{
+    Proxy & proxy = m_proxies[proxyIndex];
+    setBBox(proxy, proxy.m_object->shape()->bbox());
+
+    // Append to the ends and sort into place. This finds the overlaps like moving does.
+    const float mins[] = {proxy.m_bbox.x1(), proxy.m_bbox.y1()};
+    const float maxs[] = {proxy.m_bbox.x2(), proxy.m_bbox.y2()};
+    for (unsigned int axis = 0; axis < 2; axis++)
+    {
+        auto & endPoints = m_endPoints[axis];
+        const unsigned int minIndex = static_cast<unsigned int>(endPoints.size());
+        endPoints.push_back({mins[axis], proxyIndex, true});
+        endPoints.push_back({maxs[axis], proxyIndex, false});
+        proxy.m_minIndex[axis] = minIndex;
+        proxy.m_maxIndex[axis] = minIndex + 1;
+
+        sortEndPoint(axis, proxy.m_minIndex[axis]);
+        sortEndPoint(axis, proxy.m_maxIndex[axis]);
+    }
+}
+
+void MCSweepAndPrune::appendEndPoints(unsigned int proxyIndex)
+{
+    Proxy & proxy = m_proxies[proxyIndex];
+    setBBox(proxy, proxy.m_object->shape()->bbox());
+
+    const float mins[] = {proxy.m_bbox.x1(), proxy.m_bbox.y1()};
+    const float maxs[] = {proxy.m_bbox.x2(), proxy.m_bbox.y2()};
+    for (unsigned int axis = 0; axis < 2; axis++)
+    {
+        m_endPoints[axis].push_back({mins[axis], proxyIndex, true});
+        m_endPoints[axis].push_back({maxs[axis], proxyIndex, false});
+    }
+}
+
+void MCSweepAndPrune::mergeEndPoints(size_t sortedCount)
+{
+    for (auto && endPoints : m_endPoints)
+    {
+        const auto sortedEnd = endPoints.begin() + static_cast<std::ptrdiff_t>(sortedCount);
+        std::sort(sortedEnd, endPoints.end(), endPointLess);
+        std::inplace_merge(endPoints.begin(), sortedEnd, endPoints.end(), endPointLess);
+    }
+
+    updateEndPointIndices();
+}
+
+void MCSweepAndPrune::updateOverlaps()
+{
+    for (auto && overlaps : m_overlaps)
+    {
+        overlaps.clear();
+    }
+
+    // Sweep the X-axis. The proxies whose X-ranges contain the current endpoint are active.
+    m_activeProxies.clear();
+    for (auto && endPoint : m_endPoints[0])
+    {
+        const unsigned int proxyIndex1 = endPoint.m_proxyIndex;
+        const Proxy & proxy1 = m_proxies[proxyIndex1];
+        if (!proxy1.m_object)
+        {
+            continue;
+        }
+
+        if (endPoint.m_isMin)
+        {
+            for (unsigned int proxyIndex2 : m_activeProxies)
+            {
+                const Proxy & proxy2 = m_proxies[proxyIndex2];
+                if (!(proxy1.m_isStatic && proxy2.m_isStatic) && bboxesOverlap(proxy1.m_bbox, proxy2.m_bbox))
+                {
+                    m_overlaps[proxyIndex1].push_back(proxyIndex2);
+                    m_overlaps[proxyIndex2].push_back(proxyIndex1);
+                }
+            }
+
+            m_activeProxies.push_back(proxyIndex1);
+        }
+        else
+        {
+            const auto iter = std::find(m_activeProxies.begin(), m_activeProxies.end(), proxyIndex1);
+            *iter = m_activeProxies.back();
+            m_activeProxies.pop_back();
+        }
+    }
+}
+
+void MCSweepAndPrune::moveEndPoints(unsigned int proxyIndex)
+{
+    Proxy & proxy = m_proxies[proxyIndex];
+    const MCBBox<float> bbox = proxy.m_object->shape()->bbox();
+    if (bbox.x1() == proxy.m_bbox.x1() && bbox.y1() == proxy.m_bbox.y1() &&
+        bbox.x2() == proxy.m_bbox.x2() && bbox.y2() == proxy.m_bbox.y2())
+    {
+        return;
+    }
+
+    setBBox(proxy, bbox);
+
+    const float mins[] = {bbox.x1(), bbox.y1()};
+    const float maxs[] = {bbox.x2(), bbox.y2()};
+    for (unsigned int axis = 0; axis < 2; axis++)
+    {
+        auto & endPoints = m_endPoints[axis];
+        const bool isMaxMovingUp = maxs[axis] > endPoints[proxy.m_maxIndex[axis]].m_value;
+        endPoints[proxy.m_minIndex[axis]].m_value = mins[axis];
+        endPoints[proxy.m_maxIndex[axis]].m_value = maxs[axis];
+
+        // The endpoints of a proxy never pass each other, so the max must be moved
+        // first when it moves up. Otherwise it would stop the min.
+        if (isMaxMovingUp)
+        {
+            sortEndPoint(axis, proxy.m_maxIndex[axis]);
+            sortEndPoint(axis, proxy.m_minIndex[axis]);
+        }
+        else
+        {
+            sortEndPoint(axis, proxy.m_minIndex[axis]);
+            sortEndPoint(axis, proxy.m_maxIndex[axis]);
+        }
+    }
+}
+
+void MCSweepAndPrune::sortEndPoint(unsigned int axis, unsigned int index)
+{
+    auto & endPoints = m_endPoints[axis];
+    const EndPoint endPoint = endPoints[index];
+
+    // Overlaps can only begin or end when a min passes a max
+    while (index > 0 && endPointLess(endPoint, endPoints[index - 1]))
+    {
+        const EndPoint & other = endPoints[index - 1];
+        if (other.m_isMin != endPoint.m_isMin)
+        {
+            updateOverlap(endPoint.m_proxyIndex, other.m_proxyIndex);
+        }
+
+        endPoints[index] = other;
+        setEndPointIndex(other, axis, index);
+        index--;
+    }
+
+    while (index + 1 < endPoints.size() && endPointLess(endPoints[index + 1], endPoint))
+    {
+        const EndPoint & other = endPoints[index + 1];
+        if (other.m_isMin != endPoint.m_isMin)
+        {
+            updateOverlap(endPoint.m_proxyIndex, other.m_proxyIndex);
+        }
+
+        endPoints[index] = other;
+        setEndPointIndex(other, axis, index);
+        index++;
+    }
+
+    endPoints[index] = endPoint;
+    setEndPointIndex(endPoint, axis, index);
+}
+
+void MCSweepAndPrune::updateOverlap(unsigned int proxyIndex1, unsigned int proxyIndex2)
+{
+    const Proxy & proxy1 = m_proxies[proxyIndex1];
+    const Proxy & proxy2 = m_proxies[proxyIndex2];
+    if (proxyIndex1 == proxyIndex2 || !proxy2.m_object || (proxy1.m_isStatic && proxy2.m_isStatic))
+    {
+        return;
+    }
+
+    // The box of the other proxy is the one in the arrays, so the overlap is in sync with the endpoints
+    auto & overlaps1 = m_overlaps[proxyIndex1];
+    const auto iter1 = std::find(overlaps1.begin(), overlaps1.end(), proxyIndex2);
+    if (bboxesOverlap(proxy1.m_bbox, proxy2.m_bbox))
+    {
+        if (iter1 == overlaps1.end())
+        {
+            overlaps1.push_back(proxyIndex2);
+            m_overlaps[proxyIndex2].push_back(proxyIndex1);
+        }
+    }
+    else if (iter1 != overlaps1.end())
+    {
+        *iter1 = overlaps1.back();
+        overlaps1.pop_back();
+
+        auto & overlaps2 = m_overlaps[proxyIndex2];
+        const auto iter2 = std::find(overlaps2.begin(), overlaps2.end(), proxyIndex1);
+        *iter2 = overlaps2.back();
+        overlaps2.pop_back();
+    }
+}
+
+void MCSweepAndPrune::markHot(unsigned int proxyIndex)
+{
+    Proxy & proxy = m_proxies[proxyIndex];
+    if (proxy.m_object && !proxy.m_isHot)
+    {
+        proxy.m_isHot = true;
+        m_hotProxies.push_back(proxyIndex);
+    }
+}
+
+void MCSweepAndPrune::markColliding(unsigned int proxyIndex)
+{
+    Proxy & proxy = m_proxies[proxyIndex];
+    if (!proxy.m_isColliding)
+    {
+        proxy.m_isColliding = true;
+        m_collidingProxies.push_back(proxyIndex);
+    }
+}
+
+const MCSweepAndPrune::CollisionVector & MCSweepAndPrune::getPossibleCollisions()
+{
+    m_collisions.clear();
+
+    compact();
+
+    // The proxies that collided on the previous call are tested again like the dirty cells of the grid
+    m_hotProxies.clear();
+    for (unsigned int proxyIndex : m_collidingProxies)
+    {
+        m_proxies[proxyIndex].m_isColliding = false;
+        markHot(proxyIndex);
+    }
+    m_collidingProxies.clear();
+
+    for (unsigned int proxyIndex : m_movedProxies)
+    {
+        Proxy & proxy = m_proxies[proxyIndex];
+        if (proxy.m_object)
+        {
+            proxy.m_isMoved = false;
+            moveEndPoints(proxyIndex);
+            markHot(proxyIndex);
+        }
+    }
+    m_movedProxies.clear();
+
+    // Sorting each proxy into place is O(n) per proxy, so e.g. a new level is inserted as a batch
+    const bool isBatchInsert = m_insertedProxies.size() > BATCH_INSERT_COUNT;
+    const size_t sortedCount = m_endPoints[0].size();
+    for (unsigned int proxyIndex : m_insertedProxies)
+    {
+        Proxy & proxy = m_proxies[proxyIndex];
+        if (proxy.m_object)
+        {
+            proxy.m_isMoved = false;
+            if (isBatchInsert)
+            {
+                appendEndPoints(proxyIndex);
+            }
+            else
+            {
+                insertEndPoints(proxyIndex);
+            }
+            markHot(proxyIndex);
+        }
+    }
+
+    if (isBatchInsert)
+    {
+        mergeEndPoints(sortedCount);
+        updateOverlaps();
+    }
+    m_insertedProxies.clear();
+
+    for (unsigned int proxyIndex1 : m_hotProxies)
+    {
+        MCObject & object1 = *m_proxies[proxyIndex1].m_object;
+        for (unsigned int proxyIndex2 : m_overlaps[proxyIndex1])
+        {
+            // A pair of two hot proxies is reported by the one with the smaller index
+            const Proxy & proxy2 = m_proxies[proxyIndex2];
+            if (!proxy2.m_object || (proxy2.m_isHot && proxyIndex2 < proxyIndex1))
+            {
+                continue;
+            }
+
+            if (MCObjectGrid::mayCollide(object1, *proxy2.m_object))
+            {
+                m_collisions.push_back({&object1, proxy2.m_object});
+                m_collisions.push_back({proxy2.m_object, &object1});
+                markColliding(proxyIndex1);
+                markColliding(proxyIndex2);
+            }
+        }
+    }
+
+    for (unsigned int proxyIndex : m_hotProxies)
+    {
+        m_proxies[proxyIndex].m_isHot = false;
+    }
+
+    return m_collisions;
+}
+
+size_t MCSweepAndPrune::objectCount() const
+{
+    return m_proxyIndices.size();
+}
+
+bool MCSweepAndPrune::isStatic(MCObject & object) const
+{
+    const auto iter = m_proxyIndices.find(&object);
+    return iter != m_proxyIndices.end() && m_proxies[iter->second].m_isStatic;
+}
+
+void MCSweepAndPrune::saveState(MCStateBuffer & state) const
+{
+    state.writeVector(m_proxies);
+    for (auto && overlaps : m_overlaps)
+    {
+        state.writeVector(overlaps);
+    }
+
+    state.writeVector(m_endPoints[0]);
+    state.writeVector(m_endPoints[1]);
+    state.writeVector(m_insertedProxies);
+    state.writeVector(m_movedProxies);
+    state.writeVector(m_collidingProxies);
+    state.write(m_removedCount);
+    state.write(m_maxDynamicWidth);
+
+    // Only the non-empty view cells are stored
+    for (unsigned int index = 0; index < m_viewCells.size(); index++)
+    {
+        if (!m_viewCells[index].empty())
+        {
+            state.write(index);
+            state.writeVector(m_viewCells[index]);
+        }
+    }
+
+    state.write(END_OF_CELLS);
+}
+
+void MCSweepAndPrune::restoreState(MCStateBuffer & state)
+{
+    state.readVector(m_proxies);
+    m_overlaps.resize(m_proxies.size());
+    for (auto && overlaps : m_overlaps)
+    {
+        state.readVector(overlaps);
+    }
+
+    state.readVector(m_endPoints[0]);
+    state.readVector(m_endPoints[1]);
+    state.readVector(m_insertedProxies);
+    state.readVector(m_movedProxies);
+    state.readVector(m_collidingProxies);
+    state.read(m_removedCount);
+    state.read(m_maxDynamicWidth);
+
+    for (auto && cell : m_viewCells)
+    {
+        cell.clear();
+    }
+
+    unsigned int index = END_OF_CELLS;
+    while (state.read(index) && index != END_OF_CELLS)
+    {
+        if (index >= m_viewCells.size())
+        {
+            state.invalidate();
+            return;
+        }
+
+        state.readVector(m_viewCells[index]);
+    }
+
+    m_proxyIndices.clear();
+    for (unsigned int proxyIndex = 0; proxyIndex < m_proxies.size(); proxyIndex++)
+    {
+        if (m_proxies[proxyIndex].m_object)
+        {
+            m_proxyIndices[m_proxies[proxyIndex].m_object] = proxyIndex;
+        }
+    }
+}
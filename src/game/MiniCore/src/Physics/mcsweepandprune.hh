@@ -0,0 +1,307 @@
+// This file belongs to the "MiniCore" game engine.
+// Copyright (C) 2018 Jussi Lind <jussi.lind@iki.fi>
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+// MA  02110-1301, USA.
+//
+
+#ifndef MCSWEEPANDPRUNE_HH
+#define MCSWEEPANDPRUNE_HH
+
+#include "mcbbox.hh"
+#include "mcmacros.hh"
+#include "mcobject.hh"
+#include "mcobjectgrid.hh"
+
+#include <algorithm>
+#include <unordered_map>
+#include <vector>
+
+class MCStateBuffer;
+
+/*! Incremental sort-and-sweep broadphase on the X- and Y-axes. This is an alternative
+ *  to MCObjectGrid and can be selected with MCWorld::setDimensions(), but the grid is
+ *  faster in stepping the shipped tracks. The object grid is not maintained when this
+ *  is used, so the spatial queries are also served from here.
+ *
+ *  Both axes are sorted because the overlapping pairs are found from the endpoints that
+ *  pass each other: a pair starts or stops overlapping when its boxes start or stop
+ *  overlapping on either axis. With only the X-axis sorted, every pair overlapping on X
+ *  would have to be tested on Y on every step, and the race tracks have long walls and
+ *  rows of scenery that overlap most objects sharing their X-range.
+ *
+ *  The sorted endpoint arrays are kept between steps. Only the endpoints of the objects
+ *  that have moved (update()) are moved in the arrays, and the overlapping bounding boxes
+ *  are tracked as the endpoints pass each other. Static objects are never moved in the
+ *  arrays unless they are updated themselves, and they are never paired with each other.
+ *
+ *  Like the dirty cells of MCObjectGrid, only the pairs of the objects that have moved
+ *  or collided on the previous call are reported, so the cost depends on the moving
+ *  objects instead of the size of the level. Each possible collision is reported once.
+ *
+ *  Objects with bypassed collisions, e.g. particles, are kept only for the queries.
+ *
+ *  The view queries of the renderer use a coarse grid of cells that contain the objects
+ *  overlapping them with their view boxes. An object is moved between the cells only
+ *  when it enters or leaves a cell. */
+class MCSweepAndPrune
+{
+public:
+
+    typedef MCObjectGrid::CollisionVector CollisionVector;
+
+    /*! Constructor.
+     *  \param x1,y1,x2,y2 represent the area covered by the view cells.
+     *  \param cellW,cellH are the dimensions of the view cells. */
+    MCSweepAndPrune(float x1, float y1, float x2, float y2, float cellW, float cellH);
+
+    /*! Insert an object. Objects without a shape are ignored. The endpoints
+     *  are sorted into place on the next getPossibleCollisions().
+     *  \param object is the object to be inserted. */
+    void insert(MCObject & object);
+
+    /*! Mark the object as moved so that its endpoints get moved on the next
+     *  getPossibleCollisions(). Re-inserts the object if it has become stationary
+     *  or non-stationary, or its collisions have been bypassed or enabled.
+     *  \return true if the object was found. */
+    bool update(MCObject & object);
+
+    /*! Remove an object (O(1)). The freed slots are compacted on a later
+     *  getPossibleCollisions() once enough of them have been freed.
+     *  \param object is the object to be removed.
+     *  \return true if was removed. */
+    bool remove(MCObject & object);
+
+    //! Remove all objects.
+    void removeAll();
+
+    /*! Move the endpoints of the moved objects and get possible collisions.
+     *  The filtering is the same as in MCObjectGrid::getPossibleCollisions().
+     *  \return possible collisions. */
+    const CollisionVector & getPossibleCollisions();
+
+    /*! Call function(MCObject &) once for each object whose view overlaps given BBox.
+     *  Objects without a view are skipped. \see MCObjectGrid::forEachObjectWithinBBox(). */
+    template <typename Function>
+    void forEachObjectWithinBBox(const MCBBox<float> & bbox, Function function) const
+    {
+        unsigned int range[4];
+        viewCellRange(bbox, range);
+
+        for (unsigned int j = range[2]; j <= range[3]; j++)
+        {
+            for (unsigned int i = range[0]; i <= range[1]; i++)
+            {
+                for (unsigned int proxyIndex : m_viewCells[j * m_viewHorSize + i])
+                {
+                    // Visit only in the first cell shared with the query range
+                    const Proxy & proxy = m_proxies[proxyIndex];
+                    if (i != std::max(range[0], proxy.m_viewCells[0]) || j != std::max(range[2], proxy.m_viewCells[2]))
+                    {
+                        continue;
+                    }
+
+                    MCObject * obj = proxy.m_object;
+                    if (obj->shape()->view() &&
+                        bbox.intersects(obj->shape()->view()->bbox().translated(MCVector2dF(obj->location()))))
+                    {
+                        function(*obj);
+                    }
+                }
+            }
+        }
+    }
+
+    /*! Call function(MCObject &) once for each dynamic object whose shape overlaps given
+     *  BBox. Static objects and objects with bypassed collisions are not visited.
+     *  \see MCObjectGrid::forEachDynamicObjectWithinBBox(). */
+    template <typename Function>
+    void forEachDynamicObjectWithinBBox(const MCBBox<float> & bbox, Function function) const
+    {
+        // A dynamic box overlapping the given box starts at most the widest dynamic box before it
+        const auto & endPoints = m_endPoints[0];
+        auto iter = std::lower_bound(endPoints.begin(), endPoints.end(), bbox.x1() - m_maxDynamicWidth,
+            [] (const EndPoint & endPoint, float value) { return endPoint.m_value < value; });
+        for (; iter != endPoints.end() && iter->m_value <= bbox.x2(); iter++)
+        {
+            const Proxy & proxy = m_proxies[iter->m_proxyIndex];
+            if (iter->m_isMin && proxy.m_object && !proxy.m_isStatic && !proxy.m_isMoved && bbox.intersects(proxy.m_bbox))
+            {
+                function(*proxy.m_object);
+            }
+        }
+
+        // The endpoints of the moved and inserted objects are not up-to-date yet
+        const auto visitPending = [&] (const std::vector<unsigned int> & proxyIndices) {
+            for (unsigned int proxyIndex : proxyIndices)
+            {
+                const Proxy & proxy = m_proxies[proxyIndex];
+                if (proxy.m_object && !proxy.m_isStatic && bbox.intersects(proxy.m_object->shape()->bbox()))
+                {
+                    function(*proxy.m_object);
+                }
+            }
+        };
+
+        visitPending(m_movedProxies);
+        visitPending(m_insertedProxies);
+    }
+
+    //! \return number of inserted objects.
+    size_t objectCount() const;
+
+    //! \return true if the given object is stored as static geometry.
+    bool isStatic(MCObject & object) const;
+
+    //! Save the proxies, the sorted endpoints and the overlaps into the given buffer.
+    void saveState(MCStateBuffer & state) const;
+
+    //! Restore the state saved with saveState().
+    void restoreState(MCStateBuffer & state);
+
+private:
+
+    DISABLE_COPY(MCSweepAndPrune);
+    DISABLE_ASSI(MCSweepAndPrune);
+
+    struct Proxy
+    {
+        //! nullptr if the object has been removed.
+        MCObject * m_object;
+
+        //! The bounding box stored in the endpoint arrays.
+        MCBBox<float> m_bbox;
+
+        //! Indices of the endpoints in the X- and Y-arrays.
+        unsigned int m_minIndex[2];
+
+        unsigned int m_maxIndex[2];
+
+        bool m_isStatic;
+
+        //! Only for the queries. Doesn't have endpoints.
+        bool m_isQueryOnly;
+
+        //! Moved or inserted since the previous getPossibleCollisions().
+        bool m_isMoved;
+
+        bool m_isHot;
+
+        bool m_isColliding;
+
+        //! The range i0, i1, j0, j1 of the view cells containing the proxy.
+        unsigned int m_viewCells[4];
+    };
+
+    struct EndPoint
+    {
+        float m_value;
+
+        unsigned int m_proxyIndex;
+
+        bool m_isMin;
+    };
+
+    static bool endPointLess(const EndPoint & left, const EndPoint & right);
+
+    static bool bboxesOverlap(const MCBBox<float> & bbox1, const MCBBox<float> & bbox2);
+
+    void setBBox(Proxy & proxy, const MCBBox<float> & bbox);
+
+    void compact();
+
+    void updateEndPointIndices();
+
+    void insertEndPoints(unsigned int proxyIndex);
+
+    void appendEndPoints(unsigned int proxyIndex);
+
+    //! Merge the endpoints appended after the first sortedCount ones into the sorted arrays.
+    void mergeEndPoints(size_t sortedCount);
+
+    //! Rebuild all overlaps with a sweep over the X-axis.
+    void updateOverlaps();
+
+    void moveEndPoints(unsigned int proxyIndex);
+
+    void sortEndPoint(unsigned int axis, unsigned int index);
+
+    void setEndPointIndex(const EndPoint & endPoint, unsigned int axis, unsigned int index);
+
+    void updateOverlap(unsigned int proxyIndex1, unsigned int proxyIndex2);
+
+    void markHot(unsigned int proxyIndex);
+
+    void markColliding(unsigned int proxyIndex);
+
+    void viewCellRange(const MCBBox<float> & bbox, unsigned int (&range)[4]) const;
+
+    static MCBBox<float> viewBBox(const MCObject & object);
+
+    void insertView(unsigned int proxyIndex);
+
+    void removeView(unsigned int proxyIndex);
+
+    //! Move the proxy to its new view cells if the range has changed.
+    void updateView(unsigned int proxyIndex);
+
+    std::vector<Proxy> m_proxies;
+
+    //! Maps objects to their slots in m_proxies.
+    std::unordered_map<MCObject *, unsigned int> m_proxyIndices;
+
+    //! Proxies overlapping each proxy on both axes. Pairs of static proxies are not stored.
+    std::vector<std::vector<unsigned int>> m_overlaps;
+
+    //! Sorted endpoints on the X- and Y-axes.
+    std::vector<EndPoint> m_endPoints[2];
+
+    std::vector<unsigned int> m_insertedProxies;
+
+    std::vector<unsigned int> m_movedProxies;
+
+    //! Proxies whose pairs are tested on the current call.
+    std::vector<unsigned int> m_hotProxies;
+
+    //! Proxies that had collisions on the previous call.
+    std::vector<unsigned int> m_collidingProxies;
+
+    //! Proxies whose X-ranges contain the current endpoint in updateOverlaps().
+    std::vector<unsigned int> m_activeProxies;
+
+    std::vector<unsigned int> m_proxyRemap;
+
+    unsigned int m_removedCount;
+
+    //! Upper bound for the widths of the dynamic boxes in the endpoint arrays.
+    float m_maxDynamicWidth;
+
+    CollisionVector m_collisions;
+
+    MCBBox<float> m_viewArea;
+
+    unsigned int m_viewHorSize;
+
+    unsigned int m_viewVerSize;
+
+    float m_viewHelpHor;
+
+    float m_viewHelpVer;
+
+    //! Proxies overlapping each view cell with their view boxes.
+    std::vector<std::vector<unsigned int>> m_viewCells;
+};
+
+#endif // MCSWEEPANDPRUNE_HH
@@ -0,0 +1,139 @@
+// This file belongs to the "MiniCore" game engine.
+// Copyright (C) 2018 Jussi Lind <jussi.lind@iki.fi>
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+// MA  02110-1301, USA.
+//
+
+#include "mctriggervolume.hh"
+#include "mccircleshape.hh"
+#include "mcmathutil.hh"
+#include "mcobject.hh"
+#include "mcrectshape.hh"
+
+#include <algorithm>
+
+MCTriggerVolume::MCTriggerVolume(float width, float height, Callback callback)
+: m_obbox(width / 2, height / 2, MCVector2dF())
+, m_callback(callback)
+{
+}
+
+MCTriggerVolume::~MCTriggerVolume()
+{
+}
+
+void MCTriggerVolume::setLocation(const MCVector2dF & location)
+{
+    m_location = location;
+    updateTransform();
+}
+
+void MCTriggerVolume::setAngle(float angle)
+{
+    m_angle = angle;
+    updateTransform();
+}
+
+MCObject * MCTriggerVolume::owner() const
+{
+    return m_owner;
+}
+
+const MCOBBox<float> & MCTriggerVolume::obbox() const
+{
+    return m_obbox;
+}
+
+bool MCTriggerVolume::overlaps(const MCObject & object) const
+{
+    const MCShape & shape = *object.shape();
+    if (shape.instanceTypeId() == MCRectShape::typeId())
+    {
+        return !m_obbox.isSeparatedFrom(static_cast<const MCRectShape &>(shape).obbox());
+    }
+    else if (shape.instanceTypeId() == MCCircleShape::typeId())
+    {
+        return !m_obbox.isSeparatedFrom(MCVector2dF(shape.location()), shape.radius());
+    }
+
+    const MCBBoxF bbox = shape.bbox();
+    return !m_obbox.isSeparatedFrom(MCOBBox<float>(
+        bbox.width() / 2, bbox.height() / 2, MCVector2dF((bbox.x1() + bbox.x2()) / 2, (bbox.y1() + bbox.y2()) / 2)));
+}
+
+const std::vector<MCObject *> & MCTriggerVolume::objects() const
+{
+    return m_objects;
+}
+
+void MCTriggerVolume::updateTransform()
+{
+    if (m_owner)
+    {
+        m_obbox.rotate(m_owner->angle() + m_angle);
+        m_obbox.translate(MCVector2dF(m_owner->location()) + MCMathUtil::rotatedVector(m_location, m_owner->angle()));
+    }
+    else
+    {
+        m_obbox.rotate(m_angle);
+        m_obbox.translate(m_location);
+    }
+}
+
+void MCTriggerVolume::update(const std::vector<MCObject *> & objects)
+{
+    m_previousObjects.swap(m_objects);
+    m_objects.assign(objects.begin(), objects.end());
+
+    if (!m_callback)
+    {
+        return;
+    }
+
+    // Only a few objects are inside at a time, so linear searches are enough.
+    // The callback may remove objects, so the vectors are indexed on each iteration.
+    for (size_t i = 0; i < m_objects.size(); i++)
+    {
+        MCObject * object = m_objects[i];
+        const bool wasInside = std::find(m_previousObjects.begin(), m_previousObjects.end(), object) != m_previousObjects.end();
+        m_callback(*object, wasInside ? Event::Stay : Event::Enter);
+    }
+
+    for (size_t i = 0; i < m_previousObjects.size(); i++)
+    {
+        MCObject * object = m_previousObjects[i];
+        if (std::find(m_objects.begin(), m_objects.end(), object) == m_objects.end())
+        {
+            m_callback(*object, Event::Exit);
+        }
+    }
+}
+
+void MCTriggerVolume::removeObject(MCObject & object)
+{
+    m_previousObjects.erase(std::remove(m_previousObjects.begin(), m_previousObjects.end(), &object), m_previousObjects.end());
+
+    const auto iter = std::find(m_objects.begin(), m_objects.end(), &object);
+    if (iter != m_objects.end())
+    {
+        m_objects.erase(iter);
+
+        if (m_callback)
+        {
+            m_callback(object, Event::Exit);
+        }
+    }
+}
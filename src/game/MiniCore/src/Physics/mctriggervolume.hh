@@ -0,0 +1,125 @@
+// This file belongs to the "MiniCore" game engine.
+// Copyright (C) 2018 Jussi Lind <jussi.lind@iki.fi>
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+// MA  02110-1301, USA.
+//
+
+#ifndef MCTRIGGERVOLUME_HH
+#define MCTRIGGERVOLUME_HH
+
+#include "mcmacros.hh"
+#include "mcobbox.hh"
+#include "mcvector2d.hh"
+
+#include <functional>
+#include <memory>
+#include <vector>
+
+class MCObject;
+class MCWorld;
+
+/*! \class MCTriggerVolume
+ *  \brief An overlap-only box that reports the objects entering, staying in and leaving it.
+ *
+ *  Trigger volumes are not a part of the collision detection: they don't generate
+ *  contacts or MCCollisionEvents and they are not tested on the position resolver
+ *  iterations. MCWorld evaluates the added volumes once per step after the collisions
+ *  have been processed, against the dynamic objects of MCObjectGrid that collide with
+ *  trigger objects, i.e. physics or trigger objects that don't bypass collisions.
+ *
+ *  Objects removed from the world leave the volumes with Event::Exit. A volume added
+ *  to an MCObject follows the object and it's added to and removed from the world
+ *  together with the object. */
+class MCTriggerVolume
+{
+public:
+
+    //! Events passed to the callback.
+    enum class Event
+    {
+        Enter,
+        Stay,
+        Exit
+    };
+
+    typedef std::function<void(MCObject & object, Event event)> Callback;
+
+    /*! Constructor.
+     *  \param width,height Size of the volume.
+     *  \param callback Function called for the objects inside on each step and once when they leave. */
+    MCTriggerVolume(float width, float height, Callback callback);
+
+    //! Destructor.
+    ~MCTriggerVolume();
+
+    //! Set the location. Relative to the owner, if the volume has been added to an object.
+    void setLocation(const MCVector2dF & location);
+
+    //! Set the angle in degrees. Relative to the owner, if the volume has been added to an object.
+    void setAngle(float angle);
+
+    //! \return the object the volume has been added to or nullptr.
+    MCObject * owner() const;
+
+    //! \return the volume in world coordinates as of the latest evaluation.
+    const MCOBBox<float> & obbox() const;
+
+    //! \return true if the shape of the given object overlaps the volume.
+    bool overlaps(const MCObject & object) const;
+
+    //! \return the objects inside the volume on the latest evaluation.
+    const std::vector<MCObject *> & objects() const;
+
+private:
+
+    DISABLE_COPY(MCTriggerVolume);
+    DISABLE_ASSI(MCTriggerVolume);
+
+    friend class MCObject;
+    friend class MCWorld;
+
+    //! Update the box from the location and the angle of the owner.
+    void updateTransform();
+
+    //! Set the objects that overlap the volume now and call the callback.
+    void update(const std::vector<MCObject *> & objects);
+
+    //! Forget the given object. The callback is called with Event::Exit if the object was inside.
+    void removeObject(MCObject & object);
+
+    MCOBBox<float> m_obbox;
+
+    MCVector2dF m_location;
+
+    float m_angle = 0;
+
+    Callback m_callback;
+
+    MCObject * m_owner = nullptr;
+
+    MCWorld * m_world = nullptr;
+
+    //! Index in the world's trigger volume vector.
+    int m_index = -1;
+
+    std::vector<MCObject *> m_objects;
+
+    std::vector<MCObject *> m_previousObjects;
+};
+
+typedef std::shared_ptr<MCTriggerVolume> MCTriggerVolumePtr;
+
+#endif // MCTRIGGERVOLUME_HH
@@ -0,0 +1,351 @@
+// This file belongs to the "MiniCore" game engine.
+// Copyright (C) 2018 Jussi Lind <jussi.lind@iki.fi>
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+// MA  02110-1301, USA.
+//
+
+#include "MCCollisionDetectorTest.hpp"
+#include "../../Core/mcobbox.hh"
+#include "../../Core/mcobject.hh"
+#include "../../Core/mcrandomstream.hh"
+#include "../../Physics/mccircleshape.hh"
+#include "../../Physics/mccollisiondetector.hh"
+#include "../../Physics/mccontact.hh"
+#include "../../Physics/mccontactarena.hh"
+#include "../../Physics/mcrectshape.hh"
+
+#include <memory>
+#include <vector>
+
+namespace {
+
+struct ExpectedContact
+{
+    MCObject * m_object;
+    MCObject * m_otherObject;
+    MCVector2dF m_point;
+    MCVector2dF m_normal;
+    float m_depth;
+};
+
+typedef std::vector<ExpectedContact> Contacts;
+
+// The vertex tests done by MCCollisionDetector before the separating axis test
+// and the batched containment test. All objects accept the collision events.
+void addRectAgainstRect(MCRectShape & rect1, MCRectShape & rect2, Contacts & contacts)
+{
+    for (unsigned int i = 0; i < 4; i++)
+    {
+        const MCVector2dF vertex = rect1.obbox().vertex(i);
+        if (rect2.contains(vertex))
+        {
+            ExpectedContact contact = {&rect1.parent(), &rect2.parent(), vertex, MCVector2dF(), 0};
+            contact.m_depth = rect2.interpenetrationDepth(MCSegmentF(vertex, rect1.location()), contact.m_normal);
+            contacts.push_back(contact);
+        }
+    }
+}
+
+void addRectAgainstCircle(MCRectShape & rect, MCCircleShape & circle, Contacts & contacts)
+{
+    for (unsigned int i = 0; i < 5; i++)
+    {
+        const MCVector2dF rectVertex = i < 4 ? rect.obbox().vertex(i) : MCVector2dF(rect.location());
+        MCVector2dF circleVertex(rectVertex - MCVector2dF(circle.location()));
+        circleVertex.clampFast(circle.radius());
+        circleVertex += MCVector2dF(circle.location());
+        if (rect.contains(circleVertex))
+        {
+            ExpectedContact contact = {&circle.parent(), &rect.parent(), circleVertex, MCVector2dF(), 0};
+            contact.m_depth = rect.interpenetrationDepth(MCSegmentF(circleVertex, circle.location()), contact.m_normal);
+            contacts.push_back(contact);
+        }
+    }
+}
+
+bool identical(const MCVector2dF & a, const MCVector2dF & b)
+{
+    return a.i() == b.i() && a.j() == b.j();
+}
+
+// Compare the contacts of object1 with object2 in the arena
+bool hasContacts(MCContactArena & arena, const Contacts & expected)
+{
+    if (expected.empty())
+    {
+        return true;
+    }
+
+    MCObject & object = *expected.front().m_object;
+    for (int spanIndex = arena.firstSpan(object); spanIndex >= 0; spanIndex = arena.span(spanIndex).m_next)
+    {
+        const MCContactArena::Span & span = arena.span(spanIndex);
+        if (span.m_isDeleted || span.m_otherObject != expected.front().m_otherObject)
+        {
+            continue;
+        }
+
+        if (arena.end(span) - arena.begin(span) != static_cast<int>(expected.size()))
+        {
+            return false;
+        }
+
+        const MCContact * contact = arena.begin(span);
+        for (auto && expectedContact : expected)
+        {
+            if (!identical(contact->contactPoint(), expectedContact.m_point) ||
+                !identical(contact->contactNormal(), expectedContact.m_normal) ||
+                contact->interpenetrationDepth() != expectedContact.m_depth)
+            {
+                return false;
+            }
+            contact++;
+        }
+        return true;
+    }
+
+    return false;
+}
+
+std::unique_ptr<MCObject> rectObject(float w, float h)
+{
+    std::unique_ptr<MCObject> object(new MCObject("RECT"));
+    object->setShape(MCShapePtr(new MCRectShape(MCShapeViewPtr(), w, h)));
+    return object;
+}
+
+std::unique_ptr<MCObject> circleObject(float radius)
+{
+    std::unique_ptr<MCObject> object(new MCObject("CIRCLE"));
+    object->setShape(MCShapePtr(new MCCircleShape(MCShapeViewPtr(), radius)));
+    return object;
+}
+
+MCRectShape & rectShape(MCObject & object)
+{
+    return *static_cast<MCRectShape *>(object.shape().get());
+}
+
+MCCircleShape & circleShape(MCObject & object)
+{
+    return *static_cast<MCCircleShape *>(object.shape().get());
+}
+
+} // namespace
+
+MCCollisionDetectorTest::MCCollisionDetectorTest()
+{
+}
+
+void MCCollisionDetectorTest::testContainsMask()
+{
+    MCRandomStream random(1);
+    for (int n = 0; n < 2000; n++)
+    {
+        MCOBBoxF obbox(1 + random.getValue() * 20, 1 + random.getValue() * 20,
+            MCVector2dF(random.getValue() * 2000, random.getValue() * 2000));
+        obbox.rotate(n % 4 ? random.getValue() * 720 - 360 : (n % 8) * 45);
+
+        // Points near the box, on the vertices and on the edges
+        MCVector2dF points[4];
+        for (unsigned int i = 0; i < 4; i++)
+        {
+            switch ((n + i) % 3)
+            {
+            case 0:
+                points[i] = obbox.location() + random.randomVector2d() * 30 * random.getValue();
+                break;
+            case 1:
+                points[i] = obbox.vertex(i);
+                break;
+            default:
+                points[i] = (obbox.vertex(i) + obbox.vertex(i + 1)) * 0.5f;
+                break;
+            }
+        }
+
+        unsigned int expected = 0;
+        for (unsigned int i = 0; i < 4; i++)
+        {
+            expected |= obbox.contains(points[i]) << i;
+        }
+
+        QVERIFY(obbox.containsMask(points) == expected);
+    }
+}
+
+void MCCollisionDetectorTest::testSeparation()
+{
+    MCRandomStream random(2);
+    int separatedCount = 0;
+    for (int n = 0; n < 5000; n++)
+    {
+        MCOBBoxF obbox1(1 + random.getValue() * 20, 1 + random.getValue() * 20,
+            MCVector2dF(1000 + random.getValue() * 60, 1000 + random.getValue() * 60));
+        obbox1.rotate(random.getValue() * 360);
+        MCOBBoxF obbox2(1 + random.getValue() * 20, 1 + random.getValue() * 20,
+            MCVector2dF(1000 + random.getValue() * 60, 1000 + random.getValue() * 60));
+        obbox2.rotate(n % 2 ? random.getValue() * 360 : obbox1.angle());
+
+        // A separated pair must not have contained vertices
+        if (obbox1.isSeparatedFrom(obbox2))
+        {
+            separatedCount++;
+            QVERIFY(obbox1.isSeparatedFrom(obbox2) == obbox2.isSeparatedFrom(obbox1));
+            for (unsigned int i = 0; i < 4; i++)
+            {
+                QVERIFY(!obbox1.contains(obbox2.vertex(i)));
+                QVERIFY(!obbox2.contains(obbox1.vertex(i)));
+            }
+        }
+
+        // A separated circle must not have contained points
+        const MCVector2dF center(1000 + random.getValue() * 60, 1000 + random.getValue() * 60);
+        const float radius = 1 + random.getValue() * 10;
+        if (obbox1.isSeparatedFrom(center, radius))
+        {
+            for (int i = 0; i < 16; i++)
+            {
+                QVERIFY(!obbox1.contains(center + random.randomVector2d() * radius * random.getValue()));
+            }
+        }
+    }
+
+    QVERIFY(separatedCount > 1000);
+
+    // Boxes that touch at an edge are not separated
+    MCOBBoxF obbox1(5, 5, MCVector2dF(0, 0));
+    MCOBBoxF obbox2(5, 5, MCVector2dF(10, 0));
+    QVERIFY(!obbox1.isSeparatedFrom(obbox2));
+    QVERIFY(!obbox1.isSeparatedFrom(MCVector2dF(10, 0), 5));
+}
+
+void MCCollisionDetectorTest::testRectAgainstRectContacts()
+{
+    MCRandomStream random(3);
+    std::vector<std::unique_ptr<MCObject>> objects;
+    MCObjectGrid::CollisionVector pairs;
+    std::vector<Contacts> expected;
+    for (int n = 0; n < 1000; n++)
+    {
+        objects.push_back(rectObject(2 + random.getValue() * 30, 2 + random.getValue() * 30));
+        MCObject & object1 = *objects.back();
+        object1.translate(MCVector3dF(n * 100, 0));
+        object1.rotate(random.getValue() * 360);
+
+        objects.push_back(rectObject(2 + random.getValue() * 30, 2 + random.getValue() * 30));
+        MCObject & object2 = *objects.back();
+        object2.translate(MCVector3dF(n * 100 + random.getValue() * 40 - 20, random.getValue() * 40 - 20));
+        object2.rotate(n % 3 ? random.getValue() * 360 : object1.angle() + 90);
+
+        pairs.push_back(std::make_pair(&object1, &object2));
+
+        // The second pass is used if the first one doesn't have hits
+        Contacts contacts;
+        addRectAgainstRect(rectShape(object1), rectShape(object2), contacts);
+        if (contacts.empty())
+        {
+            addRectAgainstRect(rectShape(object2), rectShape(object1), contacts);
+        }
+        expected.push_back(contacts);
+    }
+
+    MCCollisionDetector detector;
+    unsigned int expectedCollisions = 0;
+    for (auto && contacts : expected)
+    {
+        expectedCollisions += !contacts.empty();
+    }
+    QVERIFY(expectedCollisions > 100);
+    QVERIFY(detector.detectCollisions(pairs) == expectedCollisions);
+
+    for (auto && contacts : expected)
+    {
+        QVERIFY(hasContacts(detector.contactArena(), contacts));
+    }
+}
+
+void MCCollisionDetectorTest::testRectAgainstCircleContacts()
+{
+    MCRandomStream random(4);
+    std::vector<std::unique_ptr<MCObject>> objects;
+    MCObjectGrid::CollisionVector pairs;
+    std::vector<Contacts> expected;
+    for (int n = 0; n < 1000; n++)
+    {
+        objects.push_back(rectObject(2 + random.getValue() * 30, 2 + random.getValue() * 30));
+        MCObject & rect = *objects.back();
+        rect.translate(MCVector3dF(n * 100, 0));
+        rect.rotate(random.getValue() * 360);
+
+        objects.push_back(circleObject(1 + random.getValue() * 15));
+        MCObject & circle = *objects.back();
+        circle.translate(MCVector3dF(n * 100 + random.getValue() * 50 - 25, random.getValue() * 50 - 25));
+
+        pairs.push_back(std::make_pair(&rect, &circle));
+
+        Contacts contacts;
+        addRectAgainstCircle(rectShape(rect), circleShape(circle), contacts);
+        expected.push_back(contacts);
+    }
+
+    MCCollisionDetector detector;
+    unsigned int expectedCollisions = 0;
+    for (auto && contacts : expected)
+    {
+        expectedCollisions += !contacts.empty();
+    }
+    QVERIFY(expectedCollisions > 100);
+    QVERIFY(detector.detectCollisions(pairs) == expectedCollisions);
+
+    for (auto && contacts : expected)
+    {
+        QVERIFY(hasContacts(detector.contactArena(), contacts));
+    }
+}
+
+void MCCollisionDetectorTest::benchmarkRectAgainstRect()
+{
+    // Pairs from a broadphase: mostly close, but not overlapping
+    MCRandomStream random(5);
+    std::vector<std::unique_ptr<MCObject>> objects;
+    MCObjectGrid::CollisionVector pairs;
+    for (int n = 0; n < 1000; n++)
+    {
+        objects.push_back(rectObject(10, 10));
+        MCObject & object1 = *objects.back();
+        object1.translate(MCVector3dF(n * 100, 0));
+        object1.rotate(random.getValue() * 360);
+
+        objects.push_back(rectObject(10, 10));
+        MCObject & object2 = *objects.back();
+        object2.translate(MCVector3dF(n * 100 + random.getValue() * 40 - 20, random.getValue() * 40 - 20));
+        object2.rotate(random.getValue() * 360);
+
+        pairs.push_back(std::make_pair(&object1, &object2));
+    }
+
+    MCCollisionDetector detector;
+    detector.setThreadCount(1);
+    detector.enablePrimaryCollisionEvents(false);
+
+    QBENCHMARK {
+        detector.contactArena().reset();
+        detector.detectCollisions(pairs);
+    }
+}
+
+QTEST_GUILESS_MAIN(MCCollisionDetectorTest)
@@ -0,0 +1,167 @@
+// This file belongs to the "MiniCore" game engine.
+// Copyright (C) 2018 Jussi Lind <jussi.lind@iki.fi>
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+// MA  02110-1301, USA.
+//
+
+#include "MCContactArenaTest.hpp"
+#include "../../Core/mcobject.hh"
+#include "../../Physics/mccontactarena.hh"
+#include "../../Physics/mcimpulsegenerator.hh"
+#include "../../Physics/mcphysicscomponent.hh"
+
+#include <vector>
+
+namespace {
+
+void addPair(MCContactArena & arena, MCObject & object1, MCObject & object2, float depth)
+{
+    arena.addContacts(object1, object2, 1)->init(object2, MCVector2dF(1, 2), MCVector2dF(1, 0), depth);
+    arena.addContacts(object2, object1, 1)->init(object1, MCVector2dF(1, 2), MCVector2dF(-1, 0), depth);
+}
+
+unsigned int liveSpanCount(const MCContactArena & arena, const MCObject & object)
+{
+    unsigned int count = 0;
+    for (int i = arena.firstSpan(object); i >= 0; i = arena.span(i).m_next)
+    {
+        count += !arena.span(i).m_isDeleted;
+    }
+    return count;
+}
+
+} // namespace
+
+MCContactArenaTest::MCContactArenaTest()
+{
+}
+
+void MCContactArenaTest::testAddContacts()
+{
+    MCContactArena arena;
+    MCObject object1("TEST");
+    MCObject object2("TEST");
+    MCObject object3("TEST");
+
+    QVERIFY(arena.firstSpan(object1) == -1);
+
+    MCContact * contacts = arena.addContacts(object1, object2, 2);
+    contacts[0].init(object2, MCVector2dF(1, 2), MCVector2dF(1, 0), 1.0f);
+    contacts[1].init(object2, MCVector2dF(3, 4), MCVector2dF(0, 1), 2.0f);
+    arena.addContacts(object1, object3, 1)->init(object3, MCVector2dF(5, 6), MCVector2dF(1, 0), 3.0f);
+
+    QVERIFY(arena.contactCount() == 3);
+
+    // Spans are listed in the order they were added
+    const MCContactArena::Span & span1 = arena.span(arena.firstSpan(object1));
+    QVERIFY(span1.m_otherObject == &object2);
+    QVERIFY(arena.end(span1) - arena.begin(span1) == 2);
+    QVERIFY(arena.begin(span1)[1].interpenetrationDepth() == 2.0f);
+
+    const MCContactArena::Span & span2 = arena.span(span1.m_next);
+    QVERIFY(span2.m_otherObject == &object3);
+    QVERIFY(&arena.begin(span2)->object() == &object3);
+    QVERIFY(span2.m_next == -1);
+
+    QVERIFY(arena.firstSpan(object2) == -1);
+}
+
+void MCContactArenaTest::testDeleteContacts()
+{
+    MCContactArena arena;
+    MCObject object1("TEST");
+    MCObject object2("TEST");
+    MCObject object3("TEST");
+
+    addPair(arena, object1, object2, 1.0f);
+    addPair(arena, object1, object3, 1.0f);
+
+    arena.deleteContacts(object1, object2);
+    QVERIFY(liveSpanCount(arena, object1) == 1);
+    QVERIFY(liveSpanCount(arena, object2) == 1);
+
+    arena.deleteContacts(object1);
+    QVERIFY(liveSpanCount(arena, object1) == 0);
+    QVERIFY(liveSpanCount(arena, object3) == 1);
+}
+
+void MCContactArenaTest::testRemoveObject()
+{
+    MCContactArena arena;
+    MCObject object1("TEST");
+    MCObject object2("TEST");
+    MCObject object3("TEST");
+
+    addPair(arena, object1, object2, 1.0f);
+    addPair(arena, object2, object3, 1.0f);
+    addPair(arena, object1, object3, 1.0f);
+
+    arena.removeObject(object2);
+    QVERIFY(liveSpanCount(arena, object1) == 1);
+    QVERIFY(liveSpanCount(arena, object2) == 0);
+    QVERIFY(liveSpanCount(arena, object3) == 1);
+}
+
+void MCContactArenaTest::testReset()
+{
+    MCContactArena arena;
+    MCObject object1("TEST");
+    MCObject object2("TEST");
+
+    addPair(arena, object1, object2, 1.0f);
+    arena.reset();
+
+    QVERIFY(arena.contactCount() == 0);
+    QVERIFY(arena.firstSpan(object1) == -1);
+    QVERIFY(arena.firstSpan(object2) == -1);
+
+    // Stale list heads of the previous step must not be followed
+    addPair(arena, object2, object1, 2.0f);
+    QVERIFY(liveSpanCount(arena, object1) == 1);
+    QVERIFY(arena.span(arena.firstSpan(object1)).m_next == -1);
+
+    // Another arena doesn't see the contacts of this one
+    MCContactArena otherArena;
+    QVERIFY(otherArena.firstSpan(object1) == -1);
+}
+
+void MCContactArenaTest::testResolveDeepestContactOverBothOrders()
+{
+    MCContactArena arena;
+    MCObject object1("TEST");
+    MCObject object2("TEST");
+    object1.physicsComponent().setMass(1);
+    object2.physicsComponent().setMass(1);
+
+    // The grid reports the pair as {1, 2} and {2, 1}, so both objects get two spans
+    // with each other. The deepest vertex is in the span of the {2, 1} pass.
+    addPair(arena, object1, object2, 1.0f);
+    arena.addContacts(object2, object1, 1)->init(object1, MCVector2dF(1, 2), MCVector2dF(-1, 0), 3.0f);
+    arena.addContacts(object1, object2, 1)->init(object2, MCVector2dF(1, 2), MCVector2dF(1, 0), 3.0f);
+
+    std::vector<MCObject *> objs = {&object1, &object2};
+    MCImpulseGenerator impulseGenerator;
+    QVERIFY(qFuzzyCompare(impulseGenerator.resolvePositions(objs, arena, 1.0f), 3.0f));
+
+    // Equal masses share the displacement
+    QVERIFY(qFuzzyCompare(object1.location().i(), 1.5f));
+    QVERIFY(qFuzzyCompare(object2.location().i(), -1.5f));
+
+    QVERIFY(liveSpanCount(arena, object1) == 0);
+    QVERIFY(liveSpanCount(arena, object2) == 0);
+}
+
+QTEST_GUILESS_MAIN(MCContactArenaTest)
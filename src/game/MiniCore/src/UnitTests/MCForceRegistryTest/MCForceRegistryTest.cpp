@@ -18,12 +18,20 @@
 //
 
 #include "MCForceRegistryTest.hpp"
+#include "../../Physics/mcdragforcegenerator.hh"
 #include "../../Physics/mcforcegenerator.hh"
 #include "../../Physics/mcforceregistry.hh"
+#include "../../Physics/mcfrictiongenerator.hh"
+#include "../../Physics/mcgravitygenerator.hh"
+#include "../../Physics/mcphysicscomponent.hh"
+#include "../../Physics/mcrectshape.hh"
 #include "../../Core/mcworld.hh"
 #include "../../Core/mcobject.hh"
 
+#include <algorithm>
 #include <memory>
+#include <typeinfo>
+#include <vector>
 
 class TestForceGenerator : public MCForceGenerator
 {
@@ -51,6 +59,141 @@ public:
 
 unsigned int TestForceGenerator::m_destructorCallCount = 0;
 
+class ConstantForceGenerator : public MCForceGenerator
+{
+public:
+
+    //! \reimp
+    void updateForce(MCObject & object)
+    {
+        object.physicsComponent().addForce(MCVector3dF(0.3f, -0.7f, 0.1f));
+    }
+};
+
+class StopGenerator : public MCForceGenerator
+{
+public:
+
+    //! \reimp
+    void updateForce(MCObject & object)
+    {
+        object.physicsComponent().setVelocity(MCVector3dF(0, 0, 0));
+    }
+};
+
+namespace {
+
+// MCForceRegistry calls the generators of these types before the other generators
+bool isBuiltIn(const MCForceGenerator & generator)
+{
+    const std::type_info & type = typeid(generator);
+    return type == typeid(MCFrictionGenerator) || type == typeid(MCDragForceGenerator) || type == typeid(MCGravityGenerator);
+}
+
+struct ForceTestScene
+{
+    // Objects updated by calling MCForceGenerator::updateForce() in the registration order
+    std::vector<std::unique_ptr<MCObject>> referenceObjects;
+
+    std::vector<std::vector<MCForceGeneratorPtr>> referenceGenerators;
+
+    // Objects updated by MCForceRegistry
+    std::vector<std::unique_ptr<MCObject>> objects;
+};
+
+// Builds the same set of objects and generators twice. The generator types and the
+// registration orders vary per object and some generators are disabled or removed.
+void buildForceTestScene(ForceTestScene & scene, MCWorld & world, MCForceRegistry & registry, unsigned int objectCount)
+{
+    for (unsigned int i = 0; i < objectCount; i++)
+    {
+        std::vector<MCForceGeneratorPtr> generators;
+        if (i % 2 == 0)
+        {
+            generators.push_back(MCForceGeneratorPtr(new MCFrictionGenerator(0.1f + 0.01f * (i % 13), 0.5f, world)));
+        }
+
+        if (i % 3 == 0)
+        {
+            generators.push_back(MCForceGeneratorPtr(new MCDragForceGenerator(0.02f, 0.001f * (i % 5))));
+        }
+
+        if (i % 4 == 0)
+        {
+            generators.push_back(MCForceGeneratorPtr(new MCGravityGenerator(MCVector3dF(0, 0, -9.81f))));
+        }
+
+        if (i % 5 == 0)
+        {
+            generators.push_back(MCForceGeneratorPtr(new ConstantForceGenerator));
+        }
+
+        if (i % 6 == 0)
+        {
+            generators.push_back(MCForceGeneratorPtr(new MCFrictionGenerator(0.7f, 0.7f, world)));
+            generators.back()->enable(false);
+        }
+
+        std::rotate(generators.begin(), generators.begin() + (generators.empty() ? 0 : i % generators.size()), generators.end());
+
+        for (int copy = 0; copy < 2; copy++)
+        {
+            MCObject * object = new MCObject("TestObject");
+            if (i % 2)
+            {
+                object->setShape(MCShapePtr(new MCRectShape(MCShapeViewPtr(), 4, 2)));
+            }
+
+            object->physicsComponent().setMass(1.0f + i % 7, i % 11 == 0);
+            world.addObject(*object);
+            // Include zero vectors, which are not normalized
+            const MCVector3dF velocity(0.37f * (i % 9) - 1.5f, 0.11f * (i % 17) - 0.9f, 0.05f * (i % 3));
+            object->physicsComponent().setVelocity(i % 10 == 7 ? MCVector3dF() : velocity);
+            object->physicsComponent().setAngularVelocity(0.2f * (i % 5) - 0.4f);
+
+            if (copy == 0)
+            {
+                std::vector<MCForceGeneratorPtr> referenceGenerators = generators;
+                if (i % 9 == 0)
+                {
+                    referenceGenerators.push_back(MCForceGeneratorPtr(new MCFrictionGenerator(0.25f, 0.25f, world)));
+                }
+
+                // The old registry removed by swapping with the last generator
+                if (i % 8 == 0 && referenceGenerators.size() > 1)
+                {
+                    referenceGenerators[0] = referenceGenerators.back();
+                    referenceGenerators.pop_back();
+                }
+
+                scene.referenceObjects.push_back(std::unique_ptr<MCObject>(object));
+                scene.referenceGenerators.push_back(referenceGenerators);
+            }
+            else
+            {
+                for (auto && generator : generators)
+                {
+                    registry.addForceGenerator(generator, *object);
+                }
+
+                if (i % 9 == 0)
+                {
+                    registry.addFriction(0.25f, 0.25f, *object);
+                }
+
+                if (i % 8 == 0 && generators.size() + (i % 9 == 0) > 1)
+                {
+                    registry.removeForceGenerator(generators[0], *object);
+                }
+
+                scene.objects.push_back(std::unique_ptr<MCObject>(object));
+            }
+        }
+    }
+}
+
+} // namespace
+
 MCForceRegistryTest::MCForceRegistryTest()
 {
 }
@@ -145,4 +288,109 @@ void MCForceRegistryTest::testClear()
     QVERIFY(static_cast<TestForceGenerator *>(force.get())->m_updated == false);
 }
 
+void MCForceRegistryTest::testBitExactWithUpdateForce()
+{
+    MCWorld world;
+    world.setDimensions(0, 1024, 0, 1024, 0, 100, 1.0f, false, 64);
+    MCForceRegistry dut;
+
+    ForceTestScene scene;
+    buildForceTestScene(scene, world, dut, 200);
+
+    for (int step = 0; step < 20; step++)
+    {
+        for (bool builtIn : {true, false})
+        {
+            for (unsigned int i = 0; i < scene.referenceObjects.size(); i++)
+            {
+                for (auto && generator : scene.referenceGenerators[i])
+                {
+                    if (scene.referenceObjects[i]->index() != -1 && generator->enabled() && isBuiltIn(*generator) == builtIn)
+                    {
+                        generator->updateForce(*scene.referenceObjects[i]);
+                    }
+                }
+            }
+        }
+
+        dut.update();
+
+        for (unsigned int i = 0; i < scene.objects.size(); i++)
+        {
+            MCPhysicsComponent & reference = scene.referenceObjects[i]->physicsComponent();
+            MCPhysicsComponent & physicsComponent = scene.objects[i]->physicsComponent();
+            if (physicsComponent.isStationary())
+            {
+                continue;
+            }
+
+            reference.stepTime(10);
+            physicsComponent.stepTime(10);
+
+            // Bit-exact comparison on purpose
+            QVERIFY(reference.velocity().i() == physicsComponent.velocity().i());
+            QVERIFY(reference.velocity().j() == physicsComponent.velocity().j());
+            QVERIFY(reference.velocity().k() == physicsComponent.velocity().k());
+            QVERIFY(reference.angularVelocity() == physicsComponent.angularVelocity());
+        }
+    }
+
+    for (auto && object : scene.objects)
+    {
+        dut.removeForceGenerators(*object);
+    }
+}
+
+void MCForceRegistryTest::testGenericGeneratorsRunAfterBuiltInForces()
+{
+    MCWorld world;
+    MCForceRegistry dut;
+
+    MCForceGeneratorPtr stop(new StopGenerator);
+    MCForceGeneratorPtr drag(new MCDragForceGenerator(0.1f, 0.01f));
+
+    MCObject reference("TestObject");
+    MCObject object("TestObject");
+    for (auto && o : {&reference, &object})
+    {
+        o->physicsComponent().setMass(1.0f);
+        world.addObject(*o);
+        o->physicsComponent().setVelocity(MCVector3dF(2.0f, 1.0f, 0.0f));
+    }
+
+    // The drag force must be computed from the velocity before the stop generator runs
+    dut.addForceGenerator(stop, object);
+    dut.addForceGenerator(drag, object);
+    dut.update();
+
+    drag->updateForce(reference);
+    stop->updateForce(reference);
+
+    reference.physicsComponent().stepTime(10);
+    object.physicsComponent().stepTime(10);
+
+    QVERIFY(reference.physicsComponent().velocity().i() < 0);
+    QVERIFY(reference.physicsComponent().velocity().i() == object.physicsComponent().velocity().i());
+    QVERIFY(reference.physicsComponent().velocity().j() == object.physicsComponent().velocity().j());
+
+    dut.removeForceGenerators(object);
+}
+
+void MCForceRegistryTest::benchmarkUpdate()
+{
+    MCWorld world;
+    world.setDimensions(0, 1024, 0, 1024, 0, 100, 1.0f, false, 64);
+    MCForceRegistry dut;
+
+    ForceTestScene scene;
+    buildForceTestScene(scene, world, dut, 5000);
+
+    QBENCHMARK {
+        for (int i = 0; i < 100; i++)
+        {
+            dut.update();
+        }
+    }
+}
+
 QTEST_GUILESS_MAIN(MCForceRegistryTest)
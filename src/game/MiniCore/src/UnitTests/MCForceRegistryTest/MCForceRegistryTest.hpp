@@ -36,4 +36,10 @@ private slots:
     void testUpdateWithEnable();
 
     void testClear();
+
+    void testBitExactWithUpdateForce();
+
+    void testGenericGeneratorsRunAfterBuiltInForces();
+
+    void benchmarkUpdate();
 };
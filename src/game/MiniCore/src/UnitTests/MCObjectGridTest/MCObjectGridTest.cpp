@@ -0,0 +1,507 @@
+// This file belongs to the "MiniCore" game engine.
+// Copyright (C) 2018 Jussi Lind <jussi.lind@iki.fi>
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+// MA  02110-1301, USA.
+//
+
+#include "MCObjectGridTest.hpp"
+#include "../../Core/mcobject.hh"
+#include "../../Core/mcworld.hh"
+#include "../../Physics/mccircleshape.hh"
+#include "../../Physics/mcobjectgrid.hh"
+#include "../../Physics/mcphysicscomponent.hh"
+#include "../../Physics/mcrectshape.hh"
+#include "../../Graphics/mcshapeview.hh"
+
+#include <algorithm>
+#include <cstdlib>
+#include <memory>
+#include <vector>
+
+namespace {
+class TestView : public MCShapeView
+{
+public:
+
+    TestView(float width, float height)
+        : MCShapeView("TestView")
+        , m_bbox(-width / 2, -height / 2, width / 2, height / 2)
+    {
+    }
+
+    virtual const MCBBoxF & bbox() const override
+    {
+        return m_bbox;
+    }
+
+    virtual void bind() override
+    {
+    }
+
+    virtual void bindShadow() override
+    {
+    }
+
+    virtual void release() override
+    {
+    }
+
+    virtual void releaseShadow() override
+    {
+    }
+
+    virtual MCGLObjectBase * object() const override
+    {
+        return nullptr;
+    }
+
+private:
+
+    MCBBoxF m_bbox;
+};
+
+MCObjectPtr createViewObject(float width, float height, bool isStatic)
+{
+    MCObjectPtr object(new MCObject(
+        MCShapePtr(new MCRectShape(MCShapeViewPtr(new TestView(width, height)), width, height)), "TEST_OBJECT"));
+    if (isStatic)
+    {
+        object->physicsComponent().setMass(0, true);
+    }
+    else
+    {
+        object->physicsComponent().setMass(1);
+    }
+    return object;
+}
+}
+
+MCObjectGridTest::MCObjectGridTest()
+{
+}
+
+void MCObjectGridTest::testInsertAndRemove()
+{
+    MCWorld world;
+    world.setDimensions(0, 100, 0, 100, 0, 10, 1.0f, false, 10);
+
+    MCObject object1(MCShapePtr(new MCRectShape(nullptr, 2.0f, 2.0f)), "TEST_OBJECT");
+    object1.translate(MCVector3dF(55, 55));
+
+    MCObject object2(MCShapePtr(new MCRectShape(nullptr, 2.0f, 2.0f)), "TEST_OBJECT");
+    object2.translate(MCVector3dF(55.5f, 55));
+
+    MCObjectGrid & grid = world.objectGrid();
+    QVERIFY(!grid.remove(object1));
+
+    grid.insert(object1);
+    grid.insert(object1); // Double insertion must not duplicate the object
+    grid.insert(object2);
+    QVERIFY(grid.getPossibleCollisions().size() == 2);
+
+    QVERIFY(grid.remove(object1));
+    QVERIFY(!grid.remove(object1));
+    QVERIFY(grid.getPossibleCollisions().size() == 0);
+
+    QVERIFY(grid.remove(object2));
+}
+
+void MCObjectGridTest::testPossibleCollisions()
+{
+    MCWorld world;
+    world.setDimensions(0, 100, 0, 100, 0, 10, 1.0f, false, 10);
+
+    MCObject object1(MCShapePtr(new MCRectShape(nullptr, 2.0f, 2.0f)), "TEST_OBJECT");
+    MCObject object2(MCShapePtr(new MCRectShape(nullptr, 2.0f, 2.0f)), "TEST_OBJECT");
+    MCObject object3(MCShapePtr(new MCRectShape(nullptr, 2.0f, 2.0f)), "TEST_OBJECT");
+
+    world.addObject(object1);
+    world.addObject(object2);
+    world.addObject(object3);
+
+    object1.translate(MCVector3dF(25, 25));
+    object2.translate(MCVector3dF(25.5f, 25));
+    object3.translate(MCVector3dF(75, 75));
+
+    MCObjectGrid & grid = world.objectGrid();
+    auto collisions = grid.getPossibleCollisions();
+    QVERIFY(collisions.size() == 2);
+    QVERIFY(collisions[0].first == collisions[1].second);
+    QVERIFY(collisions[0].second == collisions[1].first);
+
+    object2.translate(MCVector3dF(75.5f, 75));
+    collisions = grid.getPossibleCollisions();
+    QVERIFY(collisions.size() == 2);
+    QVERIFY(collisions[0].first == &object2 || collisions[0].first == &object3);
+    QVERIFY(collisions[1].first == &object2 || collisions[1].first == &object3);
+
+    object2.translate(MCVector3dF(50, 50));
+    QVERIFY(grid.getPossibleCollisions().size() == 0);
+}
+
+void MCObjectGridTest::testNoDuplicateCollisions()
+{
+    MCWorld world;
+    world.setDimensions(0, 100, 0, 100, 0, 10, 1.0f, false, 10);
+
+    // Both objects span the same four cells
+    MCObject object1(MCShapePtr(new MCRectShape(nullptr, 4.0f, 4.0f)), "TEST_OBJECT");
+    MCObject object2(MCShapePtr(new MCRectShape(nullptr, 4.0f, 4.0f)), "TEST_OBJECT");
+
+    world.addObject(object1);
+    world.addObject(object2);
+
+    object1.translate(MCVector3dF(50, 50));
+    object2.translate(MCVector3dF(50.5f, 50));
+
+    QVERIFY(world.objectGrid().getPossibleCollisions().size() == 2);
+}
+
+void MCObjectGridTest::testUpdate()
+{
+    MCWorld world;
+    world.setDimensions(0, 100, 0, 100, 0, 10, 1.0f, false, 10);
+
+    MCObject object1(MCShapePtr(new MCRectShape(nullptr, 2.0f, 2.0f)), "TEST_OBJECT");
+    MCObject object2(MCShapePtr(new MCRectShape(nullptr, 2.0f, 2.0f)), "TEST_OBJECT");
+
+    world.addObject(object1);
+    world.addObject(object2);
+
+    object1.translate(MCVector3dF(25, 25));
+    object2.translate(MCVector3dF(35, 25));
+
+    MCObjectGrid & grid = world.objectGrid();
+    QVERIFY(grid.getPossibleCollisions().size() == 0);
+
+    // Move inside the same cell
+    const unsigned int avoidedReinsertions = grid.avoidedReinsertions();
+    object1.translate(MCVector3dF(25.5f, 25));
+    QVERIFY(grid.avoidedReinsertions() == avoidedReinsertions + 1);
+    QVERIFY(grid.getPossibleCollisions().size() == 0);
+
+    // Move to span two cells, one of which is shared with object2
+    object1.translate(MCVector3dF(30, 25));
+    QVERIFY(grid.avoidedReinsertions() == avoidedReinsertions + 1);
+    QVERIFY(grid.getPossibleCollisions().size() == 0);
+
+    // Move inside the same two cells so that the objects overlap
+    object2.translate(MCVector3dF(31.5f, 25));
+    QVERIFY(grid.getPossibleCollisions().size() == 2);
+
+    // Leave the shared cell
+    object1.translate(MCVector3dF(15, 25));
+    QVERIFY(grid.getPossibleCollisions().size() == 0);
+    QVERIFY(grid.remove(object1));
+    QVERIFY(!grid.update(object1));
+}
+
+namespace {
+
+// The filter as it was before the filter records: must give the same answers
+bool checkCollisionFilter(MCObject & obj1, MCObject & obj2)
+{
+    return &obj1.parent() != &obj2 &&
+        &obj2.parent() != &obj1 &&
+        (!obj1.physicsComponent().isSleeping() || !obj2.physicsComponent().isSleeping()) &&
+        (obj1.isPhysicsObject() || obj1.isTriggerObject()) && !obj1.bypassCollisions() &&
+        (obj2.isPhysicsObject() || obj2.isTriggerObject()) && !obj2.bypassCollisions() &&
+        obj1.physicsComponent().neverCollideWithTag() != obj2.physicsComponent().collisionTag() &&
+        obj2.physicsComponent().neverCollideWithTag() != obj1.physicsComponent().collisionTag() &&
+        (obj1.collisionLayer() == obj2.collisionLayer() || obj1.collisionLayer() == -1 || obj2.collisionLayer() == -1);
+}
+
+} // namespace
+
+void MCObjectGridTest::testCollisionFilter()
+{
+    const int layers[] = {-1, 0, 1, 31, 32, -2};
+    const int tags[] = {-1, 0, 2, 31, 40};
+
+    std::srand(1);
+    std::vector<MCObjectPtr> objects;
+    for (int i = 0; i < 64; i++)
+    {
+        objects.push_back(MCObjectPtr(new MCObject(MCShapePtr(new MCRectShape(nullptr, 2.0f, 2.0f)), "TEST_OBJECT")));
+    }
+
+    for (int round = 0; round < 50; round++)
+    {
+        // Change the properties after the objects have been created so that the filters must follow
+        for (auto && object : objects)
+        {
+            object->setIsPhysicsObject(std::rand() % 4);
+            object->setIsTriggerObject(!(std::rand() % 4));
+            object->setBypassCollisions(!(std::rand() % 8));
+            object->setCollisionLayer(layers[std::rand() % 6]);
+            object->physicsComponent().setCollisionTag(tags[std::rand() % 5]);
+            object->physicsComponent().setNeverCollideWithTag(tags[std::rand() % 5]);
+            object->physicsComponent().toggleSleep(!(std::rand() % 3));
+        }
+
+        for (int i = 0; i < 8; i++)
+        {
+            MCObjectPtr child = objects[std::rand() % objects.size()];
+            MCObject & parent = *objects[std::rand() % objects.size()];
+            if (&child->parent() == child.get() && child.get() != &parent && &parent.parent() == &parent)
+            {
+                parent.addChildObject(child);
+            }
+            else if (&child->parent() != child.get())
+            {
+                child->parent().removeChildObject(child);
+            }
+        }
+
+        for (auto && object1 : objects)
+        {
+            for (auto && object2 : objects)
+            {
+                if (object1 != object2)
+                {
+                    QVERIFY(MCCollisionFilter::accepts(object1->collisionFilter(), object2->collisionFilter()) ==
+                        checkCollisionFilter(*object1, *object2));
+                }
+            }
+        }
+    }
+}
+
+void MCObjectGridTest::testStaticObjects()
+{
+    MCWorld world;
+    world.setDimensions(0, 100, 0, 100, 0, 10, 1.0f, false, 10);
+
+    const int staticCount = 20;
+    std::vector<MCObjectPtr> walls;
+    for (int i = 0; i < staticCount; i++)
+    {
+        MCObjectPtr wall(new MCObject(MCShapePtr(new MCRectShape(nullptr, 2.0f, 2.0f)), "TEST_OBJECT"));
+        wall->physicsComponent().setMass(0, true);
+        wall->translate(MCVector3dF(55, 55));
+        world.addObject(*wall);
+        walls.push_back(wall);
+    }
+
+    MCObject object(MCShapePtr(new MCRectShape(nullptr, 2.0f, 2.0f)), "TEST_OBJECT");
+    object.physicsComponent().setMass(1);
+    world.addObject(object);
+    object.translate(MCVector3dF(55.5f, 55));
+
+    MCObjectGrid & grid = world.objectGrid();
+    QVERIFY(MCObjectGrid::isStatic(*walls[0]));
+    QVERIFY(!MCObjectGrid::isStatic(object));
+
+    // Static objects are tested only against the dynamic object
+    QVERIFY(grid.getPossibleCollisions().size() == 2 * staticCount);
+    QVERIFY(grid.testedPairs() == staticCount);
+
+    object.translate(MCVector3dF(15, 15));
+    QVERIFY(grid.getPossibleCollisions().size() == 0);
+
+    // A static object that becomes dynamic is moved to the dynamic objects on update
+    walls[0]->physicsComponent().setMass(1);
+    walls[0]->translate(MCVector3dF(15.5f, 15));
+    QVERIFY(!MCObjectGrid::isStatic(*walls[0]));
+    QVERIFY(grid.getPossibleCollisions().size() == 2);
+
+    QVERIFY(grid.remove(*walls[1]));
+    QVERIFY(!grid.remove(*walls[1]));
+}
+
+void MCObjectGridTest::testQueriesReportObjectsOnce()
+{
+    MCWorld world;
+    world.setDimensions(0, 100, 0, 100, 0, 10, 1.0f, false, 10);
+
+    // Covers 5 x 5 cells
+    MCObjectPtr object = createViewObject(40, 40, false);
+    object->translate(MCVector3dF(50, 50));
+    world.addObject(*object);
+
+    MCObjectGrid & grid = world.objectGrid();
+    MCObjectGrid::ObjectVector result;
+    grid.getObjectsWithinBBox(MCBBox<float>(0, 0, 100, 100), result);
+    QVERIFY(result.size() == 1);
+    QVERIFY(result[0] == object.get());
+
+    // A query that starts inside the object
+    grid.getObjectsWithinBBox(MCBBox<float>(45, 45, 100, 100), result);
+    QVERIFY(result.size() == 1);
+
+    grid.getObjectsWithinDistance(MCVector2dF(50, 50), 30, result);
+    QVERIFY(result.size() == 1);
+
+    int visits = 0;
+    grid.forEachObjectWithinBBox(MCBBox<float>(0, 0, 100, 100), [&visits] (MCObject &) {
+        visits++;
+    });
+    QVERIFY(visits == 1);
+
+    visits = 0;
+    grid.forEachDynamicObjectWithinBBox(MCBBox<float>(35, 35, 65, 65), [&visits] (MCObject &) {
+        visits++;
+    });
+    QVERIFY(visits == 1);
+
+    // The object is not reported outside of its bounding box
+    grid.getObjectsWithinBBox(MCBBox<float>(0, 0, 25, 25), result);
+    QVERIFY(result.empty());
+
+    world.removeObjectNow(*object);
+}
+
+void MCObjectGridTest::testQueriesReturnStaticAndDynamicObjects()
+{
+    MCWorld world;
+    world.setDimensions(0, 100, 0, 100, 0, 10, 1.0f, false, 10);
+
+    MCObjectPtr wall = createViewObject(20, 4, true);
+    wall->translate(MCVector3dF(20, 20));
+    world.addObject(*wall);
+
+    MCObjectPtr object = createViewObject(4, 4, false);
+    object->translate(MCVector3dF(25, 25));
+    world.addObject(*object);
+
+    MCObjectGrid & grid = world.objectGrid();
+    QVERIFY(MCObjectGrid::isStatic(*wall));
+    QVERIFY(!MCObjectGrid::isStatic(*object));
+
+    MCObjectGrid::ObjectVector result;
+    grid.getObjectsWithinBBox(MCBBox<float>(10, 10, 30, 30), result);
+    QVERIFY(result.size() == 2);
+    QVERIFY(std::find(result.begin(), result.end(), wall.get()) != result.end());
+    QVERIFY(std::find(result.begin(), result.end(), object.get()) != result.end());
+
+    QVERIFY(grid.getObjectsWithinBBox(MCBBox<float>(10, 10, 30, 30)).size() == 2);
+
+    // Static objects are not visited by the dynamic query
+    std::vector<MCObject *> visited;
+    grid.forEachDynamicObjectWithinBBox(MCBBox<float>(10, 10, 30, 30), [&visited] (MCObject & object) {
+        visited.push_back(&object);
+    });
+    QVERIFY(visited.size() == 1);
+    QVERIFY(visited[0] == object.get());
+
+    world.removeObjectNow(*wall);
+    world.removeObjectNow(*object);
+}
+
+void MCObjectGridTest::testQueriesSkipObjectsWithoutView()
+{
+    MCWorld world;
+    world.setDimensions(0, 100, 0, 100, 0, 10, 1.0f, false, 10);
+
+    MCObject object(MCShapePtr(new MCRectShape(nullptr, 4.0f, 4.0f)), "TEST_OBJECT");
+    object.physicsComponent().setMass(1);
+    object.translate(MCVector3dF(50, 50));
+    world.addObject(object);
+
+    MCObjectGrid & grid = world.objectGrid();
+    MCObjectGrid::ObjectVector result;
+    grid.getObjectsWithinBBox(MCBBox<float>(40, 40, 60, 60), result);
+    QVERIFY(result.empty());
+
+    grid.getObjectsWithinDistance(MCVector2dF(50, 50), 10, result);
+    QVERIFY(result.empty());
+
+    QVERIFY(grid.getObjectsWithinBBox(MCBBox<float>(40, 40, 60, 60)).empty());
+
+    // The dynamic query uses the shapes
+    int visits = 0;
+    grid.forEachDynamicObjectWithinBBox(MCBBox<float>(40, 40, 60, 60), [&visits] (MCObject &) {
+        visits++;
+    });
+    QVERIFY(visits == 1);
+
+    world.removeObjectNow(object);
+}
+
+void MCObjectGridTest::testQueryVectorKeepsCapacity()
+{
+    MCWorld world;
+    world.setDimensions(0, 100, 0, 100, 0, 10, 1.0f, false, 10);
+
+    MCObjectPtr object = createViewObject(4, 4, false);
+    object->translate(MCVector3dF(50, 50));
+    world.addObject(*object);
+
+    MCObjectGrid & grid = world.objectGrid();
+    MCObjectGrid::ObjectVector result;
+    result.reserve(16);
+    result.push_back(nullptr);
+    const size_t capacity = result.capacity();
+
+    grid.getObjectsWithinBBox(MCBBox<float>(0, 0, 10, 10), result);
+    QVERIFY(result.empty());
+    QVERIFY(result.capacity() == capacity);
+
+    grid.getObjectsWithinDistance(MCVector2dF(50, 50), 5, result);
+    QVERIFY(result.size() == 1);
+    QVERIFY(result.capacity() == capacity);
+
+    grid.getObjectsWithinDistance(MCVector2dF(10, 10), 5, result);
+    QVERIFY(result.empty());
+    QVERIFY(result.capacity() == capacity);
+
+    world.removeObjectNow(*object);
+}
+
+void MCObjectGridTest::benchmarkMovingObjects()
+{
+    MCWorld world;
+    world.setDimensions(0, 4096, 0, 4096, 0, 100, 1.0f, true, 128);
+
+    std::srand(1);
+
+    const int objectCount = 2500;
+    std::vector<std::unique_ptr<MCObject>> objects;
+    for (int i = 0; i < objectCount; i++)
+    {
+        std::unique_ptr<MCObject> object;
+        if (i % 2)
+        {
+            object.reset(new MCObject(MCShapePtr(new MCRectShape(nullptr, 20.0f, 10.0f)), "TEST_OBJECT"));
+        }
+        else
+        {
+            object.reset(new MCObject(MCShapePtr(new MCCircleShape(nullptr, 6.0f)), "TEST_OBJECT"));
+        }
+
+        object->physicsComponent().setMass(1);
+        object->physicsComponent().preventSleeping(true);
+        object->physicsComponent().setLinearDamping(1.0f);
+        object->addToWorld(world, 50 + std::rand() % 4000, 50 + std::rand() % 4000);
+        object->physicsComponent().setVelocity(
+            MCVector3dF((std::rand() % 200 - 100) / 50.0f, (std::rand() % 200 - 100) / 50.0f));
+        objects.push_back(std::move(object));
+    }
+
+    QBENCHMARK {
+        for (int i = 0; i < 100; i++)
+        {
+            world.stepTime(16);
+        }
+    }
+
+    for (auto && object : objects)
+    {
+        object->removeFromWorldNow();
+    }
+}
+
+QTEST_GUILESS_MAIN(MCObjectGridTest)
@@ -97,7 +97,7 @@ void MCObjectTest::testAddChildren()
     QVERIFY(child1->index() == -1);
     QVERIFY(child2->index() == -1);
 
-    root.addToWorld(); // Adding via object adds also children
+    root.addToWorld(world); // Adding via object adds also children
 
     QVERIFY(root.index() >= 0);
     QVERIFY(child1->index() >= 0);
@@ -139,7 +139,7 @@ void MCObjectTest::testAddToWorld()
     MCWorld world;
     MCObject object("test");
     QVERIFY(object.index() == -1);
-    object.addToWorld();
+    object.addToWorld(world);
     QVERIFY(object.index() >= 0);
 
     object.removeFromWorld(); // Lazy removal
@@ -147,7 +147,7 @@ void MCObjectTest::testAddToWorld()
     world.stepTime(1);
     QVERIFY(object.index() == -1);
 
-    object.addToWorld();
+    object.addToWorld(world);
     QVERIFY(object.index() >= 0);
 
     object.removeFromWorldNow(); // Immediate removal
@@ -158,7 +158,7 @@ void MCObjectTest::testAngularVelocityAndSleep()
 {
     MCWorld world;
     MCObject object("TestObject");
-    object.addToWorld();
+    object.addToWorld(world);
 
     QVERIFY(qFuzzyCompare(object.physicsComponent().angularVelocity(), float(0)));
 
@@ -187,7 +187,7 @@ void MCObjectTest::testAngularVelocityIntegration()
 {
     MCWorld world;
     MCObject object("TestObject");
-    object.addToWorld();
+    object.addToWorld(world);
 
     QVERIFY(qFuzzyCompare(object.physicsComponent().angularVelocity(), float(0)));
     QVERIFY(qFuzzyCompare(object.angle(), float(0)));
@@ -224,6 +224,8 @@ void MCObjectTest::testDefaultFlags()
     QVERIFY(!object.isParticle());
     QVERIFY(object.isPhysicsObject());
     QVERIFY(!object.isTriggerObject());
+    QVERIFY(!object.isRenderOnly());
+    QVERIFY(!object.receivesPersistContactEvents());
 
     object.setBypassCollisions(true);
     QVERIFY(object.bypassCollisions());
@@ -239,13 +241,19 @@ void MCObjectTest::testDefaultFlags()
 
     object.setIsTriggerObject(true);
     QVERIFY(object.isTriggerObject());
+
+    object.setIsRenderOnly(true);
+    QVERIFY(object.isRenderOnly());
+
+    object.setReceivesPersistContactEvents(true);
+    QVERIFY(object.receivesPersistContactEvents());
 }
 
 void MCObjectTest::testDelete()
 {
     MCWorld world;
     MCObject * object = new MCObject("TestObject");
-    object->addToWorld();
+    object->addToWorld(world);
     QVERIFY(world.objectCount() == 5); // 5 includes internal walls
 
     delete object;
@@ -268,7 +276,7 @@ void MCObjectTest::testChildRotate()
     const float child2Angle = 90;
     root.addChildObject(child2, MCVector3dF(2, 2, 2), 90);
 
-    root.addToWorld();
+    root.addToWorld(world);
 
     // Root at (0, 0, 0)
 
@@ -324,7 +332,7 @@ void MCObjectTest::testChildTranslate()
     root.addChildObject(child1, MCVector3dF(1, 1, 1));
     root.addChildObject(child2, MCVector3dF(2, 2, 2));
 
-    root.addToWorld();
+    root.addToWorld(world);
 
     // Root at (0, 0, 0)
 
@@ -341,6 +349,45 @@ void MCObjectTest::testChildTranslate()
     vector3dCompare(child2->location(), MCVector3dF(3, 4, 5));
 }
 
+void MCObjectTest::testRenderOnlyChild()
+{
+    MCWorld world;
+    world.setDimensions(0, 1024, 0, 768, 0, 100, 1);
+
+    MCObject root("root");
+    root.setShape(MCShapePtr(new MCRectShape(nullptr, 2, 2)));
+    MCShapePtr shape(new MCRectShape(nullptr, 2, 2));
+    MCObjectPtr child(new MCObject("child"));
+    child->setShape(shape);
+    child->setIsRenderOnly(true);
+    root.addChildObject(child, MCVector3dF(1, 1, 1));
+
+    root.addToWorld(world);
+    QVERIFY(world.objectCount() == 5); // 5 includes internal walls
+    QVERIFY(child->index() == -1);
+
+    // Render-only children still follow the parent
+    root.translate(MCVector3dF(1, 2, 3));
+    vector3dCompare(child->location(), MCVector3dF(2, 3, 4));
+
+    // ..and they are interpolated with the parent
+    root.physicsComponent().setMass(1);
+    root.physicsComponent().setLinearDamping(1); // Disable damping
+    root.physicsComponent().setVelocity(MCVector3dF(4, 0, 0));
+
+    world.stepTime(1);
+    vector3dCompare(child->location(), MCVector3dF(6, 3, 4));
+
+    world.setRenderInterpolation(0.5f);
+    MCVector3dF location;
+    float angle;
+    shape->renderTransform(location, angle);
+    vector3dCompare(location, MCVector3dF(4, 3, 4));
+
+    root.removeFromWorldNow();
+    QVERIFY(world.objectCount() == 4);
+}
+
 void MCObjectTest::testCollisionLayer()
 {
     MCWorld world;
@@ -353,7 +400,7 @@ void MCObjectTest::testCollisionLayer()
     root.addChildObject(child1);
     root.addChildObject(child2);
 
-    root.addToWorld();
+    root.addToWorld(world);
 
     QVERIFY(root.collisionLayer() == 0);
     QVERIFY(child1->collisionLayer() == 0);
@@ -387,7 +434,7 @@ void MCObjectTest::testLinearDamping()
 {
     MCWorld world;
     MCObject object("TestObject");
-    object.addToWorld();
+    object.addToWorld(world);
     object.physicsComponent().setLinearDamping(0.5f);
     vector3dCompare(object.physicsComponent().velocity(), MCVector3dF(0, 0, 0));
 
@@ -413,6 +460,49 @@ void MCObjectTest::testMass()
     QVERIFY(qFuzzyCompare(object.physicsComponent().invMass(), float(0.0)));
 }
 
+void MCObjectTest::testRenderInterpolation()
+{
+    MCWorld world;
+    world.setDimensions(0, 100, 0, 100, 0, 10);
+
+    MCObject object("TestObject");
+    MCShapePtr shape(new MCRectShape(nullptr, 2, 2));
+    object.setShape(shape);
+    object.physicsComponent().setMass(1);
+    object.physicsComponent().setLinearDamping(1); // Disable damping
+
+    // Nothing is interpolated before the first step
+    object.translate(MCVector3dF(50, 50, 0));
+    object.addToWorld(world);
+    world.setRenderInterpolation(0.5f);
+    MCVector3dF location;
+    float angle;
+    shape->renderTransform(location, angle);
+    vector3dCompare(location, MCVector3dF(50, 50, 0));
+
+    world.setRenderInterpolation(1.0f);
+    object.physicsComponent().setVelocity(MCVector3dF(4, 0, 0));
+
+    world.stepTime(1);
+    QVERIFY(qFuzzyCompare(shape->location().i(), 54.0f));
+
+    shape->renderTransform(location, angle);
+    vector3dCompare(location, shape->location());
+
+    world.setRenderInterpolation(0.5f);
+    shape->renderTransform(location, angle);
+    vector3dCompare(location, MCVector3dF(52, 50, 0));
+
+    // Moves between the steps are not interpolated
+    object.translate(MCVector3dF(60, 50, 0));
+    object.rotate(90);
+    shape->renderTransform(location, angle);
+    vector3dCompare(location, MCVector3dF(60, 50, 0));
+    QVERIFY(qFuzzyCompare(angle, 90.0f));
+
+    object.removeFromWorldNow();
+}
+
 void MCObjectTest::testRotate()
 {
     MCObject object("TestObject");
@@ -427,7 +517,7 @@ void MCObjectTest::testRotate()
     QVERIFY(qFuzzyCompare(object.angle(), float(45)));
     QVERIFY(qFuzzyCompare(shape->angle(), float(45)));
 
-    object.addToWorld();
+    object.addToWorld(world);
     object.rotate(22);
     QVERIFY(qFuzzyCompare(object.angle(), float(22)));
     QVERIFY(qFuzzyCompare(shape->angle(), float(22)));
@@ -435,6 +525,7 @@ void MCObjectTest::testRotate()
 
 void MCObjectTest::testTimerEvent()
 {
+    MCWorld world;
     TestObject testObject1, testObject2;
     QVERIFY(!testObject1.m_timerEventReceived);
     QVERIFY(!testObject2.m_timerEventReceived);
@@ -442,23 +533,23 @@ void MCObjectTest::testTimerEvent()
     testObject1.m_timerEventReceived = false;
     testObject2.m_timerEventReceived = false;
     MCTimerEvent timerEvent(100);
-    MCObject::sendTimerEvent(timerEvent);
+    world.sendTimerEvent(timerEvent);
     QVERIFY(!testObject1.m_timerEventReceived);
     QVERIFY(!testObject2.m_timerEventReceived);
 
     testObject1.m_timerEventReceived = false;
     testObject2.m_timerEventReceived = false;
-    MCObject::subscribeTimerEvent(testObject1);
-    MCObject::subscribeTimerEvent(testObject2);
-    MCObject::sendTimerEvent(timerEvent);
+    world.subscribeTimerEvent(testObject1);
+    world.subscribeTimerEvent(testObject2);
+    world.sendTimerEvent(timerEvent);
     QVERIFY(testObject1.m_timerEventReceived);
     QVERIFY(testObject2.m_timerEventReceived);
 
     testObject1.m_timerEventReceived = false;
     testObject2.m_timerEventReceived = false;
-    MCObject::unsubscribeTimerEvent(testObject1);
-    MCObject::unsubscribeTimerEvent(testObject2);
-    MCObject::sendTimerEvent(timerEvent);
+    world.unsubscribeTimerEvent(testObject1);
+    world.unsubscribeTimerEvent(testObject2);
+    world.sendTimerEvent(timerEvent);
     QVERIFY(!testObject1.m_timerEventReceived);
     QVERIFY(!testObject2.m_timerEventReceived);
 }
@@ -467,7 +558,7 @@ void MCObjectTest::testTranslate()
 {
     MCWorld world;
     MCObject object("TestObject");
-    object.addToWorld();
+    object.addToWorld(world);
 
     vector3dCompare(object.location(), MCVector3dF(0, 0, 0));
 
@@ -480,7 +571,7 @@ void MCObjectTest::testVelocityAndSleep()
 {
     MCWorld world;
     MCObject object("TestObject");
-    object.addToWorld();
+    object.addToWorld(world);
     object.physicsComponent().setLinearDamping(1); // Disable damping
     vector3dCompare(object.physicsComponent().velocity(), MCVector3dF(0, 0, 0));
 
@@ -509,7 +600,7 @@ void MCObjectTest::testVelocityAndPreventSleeping()
 {
     MCWorld world;
     MCObject object("TestObject");
-    object.addToWorld();
+    object.addToWorld(world);
 
     object.physicsComponent().setVelocity(MCVector3dF(1, 1, 1));
 
@@ -541,7 +632,7 @@ void MCObjectTest::testVelocityIntegration()
     MCWorld world;
     world.setDimensions(0, 1024, 0, 768, 0, 100, 1);
     MCObject object("TestObject");
-    object.addToWorld();
+    object.addToWorld(world);
 
     vector3dCompare(object.location(), MCVector3dF(0, 0, 0));
     vector3dCompare(object.physicsComponent().velocity(), MCVector3dF(0, 0, 0));
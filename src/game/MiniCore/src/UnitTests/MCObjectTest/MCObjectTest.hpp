@@ -57,6 +57,10 @@ private slots:
 
     void testMass();
 
+    void testRenderInterpolation();
+
+    void testRenderOnlyChild();
+
     void testRotate();
 
     void testTimerEvent();
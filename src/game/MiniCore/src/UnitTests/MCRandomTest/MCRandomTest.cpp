@@ -0,0 +1,178 @@
+// This file belongs to the "MiniCore" game engine.
+// Copyright (C) 2018 Jussi Lind <jussi.lind@iki.fi>
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+// MA  02110-1301, USA.
+//
+
+#include "MCRandomTest.hpp"
+#include "../../Core/mcrandom.hh"
+#include "../../Core/mcrandomstream.hh"
+#include "../../Core/mcstatebuffer.hh"
+#include "../../Core/mcworld.hh"
+
+#include <cmath>
+#include <vector>
+
+namespace {
+
+bool equals(const MCVector2dF & vector1, const MCVector2dF & vector2)
+{
+    return vector1.i() == vector2.i() && vector1.j() == vector2.j();
+}
+
+bool equals(const MCVector3dF & vector1, const MCVector3dF & vector2)
+{
+    return vector1.i() == vector2.i() && vector1.j() == vector2.j() && vector1.k() == vector2.k();
+}
+
+} // namespace
+
+MCRandomTest::MCRandomTest()
+{
+}
+
+void MCRandomTest::testSeed()
+{
+    MCRandomStream stream1(42, 1);
+    MCRandomStream stream2(42, 1);
+    for (int i = 0; i < 100; i++)
+    {
+        QVERIFY(stream1.next() == stream2.next());
+    }
+
+    // Reseeding restarts the sequence
+    MCRandomStream stream3(42, 1);
+    const uint32_t first = stream3.next();
+    stream3.next();
+    stream3.seed(42, 1);
+    QVERIFY(stream3.next() == first);
+
+    // The wrapper restarts also
+    MCRandom::setSeed(7);
+    const float value = MCRandom::getValue();
+    MCRandom::setSeed(7);
+    QVERIFY(MCRandom::getValue() == value);
+}
+
+void MCRandomTest::testStreams()
+{
+    MCRandomStream stream1(42, 0);
+    MCRandomStream stream2(42, 1);
+    MCRandomStream stream3(43, 0);
+    int equal12 = 0;
+    int equal13 = 0;
+    for (int i = 0; i < 100; i++)
+    {
+        const uint32_t value = stream1.next();
+        equal12 += value == stream2.next();
+        equal13 += value == stream3.next();
+    }
+
+    QVERIFY(equal12 < 2);
+    QVERIFY(equal13 < 2);
+}
+
+void MCRandomTest::testRange()
+{
+    MCRandomStream stream(1);
+    float sum = 0;
+    const int count = 10000;
+    for (int i = 0; i < count; i++)
+    {
+        const float value = stream.getValue();
+        QVERIFY(value >= 0.0f && value < 1.0f);
+        sum += value;
+    }
+
+    QVERIFY(std::fabs(sum / count - 0.5f) < 0.02f);
+}
+
+void MCRandomTest::testFill()
+{
+    MCRandomStream stream1(3, 2);
+    MCRandomStream stream2(3, 2);
+
+    std::vector<float> values(17);
+    stream1.fill(values.data(), values.size());
+    for (float value : values)
+    {
+        QVERIFY(value == stream2.getValue());
+    }
+
+    std::vector<MCVector2dF> vectors2d(17);
+    stream1.fill(vectors2d.data(), vectors2d.size());
+    for (auto && vector : vectors2d)
+    {
+        QVERIFY(equals(vector, stream2.randomVector2d()));
+    }
+
+    std::vector<MCVector3dF> vectors3d(17);
+    stream1.fill(vectors3d.data(), vectors3d.size());
+    for (auto && vector : vectors3d)
+    {
+        QVERIFY(equals(vector, stream2.randomVector3d()));
+    }
+
+    stream1.fillPositiveZ(vectors3d.data(), vectors3d.size());
+    for (auto && vector : vectors3d)
+    {
+        QVERIFY(equals(vector, stream2.randomVector3dPositiveZ()));
+    }
+}
+
+void MCRandomTest::testVectors()
+{
+    MCRandomStream stream(5);
+    for (int i = 0; i < 1000; i++)
+    {
+        QVERIFY(std::fabs(stream.randomVector2d().length() - 1.0f) < 0.001f);
+        QVERIFY(std::fabs(stream.randomVector3d().length() - 1.0f) < 0.001f);
+
+        const MCVector3dF positiveZ = stream.randomVector3dPositiveZ();
+        QVERIFY(std::fabs(positiveZ.length() - 1.0f) < 0.001f);
+        QVERIFY(positiveZ.k() >= 0.0f);
+    }
+}
+
+void MCRandomTest::testWorldStreams()
+{
+    MCWorld world1;
+    MCWorld world2;
+    world1.setRandomSeed(11);
+    world2.setRandomSeed(11);
+
+    // Streams of a world don't affect each other
+    world1.randomStream(0).next();
+    QVERIFY(world1.randomStream(1).next() == world2.randomStream(1).next());
+    QVERIFY(world1.randomStream(0).next() != world2.randomStream(0).next());
+
+    // Reseeding restarts the streams created before
+    world1.setRandomSeed(11);
+    world2.setRandomSeed(11);
+    QVERIFY(world1.randomStream(0).next() == world2.randomStream(0).next());
+
+    // Streams are a part of the world state
+    MCStateBuffer state;
+    world1.saveState(state);
+    const uint32_t value0 = world1.randomStream(0).next();
+    const uint32_t value2 = world1.randomStream(2).next();
+    state.rewind();
+    QVERIFY(world1.restoreState(state));
+    QVERIFY(world1.randomStream(0).next() == value0);
+    QVERIFY(world1.randomStream(2).next() == value2);
+}
+
+QTEST_GUILESS_MAIN(MCRandomTest)
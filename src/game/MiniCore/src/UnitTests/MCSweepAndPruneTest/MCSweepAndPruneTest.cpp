@@ -0,0 +1,732 @@
+// This file belongs to the "MiniCore" game engine.
+// Copyright (C) 2018 Jussi Lind <jussi.lind@iki.fi>
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+// MA  02110-1301, USA.
+//
+
+#include "MCSweepAndPruneTest.hpp"
+#include "../../Core/mcobject.hh"
+#include "../../Core/mcstatebuffer.hh"
+#include "../../Core/mcworld.hh"
+#include "../../Physics/mccircleshape.hh"
+#include "../../Physics/mcobjectgrid.hh"
+#include "../../Physics/mcphysicscomponent.hh"
+#include "../../Physics/mcrectshape.hh"
+#include "../../Physics/mcsweepandprune.hh"
+#include "../../Graphics/mcshapeview.hh"
+
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QXmlStreamReader>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <memory>
+#include <vector>
+
+namespace {
+class TestView : public MCShapeView
+{
+public:
+
+    TestView(float width, float height)
+        : MCShapeView("TestView")
+        , m_bbox(-width / 2, -height / 2, width / 2, height / 2)
+    {
+    }
+
+    virtual const MCBBoxF & bbox() const override
+    {
+        return m_bbox;
+    }
+
+    virtual void bind() override
+    {
+    }
+
+    virtual void bindShadow() override
+    {
+    }
+
+    virtual void release() override
+    {
+    }
+
+    virtual void releaseShadow() override
+    {
+    }
+
+    virtual MCGLObjectBase * object() const override
+    {
+        return nullptr;
+    }
+
+private:
+
+    MCBBoxF m_bbox;
+};
+
+MCObjectPtr createObject(float width, float height, bool isStatic, float viewSize = 0)
+{
+    MCShapeViewPtr view(viewSize > 0 ? new TestView(viewSize, viewSize) : nullptr);
+    MCObjectPtr object(new MCObject(MCShapePtr(new MCRectShape(view, width, height)), "TEST_OBJECT"));
+    if (isStatic)
+    {
+        object->physicsComponent().setMass(0, true);
+    }
+    else
+    {
+        object->physicsComponent().setMass(1);
+        object->physicsComponent().preventSleeping(true);
+    }
+    return object;
+}
+
+typedef std::vector<std::pair<MCObject *, MCObject *>> PairVector;
+
+PairVector sortedPairs(const MCSweepAndPrune::CollisionVector & collisions)
+{
+    PairVector pairs(collisions.begin(), collisions.end());
+    std::sort(pairs.begin(), pairs.end());
+    return pairs;
+}
+
+//! Touching boxes are reported by the sweep, so this includes the edges unlike MCBBox::intersects().
+bool bboxesOverlap(MCObject & object1, MCObject & object2)
+{
+    const MCBBox<float> bbox1 = object1.shape()->bbox();
+    const MCBBox<float> bbox2 = object2.shape()->bbox();
+    return bbox1.x1() <= bbox2.x2() && bbox1.x2() >= bbox2.x1() && bbox1.y1() <= bbox2.y2() && bbox1.y2() >= bbox2.y1();
+}
+
+void setUpWorld(MCWorld & world, MCWorld::Broadphase broadphase)
+{
+    world.setDimensions(0, 100, 0, 100, 0, 10, 1.0f, false, 10, broadphase);
+}
+
+// The objects of the shipped tracks as src/game/trackobjectfactory.cpp builds them.
+// The sizes are the surface sizes of data/surfaces.conf. The branches of the trees are left out.
+struct TrackObjectType
+{
+    const char * role;
+    float width;
+    float height;
+    float viewWidth;
+    float viewHeight;
+    float mass;
+    bool isStationary;
+    bool isCircle;
+    bool isPhysicsObject;
+};
+
+const TrackObjectType trackObjectTypes[] = {
+    {"brake", 64, 32, 64, 32, 1000, false, false, true},
+    {"bushArea", 128, 128, 128, 128, 0, true, false, false},
+    {"crate", 24, 24, 24, 24, 1000, false, false, true},
+    {"dustRacing2DBanner", 256, 16, 256, 16, 15000, false, false, true},
+    {"grandstand", 128, 128, 128, 128, 20000, false, false, true},
+    {"left", 64, 24, 64, 24, 1000, false, false, true},
+    {"pit", 256, 54, 256, 54, 1, true, false, false},
+    {"plant", 4, 4, 32, 32, 250, false, false, true},
+    {"right", 64, 24, 64, 24, 1000, false, false, true},
+    {"rock", 16, 16, 16, 16, 2500, false, false, true},
+    {"sandAreaBig", 512, 64, 512, 64, 0, true, false, false},
+    {"sandAreaCurve", 128, 128, 128, 128, 0, true, false, false},
+    {"tire", 15, 15, 15, 15, 500, false, true, true},
+    {"tree", 16, 16, 48, 48, 1, true, true, true},
+    {"wall", 64, 16, 64, 16, 20000, false, false, true},
+    {"wallLong", 256, 16, 256, 16, 80000, false, false, true}};
+
+const int trackTileSize = 256;
+
+const int shippedTrackCarCount = 12;
+
+const float shippedTrackCarSpeed = 600;
+
+const int shippedTrackStepCount = 600;
+
+//! A shipped track loaded into a world of its own. The cars drive along the route of the track.
+struct ShippedTrack
+{
+    ~ShippedTrack()
+    {
+        for (auto && object : objects)
+        {
+            object->removeFromWorldNow();
+        }
+    }
+
+    //! \return true if the track was loaded.
+    bool load(const QString & fileName, MCWorld::Broadphase broadphase)
+    {
+        QFile file(QDir(TRACK_PATH).filePath(fileName));
+        if (!file.open(QIODevice::ReadOnly))
+        {
+            return false;
+        }
+
+        QXmlStreamReader reader(&file);
+        if (!reader.readNextStartElement() || reader.name() != "track")
+        {
+            return false;
+        }
+
+        // The y-axis of the editor points down
+        const float height = reader.attributes().value("rows").toInt() * trackTileSize;
+        const float width = reader.attributes().value("cols").toInt() * trackTileSize;
+        world.setDimensions(0, width, 0, height, 0, 1000, 0.05f, true, 128, broadphase);
+
+        while (reader.readNextStartElement())
+        {
+            const QXmlStreamAttributes attributes = reader.attributes();
+            const float x = attributes.value("x").toFloat();
+            const float y = height - attributes.value("y").toFloat();
+            if (reader.name() == "o")
+            {
+                for (auto && type : trackObjectTypes)
+                {
+                    if (attributes.value("r") == type.role)
+                    {
+                        addObject(type, x, y, -attributes.value("o").toInt(), attributes.value("fs").toInt());
+                    }
+                }
+            }
+            else if (reader.name() == "n")
+            {
+                route.push_back(MCVector3dF(x, y));
+            }
+
+            reader.skipCurrentElement();
+        }
+
+        if (reader.hasError() || route.empty())
+        {
+            return false;
+        }
+
+        for (int i = 0; i < shippedTrackCarCount; i++)
+        {
+            const size_t node = i * route.size() / shippedTrackCarCount;
+            MCObjectPtr car(new MCObject(MCShapePtr(new MCRectShape(MCShapeViewPtr(new TestView(48, 24)), 48, 24)), "car"));
+            car->physicsComponent().setMass(1500);
+            car->physicsComponent().preventSleeping(true);
+            car->addToWorld(world, route[node].i(), route[node].j());
+            objects.push_back(car);
+            cars.push_back(car);
+            targets.push_back((node + 1) % route.size());
+        }
+
+        return true;
+    }
+
+    void addObject(const TrackObjectType & type, float x, float y, int angle, bool forceStationary)
+    {
+        MCShapeViewPtr view(new TestView(type.viewWidth, type.viewHeight));
+        MCShapePtr shape(type.isCircle ?
+            static_cast<MCShape *>(new MCCircleShape(view, type.width / 2)) :
+            static_cast<MCShape *>(new MCRectShape(view, type.width, type.height)));
+        MCObjectPtr object(new MCObject(shape, type.role));
+        object->physicsComponent().setMass(forceStationary ? 0 : type.mass, forceStationary || type.isStationary);
+        object->setIsPhysicsObject(type.isPhysicsObject);
+        object->rotate(angle);
+        object->addToWorld(world, x, y);
+        objects.push_back(object);
+    }
+
+    //! Steer the cars towards their next route nodes and step the world.
+    void step()
+    {
+        for (size_t i = 0; i < cars.size(); i++)
+        {
+            const MCVector3dF & location = cars[i]->location();
+            float dx = route[targets[i]].i() - location.i();
+            float dy = route[targets[i]].j() - location.j();
+            const float distance = std::sqrt(dx * dx + dy * dy);
+            if (distance < trackTileSize / 2)
+            {
+                targets[i] = (targets[i] + 1) % route.size();
+            }
+
+            if (distance > 0)
+            {
+                dx *= shippedTrackCarSpeed / distance;
+                dy *= shippedTrackCarSpeed / distance;
+            }
+
+            cars[i]->physicsComponent().setVelocity(MCVector3dF(dx, dy));
+        }
+
+        world.stepTime(16);
+    }
+
+    //! Visit the objects within a 1280x720 camera view centered at the given location like the renderer does.
+    size_t queryView(const MCVector3dF & center) const
+    {
+        const MCBBox<float> bbox(center.i() - 640, center.j() - 360, center.i() + 640, center.j() + 360);
+        size_t count = 0;
+        const auto visit = [&count] (MCObject &) {
+            count++;
+        };
+
+        if (world.broadphase() == MCWorld::Broadphase::SweepAndPrune)
+        {
+            world.sweepAndPrune().forEachObjectWithinBBox(bbox, visit);
+        }
+        else
+        {
+            world.objectGrid().forEachObjectWithinBBox(bbox, visit);
+        }
+
+        return count;
+    }
+
+    MCWorld world;
+
+    std::vector<MCObjectPtr> objects;
+
+    std::vector<MCObjectPtr> cars;
+
+    std::vector<MCVector3dF> route;
+
+    std::vector<size_t> targets;
+};
+
+void addShippedTrackRows()
+{
+    QTest::addColumn<QString>("fileName");
+    QTest::addColumn<bool>("sweepAndPrune");
+
+    const QStringList fileNames = QDir(TRACK_PATH).entryList(QStringList("*.trk"), QDir::Files, QDir::Name);
+    if (fileNames.isEmpty())
+    {
+        QSKIP("The shipped tracks were not found");
+    }
+
+    for (auto && fileName : fileNames)
+    {
+        const QString name = QFileInfo(fileName).completeBaseName();
+        QTest::newRow(qPrintable(name + " grid")) << fileName << false;
+        QTest::newRow(qPrintable(name + " sap")) << fileName << true;
+    }
+}
+}
+
+MCSweepAndPruneTest::MCSweepAndPruneTest()
+{
+}
+
+void MCSweepAndPruneTest::testInsertAndRemove()
+{
+    MCWorld world;
+    setUpWorld(world, MCWorld::Broadphase::SweepAndPrune);
+
+    MCObjectPtr object1 = createObject(2, 2, false);
+    MCObjectPtr object2 = createObject(2, 2, false);
+    MCObjectPtr object3 = createObject(2, 2, false);
+    object1->addToWorld(world, 10, 10);
+    object2->addToWorld(world, 11.5f, 10);
+    object3->addToWorld(world, 13, 10);
+
+    MCSweepAndPrune & sweepAndPrune = world.sweepAndPrune();
+    QVERIFY(sweepAndPrune.objectCount() == 3);
+    QVERIFY(sweepAndPrune.getPossibleCollisions().size() == 4);
+
+    // Inserting twice doesn't add a proxy
+    sweepAndPrune.insert(*object1);
+    QVERIFY(sweepAndPrune.objectCount() == 3);
+
+    QVERIFY(sweepAndPrune.remove(*object2));
+    QVERIFY(!sweepAndPrune.remove(*object2));
+    QVERIFY(sweepAndPrune.objectCount() == 2);
+    QVERIFY(sweepAndPrune.getPossibleCollisions().empty());
+
+    // The remaining proxies are still found after the compaction
+    object1->translate(MCVector3dF(12, 10));
+    const PairVector pairs = sortedPairs(sweepAndPrune.getPossibleCollisions());
+    QVERIFY(pairs.size() == 2);
+    QVERIFY(std::find(pairs.begin(), pairs.end(), std::make_pair(object1.get(), object3.get())) != pairs.end());
+
+    sweepAndPrune.insert(*object2);
+    QVERIFY(sweepAndPrune.objectCount() == 3);
+    QVERIFY(sweepAndPrune.getPossibleCollisions().size() == 6);
+
+    QVERIFY(sweepAndPrune.remove(*object1));
+    QVERIFY(sweepAndPrune.remove(*object3));
+    QVERIFY(sweepAndPrune.getPossibleCollisions().empty());
+}
+
+void MCSweepAndPruneTest::testStaticObjects()
+{
+    MCWorld world;
+    setUpWorld(world, MCWorld::Broadphase::SweepAndPrune);
+
+    const int staticCount = 20;
+    std::vector<MCObjectPtr> walls;
+    for (int i = 0; i < staticCount; i++)
+    {
+        MCObjectPtr wall = createObject(2, 2, true);
+        wall->addToWorld(world, 55, 55);
+        walls.push_back(wall);
+    }
+
+    MCObjectPtr object = createObject(2, 2, false);
+    object->addToWorld(world, 55.5f, 55);
+
+    MCSweepAndPrune & sweepAndPrune = world.sweepAndPrune();
+    QVERIFY(sweepAndPrune.isStatic(*walls[0]));
+    QVERIFY(!sweepAndPrune.isStatic(*object));
+
+    // Static objects are tested only against the dynamic object
+    QVERIFY(sweepAndPrune.getPossibleCollisions().size() == 2 * staticCount);
+
+    object->translate(MCVector3dF(15, 15));
+    QVERIFY(sweepAndPrune.getPossibleCollisions().empty());
+
+    // Moving a static object re-sorts the static endpoints
+    walls[1]->translate(MCVector3dF(15.5f, 15));
+    QVERIFY(sweepAndPrune.isStatic(*walls[1]));
+    QVERIFY(sweepAndPrune.getPossibleCollisions().size() == 2);
+
+    // A static object that becomes dynamic is moved to the dynamic objects on update.
+    // It's still sleeping, so it's not tested against the static object.
+    walls[0]->physicsComponent().setMass(1);
+    walls[0]->translate(MCVector3dF(14.5f, 15));
+    QVERIFY(!sweepAndPrune.isStatic(*walls[0]));
+    QVERIFY(sweepAndPrune.objectCount() == staticCount + 1);
+    QVERIFY(sweepAndPrune.getPossibleCollisions().size() == 4);
+}
+
+void MCSweepAndPruneTest::testOnlyMovedObjectsAreRefreshed()
+{
+    MCWorld world;
+    setUpWorld(world, MCWorld::Broadphase::SweepAndPrune);
+
+    MCObjectPtr object1 = createObject(2, 2, false);
+    MCObjectPtr object2 = createObject(2, 2, false);
+    object1->addToWorld(world, 10, 10);
+    object2->addToWorld(world, 20, 10);
+
+    MCSweepAndPrune & sweepAndPrune = world.sweepAndPrune();
+    QVERIFY(sweepAndPrune.getPossibleCollisions().empty());
+
+    // Moving the objects past each other swaps their endpoints
+    object1->translate(MCVector3dF(30, 10));
+    QVERIFY(sweepAndPrune.getPossibleCollisions().empty());
+
+    object2->translate(MCVector3dF(31, 10));
+    QVERIFY(sweepAndPrune.getPossibleCollisions().size() == 2);
+
+    // Repeated queries without moves give the same result
+    QVERIFY(sweepAndPrune.getPossibleCollisions().size() == 2);
+
+    // Sleeping objects are filtered out even if they don't move
+    object1->physicsComponent().preventSleeping(false);
+    object2->physicsComponent().preventSleeping(false);
+    object1->physicsComponent().toggleSleep(true);
+    object2->physicsComponent().toggleSleep(true);
+    QVERIFY(sweepAndPrune.getPossibleCollisions().empty());
+}
+
+void MCSweepAndPruneTest::testMatchesGrid()
+{
+    MCWorld gridWorld;
+    setUpWorld(gridWorld, MCWorld::Broadphase::Grid);
+
+    MCWorld sweepWorld;
+    setUpWorld(sweepWorld, MCWorld::Broadphase::SweepAndPrune);
+
+    std::srand(1);
+
+    std::vector<MCObjectPtr> gridObjects;
+    std::vector<MCObjectPtr> sweepObjects;
+    const auto addObjects = [&] (int count) {
+        for (int i = 0; i < count; i++)
+        {
+            const bool isStatic = gridObjects.size() % 4 == 0;
+            const float width = 1 + std::rand() % 8;
+            const float height = 1 + std::rand() % 8;
+            const float x = 5 + (std::rand() % 9000) / 100.0f;
+            const float y = 5 + (std::rand() % 9000) / 100.0f;
+
+            gridObjects.push_back(createObject(width, height, isStatic));
+            gridObjects.back()->addToWorld(gridWorld, x, y);
+
+            sweepObjects.push_back(createObject(width, height, isStatic));
+            sweepObjects.back()->addToWorld(sweepWorld, x, y);
+        }
+    };
+
+    // Many objects at once are inserted as a batch and a few are sorted into place one by one
+    addObjects(200);
+
+    for (int round = 0; round < 10; round++)
+    {
+        // The grid tests only the cells and the shapes, so it also reports
+        // pairs whose bounding boxes don't overlap
+        PairVector gridPairs = sortedPairs(gridWorld.objectGrid().getPossibleCollisions());
+        gridPairs.erase(
+            std::remove_if(gridPairs.begin(), gridPairs.end(), [] (const std::pair<MCObject *, MCObject *> & pair) {
+                return !bboxesOverlap(*pair.first, *pair.second);
+            }),
+            gridPairs.end());
+
+        const PairVector sweepPairs = sortedPairs(sweepWorld.sweepAndPrune().getPossibleCollisions());
+        QVERIFY(!gridPairs.empty());
+        QVERIFY(gridPairs.size() == sweepPairs.size());
+
+        // The objects of the worlds are matched by their index
+        PairVector mappedPairs;
+        for (auto && pair : sweepPairs)
+        {
+            const auto index = [&] (MCObject * object) {
+                return std::find_if(sweepObjects.begin(), sweepObjects.end(), [object] (const MCObjectPtr & candidate) {
+                    return candidate.get() == object;
+                }) - sweepObjects.begin();
+            };
+            mappedPairs.push_back({gridObjects[index(pair.first)].get(), gridObjects[index(pair.second)].get()});
+        }
+        std::sort(mappedPairs.begin(), mappedPairs.end());
+        QVERIFY(mappedPairs == gridPairs);
+
+        // Move all dynamic objects and remove some of them
+        for (size_t i = 0; i < gridObjects.size(); i++)
+        {
+            if (!gridObjects[i]->physicsComponent().isStationary())
+            {
+                const float dx = (std::rand() % 400 - 200) / 100.0f;
+                const float dy = (std::rand() % 400 - 200) / 100.0f;
+                const MCVector3dF location = gridObjects[i]->location() + MCVector3dF(dx, dy);
+                gridObjects[i]->translate(location);
+                sweepObjects[i]->translate(location);
+            }
+        }
+
+        gridObjects[round * 7 + 1]->removeFromWorldNow();
+        sweepObjects[round * 7 + 1]->removeFromWorldNow();
+
+        addObjects(round == 5 ? 50 : 3);
+    }
+}
+
+void MCSweepAndPruneTest::testGridIsNotMaintained()
+{
+    MCWorld world;
+    setUpWorld(world, MCWorld::Broadphase::SweepAndPrune);
+
+    MCObjectPtr wall = createObject(20, 4, true);
+    MCObjectPtr object = createObject(4, 4, false);
+    wall->addToWorld(world, 20, 20);
+    object->addToWorld(world, 25, 25);
+    object->translate(MCVector3dF(26, 23));
+    world.stepTime(16);
+
+    MCObjectGrid::ObjectVector result;
+    world.objectGrid().getObjectsWithinBBox(MCBBox<float>(0, 0, 100, 100), result);
+    QVERIFY(result.empty());
+    QVERIFY(world.sweepAndPrune().objectCount() == 2);
+
+    object->translate(MCVector3dF(26, 22));
+    QVERIFY(world.sweepAndPrune().getPossibleCollisions().size() == 2);
+
+    object->removeFromWorldNow();
+    QVERIFY(world.sweepAndPrune().objectCount() == 1);
+}
+
+void MCSweepAndPruneTest::testQueries()
+{
+    MCWorld world;
+    setUpWorld(world, MCWorld::Broadphase::SweepAndPrune);
+
+    MCObjectPtr wall = createObject(20, 4, true, 20);
+    wall->addToWorld(world, 20, 20);
+
+    MCObjectPtr object = createObject(4, 4, false, 4);
+    object->addToWorld(world, 25, 25);
+
+    // The view is larger than the shape
+    MCObjectPtr tree = createObject(2, 2, true, 30);
+    tree->addToWorld(world, 60, 60);
+
+    // Objects without a view are not visited by the view query
+    MCObjectPtr invisible = createObject(4, 4, false);
+    invisible->addToWorld(world, 26, 26);
+
+    const MCSweepAndPrune & sweepAndPrune = world.sweepAndPrune();
+    std::vector<MCObject *> visited;
+    sweepAndPrune.forEachObjectWithinBBox(MCBBox<float>(10, 10, 30, 30), [&visited] (MCObject & object) {
+        visited.push_back(&object);
+    });
+    QVERIFY(visited.size() == 2);
+    QVERIFY(std::find(visited.begin(), visited.end(), wall.get()) != visited.end());
+    QVERIFY(std::find(visited.begin(), visited.end(), object.get()) != visited.end());
+
+    visited.clear();
+    sweepAndPrune.forEachObjectWithinBBox(MCBBox<float>(40, 40, 47, 47), [&visited] (MCObject & object) {
+        visited.push_back(&object);
+    });
+    QVERIFY(visited.size() == 1);
+    QVERIFY(visited[0] == tree.get());
+
+    // Static objects are not visited by the dynamic query
+    visited.clear();
+    sweepAndPrune.forEachDynamicObjectWithinBBox(MCBBox<float>(10, 10, 30, 30), [&visited] (MCObject & object) {
+        visited.push_back(&object);
+    });
+    QVERIFY(visited.size() == 2);
+    QVERIFY(std::find(visited.begin(), visited.end(), object.get()) != visited.end());
+    QVERIFY(std::find(visited.begin(), visited.end(), invisible.get()) != visited.end());
+
+    // Sorted objects are found from the endpoints and moved objects at their new locations
+    world.sweepAndPrune().getPossibleCollisions();
+    object->translate(MCVector3dF(50, 50));
+    visited.clear();
+    sweepAndPrune.forEachDynamicObjectWithinBBox(MCBBox<float>(10, 10, 30, 30), [&visited] (MCObject & object) {
+        visited.push_back(&object);
+    });
+    QVERIFY(visited.size() == 1);
+    QVERIFY(visited[0] == invisible.get());
+
+    visited.clear();
+    sweepAndPrune.forEachDynamicObjectWithinBBox(MCBBox<float>(45, 45, 55, 55), [&visited] (MCObject & object) {
+        visited.push_back(&object);
+    });
+    QVERIFY(visited.size() == 1);
+    QVERIFY(visited[0] == object.get());
+
+    // The view cells follow the moved objects
+    visited.clear();
+    sweepAndPrune.forEachObjectWithinBBox(MCBBox<float>(45, 45, 55, 55), [&visited] (MCObject & object) {
+        visited.push_back(&object);
+    });
+    QVERIFY(visited.size() == 2);
+    QVERIFY(std::find(visited.begin(), visited.end(), object.get()) != visited.end());
+    QVERIFY(std::find(visited.begin(), visited.end(), tree.get()) != visited.end());
+
+    visited.clear();
+    sweepAndPrune.forEachObjectWithinBBox(MCBBox<float>(10, 10, 30, 30), [&visited] (MCObject & object) {
+        visited.push_back(&object);
+    });
+    QVERIFY(visited.size() == 1);
+    QVERIFY(visited[0] == wall.get());
+
+    // Removed objects are not visited
+    world.sweepAndPrune().getPossibleCollisions();
+    object->removeFromWorldNow();
+    visited.clear();
+    sweepAndPrune.forEachDynamicObjectWithinBBox(MCBBox<float>(45, 45, 55, 55), [&visited] (MCObject & object) {
+        visited.push_back(&object);
+    });
+    QVERIFY(visited.empty());
+
+    sweepAndPrune.forEachObjectWithinBBox(MCBBox<float>(45, 45, 55, 55), [&visited] (MCObject & object) {
+        visited.push_back(&object);
+    });
+    QVERIFY(visited.size() == 1);
+    QVERIFY(visited[0] == tree.get());
+}
+
+void MCSweepAndPruneTest::testSaveAndRestoreState()
+{
+    MCWorld world;
+    setUpWorld(world, MCWorld::Broadphase::SweepAndPrune);
+
+    MCObjectPtr wall = createObject(20, 4, true);
+    MCObjectPtr object1 = createObject(4, 4, false);
+    MCObjectPtr object2 = createObject(4, 4, false);
+    wall->addToWorld(world, 20, 20);
+    object1->addToWorld(world, 25, 21);
+    object2->addToWorld(world, 27, 22);
+
+    MCSweepAndPrune & sweepAndPrune = world.sweepAndPrune();
+    const PairVector savedPairs = sortedPairs(sweepAndPrune.getPossibleCollisions());
+    QVERIFY(savedPairs.size() == 6);
+
+    MCStateBuffer state;
+    sweepAndPrune.saveState(state);
+
+    QVERIFY(sweepAndPrune.remove(*object1));
+    QVERIFY(sweepAndPrune.getPossibleCollisions().size() == 2);
+
+    state.rewind();
+    sweepAndPrune.restoreState(state);
+    QVERIFY(state.isValid() && state.atEnd());
+    QVERIFY(sweepAndPrune.objectCount() == 3);
+    QVERIFY(sortedPairs(sweepAndPrune.getPossibleCollisions()) == savedPairs);
+
+    // The proxy index map is restored, too
+    QVERIFY(sweepAndPrune.remove(*object1));
+    QVERIFY(sweepAndPrune.getPossibleCollisions().size() == 2);
+    sweepAndPrune.insert(*object1);
+}
+
+void MCSweepAndPruneTest::benchmarkShippedTracks_data()
+{
+    addShippedTrackRows();
+}
+
+void MCSweepAndPruneTest::benchmarkShippedTracks()
+{
+    QFETCH(QString, fileName);
+    QFETCH(bool, sweepAndPrune);
+
+    ShippedTrack track;
+    QVERIFY(track.load(fileName, sweepAndPrune ? MCWorld::Broadphase::SweepAndPrune : MCWorld::Broadphase::Grid));
+
+    QBENCHMARK {
+        for (int i = 0; i < shippedTrackStepCount; i++)
+        {
+            track.step();
+        }
+    }
+}
+
+void MCSweepAndPruneTest::benchmarkShippedTrackViewQueries_data()
+{
+    addShippedTrackRows();
+}
+
+void MCSweepAndPruneTest::benchmarkShippedTrackViewQueries()
+{
+    QFETCH(QString, fileName);
+    QFETCH(bool, sweepAndPrune);
+
+    ShippedTrack track;
+    QVERIFY(track.load(fileName, sweepAndPrune ? MCWorld::Broadphase::SweepAndPrune : MCWorld::Broadphase::Grid));
+
+    // Two split-screen cameras follow the first two cars
+    std::vector<MCVector3dF> centers;
+    for (int i = 0; i < shippedTrackStepCount; i++)
+    {
+        track.step();
+        centers.push_back(track.cars[0]->location());
+        centers.push_back(track.cars[1]->location());
+    }
+
+    size_t count = 0;
+    QBENCHMARK {
+        count = 0;
+        for (auto && center : centers)
+        {
+            count += track.queryView(center);
+        }
+    }
+
+    QVERIFY(count > 0);
+}
+
+QTEST_GUILESS_MAIN(MCSweepAndPruneTest)
@@ -0,0 +1,201 @@
+// This file belongs to the "MiniCore" game engine.
+// Copyright (C) 2018 Jussi Lind <jussi.lind@iki.fi>
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+// MA  02110-1301, USA.
+//
+
+#include "MCTrigonomTest.hpp"
+#include "../../Core/mctrigonom.hh"
+
+#include <cmath>
+#include <vector>
+
+namespace {
+
+// The lookup table used before, for comparison
+class Lut
+{
+public:
+
+    Lut()
+    : m_sin(7200)
+    , m_cos(7200)
+    {
+        for (int i = 0; i < 7200; i++)
+        {
+            m_sin[i] = std::sin(MCTrigonom::degToRad(i / 10.0f - 3600));
+            m_cos[i] = std::cos(MCTrigonom::degToRad(i / 10.0f - 3600));
+        }
+    }
+
+    float sin(float angle) const
+    {
+        const int index = static_cast<int>(angle * 10.0f) + 3600;
+        if (index >= 0 && index < 7200)
+        {
+            return m_sin[index];
+        }
+        return std::sin(MCTrigonom::degToRad(angle));
+    }
+
+    float cos(float angle) const
+    {
+        const int index = static_cast<int>(angle * 10.0f) + 3600;
+        if (index >= 0 && index < 7200)
+        {
+            return m_cos[index];
+        }
+        return std::cos(MCTrigonom::degToRad(angle));
+    }
+
+private:
+
+    std::vector<float> m_sin;
+
+    std::vector<float> m_cos;
+};
+
+std::vector<float> testAngles()
+{
+    std::vector<float> angles;
+    for (int i = 0; i < 10000; i++)
+    {
+        angles.push_back(-720.0f + i * 0.1443f);
+    }
+    return angles;
+}
+
+double maxError(float (*function)(float), double (*reference)(double), float minAngle, float maxAngle, float step)
+{
+    double error = 0;
+    for (float angle = minAngle; angle < maxAngle; angle += step)
+    {
+        const double radians = static_cast<double>(angle) * M_PI / 180.0;
+        error = std::max(error, std::fabs(function(angle) - reference(radians)));
+    }
+    return error;
+}
+
+} // namespace
+
+MCTrigonomTest::MCTrigonomTest()
+{
+}
+
+void MCTrigonomTest::testAccuracy()
+{
+    QVERIFY(maxError(MCTrigonom::sin, std::sin, -720, 720, 0.013f) < 2e-7);
+    QVERIFY(maxError(MCTrigonom::cos, std::cos, -720, 720, 0.013f) < 2e-7);
+
+    // The old lookup table had a resolution of 0.1 degrees
+    const Lut lut;
+    double lutError = 0;
+    for (float angle = -360; angle < 360; angle += 0.013f)
+    {
+        lutError = std::max(lutError, std::fabs(lut.sin(angle) - std::sin(static_cast<double>(angle) * M_PI / 180.0)));
+    }
+    QVERIFY(lutError > 1e-3);
+}
+
+void MCTrigonomTest::testLargeAngles()
+{
+    // Accumulated angles are reduced exactly
+    QVERIFY(maxError(MCTrigonom::sin, std::sin, 100000, 101000, 0.0625f) < 2e-7);
+    QVERIFY(maxError(MCTrigonom::cos, std::cos, -101000, -100000, 0.0625f) < 2e-7);
+
+    for (float angle = 0; angle < 360; angle += 7.5f)
+    {
+        QVERIFY(std::fabs(MCTrigonom::sin(angle + 360.0f * 2000) - MCTrigonom::sin(angle)) < 1e-7f);
+        QVERIFY(std::fabs(MCTrigonom::cos(angle - 360.0f * 2000) - MCTrigonom::cos(angle)) < 1e-7f);
+    }
+}
+
+void MCTrigonomTest::testQuadrants()
+{
+    QVERIFY(MCTrigonom::sin(0) == 0.0f);
+    QVERIFY(MCTrigonom::cos(0) == 1.0f);
+    QVERIFY(MCTrigonom::sin(90) == 1.0f);
+    QVERIFY(MCTrigonom::cos(90) == 0.0f);
+    QVERIFY(MCTrigonom::sin(180) == 0.0f);
+    QVERIFY(MCTrigonom::cos(180) == -1.0f);
+    QVERIFY(MCTrigonom::sin(-90) == -1.0f);
+    QVERIFY(MCTrigonom::cos(270) == 0.0f);
+
+    float sin, cos;
+    MCTrigonom::sinCos(123.4f, sin, cos);
+    QVERIFY(sin == MCTrigonom::sin(123.4f));
+    QVERIFY(cos == MCTrigonom::cos(123.4f));
+}
+
+void MCTrigonomTest::testBatch()
+{
+    const std::vector<float> angles = testAngles();
+    std::vector<float> sines(angles.size());
+    std::vector<float> cosines(angles.size());
+    MCTrigonom::sinCos(angles.data(), sines.data(), cosines.data(), angles.size());
+
+    for (unsigned int i = 0; i < angles.size(); i++)
+    {
+        float sin, cos;
+        MCTrigonom::sinCos(angles[i], sin, cos);
+        QVERIFY(sines[i] == sin);
+        QVERIFY(cosines[i] == cos);
+    }
+}
+
+void MCTrigonomTest::benchmarkLut()
+{
+    const Lut lut;
+    const std::vector<float> angles = testAngles();
+    std::vector<float> sines(angles.size());
+    std::vector<float> cosines(angles.size());
+
+    QBENCHMARK {
+        for (unsigned int i = 0; i < angles.size(); i++)
+        {
+            sines[i] = lut.sin(angles[i]);
+            cosines[i] = lut.cos(angles[i]);
+        }
+    }
+}
+
+void MCTrigonomTest::benchmarkSinCos()
+{
+    const std::vector<float> angles = testAngles();
+    std::vector<float> sines(angles.size());
+    std::vector<float> cosines(angles.size());
+
+    QBENCHMARK {
+        for (unsigned int i = 0; i < angles.size(); i++)
+        {
+            sines[i] = MCTrigonom::sin(angles[i]);
+            cosines[i] = MCTrigonom::cos(angles[i]);
+        }
+    }
+}
+
+void MCTrigonomTest::benchmarkBatchSinCos()
+{
+    const std::vector<float> angles = testAngles();
+    std::vector<float> sines(angles.size());
+    std::vector<float> cosines(angles.size());
+
+    QBENCHMARK {
+        MCTrigonom::sinCos(angles.data(), sines.data(), cosines.data(), angles.size());
+    }
+}
+
+QTEST_GUILESS_MAIN(MCTrigonomTest)
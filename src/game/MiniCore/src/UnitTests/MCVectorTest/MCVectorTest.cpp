@@ -0,0 +1,254 @@
+// This file belongs to the "MiniCore" game engine.
+// Copyright (C) 2018 Jussi Lind <jussi.lind@iki.fi>
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+// MA  02110-1301, USA.
+//
+
+#include "MCVectorTest.hpp"
+#include "../../Core/mcvector2d.hh"
+#include "../../Core/mcvector3d.hh"
+#include "../../Core/mcvectorbatch.hh"
+
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <vector>
+
+namespace {
+
+bool identical(float a, float b)
+{
+    return !std::memcmp(&a, &b, sizeof(float));
+}
+
+bool identical(const MCVector2dF & a, const MCVector2dF & b)
+{
+    return identical(a.i(), b.i()) && identical(a.j(), b.j());
+}
+
+bool identical(const MCVector3dF & a, const MCVector3dF & b)
+{
+    return identical(a.i(), b.i()) && identical(a.j(), b.j()) && identical(a.k(), b.k());
+}
+
+// Values including zeros, infinities and denormals
+std::vector<float> testValues()
+{
+    std::vector<float> values = {
+        0.0f, -0.0f, 1.0f, -1.0f, 0.5f, 3.0f, -7.25f, 1e-40f, -1e-40f, 1e30f,
+        std::numeric_limits<float>::infinity(), -std::numeric_limits<float>::infinity()};
+
+    float value = 0.1f;
+    for (int i = 0; i < 20; i++)
+    {
+        values.push_back(value);
+        values.push_back(-value * 1.7f);
+        value *= 3.3f;
+    }
+    return values;
+}
+
+std::vector<MCVector3dF> testVectors3d()
+{
+    const std::vector<float> values = testValues();
+    std::vector<MCVector3dF> vectors;
+    for (unsigned int i = 0; i < values.size(); i++)
+    {
+        for (unsigned int j = 0; j < values.size(); j += 3)
+        {
+            vectors.push_back(MCVector3dF(values[i], values[j], values[(i + j) % values.size()]));
+        }
+    }
+    return vectors;
+}
+
+std::vector<MCVector2dF> testVectors2d()
+{
+    std::vector<MCVector2dF> vectors;
+    for (auto && vector : testVectors3d())
+    {
+        vectors.push_back(MCVector2dF(vector));
+    }
+    return vectors;
+}
+
+} // namespace
+
+MCVectorTest::MCVectorTest()
+{
+}
+
+void MCVectorTest::testOperations()
+{
+    // The results must be the same as with separate component operations
+    const std::vector<MCVector3dF> vectors = testVectors3d();
+    for (unsigned int n = 1; n < vectors.size(); n++)
+    {
+        const MCVector3dF & a = vectors[n - 1];
+        const MCVector3dF & b = vectors[n];
+        const float s = b.j();
+
+        QVERIFY(identical(a + b, MCVector3dF(a.i() + b.i(), a.j() + b.j(), a.k() + b.k())));
+        QVERIFY(identical(a - b, MCVector3dF(a.i() - b.i(), a.j() - b.j(), a.k() - b.k())));
+        QVERIFY(identical(a * b, MCVector3dF(a.i() * b.i(), a.j() * b.j(), a.k() * b.k())));
+        QVERIFY(identical(a.comp(b), MCVector3dF(a.i() * b.i(), a.j() * b.j(), a.k() * b.k())));
+        QVERIFY(identical(a * s, MCVector3dF(a.i() * s, a.j() * s, a.k() * s)));
+        QVERIFY(identical(a / s, MCVector3dF(a.i() / s, a.j() / s, a.k() / s)));
+        QVERIFY(identical(-a, MCVector3dF(-a.i(), -a.j(), -a.k())));
+
+        MCVector3dF c(a);
+        c += b;
+        QVERIFY(identical(c, a + b));
+        c -= b;
+        QVERIFY(identical(c, a + b - b));
+        c *= s;
+        QVERIFY(identical(c, (a + b - b) * s));
+        c /= s;
+        QVERIFY(identical(c, (a + b - b) * s / s));
+    }
+
+    // The padding lane must not leak into the components
+    MCVector3dF a(1, 2, 3);
+    a /= 0.0f;
+    a *= std::numeric_limits<float>::infinity();
+    QVERIFY(std::isinf(a.i()) && std::isinf(a.j()) && std::isinf(a.k()));
+}
+
+void MCVectorTest::testCrossProduct()
+{
+    const std::vector<MCVector3dF> vectors = testVectors3d();
+    for (unsigned int n = 1; n < vectors.size(); n++)
+    {
+        const MCVector3dF & a = vectors[n - 1];
+        const MCVector3dF & b = vectors[n];
+        const float i = a.j() * b.k() - b.j() * a.k();
+        const float j = a.i() * b.k() - b.i() * a.k();
+        const float k = a.i() * b.j() - b.i() * a.j();
+        QVERIFY(identical(a % b, MCVector3dF(i, -j, k)));
+    }
+
+    const MCVector3dF x(1, 0, 0);
+    const MCVector3dF y(0, 1, 0);
+    const MCVector3dF z = x % y;
+    QVERIFY(z.i() == 0 && z.j() == 0 && z.k() == 1);
+}
+
+void MCVectorTest::testBatchAddScaled()
+{
+    std::vector<MCVector3dF> vectors = testVectors3d();
+    const std::vector<MCVector3dF> deltas(vectors.rbegin(), vectors.rend());
+    std::vector<MCVector3dF> expected = vectors;
+    for (unsigned int n = 0; n < vectors.size(); n++)
+    {
+        expected[n] += deltas[n] * 0.3f;
+    }
+
+    MCVectorBatch::addScaled(vectors.data(), deltas.data(), 0.3f, vectors.size());
+    for (unsigned int n = 0; n < vectors.size(); n++)
+    {
+        QVERIFY(identical(vectors[n], expected[n]));
+    }
+}
+
+void MCVectorTest::testBatchLengthFast()
+{
+    const std::vector<MCVector2dF> vectors2d = testVectors2d();
+    std::vector<float> lengths(vectors2d.size());
+
+    // Odd counts use also the remainder loop
+    MCVectorBatch::lengthFast(vectors2d.data(), lengths.data(), vectors2d.size() - 1);
+    for (unsigned int n = 0; n < vectors2d.size() - 1; n++)
+    {
+        QVERIFY(identical(lengths[n], vectors2d[n].lengthFast()));
+    }
+
+    const std::vector<MCVector3dF> vectors3d = testVectors3d();
+    lengths.resize(vectors3d.size());
+    MCVectorBatch::lengthFast(vectors3d.data(), lengths.data(), vectors3d.size() - 1);
+    for (unsigned int n = 0; n < vectors3d.size() - 1; n++)
+    {
+        QVERIFY(identical(lengths[n], vectors3d[n].lengthFast()));
+    }
+}
+
+void MCVectorTest::testBatchClampFast()
+{
+    std::vector<MCVector2dF> vectors2d = testVectors2d();
+    std::vector<MCVector2dF> expected2d = vectors2d;
+    for (auto && vector : expected2d)
+    {
+        vector.clampFast(2.5f);
+    }
+
+    MCVectorBatch::clampFast(vectors2d.data(), 2.5f, vectors2d.size());
+    for (unsigned int n = 0; n < vectors2d.size(); n++)
+    {
+        QVERIFY(identical(vectors2d[n], expected2d[n]));
+    }
+
+    std::vector<MCVector3dF> vectors3d = testVectors3d();
+    std::vector<MCVector3dF> expected3d = vectors3d;
+    for (auto && vector : expected3d)
+    {
+        vector.clampFast(2.5f);
+    }
+
+    MCVectorBatch::clampFast(vectors3d.data(), 2.5f, vectors3d.size());
+    for (unsigned int n = 0; n < vectors3d.size(); n++)
+    {
+        QVERIFY(identical(vectors3d[n], expected3d[n]));
+    }
+}
+
+void MCVectorTest::benchmarkOperations()
+{
+    std::vector<MCVector3dF> locations = testVectors3d();
+    std::vector<MCVector3dF> velocities(locations.rbegin(), locations.rend());
+    const MCVector3dF acceleration(0.5f, -0.25f, -9.81f);
+
+    QBENCHMARK {
+        for (unsigned int n = 0; n < locations.size(); n++)
+        {
+            velocities[n] += acceleration * 0.01f;
+            velocities[n] *= 0.999f;
+            locations[n] += velocities[n] * 0.016f;
+            locations[n] -= (velocities[n] % acceleration) * 1e-6f;
+        }
+    }
+}
+
+void MCVectorTest::benchmarkClampFast()
+{
+    std::vector<MCVector3dF> vectors = testVectors3d();
+
+    QBENCHMARK {
+        for (auto && vector : vectors)
+        {
+            vector.clampFast(2.5f);
+        }
+    }
+}
+
+void MCVectorTest::benchmarkBatchClampFast()
+{
+    std::vector<MCVector3dF> vectors = testVectors3d();
+
+    QBENCHMARK {
+        MCVectorBatch::clampFast(vectors.data(), 2.5f, vectors.size());
+    }
+}
+
+QTEST_GUILESS_MAIN(MCVectorTest)
@@ -19,10 +19,27 @@
 
 #include "MCWorldTest.hpp"
 #include "../../Core/mcworld.hh"
+#include "../../Core/mcworldrendererbase.hh"
+#include "../../Core/mcmathutil.hh"
 #include "../../Core/mcobject.hh"
+#include "../../Core/mcstatebuffer.hh"
 #include "../../Physics/mcrectshape.hh"
+#include "../../Physics/mccollisiondetector.hh"
 #include "../../Physics/mccollisionevent.hh"
+#include "../../Physics/mccontactevent.hh"
+#include "../../Physics/mcislandmanager.hh"
 #include "../../Physics/mcphysicscomponent.hh"
+#include "../../Physics/mctriggervolume.hh"
+
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <memory>
+#include <new>
+#include <thread>
+#include <tuple>
+#include <type_traits>
+#include <vector>
 
 class TestObject : public MCObject
 {
@@ -40,9 +57,251 @@ public:
         event.accept();
     }
 
+    virtual void contactEvent(MCContactEvent & event)
+    {
+        m_contactEvents.push_back(event.type());
+        if (m_contactLog)
+        {
+            m_contactLog->push_back(id());
+        }
+
+        event.accept();
+
+        if (m_contactHandler)
+        {
+            m_contactHandler(event);
+        }
+    }
+
     bool m_collisionEventReceived;
+
+    std::vector<MCContactEvent::Type> m_contactEvents;
+
+    std::vector<unsigned int> * m_contactLog = nullptr;
+
+    std::function<void (MCContactEvent &)> m_contactHandler;
+};
+
+class TestRenderer : public MCWorldRendererBase
+{
+public:
+
+    TestRenderer(std::vector<MCObject *> & objects, int & renderCount)
+    : m_objects(objects)
+    , m_renderCount(renderCount)
+    {
+    }
+
+    virtual void addObject(MCObject & object) override
+    {
+        m_objects.push_back(&object);
+    }
+
+    virtual void removeObject(MCObject & object) override
+    {
+        m_objects.erase(std::find(m_objects.begin(), m_objects.end(), &object));
+    }
+
+    virtual void clear() override
+    {
+        m_objects.clear();
+    }
+
+    virtual void buildBatches(MCCamera *) override
+    {
+    }
+
+    virtual void render(MCCamera *, MCRenderGroup) override
+    {
+        m_renderCount++;
+    }
+
+    std::vector<MCObject *> & m_objects;
+
+    int & m_renderCount;
 };
 
+namespace {
+
+// Two columns of cars on a start grid driving into a tightly packed pile of crates
+void addStartGridAndCratePile(MCWorld & world, std::vector<std::unique_ptr<TestObject>> & objects)
+{
+    auto addObject = [&world, &objects] (float w, float h, float x, float y, float vx) {
+        TestObject * object = new TestObject;
+        object->setShape(MCShapePtr(new MCRectShape(MCShapeViewPtr(), w, h)));
+        object->physicsComponent().setMass(1);
+        object->addToWorld(world, x, y);
+        object->physicsComponent().setVelocity(MCVector3dF(vx, 0));
+        objects.push_back(std::unique_ptr<TestObject>(object));
+    };
+
+    for (int i = 0; i < 12; i++)
+    {
+        addObject(32, 16, 900 - 40 * (i / 2), 1060 + (i % 2) * 40, 2.0f);
+    }
+
+    for (int j = 0; j < 20; j++)
+    {
+        for (int i = 0; i < 20; i++)
+        {
+            addObject(9, 9, 1000 + 8 * i, 1000 + 8 * j, 0);
+        }
+    }
+}
+
+void stepStartGridAndCratePile(MCWorld::Broadphase broadphase, unsigned int threadCount = 0)
+{
+    MCWorld world;
+    world.setDimensions(0, 2048, 0, 2048, 0, 100, 1.0f, true, 128, broadphase);
+    QVERIFY(world.broadphase() == broadphase);
+    world.collisionDetector().setThreadCount(threadCount);
+
+    std::vector<std::unique_ptr<TestObject>> objects;
+    addStartGridAndCratePile(world, objects);
+
+    QBENCHMARK {
+        for (int i = 0; i < 100; i++)
+        {
+            world.stepTime(16);
+        }
+    }
+
+    for (auto && object : objects)
+    {
+        object->removeFromWorldNow();
+    }
+}
+
+// Locations and angles of the given objects
+std::vector<float> transforms(const std::vector<std::unique_ptr<TestObject>> & objects)
+{
+    std::vector<float> result;
+    for (auto && object : objects)
+    {
+        result.push_back(object->location().i());
+        result.push_back(object->location().j());
+        result.push_back(object->angle());
+    }
+
+    return result;
+}
+
+// Simulates the start grid and the crate pile in a world of its own and returns the final locations.
+// The resolver statistics of the steps are summed to the given statistics.
+std::vector<float> simulateStartGridAndCratePile(
+    int steps,
+    MCWorld::ResolverMode resolverMode = MCWorld::ResolverMode::Full,
+    float depthTolerance = 0,
+    MCWorld::ResolverStatistics * statistics = nullptr)
+{
+    MCWorld world;
+    world.setDimensions(0, 2048, 0, 2048, 0, 100, 1.0f, true, 128);
+    world.setResolverMode(resolverMode, depthTolerance);
+
+    std::vector<std::unique_ptr<TestObject>> objects;
+    addStartGridAndCratePile(world, objects);
+
+    for (int i = 0; i < steps; i++)
+    {
+        world.stepTime(16);
+
+        if (statistics)
+        {
+            const MCWorld::ResolverStatistics & stepStatistics = world.resolverStatistics();
+            statistics->m_iterations += stepStatistics.m_iterations;
+            statistics->m_skippedIterations += stepStatistics.m_skippedIterations;
+            statistics->m_testedPairs += stepStatistics.m_testedPairs;
+            statistics->m_avoidedPairTests += stepStatistics.m_avoidedPairTests;
+            statistics->m_elapsedTime += stepStatistics.m_elapsedTime;
+        }
+    }
+
+    const std::vector<float> locations = transforms(objects);
+    for (auto && object : objects)
+    {
+        object->removeFromWorldNow();
+    }
+
+    return locations;
+}
+
+// Steps the given number of independent worlds in parallel threads. With linear scaling,
+// one world per hardware thread takes as long as a single world.
+void stepParallelWorlds(unsigned int worldCount)
+{
+    QBENCHMARK {
+        std::vector<std::thread> threads;
+        for (unsigned int i = 0; i < worldCount; i++)
+        {
+            threads.push_back(std::thread([] () {
+                simulateStartGridAndCratePile(100);
+            }));
+        }
+
+        for (auto && thread : threads)
+        {
+            thread.join();
+        }
+    }
+}
+
+// A resting box. Boxes closer than 4 units overlap.
+MCObject * addRestingBox(MCWorld & world, std::vector<std::unique_ptr<MCObject>> & objects, float x, float y)
+{
+    MCObject * object = new MCObject("BOX");
+    object->setShape(MCShapePtr(new MCRectShape(MCShapeViewPtr(), 4, 4)));
+    object->physicsComponent().setMass(1);
+    object->addToWorld(world, x, y);
+    objects.push_back(std::unique_ptr<MCObject>(object));
+    return object;
+}
+
+// Free bodies far enough from each other so that they never collide. The bodies are added to the world if given.
+void addFreeBodies(std::vector<std::unique_ptr<MCObject>> & objects, unsigned int count, MCWorld * world)
+{
+    for (unsigned int i = 0; i < count; i++)
+    {
+        MCObject * object = new MCObject("FREE_BODY");
+        if (i % 2)
+        {
+            object->setShape(MCShapePtr(new MCRectShape(MCShapeViewPtr(), 4, 4)));
+        }
+
+        object->physicsComponent().setMass(1.0f + i % 5);
+        object->physicsComponent().setLinearDamping(0.99f + 0.001f * (i % 7));
+        object->physicsComponent().setAngularDamping(0.95f + 0.01f * (i % 3));
+        object->physicsComponent().preventSleeping(true);
+
+        const float x = 64 + 32 * (i % 100);
+        const float y = 64 + 32 * (i / 100);
+        if (world)
+        {
+            object->addToWorld(*world, x, y);
+        }
+        else
+        {
+            object->translate(MCVector3dF(x, y));
+        }
+
+        objects.push_back(std::unique_ptr<MCObject>(object));
+    }
+}
+
+void addFreeBodyInput(MCObject & object, unsigned int index, int step)
+{
+    const float phase = 0.1f * index + 0.3f * step;
+    object.physicsComponent().addForce(MCVector3dF(std::sin(phase), std::cos(phase), 0.1f));
+    object.physicsComponent().addTorque(0.01f * std::cos(phase));
+
+    if ((index + step) % 3 == 0)
+    {
+        object.physicsComponent().addImpulse(MCVector3dF(0.01f, -0.02f));
+        object.physicsComponent().addAngularImpulse(0.001f);
+    }
+}
+
+} // namespace
+
 MCWorldTest::MCWorldTest()
 {
 }
@@ -82,6 +341,47 @@ void MCWorldTest::testInstance()
     QVERIFY(MCWorld::hasInstance() == false);
 }
 
+void MCWorldTest::testRenderer()
+{
+    {
+        // Without a renderer rendering does nothing
+        MCWorld world;
+        QVERIFY(!world.hasRenderer());
+
+        MCObject object("TestObject");
+        object.addToWorld(world);
+        world.prepareRendering(nullptr);
+        world.render(nullptr, MCRenderGroup::Objects);
+        world.stepTime(10);
+        object.removeFromWorldNow();
+    }
+
+    std::vector<MCObject *> renderedObjects;
+    int renderCount = 0;
+    {
+        MCWorld world(new TestRenderer(renderedObjects, renderCount));
+        QVERIFY(world.hasRenderer());
+        const size_t wallCount = renderedObjects.size();
+
+        MCObject object1("TestObject");
+        object1.addToWorld(world);
+        MCObject object2("TestObject");
+        object2.addToWorld(world);
+        QCOMPARE(renderedObjects.size(), wallCount + 2);
+
+        object1.removeFromWorldNow();
+        QCOMPARE(renderedObjects.size(), wallCount + 1);
+        QVERIFY(renderedObjects.back() == &object2);
+
+        world.prepareRendering(nullptr);
+        world.render(nullptr, MCRenderGroup::Objects);
+        QCOMPARE(renderCount, 1);
+
+        world.clear();
+        QVERIFY(renderedObjects.empty());
+    }
+}
+
 void MCWorldTest::testSetDimensions()
 {
     const float minX = 0;
@@ -148,4 +448,1081 @@ void MCWorldTest::testSleepingObjectRemovalFromIntegration()
     QVERIFY(world.objectCount() == 5);
 }
 
+void MCWorldTest::testSweepAndPruneCollision()
+{
+    MCWorld world;
+    world.setDimensions(0, 20, 0, 20, 0, 10, 1.0f, true, 128, MCWorld::Broadphase::SweepAndPrune);
+
+    TestObject object1;
+    object1.setShape(MCShapePtr(new MCRectShape(MCShapeViewPtr(), 2.0, 2.0)));
+    object1.physicsComponent().preventSleeping(true);
+
+    TestObject object2;
+    object2.setShape(MCShapePtr(new MCRectShape(MCShapeViewPtr(), 2.0, 2.0)));
+    object2.physicsComponent().preventSleeping(true);
+
+    world.addObject(object1);
+    world.addObject(object2);
+
+    object1.translate(MCVector3dF(5.0, 10.0));
+    object2.translate(MCVector3dF(15.0, 10.0));
+
+    world.stepTime(1.0);
+
+    QVERIFY(!object1.m_collisionEventReceived);
+    QVERIFY(!object2.m_collisionEventReceived);
+
+    object1.translate(MCVector3dF(9.5, 10.0));
+    object2.translate(MCVector3dF(10.5, 10.0));
+
+    world.stepTime(1.0);
+
+    QVERIFY(object1.m_collisionEventReceived);
+    QVERIFY(object2.m_collisionEventReceived);
+
+    world.removeObjectNow(object1);
+    world.removeObjectNow(object2);
+}
+
+void MCWorldTest::testContactEvents()
+{
+    MCWorld world;
+    world.setDimensions(0, 20, 0, 20, 0, 10);
+
+    TestObject object1;
+    object1.setShape(MCShapePtr(new MCRectShape(MCShapeViewPtr(), 2.0, 2.0)));
+    object1.physicsComponent().setMass(0, true);
+    object1.setReceivesPersistContactEvents(true);
+
+    TestObject object2;
+    object2.setShape(MCShapePtr(new MCRectShape(MCShapeViewPtr(), 2.0, 2.0)));
+    object2.setIsTriggerObject(true);
+    object2.setIsPhysicsObject(false);
+    object2.physicsComponent().preventSleeping(true);
+
+    world.addObject(object1);
+    world.addObject(object2);
+
+    object1.translate(MCVector3dF(10.0, 10.0));
+    object2.translate(MCVector3dF(15.0, 10.0));
+
+    world.stepTime(1.0);
+    QVERIFY(object1.m_contactEvents.empty());
+
+    object2.translate(MCVector3dF(10.5, 10.0));
+    world.stepTime(1.0);
+    world.stepTime(1.0);
+    world.stepTime(1.0);
+
+    object2.translate(MCVector3dF(15.0, 10.0));
+    world.stepTime(1.0);
+    world.stepTime(1.0);
+
+    const std::vector<MCContactEvent::Type> expected = {
+        MCContactEvent::Type::Begin,
+        MCContactEvent::Type::Persist,
+        MCContactEvent::Type::Persist,
+        MCContactEvent::Type::End};
+
+    const std::vector<MCContactEvent::Type> expectedWithoutPersist = {
+        MCContactEvent::Type::Begin,
+        MCContactEvent::Type::End};
+
+    QVERIFY(object1.m_contactEvents == expected);
+    QVERIFY(object2.m_contactEvents == expectedWithoutPersist);
+    QVERIFY(object1.m_collisionEventReceived);
+
+    world.removeObjectNow(object1);
+    world.removeObjectNow(object2);
+}
+
+void MCWorldTest::testContactEventsAreOrderedByObjectId()
+{
+    // Create the objects in both orders with respect to their addresses
+    for (int round = 0; round < 2; round++)
+    {
+        MCWorld world;
+        world.setDimensions(0, 20, 0, 20, 0, 10);
+
+        std::vector<unsigned int> contactLog;
+
+        std::aligned_storage<sizeof(TestObject), alignof(TestObject)>::type storage[2];
+        TestObject * objects[2];
+        objects[round] = new (&storage[round]) TestObject;
+        objects[1 - round] = new (&storage[1 - round]) TestObject;
+
+        for (int i = 0; i < 2; i++)
+        {
+            objects[i]->setShape(MCShapePtr(new MCRectShape(MCShapeViewPtr(), 2.0, 2.0)));
+            objects[i]->physicsComponent().setMass(1);
+            objects[i]->physicsComponent().preventSleeping(true);
+            objects[i]->m_contactLog = &contactLog;
+            world.addObject(*objects[i]);
+            objects[i]->translate(MCVector3dF(10.0 + i, 10.0));
+        }
+
+        world.stepTime(1.0);
+
+        QVERIFY(contactLog.size() == 2);
+        QVERIFY(contactLog[0] < contactLog[1]);
+
+        for (auto && object : objects)
+        {
+            world.removeObjectNow(*object);
+            object->~TestObject();
+        }
+    }
+}
+
+void MCWorldTest::testSleepingPairDoesNotEndContact()
+{
+    MCWorld world;
+    world.setDimensions(0, 100, 0, 100, 0, 10);
+    world.setResolverLoopCount(0); // Keep the overlapping boxes in contact
+
+    TestObject object1;
+    TestObject object2;
+    for (auto && object : {&object1, &object2})
+    {
+        object->setShape(MCShapePtr(new MCRectShape(MCShapeViewPtr(), 4, 4)));
+        object->physicsComponent().setMass(1);
+    }
+
+    object1.addToWorld(world, 40, 50);
+    object2.addToWorld(world, 43, 50);
+
+    for (int i = 0; i < 5; i++)
+    {
+        world.stepTime(1);
+    }
+
+    QVERIFY(object1.physicsComponent().isSleeping());
+    QVERIFY(object2.physicsComponent().isSleeping());
+
+    const std::vector<MCContactEvent::Type> expected = {MCContactEvent::Type::Begin};
+    QVERIFY(object1.m_contactEvents == expected);
+    QVERIFY(object2.m_contactEvents == expected);
+    QVERIFY(world.collisionDetector().pairCache().pairCount() == 1);
+
+    // Waking up and moving apart ends the contact
+    object2.physicsComponent().setVelocity(MCVector3dF(1, 0, 0));
+    object2.translate(MCVector3dF(60, 50));
+    world.stepTime(1);
+
+    const std::vector<MCContactEvent::Type> expectedEnd = {MCContactEvent::Type::Begin, MCContactEvent::Type::End};
+    QVERIFY(object1.m_contactEvents == expectedEnd);
+    QVERIFY(object2.m_contactEvents == expectedEnd);
+
+    world.removeObjectNow(object1);
+    world.removeObjectNow(object2);
+}
+
+void MCWorldTest::testRemovedObjectEndsContact()
+{
+    MCWorld world;
+    world.setDimensions(0, 100, 0, 100, 0, 10);
+    world.setResolverLoopCount(0); // Keep the overlapping boxes in contact
+
+    TestObject object1;
+    TestObject object2;
+    for (auto && object : {&object1, &object2})
+    {
+        object->setShape(MCShapePtr(new MCRectShape(MCShapeViewPtr(), 4, 4)));
+        object->physicsComponent().setMass(1);
+        object->physicsComponent().preventSleeping(true);
+    }
+
+    object1.addToWorld(world, 40, 50);
+    object2.addToWorld(world, 43, 50);
+    world.stepTime(1);
+
+    world.removeObjectNow(object1);
+
+    const std::vector<MCContactEvent::Type> expected = {MCContactEvent::Type::Begin};
+    const std::vector<MCContactEvent::Type> expectedEnd = {MCContactEvent::Type::Begin, MCContactEvent::Type::End};
+    QVERIFY(object1.m_contactEvents == expected);
+    QVERIFY(object2.m_contactEvents == expectedEnd);
+    QVERIFY(world.collisionDetector().pairCache().pairCount() == 0);
+
+    world.removeObjectNow(object2);
+    QVERIFY(object2.m_contactEvents == expectedEnd);
+}
+
+void MCWorldTest::testObjectRemovedByContactHandler()
+{
+    MCWorld world;
+    world.setDimensions(0, 100, 0, 100, 0, 10);
+    world.setResolverLoopCount(0); // Keep the overlapping boxes in contact
+
+    // A row of boxes where only the neighbours touch. The events are sent in the
+    // order of ids, so object1 gets the first event and deletes object2.
+    TestObject * objects[3];
+    for (int i = 0; i < 3; i++)
+    {
+        objects[i] = new TestObject;
+        objects[i]->setShape(MCShapePtr(new MCRectShape(MCShapeViewPtr(), 4, 4)));
+        objects[i]->physicsComponent().setMass(1);
+        objects[i]->physicsComponent().preventSleeping(true);
+        objects[i]->addToWorld(world, 40 + 3 * i, 50);
+    }
+
+    objects[0]->m_contactHandler = [&objects] (MCContactEvent & event) {
+        if (event.type() == MCContactEvent::Type::Begin && &event.otherObject() == objects[1])
+        {
+            objects[1]->removeFromWorldNow();
+            delete objects[1];
+            objects[1] = nullptr;
+        }
+    };
+
+    world.stepTime(1);
+
+    // The contact of object1 ends with the removal. object3 never got the Begin event of its pair.
+    const std::vector<MCContactEvent::Type> expectedEnd = {MCContactEvent::Type::Begin, MCContactEvent::Type::End};
+    QVERIFY(objects[1] == nullptr);
+    QVERIFY(objects[0]->m_contactEvents == expectedEnd);
+    QVERIFY(objects[2]->m_contactEvents.empty());
+    QVERIFY(world.collisionDetector().pairCache().pairCount() == 0);
+
+    world.stepTime(1);
+    QVERIFY(objects[0]->m_contactEvents == expectedEnd);
+    QVERIFY(objects[2]->m_contactEvents.empty());
+
+    for (TestObject * object : {objects[0], objects[2]})
+    {
+        object->removeFromWorldNow();
+        delete object;
+    }
+}
+
+void MCWorldTest::testThreadedCollisionDetectionIsDeterministic()
+{
+    MCWorld world;
+    world.setDimensions(0, 2048, 0, 2048, 0, 100, 1.0f, true, 128);
+
+    // A world doesn't start threads unless asked to
+    QVERIFY(world.collisionDetector().threadCount() == 1);
+
+    std::vector<std::unique_ptr<TestObject>> objects;
+    addStartGridAndCratePile(world, objects);
+
+    // Enough pairs for several batches
+    const MCObjectGrid::CollisionVector possibleCollisions = world.objectGrid().getPossibleCollisions();
+    QVERIFY(possibleCollisions.size() > 4 * 64);
+
+    typedef std::tuple<MCObject *, MCObject *, float, float, float, float, float> ContactData;
+    auto detect = [&] (unsigned int threadCount, unsigned int & numCollisions) {
+        world.collisionDetector().setThreadCount(threadCount);
+        numCollisions = world.collisionDetector().detectCollisions(possibleCollisions);
+
+        std::vector<ContactData> contacts;
+        MCContactArena & arena = world.collisionDetector().contactArena();
+        for (auto && object : objects)
+        {
+            for (int i = arena.firstSpan(*object); i >= 0; i = arena.span(i).m_next)
+            {
+                const MCContactArena::Span & span = arena.span(i);
+                for (const MCContact * contact = arena.begin(span); contact != arena.end(span); contact++)
+                {
+                    contacts.push_back(ContactData(object.get(), &contact->object(),
+                        contact->contactPoint().i(), contact->contactPoint().j(),
+                        contact->contactNormal().i(), contact->contactNormal().j(),
+                        contact->interpenetrationDepth()));
+                }
+            }
+        }
+
+        arena.reset();
+        return contacts;
+    };
+
+    unsigned int numCollisions1 = 0;
+    const std::vector<ContactData> contacts1 = detect(1, numCollisions1);
+    unsigned int numCollisions4 = 0;
+    const std::vector<ContactData> contacts4 = detect(4, numCollisions4);
+
+    QVERIFY(numCollisions1 > 0);
+    QVERIFY(numCollisions1 == numCollisions4);
+    QVERIFY(!contacts1.empty());
+    QVERIFY(contacts1 == contacts4); // Bit-exact on purpose
+
+    for (auto && object : objects)
+    {
+        object->removeFromWorldNow();
+    }
+}
+
+void MCWorldTest::testParallelWorlds()
+{
+    // Worlds in other threads don't touch the world of the main thread
+    MCWorld mainWorld;
+    QVERIFY(&MCWorld::instance() == &mainWorld);
+
+    MCObject object("MAIN");
+    object.setShape(MCShapePtr(new MCRectShape(MCShapeViewPtr(), 10, 10)));
+    object.addToWorld(mainWorld, 0.5f, 0.5f);
+    QVERIFY(object.world() == &mainWorld);
+    const int mainObjectCount = mainWorld.objectCount();
+
+    // A second world in the same thread is not the instance
+    const std::vector<float> reference = simulateStartGridAndCratePile(200);
+    QVERIFY(&MCWorld::instance() == &mainWorld);
+    QVERIFY(!reference.empty());
+
+    const unsigned int worldCount = 4;
+    std::vector<std::vector<float>> results(worldCount);
+    std::vector<std::thread> threads;
+    for (unsigned int i = 0; i < worldCount; i++)
+    {
+        threads.push_back(std::thread([&results, i] () {
+            results[i] = simulateStartGridAndCratePile(200);
+        }));
+    }
+
+    for (auto && thread : threads)
+    {
+        thread.join();
+    }
+
+    for (auto && result : results)
+    {
+        QVERIFY(result == reference); // Bit-exact on purpose
+    }
+
+    QVERIFY(mainWorld.objectCount() == mainObjectCount);
+    QVERIFY(object.world() == &mainWorld);
+
+    object.removeFromWorldNow();
+    QVERIFY(object.world() == nullptr);
+}
+
+void MCWorldTest::testSaveAndRestoreState()
+{
+    MCWorld world;
+    world.setDimensions(0, 2048, 0, 2048, 0, 100, 1.0f, true, 128);
+
+    std::vector<std::unique_ptr<TestObject>> objects;
+    addStartGridAndCratePile(world, objects);
+
+    auto step = [&world] (int steps) {
+        for (int i = 0; i < steps; i++)
+        {
+            world.stepTime(16);
+        }
+    };
+
+    // Save in the middle of the crash so that there are touching pairs and sleeping islands
+    step(60);
+    QVERIFY(world.collisionDetector().pairCache().pairCount() > 0);
+    MCStateBuffer state;
+    world.saveState(state);
+    const std::vector<float> savedTransforms = transforms(objects);
+    const unsigned int savedStepCount = world.stepCount();
+
+    step(100);
+    const std::vector<float> reference = transforms(objects);
+    QVERIFY(reference != savedTransforms);
+
+    // Change the objects of the world
+    objects.front()->removeFromWorldNow();
+    TestObject addedObject;
+    addedObject.setShape(MCShapePtr(new MCRectShape(MCShapeViewPtr(), 10, 10)));
+    addedObject.addToWorld(world, 500, 500);
+    step(10);
+
+    state.rewind();
+    QVERIFY(world.restoreState(state));
+    QVERIFY(state.atEnd());
+    QVERIFY(world.stepCount() == savedStepCount);
+    QVERIFY(transforms(objects) == savedTransforms);
+    QVERIFY(objects.front()->world() == &world);
+    QVERIFY(addedObject.world() == nullptr);
+
+    // Bit-exact on purpose
+    step(100);
+    QVERIFY(transforms(objects) == reference);
+
+    // The same state can be restored many times
+    state.rewind();
+    QVERIFY(world.restoreState(state));
+    step(100);
+    QVERIFY(transforms(objects) == reference);
+
+    // A truncated state is rejected
+    MCStateBuffer truncated;
+    truncated.write(1u);
+    QVERIFY(!world.restoreState(truncated));
+
+    for (auto && object : objects)
+    {
+        object->removeFromWorldNow();
+    }
+}
+
+void MCWorldTest::testRejectedStateDoesNotChangeWorld()
+{
+    MCWorld world;
+    world.setDimensions(0, 100, 0, 100, 0, 10, 1.0f, false, 10);
+
+    auto callback = [] (MCObject &, MCTriggerVolume::Event) {};
+    MCTriggerVolume volume(10, 10, callback);
+    volume.setLocation(MCVector2dF(50, 50));
+    world.addTriggerVolume(volume);
+
+    TestObject owner;
+    owner.setShape(MCShapePtr(new MCRectShape(MCShapeViewPtr(), 2.0, 2.0)));
+    owner.physicsComponent().setMass(0, true);
+    owner.setIsPhysicsObject(false);
+    MCTriggerVolumePtr ownedVolume(new MCTriggerVolume(10, 10, callback));
+    owner.addTriggerVolume(ownedVolume);
+    owner.addToWorld(world, 10, 20);
+
+    TestObject object;
+    object.setShape(MCShapePtr(new MCRectShape(MCShapeViewPtr(), 2.0, 2.0)));
+    object.physicsComponent().setMass(1);
+    object.physicsComponent().preventSleeping(true);
+    object.addToWorld(world, 50, 50);
+    world.stepTime(16);
+
+    MCStateBuffer state;
+    world.saveState(state);
+
+    // The volumes of an object removed since saving are added back with the object
+    owner.removeFromWorldNow();
+    state.rewind();
+    QVERIFY(world.restoreState(state));
+    QVERIFY(owner.world() == &world);
+    QVERIFY(volume.objects().size() == 1);
+
+    object.translate(MCVector3dF(30, 30));
+    world.stepTime(16);
+    QVERIFY(volume.objects().empty());
+    const unsigned int restoredStepCount = world.stepCount();
+
+    // A truncated state
+    MCStateBuffer truncated;
+    truncated.write(state.data(), state.size() - 1);
+    QVERIFY(!world.restoreState(truncated));
+    QVERIFY(world.stepCount() == restoredStepCount);
+    QVERIFY(object.location().i() == 30 && object.location().j() == 30);
+    QVERIFY(volume.objects().empty());
+
+    // A volume removed since saving
+    world.removeTriggerVolume(volume);
+    state.rewind();
+    QVERIFY(!world.restoreState(state));
+    QVERIFY(world.stepCount() == restoredStepCount);
+    QVERIFY(object.location().i() == 30 && object.location().j() == 30);
+    QVERIFY(object.world() == &world);
+    world.addTriggerVolume(volume);
+
+    // An object that has moved to another world
+    object.removeFromWorldNow();
+    MCWorld otherWorld;
+    otherWorld.setDimensions(0, 100, 0, 100, 0, 10, 1.0f, false, 10);
+    object.addToWorld(otherWorld, 30, 30);
+    state.rewind();
+    QVERIFY(!world.restoreState(state));
+    QVERIFY(world.stepCount() == restoredStepCount);
+    QVERIFY(owner.world() == &world);
+    QVERIFY(object.world() == &otherWorld);
+
+    object.removeFromWorldNow();
+    owner.removeFromWorldNow();
+    world.removeTriggerVolume(volume);
+}
+
+void MCWorldTest::testPhysicsStateIsKeptWhenAddedToWorld()
+{
+    MCWorld world;
+    world.setDimensions(0, 1024, 0, 1024, 0, 100, 1.0f, false, 64);
+
+    MCObject object("test");
+    object.physicsComponent().setMass(2.0f);
+    object.physicsComponent().setVelocity(MCVector3dF(1, 2, 3));
+    object.physicsComponent().setAngularVelocity(0.5f);
+
+    object.addToWorld(world, 100, 100);
+    QVERIFY(object.physicsComponent().velocity().i() == 1);
+    QVERIFY(object.physicsComponent().velocity().j() == 2);
+    QVERIFY(object.physicsComponent().velocity().k() == 3);
+    QVERIFY(object.physicsComponent().angularVelocity() == 0.5f);
+    QVERIFY(object.physicsComponent().invMass() == 0.5f);
+
+    object.removeFromWorldNow();
+    QVERIFY(object.physicsComponent().invMass() == 0.5f);
+}
+
+void MCWorldTest::testBatchIntegrationMatchesStepTime()
+{
+    MCWorld world;
+    world.setDimensions(0, 4096, 0, 4096, 0, 100, 1.0f, false, 128);
+
+    // Not a multiple of the SIMD width on purpose
+    const unsigned int count = 103;
+
+    std::vector<std::unique_ptr<MCObject>> objects;
+    addFreeBodies(objects, count, &world);
+
+    // Integrated one by one with MCPhysicsComponent::stepTime()
+    std::vector<std::unique_ptr<MCObject>> referenceObjects;
+    addFreeBodies(referenceObjects, count, nullptr);
+
+    for (int step = 0; step < 50; step++)
+    {
+        for (unsigned int i = 0; i < count; i++)
+        {
+            addFreeBodyInput(*objects[i], i, step);
+            addFreeBodyInput(*referenceObjects[i], i, step);
+            referenceObjects[i]->physicsComponent().stepTime(10);
+        }
+
+        world.stepTime(10);
+
+        for (unsigned int i = 0; i < count; i++)
+        {
+            MCPhysicsComponent & reference = referenceObjects[i]->physicsComponent();
+            MCPhysicsComponent & physicsComponent = objects[i]->physicsComponent();
+
+            // Bit-exact comparison on purpose
+            QVERIFY(reference.velocity().i() == physicsComponent.velocity().i());
+            QVERIFY(reference.velocity().j() == physicsComponent.velocity().j());
+            QVERIFY(reference.velocity().k() == physicsComponent.velocity().k());
+            QVERIFY(reference.angularVelocity() == physicsComponent.angularVelocity());
+            QVERIFY(referenceObjects[i]->location().i() == objects[i]->location().i());
+            QVERIFY(referenceObjects[i]->location().j() == objects[i]->location().j());
+            QVERIFY(referenceObjects[i]->angle() == objects[i]->angle());
+        }
+    }
+
+    for (auto && object : objects)
+    {
+        object->removeFromWorldNow();
+    }
+}
+
+void MCWorldTest::testIslandSleepsAndWakesUpAsWhole()
+{
+    MCWorld world;
+    world.setDimensions(0, 100, 0, 100, 0, 10);
+    world.setResolverLoopCount(0); // Keep the overlapping boxes in contact
+
+    std::vector<std::unique_ptr<MCObject>> objects;
+    for (int i = 0; i < 3; i++)
+    {
+        addRestingBox(world, objects, 40 + 3 * i, 50);
+    }
+
+    MCObject & single = *addRestingBox(world, objects, 80, 50);
+
+    world.stepTime(1);
+    QVERIFY(world.objectCount() == 8);
+    QVERIFY(world.islandManager().stats().m_islandCount == 2);
+    QVERIFY(world.islandManager().stats().m_largestIslandSize == 3);
+
+    world.stepTime(1);
+    QVERIFY(world.objectCount() == 4); // Only the walls
+    QVERIFY(world.islandManager().stats().m_fellAsleepCount == 4);
+    QVERIFY(world.islandManager().stats().m_sleepingIslandCount == 2);
+    QVERIFY(world.islandManager().stats().m_sleepingObjectCount == 4);
+
+    objects[2]->physicsComponent().addImpulse(MCVector3dF(1, 0, 0));
+    for (int i = 0; i < 3; i++)
+    {
+        QVERIFY(!objects[i]->physicsComponent().isSleeping());
+        QVERIFY(objects[i]->index() >= 0);
+    }
+
+    QVERIFY(single.physicsComponent().isSleeping());
+    QVERIFY(world.objectCount() == 7);
+
+    world.stepTime(1);
+    QVERIFY(world.islandManager().stats().m_wokenIslandCount == 1);
+    QVERIFY(world.islandManager().stats().m_sleepingIslandCount == 1);
+    QVERIFY(world.islandManager().stats().m_sleepingObjectCount == 1);
+
+    for (auto && object : objects)
+    {
+        object->removeFromWorldNow();
+    }
+
+    QVERIFY(world.islandManager().stats().m_sleepingIslandCount == 0);
+    QVERIFY(world.islandManager().stats().m_sleepingObjectCount == 0);
+}
+
+void MCWorldTest::testIslandIsKeptAwakeByMovingBody()
+{
+    MCWorld world;
+    world.setDimensions(0, 100, 0, 100, 0, 10);
+    world.setResolverLoopCount(0);
+
+    std::vector<std::unique_ptr<MCObject>> objects;
+    MCObject & resting = *addRestingBox(world, objects, 40, 50);
+    MCObject & moving = *addRestingBox(world, objects, 43, 50);
+    moving.physicsComponent().preventSleeping(true);
+    MCObject & single = *addRestingBox(world, objects, 80, 50);
+
+    for (int i = 0; i < 5; i++)
+    {
+        world.stepTime(1);
+    }
+
+    QVERIFY(!resting.physicsComponent().isSleeping());
+    QVERIFY(!moving.physicsComponent().isSleeping());
+    QVERIFY(single.physicsComponent().isSleeping());
+    QVERIFY(world.islandManager().stats().m_islandCount == 1);
+    QVERIFY(world.islandManager().stats().m_largestIslandSize == 2);
+
+    moving.physicsComponent().preventSleeping(false);
+    world.stepTime(1);
+    world.stepTime(1);
+    QVERIFY(resting.physicsComponent().isSleeping());
+    QVERIFY(moving.physicsComponent().isSleeping());
+
+    for (auto && object : objects)
+    {
+        object->removeFromWorldNow();
+    }
+}
+
+void MCWorldTest::testRestingBodyJoinsSleepingIsland()
+{
+    MCWorld world;
+    world.setDimensions(0, 100, 0, 100, 0, 10);
+    world.setResolverLoopCount(0);
+
+    std::vector<std::unique_ptr<MCObject>> objects;
+    MCObject & sleeping = *addRestingBox(world, objects, 40, 50);
+    world.stepTime(1);
+    world.stepTime(1);
+    QVERIFY(sleeping.physicsComponent().isSleeping());
+
+    MCObject & newcomer = *addRestingBox(world, objects, 43, 50);
+    world.stepTime(1);
+    world.stepTime(1);
+    QVERIFY(newcomer.physicsComponent().isSleeping());
+    QVERIFY(world.islandManager().stats().m_sleepingIslandCount == 1);
+    QVERIFY(world.islandManager().stats().m_sleepingObjectCount == 2);
+
+    sleeping.physicsComponent().setVelocity(MCVector3dF(1, 0, 0));
+    QVERIFY(!newcomer.physicsComponent().isSleeping());
+
+    for (auto && object : objects)
+    {
+        object->removeFromWorldNow();
+    }
+}
+
+void MCWorldTest::testKnockedPropsFallAsleep()
+{
+    MCWorld world;
+    world.setDimensions(0, 1024, 0, 1024, 0, 100, 1.0f, false, 64);
+
+    // A field of separate props and a car that drives through it
+    std::vector<std::unique_ptr<MCObject>> objects;
+    for (int j = 0; j < 10; j++)
+    {
+        for (int i = 0; i < 10; i++)
+        {
+            MCObject * prop = addRestingBox(world, objects, 400 + 10 * i, 450 + 10 * j);
+            prop->physicsComponent().setLinearDamping(0.9f);
+            prop->physicsComponent().setAngularDamping(0.9f);
+        }
+    }
+
+    MCObject * car = new MCObject("CAR");
+    car->setShape(MCShapePtr(new MCRectShape(MCShapeViewPtr(), 20, 10)));
+    car->physicsComponent().setMass(10);
+    car->physicsComponent().setLinearDamping(1); // Disable damping
+    car->physicsComponent().preventSleeping(true);
+    car->addToWorld(world, 300, 495);
+    objects.push_back(std::unique_ptr<MCObject>(car));
+
+    world.stepTime(1);
+    QVERIFY(world.objectCount() == 105); // 4 walls, 100 props and the car
+
+    world.stepTime(1);
+    QVERIFY(world.objectCount() == 5);
+
+    // The hit props and the props they hit wake up..
+    int maxObjectCount = 0;
+    for (int i = 0; i < 60; i++)
+    {
+        car->physicsComponent().setVelocity(MCVector3dF(5, 0, 0));
+        world.stepTime(1);
+        maxObjectCount = std::max(maxObjectCount, world.objectCount());
+    }
+
+    QVERIFY(maxObjectCount > 5);
+
+    // ..and fall asleep again once they have stopped
+    car->physicsComponent().preventSleeping(false);
+    car->physicsComponent().setVelocity(MCVector3dF(0, 0, 0));
+    for (int i = 0; i < 200; i++)
+    {
+        world.stepTime(1);
+    }
+
+    QVERIFY(world.objectCount() < maxObjectCount);
+    QVERIFY(world.islandManager().stats().m_sleepingObjectCount > 0);
+
+    for (auto && object : objects)
+    {
+        object->removeFromWorldNow();
+    }
+}
+
+void MCWorldTest::testIncrementalResolver()
+{
+    // Overlapping pairs next to boxes that are in the broadphase result, but never touch
+    auto simulate = [] (MCWorld::ResolverMode resolverMode, float depthTolerance, MCWorld::ResolverStatistics & statistics) {
+        MCWorld world;
+        world.setDimensions(0, 2048, 0, 2048, 0, 100, 1.0f, false, 128);
+        world.setResolverMode(resolverMode, depthTolerance);
+
+        std::vector<std::unique_ptr<TestObject>> objects;
+        for (int i = 0; i < 10; i++)
+        {
+            const float xs[] = {0, 8, 20, 32, -12, -24};
+            for (float x : xs)
+            {
+                TestObject * object = new TestObject;
+                object->setShape(MCShapePtr(new MCRectShape(MCShapeViewPtr(), 10, 10)));
+                object->physicsComponent().setMass(1);
+                object->addToWorld(world, 100 + i * 150 + x, 1000);
+                objects.push_back(std::unique_ptr<TestObject>(object));
+            }
+        }
+
+        world.stepTime(16);
+        statistics = world.resolverStatistics();
+
+        const std::vector<float> result = transforms(objects);
+        for (auto && object : objects)
+        {
+            object->removeFromWorldNow();
+        }
+
+        return result;
+    };
+
+    MCWorld world;
+    QVERIFY(world.resolverMode() == MCWorld::ResolverMode::Full);
+    world.setResolverMode(MCWorld::ResolverMode::Incremental);
+    QVERIFY(world.resolverMode() == MCWorld::ResolverMode::Incremental);
+
+    MCWorld::ResolverStatistics fullStatistics;
+    const std::vector<float> fullTransforms = simulate(MCWorld::ResolverMode::Full, 0, fullStatistics);
+    QVERIFY(fullStatistics.m_iterations == 5);
+    QVERIFY(fullStatistics.m_skippedIterations == 0);
+
+    // The same result with fewer pair tests
+    MCWorld::ResolverStatistics incrementalStatistics;
+    const std::vector<float> incrementalTransforms = simulate(MCWorld::ResolverMode::Incremental, 0, incrementalStatistics);
+    QVERIFY(incrementalTransforms == fullTransforms); // Bit-exact on purpose
+    QVERIFY(incrementalStatistics.m_iterations == 5);
+    QVERIFY(incrementalStatistics.m_testedPairs < fullStatistics.m_testedPairs);
+    QVERIFY(incrementalStatistics.m_avoidedPairTests > 0);
+
+    // Stops when the remaining interpenetration is below the tolerance
+    MCWorld::ResolverStatistics toleranceStatistics;
+    simulate(MCWorld::ResolverMode::Incremental, 1.5f, toleranceStatistics);
+    QVERIFY(toleranceStatistics.m_iterations < 5);
+    QVERIFY(toleranceStatistics.m_skippedIterations == 5 - toleranceStatistics.m_iterations);
+    QVERIFY(toleranceStatistics.m_testedPairs < incrementalStatistics.m_testedPairs);
+
+    // The start grid and the crate pile keeps overlapping, but the stacked crates are
+    // displaced without running the broadphase on each iteration.
+    MCWorld::ResolverStatistics pileStatistics;
+    simulateStartGridAndCratePile(50, MCWorld::ResolverMode::Incremental, 0, &pileStatistics);
+    QVERIFY(pileStatistics.m_iterations > 0);
+    QVERIFY(pileStatistics.m_avoidedPairTests > 0);
+    QVERIFY(pileStatistics.m_elapsedTime.count() > 0);
+}
+
+void MCWorldTest::testTriggerVolumes()
+{
+    MCWorld world;
+    world.setDimensions(0, 100, 0, 100, 0, 10, 1.0f, false, 10);
+
+    typedef std::pair<MCObject *, MCTriggerVolume::Event> Record;
+    std::vector<Record> records;
+    auto callback = [&records] (MCObject & object, MCTriggerVolume::Event event) {
+        records.push_back({&object, event});
+    };
+
+    MCTriggerVolume volume(10, 10, callback);
+    volume.setLocation(MCVector2dF(50, 50));
+    world.addTriggerVolume(volume);
+
+    // A volume owned by an object follows the object
+    TestObject owner;
+    owner.setShape(MCShapePtr(new MCRectShape(MCShapeViewPtr(), 2.0, 2.0)));
+    owner.physicsComponent().setMass(0, true);
+    owner.setIsPhysicsObject(false);
+    MCTriggerVolumePtr ownedVolume(new MCTriggerVolume(10, 10, callback));
+    ownedVolume->setLocation(MCVector2dF(20, 0));
+    owner.addTriggerVolume(ownedVolume);
+    owner.addToWorld(world, 10, 20);
+
+    TestObject object;
+    object.setShape(MCShapePtr(new MCRectShape(MCShapeViewPtr(), 2.0, 2.0)));
+    object.physicsComponent().setMass(1);
+    object.physicsComponent().preventSleeping(true);
+    object.addToWorld(world, 30, 50);
+
+    world.stepTime(16);
+    QVERIFY(records.empty());
+
+    object.translate(MCVector3dF(50, 50));
+    world.stepTime(16);
+    world.stepTime(16);
+    world.stepTime(16);
+    QVERIFY(volume.objects().size() == 1);
+
+    object.translate(MCVector3dF(80, 50));
+    world.stepTime(16);
+    world.stepTime(16);
+
+    const std::vector<Record> expected = {
+        {&object, MCTriggerVolume::Event::Enter},
+        {&object, MCTriggerVolume::Event::Stay},
+        {&object, MCTriggerVolume::Event::Stay},
+        {&object, MCTriggerVolume::Event::Exit}};
+    QVERIFY(records == expected);
+
+    // The volumes are not a part of the collision detection
+    QVERIFY(!object.m_collisionEventReceived);
+    QVERIFY(object.m_contactEvents.empty());
+
+    records.clear();
+    owner.rotate(90);
+    object.translate(MCVector3dF(10, 40));
+    world.stepTime(16);
+    QVERIFY(records.size() == 1);
+    QVERIFY(records[0] == Record(&object, MCTriggerVolume::Event::Enter));
+    QVERIFY(ownedVolume->objects().size() == 1);
+
+    // The objects inside are a part of the saved state
+    MCStateBuffer state;
+    world.saveState(state);
+    object.translate(MCVector3dF(80, 80));
+    world.stepTime(16);
+    QVERIFY(records.back() == Record(&object, MCTriggerVolume::Event::Exit));
+    state.rewind();
+    QVERIFY(world.restoreState(state));
+    world.stepTime(16);
+    QVERIFY(records.back() == Record(&object, MCTriggerVolume::Event::Stay));
+
+    // A removed object leaves the volume
+    records.clear();
+    object.removeFromWorldNow();
+    QVERIFY(ownedVolume->objects().empty());
+    QVERIFY(records.size() == 1);
+    QVERIFY(records[0] == Record(&object, MCTriggerVolume::Event::Exit));
+    world.stepTime(16);
+    QVERIFY(records.size() == 1);
+
+    owner.removeFromWorldNow();
+    QVERIFY(ownedVolume->owner() == &owner);
+    world.removeTriggerVolume(volume);
+}
+
+void MCWorldTest::benchmarkGridBroadphase()
+{
+    stepStartGridAndCratePile(MCWorld::Broadphase::Grid);
+}
+
+void MCWorldTest::benchmarkSweepAndPruneBroadphase()
+{
+    stepStartGridAndCratePile(MCWorld::Broadphase::SweepAndPrune);
+}
+
+void MCWorldTest::benchmarkSingleThreadedCollisionDetection()
+{
+    stepStartGridAndCratePile(MCWorld::Broadphase::Grid, 1);
+}
+
+void MCWorldTest::benchmarkSingleWorld()
+{
+    stepParallelWorlds(1);
+}
+
+void MCWorldTest::benchmarkParallelWorlds()
+{
+    stepParallelWorlds(std::max(1u, std::thread::hardware_concurrency()));
+}
+
+void MCWorldTest::benchmarkResolverModes_data()
+{
+    QTest::addColumn<bool>("incremental");
+
+    QTest::newRow("full") << false;
+    QTest::newRow("incremental") << true;
+}
+
+void MCWorldTest::benchmarkResolverModes()
+{
+    QFETCH(bool, incremental);
+
+    const MCWorld::ResolverMode resolverMode = incremental ? MCWorld::ResolverMode::Incremental : MCWorld::ResolverMode::Full;
+    QBENCHMARK {
+        simulateStartGridAndCratePile(100, resolverMode);
+    }
+}
+
+void MCWorldTest::benchmarkSaveAndRestoreState()
+{
+    MCWorld world;
+    world.setDimensions(0, 2048, 0, 2048, 0, 100, 1.0f, true, 128);
+
+    std::vector<std::unique_ptr<TestObject>> objects;
+    addStartGridAndCratePile(world, objects);
+
+    for (int i = 0; i < 60; i++)
+    {
+        world.stepTime(16);
+    }
+
+    MCStateBuffer state;
+    QBENCHMARK {
+        state.clear();
+        world.saveState(state);
+        world.restoreState(state);
+    }
+
+    for (auto && object : objects)
+    {
+        object->removeFromWorldNow();
+    }
+}
+
+void MCWorldTest::benchmarkIntegration()
+{
+    MCWorld world;
+    world.setDimensions(0, 4096, 0, 4096, 0, 100, 1.0f, false, 128);
+
+    std::vector<std::unique_ptr<MCObject>> objects;
+    addFreeBodies(objects, 5000, &world);
+
+    QBENCHMARK {
+        for (int step = 0; step < 100; step++)
+        {
+            for (unsigned int i = 0; i < objects.size(); i++)
+            {
+                objects[i]->physicsComponent().addForce(MCVector3dF(0.1f, 0.2f));
+            }
+
+            world.stepTime(10);
+        }
+    }
+
+    for (auto && object : objects)
+    {
+        object->removeFromWorldNow();
+    }
+}
+
+void MCWorldTest::testTriggerVolumeRemovedByCallback()
+{
+    MCWorld world;
+    world.setDimensions(0, 100, 0, 100, 0, 10, 1.0f, false, 10);
+
+    // The first volume removes itself when the object enters it
+    std::vector<int> entered;
+    std::unique_ptr<MCTriggerVolume> volumes[3];
+    for (int i = 0; i < 3; i++)
+    {
+        volumes[i].reset(new MCTriggerVolume(10, 10, [&world, &volumes, &entered, i] (MCObject &, MCTriggerVolume::Event event) {
+            if (event == MCTriggerVolume::Event::Enter)
+            {
+                entered.push_back(i);
+                if (i == 0)
+                {
+                    world.removeTriggerVolume(*volumes[0]);
+                }
+            }
+        }));
+        volumes[i]->setLocation(MCVector2dF(50, 50));
+        world.addTriggerVolume(*volumes[i]);
+    }
+
+    TestObject object;
+    object.setShape(MCShapePtr(new MCRectShape(MCShapeViewPtr(), 2.0, 2.0)));
+    object.physicsComponent().setMass(1);
+    object.physicsComponent().preventSleeping(true);
+    object.addToWorld(world, 50, 50);
+
+    // The remaining volumes are still evaluated on the same step
+    world.stepTime(16);
+    QVERIFY(entered == std::vector<int>({0, 1, 2}));
+    QVERIFY(volumes[0]->objects().empty());
+    QVERIFY(volumes[1]->objects().size() == 1);
+    QVERIFY(volumes[2]->objects().size() == 1);
+
+    // ..and they are kept in order
+    world.removeTriggerVolume(*volumes[1]);
+    world.removeTriggerVolume(*volumes[2]);
+    world.addTriggerVolume(*volumes[2]);
+    world.addTriggerVolume(*volumes[1]);
+    entered.clear();
+    world.stepTime(16);
+    QVERIFY(entered == std::vector<int>({2, 1}));
+
+    object.removeFromWorldNow();
+
+    // The volumes are deleted before the world
+    world.removeTriggerVolume(*volumes[1]);
+    world.removeTriggerVolume(*volumes[2]);
+}
+
+void MCWorldTest::testLazyChildTransforms()
+{
+    MCWorld world;
+    world.setDimensions(0, 1024, 0, 1024, 0, 100, 1.0f, false, 128);
+
+    // Overlapping objects that the resolver displaces many times
+    std::vector<std::unique_ptr<TestObject>> objects;
+    std::vector<MCObjectPtr> children;
+    for (int i = 0; i < 4; i++)
+    {
+        TestObject * object = new TestObject;
+        object->setShape(MCShapePtr(new MCRectShape(MCShapeViewPtr(), 10, 10)));
+        object->physicsComponent().setMass(1);
+
+        MCObjectPtr child(new MCObject("child"));
+        child->setShape(MCShapePtr(new MCRectShape(MCShapeViewPtr(), 2, 2)));
+        child->setBypassCollisions(true);
+        object->addChildObject(child, MCVector3dF(5, 0, 1));
+        children.push_back(child);
+
+        object->addToWorld(world, 500 + i * 6, 500);
+        objects.push_back(std::unique_ptr<TestObject>(object));
+    }
+
+    // Moves outside of stepTime() update the children immediately
+    QVERIFY(qFuzzyCompare(children[0]->location().i(), 505.0f));
+    QVERIFY(qFuzzyCompare(children[0]->location().j(), 500.0f));
+    QVERIFY(world.avoidedChildTransformUpdates() == 0);
+
+    objects[0]->physicsComponent().setVelocity(MCVector3dF(4, 0, 0));
+    world.stepTime(16);
+    QVERIFY(world.resolverStatistics().m_iterations > 0);
+    QVERIFY(world.avoidedChildTransformUpdates() > 0);
+
+    // The children follow their parents at the end of the step
+    for (unsigned int i = 0; i < objects.size(); i++)
+    {
+        const MCObject & parent = *objects[i];
+        const MCVector2dF expected = MCVector2dF(parent.location()) + MCMathUtil::rotatedVector(MCVector2dF(5, 0), parent.angle());
+        QVERIFY(std::fabs(children[i]->location().i() - expected.i()) < 0.001f);
+        QVERIFY(std::fabs(children[i]->location().j() - expected.j()) < 0.001f);
+    }
+
+    for (auto && object : objects)
+    {
+        object->removeFromWorldNow();
+    }
+}
+
 QTEST_GUILESS_MAIN(MCWorldTest)
@@ -33,9 +33,69 @@ private slots:
 
     void testInstance();
 
+    void testRenderer();
+
     void testSetDimensions();
 
     void testSimpleCollision();
 
     void testSleepingObjectRemovalFromIntegration();
+
+    void testSweepAndPruneCollision();
+
+    void testContactEvents();
+
+    void testContactEventsAreOrderedByObjectId();
+
+    void testSleepingPairDoesNotEndContact();
+
+    void testRemovedObjectEndsContact();
+
+    void testObjectRemovedByContactHandler();
+
+    void testThreadedCollisionDetectionIsDeterministic();
+
+    void testParallelWorlds();
+
+    void testSaveAndRestoreState();
+
+    void testRejectedStateDoesNotChangeWorld();
+
+    void testPhysicsStateIsKeptWhenAddedToWorld();
+
+    void testBatchIntegrationMatchesStepTime();
+
+    void testIslandSleepsAndWakesUpAsWhole();
+
+    void testIslandIsKeptAwakeByMovingBody();
+
+    void testRestingBodyJoinsSleepingIsland();
+
+    void testKnockedPropsFallAsleep();
+
+    void testIncrementalResolver();
+
+    void testTriggerVolumes();
+
+    void testTriggerVolumeRemovedByCallback();
+
+    void testLazyChildTransforms();
+
+    void benchmarkGridBroadphase();
+
+    void benchmarkSweepAndPruneBroadphase();
+
+    void benchmarkSingleThreadedCollisionDetection();
+
+    void benchmarkIntegration();
+
+    void benchmarkResolverModes_data();
+
+    void benchmarkResolverModes();
+
+    void benchmarkSaveAndRestoreState();
+
+    void benchmarkSingleWorld();
+
+    void benchmarkParallelWorlds();
 };
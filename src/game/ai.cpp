@@ -21,12 +21,14 @@
 #include "../common/route.hpp"
 #include "../common/tracktilebase.hpp"
 
-#include <MCRandom>
+#include <MCRandomStream>
+#include <MCStateBuffer>
 #include <MCTrigonom>
 
 
-AI::AI(Car & car)
+AI::AI(Car & car, MCRandomStream & random)
 : m_car(car)
+, m_random(random)
 , m_track(nullptr)
 , m_route(nullptr)
 , m_lastDiff(0)
@@ -62,7 +64,7 @@ void AI::update(bool isRaceCompleted)
 
 void AI::setRandomTolerance()
 {
-    m_randomTolerance = MCRandom::randomVector2d() * TrackTileBase::TILE_W / 8;
+    m_randomTolerance = m_random.randomVector2d() * TrackTileBase::TILE_W / 8;
 }
 
 void AI::steerControl(TargetNodeBasePtr tnode)
@@ -194,3 +196,17 @@ void AI::setTrack(Track & track)
     m_track = &track;
     m_route = &track.trackData().route();
 }
+
+void AI::saveState(MCStateBuffer & state) const
+{
+    state.write(m_lastDiff);
+    state.write(m_lastTargetNodeIndex);
+    state.write(m_randomTolerance);
+}
+
+void AI::restoreState(MCStateBuffer & state)
+{
+    state.read(m_lastDiff);
+    state.read(m_lastTargetNodeIndex);
+    state.read(m_randomTolerance);
+}
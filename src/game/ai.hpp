@@ -21,6 +21,8 @@
 #include "../common/targetnodebase.hpp"
 
 class Car;
+class MCRandomStream;
+class MCStateBuffer;
 class Route;
 class Track;
 class TrackTile;
@@ -30,8 +32,10 @@ class AI
 {
 public:
 
-    //! Constructor.
-    AI(Car & car);
+    /*! Constructor.
+     *  \param car The car to drive.
+     *  \param random The stream the steering tolerances are drawn from. */
+    AI(Car & car, MCRandomStream & random);
 
     //! Update.
     void update(bool isRaceCompleted);
@@ -42,6 +46,12 @@ public:
     //! Get associated car.
     Car & car() const;
 
+    //! Save the steering state into the given buffer.
+    void saveState(MCStateBuffer & state) const;
+
+    //! Restore the steering state saved with saveState().
+    void restoreState(MCStateBuffer & state);
+
 private:
 
     //! Steering logic.
@@ -54,6 +64,8 @@ private:
 
     Car & m_car;
 
+    MCRandomStream & m_random;
+
     Track * m_track;
 
     const Route * m_route;
@@ -14,13 +14,11 @@
 // along with Dust Racing 2D. If not, see <http://www.gnu.org/licenses/>.
 
 #include "bridge.hpp"
-#include "bridgetrigger.hpp"
 #include "car.hpp"
 #include "layers.hpp"
 #include "renderer.hpp"
 
 #include <MCAssetManager>
-#include <MCCollisionEvent>
 #include <MCObjectFactory>
 #include <MCPhysicsComponent>
 #include <MCRectShape>
@@ -34,6 +32,8 @@ static const int    RAIL_Z         = 16;
 static const float  OBJECT_Z_DELTA = RAIL_Z;
 static const float  OBJECT_Z_ZERO  = 0.0f;
 static const int    WIDTH          = 256;
+static const int    TRIGGER_WIDTH  = 16;
+static const int    TRIGGER_HEIGHT = 224;
 }
 
 Bridge::Bridge()
@@ -43,13 +43,19 @@ Bridge::Bridge()
     auto && shape = MCShapePtr(new MCRectShape(nullptr, WIDTH, WIDTH));
     setShape(shape);
 
-    setCollisionLayer(-1);
-
     setIsPhysicsObject(false);
-    setIsTriggerObject(true);
 
     physicsComponent().setMass(0, true);
 
+    // Objects that have entered the bridge are kept on it while they overlap the bridge
+    addTriggerVolume(MCTriggerVolumePtr(new MCTriggerVolume(WIDTH, WIDTH,
+        [this] (MCObject & object, MCTriggerVolume::Event event) {
+            if (event != MCTriggerVolume::Event::Exit)
+            {
+                keepObject(object);
+            }
+        })));
+
     const int railYDisplacement = 110;
 
     auto && railSurface = MCAssetManager::instance().surfaceManager().surface("wallLong");
@@ -68,13 +74,20 @@ Bridge::Bridge()
     rail1->physicsComponent().setMass(0, true);
     rail1->shape()->view()->setShaderProgram(Renderer::instance().program("defaultSpecular"));
 
+    // Objects enter the bridge through the triggers at the ends
     const int triggerXDisplacement = WIDTH / 2;
-
-    auto && trigger0 = MCObjectPtr(new BridgeTrigger(*this));
-    addChildObject(trigger0, MCVector3dF(-triggerXDisplacement, 0, 0));
-
-    auto && trigger1 = MCObjectPtr(new BridgeTrigger(*this));
-    addChildObject(trigger1, MCVector3dF( triggerXDisplacement, 0, 0));
+    for (int side : {-1, 1})
+    {
+        auto && trigger = MCTriggerVolumePtr(new MCTriggerVolume(TRIGGER_WIDTH, TRIGGER_HEIGHT,
+            [this] (MCObject & object, MCTriggerVolume::Event event) {
+                if (event != MCTriggerVolume::Event::Exit)
+                {
+                    enterObject(object);
+                }
+            }));
+        trigger->setLocation(MCVector2dF(side * triggerXDisplacement, 0));
+        addTriggerVolume(trigger);
+    }
 
     MCMeshObjectData data("bridge");
     data.setMeshId("bridge");
@@ -113,20 +126,16 @@ void Bridge::enterObject(MCObject & object)
     }
 }
 
-void Bridge::collisionEvent(MCCollisionEvent & event)
+void Bridge::keepObject(MCObject & object)
 {
-    MCObject & object = event.collidingObject();
-    if (!object.physicsComponent().isStationary())
+    if (m_objectsEntered.count(&object))
     {
-        if (m_objectsEntered.count(&object))
-        {
-            object.setCollisionLayer(static_cast<int>(Layers::Collision::BridgeRails));
-            object.physicsComponent().preventSleeping(true);
+        object.setCollisionLayer(static_cast<int>(Layers::Collision::BridgeRails));
+        object.physicsComponent().preventSleeping(true);
 
-            raiseObject(object, true);
+        raiseObject(object, true);
 
-            m_objectsOnBridge[&object] = m_tag;
-        }
+        m_objectsOnBridge[&object] = m_tag;
     }
 }
 
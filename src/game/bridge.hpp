@@ -17,10 +17,10 @@
 #define BRIDGE_HPP
 
 #include <MCObject>
+#include <MCTriggerVolume>
 
 #include <map>
 
-class MCCollisionEvent;
 class MCSurface;
 class Car;
 
@@ -30,15 +30,14 @@ public:
 
     Bridge();
 
-    //! \reimp
-    virtual void collisionEvent(MCCollisionEvent & event) override;
-
     //! \reimp
     virtual void onStepTime(int step) override;
 
+private:
+
     void enterObject(MCObject & object);
 
-private:
+    void keepObject(MCObject & object);
 
     void raiseObject(MCObject & object, bool raise);
 
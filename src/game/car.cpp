@@ -19,7 +19,6 @@
 #include "graphicsfactory.hpp"
 #include "layers.hpp"
 #include "renderer.hpp"
-#include "tire.hpp"
 
 #include <MCAssetManager>
 #include <MCCollisionEvent>
@@ -30,6 +29,7 @@
 #include <MCPhysicsComponent>
 #include <MCRectShape>
 #include <MCShape>
+#include <MCStateBuffer>
 #include <MCSurface>
 #include <MCTrigonom>
 
@@ -42,12 +42,22 @@
 #include <string>
 
 using std::dynamic_pointer_cast;
-using std::static_pointer_cast;
 
-Car::Car(Description & desc, MCSurface & surface, unsigned int index, bool isHuman)
+namespace {
+MCObjectPtr createTireObject(MCSurface & surface)
+{
+    MCObjectPtr tire(new MCObject(surface, "Tire"));
+    tire->setBypassCollisions(true);
+    tire->setIsRenderOnly(true);
+    return tire;
+}
+}
+
+Car::Car(Description & desc, MCSurface & surface, unsigned int index, bool isHuman, MCWorld & world)
 : MCObject(surface, "car")
 , m_desc(desc)
-, m_onTrackFriction(new MCFrictionGenerator(desc.rollingFrictionOnTrack, 0.0))
+, m_world(world)
+, m_onTrackFriction(new MCFrictionGenerator(desc.rollingFrictionOnTrack, 0.0, world))
 , m_leftSideOffTrack(false)
 , m_rightSideOffTrack(false)
 , m_accelerating(false)
@@ -96,20 +106,28 @@ Car::Car(Description & desc, MCSurface & surface, unsigned int index, bool isHum
     numberPlate->setBypassCollisions(true);
     numberPlate->shape()->view()->setHasShadow(false);
 
+    // The order must match TireIndex
     const float offTrackFrictionFactor = 0.8f;
     const float frontFriction = 0.85f;
+    const float rearFriction = 0.95f;
+    m_tires.reserve(4);
+    m_tires.emplace_back(*this, m_leftFrontTirePos, frontFriction, frontFriction);
+    m_tires.emplace_back(*this, m_rightFrontTirePos, frontFriction, frontFriction);
+    m_tires.emplace_back(*this, m_leftRearTirePos, rearFriction, rearFriction * offTrackFrictionFactor);
+    m_tires.emplace_back(*this, m_rightRearTirePos, rearFriction, rearFriction * offTrackFrictionFactor);
+
+    // The tires are drawn by render-only child objects, so they are not added to the world
     const MCVector3dF tireZ = MCVector3dF(0, 0, 1);
-    m_leftFrontTire.reset(new Tire(*this, frontFriction, frontFriction));
+    m_leftFrontTire = createTireObject(m_frontTire);
     addChildObject(m_leftFrontTire, m_leftFrontTirePos + tireZ, 0);
 
-    m_rightFrontTire.reset(new Tire(*this, frontFriction, frontFriction));
+    m_rightFrontTire = createTireObject(m_frontTire);
     addChildObject(m_rightFrontTire, m_rightFrontTirePos + tireZ, 0);
 
-    const float rearFriction = 0.95f;
-    m_leftRearTire.reset(new Tire(*this, rearFriction, rearFriction * offTrackFrictionFactor));
+    m_leftRearTire = createTireObject(m_frontTire);
     addChildObject(m_leftRearTire, m_leftRearTirePos + tireZ, 0);
 
-    m_rightRearTire.reset(new Tire(*this, rearFriction, rearFriction * offTrackFrictionFactor));
+    m_rightRearTire = createTireObject(m_frontTire);
     addChildObject(m_rightRearTire, m_rightRearTirePos + tireZ, 0);
 
     m_leftBrakeGlowPos += MCVector3dF(0, 0, surface.maxZ() + 1.0f);
@@ -143,11 +161,11 @@ void Car::setProperties(Description & desc)
 void Car::initForceGenerators(Description & desc)
 {
     // Add rolling friction generator (on-track)
-    MCWorld::instance().forceRegistry().addForceGenerator(m_onTrackFriction, *this);
+    m_world.forceRegistry().addForceGenerator(m_onTrackFriction, *this);
     m_onTrackFriction->enable(true);
 
     MCForceGeneratorPtr drag(new MCDragForceGenerator(desc.dragLinear, desc.dragQuadratic));
-    MCWorld::instance().forceRegistry().addForceGenerator(drag, *this);
+    m_world.forceRegistry().addForceGenerator(drag, *this);
 }
 
 void Car::clearStatuses()
@@ -190,11 +208,11 @@ void Car::accelerate(bool deccelerate)
 {
     m_skidding = false;
 
-    static_pointer_cast<Tire>(m_leftRearTire)->setSpinCoeff(1.0f);
-    static_pointer_cast<Tire>(m_rightRearTire)->setSpinCoeff(1.0f);
+    m_tires[LeftRearTire].setSpinCoeff(1.0f);
+    m_tires[RightRearTire].setSpinCoeff(1.0f);
 
     const float maxForce =
-        physicsComponent().mass() * m_desc.accelerationFriction * std::fabs(MCWorld::instance().gravity().k());
+        physicsComponent().mass() * m_desc.accelerationFriction * std::fabs(m_world.gravity().k());
     float currentForce = maxForce;
     const float velocity = physicsComponent().velocity().length();
     if (velocity > 0.001f)
@@ -209,8 +227,8 @@ void Car::accelerate(bool deccelerate)
                 if (isHuman()) // Don't enable tire spin for AI yet
                 {
                     const float spinCoeff = 0.025f + 0.975f * std::pow(velocity / maxSpinVelocity, 2.0f);
-                    static_pointer_cast<Tire>(m_leftRearTire)->setSpinCoeff(spinCoeff);
-                    static_pointer_cast<Tire>(m_rightRearTire)->setSpinCoeff(spinCoeff);
+                    m_tires[LeftRearTire].setSpinCoeff(spinCoeff);
+                    m_tires[RightRearTire].setSpinCoeff(spinCoeff);
                 }
 
                 m_skidding = true;
@@ -285,12 +303,12 @@ float Car::absSpeed() const
 
 MCVector3dF Car::leftFrontTireLocation() const
 {
-    return m_leftFrontTire->location();
+    return MCMathUtil::rotatedVector(m_leftFrontTirePos, angle()) + MCVector2dF(location());
 }
 
 MCVector3dF Car::rightFrontTireLocation() const
 {
-    return m_rightFrontTire->location();
+    return MCMathUtil::rotatedVector(m_rightFrontTirePos, angle()) + MCVector2dF(location());
 }
 
 MCVector3dF Car::leftRearTireLocation() const
@@ -313,8 +331,10 @@ void Car::updateAnimations()
     }
 
     const float offset = 5.0f;
-    m_leftFrontTire->rotateRelative(m_tireAngle - offset);
-    m_rightFrontTire->rotateRelative(m_tireAngle + offset);
+    m_tires[LeftFrontTire].setAngle(m_tireAngle - offset);
+    m_tires[RightFrontTire].setAngle(m_tireAngle + offset);
+    m_leftFrontTire->rotateRelative(m_tires[LeftFrontTire].angle());
+    m_rightFrontTire->rotateRelative(m_tires[RightFrontTire].angle());
 
     const bool brakingGlowVisible = m_braking && speedInKmh() > 0;
     m_leftBrakeGlow->setIsRenderable(brakingGlowVisible);
@@ -343,29 +363,65 @@ void Car::updateTireWear(int step)
 
         if (m_leftSideOffTrack)
         {
-            static_pointer_cast<Tire>(m_leftFrontTire)->setIsOffTrack(true);
-            static_pointer_cast<Tire>(m_leftRearTire)->setIsOffTrack(true);
+            m_tires[LeftFrontTire].setIsOffTrack(true);
+            m_tires[LeftRearTire].setIsOffTrack(true);
 
             wearOutTires(step, offTrackTireWearFactor);
         }
         else
         {
-            static_pointer_cast<Tire>(m_leftFrontTire)->setIsOffTrack(false);
-            static_pointer_cast<Tire>(m_leftRearTire)->setIsOffTrack(false);
+            m_tires[LeftFrontTire].setIsOffTrack(false);
+            m_tires[LeftRearTire].setIsOffTrack(false);
         }
 
         if (m_rightSideOffTrack)
         {
-            static_pointer_cast<Tire>(m_rightFrontTire)->setIsOffTrack(true);
-            static_pointer_cast<Tire>(m_rightRearTire)->setIsOffTrack(true);
+            m_tires[RightFrontTire].setIsOffTrack(true);
+            m_tires[RightRearTire].setIsOffTrack(true);
 
             wearOutTires(step, offTrackTireWearFactor);
         }
         else
         {
-            static_pointer_cast<Tire>(m_rightFrontTire)->setIsOffTrack(false);
-            static_pointer_cast<Tire>(m_rightRearTire)->setIsOffTrack(false);
+            m_tires[RightFrontTire].setIsOffTrack(false);
+            m_tires[RightRearTire].setIsOffTrack(false);
+        }
+    }
+}
+
+void Car::updateTires(int step)
+{
+    if (!world() || physicsComponent().isSleeping())
+    {
+        return;
+    }
+
+    // The contact points move with the car and rotate with it around its center.
+    // Share the trigonometry of the current and the previous angle by all tires.
+    const float angleDiff = MCTrigonom::radToDeg(physicsComponent().angularVelocity() * step / 1000);
+    float sin0, cos0, sin1, cos1;
+    MCTrigonom::sinCos(angle() - angleDiff, sin0, cos0);
+    MCTrigonom::sinCos(angle(), sin1, cos1);
+
+    // Use the gravity of the car's own world, which is not necessarily the primary one
+    const float gravity = world()->gravity().k();
+    const MCVector2dF velocity(physicsComponent().velocity());
+    for (auto && tire : m_tires)
+    {
+        const MCVector3dF & p = tire.location();
+        const MCVector2dF p0(cos0 * p.i() - sin0 * p.j(), sin0 * p.i() + cos0 * p.j());
+        const MCVector2dF p1(cos1 * p.i() - sin1 * p.j(), sin1 * p.i() + cos1 * p.j());
+
+        // Normal of the rolling direction
+        MCVector2dF normal(-sin1, cos1);
+        if (tire.angle() != 0)
+        {
+            float s, c;
+            MCTrigonom::sinCos(angle() + tire.angle() + 90, s, c);
+            normal = MCVector2dF(c, s);
         }
+
+        tire.applyForces(velocity + p1 - p0, normal, location() + MCVector3dF(p1, p.k()), gravity);
     }
 }
 
@@ -459,6 +515,8 @@ void Car::onStepTime(int step)
     updateAnimations();
 
     updateTireWear(step);
+
+    updateTires(step);
 }
 
 void Car::setLeftSideOffTrack(bool state)
@@ -553,7 +611,55 @@ CarSoundEffectManagerPtr Car::soundEffectManager() const
     return m_soundEffectManager;
 }
 
+void Car::saveState(MCStateBuffer & state) const
+{
+    state.write(m_leftSideOffTrack);
+    state.write(m_rightSideOffTrack);
+    state.write(m_accelerating);
+    state.write(m_braking);
+    state.write(m_reverse);
+    state.write(m_skidding);
+    state.write(m_steer);
+    state.write(m_tireAngle);
+    state.write(m_damageCapacity);
+    state.write(m_tireWearOutCapacity);
+    state.write(m_speedInKmh);
+    state.write(m_absSpeed);
+    state.write(m_dx);
+    state.write(m_dy);
+    state.write(m_nextTargetNodeIndex);
+    state.write(m_currentTargetNodeIndex);
+    state.write(m_prevTargetNodeIndex);
+    state.write(m_routeProgression);
+    state.write(m_position);
+    state.write(m_hadHardCrash);
+}
+
+void Car::restoreState(MCStateBuffer & state)
+{
+    state.read(m_leftSideOffTrack);
+    state.read(m_rightSideOffTrack);
+    state.read(m_accelerating);
+    state.read(m_braking);
+    state.read(m_reverse);
+    state.read(m_skidding);
+    state.read(m_steer);
+    state.read(m_tireAngle);
+    state.read(m_damageCapacity);
+    state.read(m_tireWearOutCapacity);
+    state.read(m_speedInKmh);
+    state.read(m_absSpeed);
+    state.read(m_dx);
+    state.read(m_dy);
+    state.read(m_nextTargetNodeIndex);
+    state.read(m_currentTargetNodeIndex);
+    state.read(m_prevTargetNodeIndex);
+    state.read(m_routeProgression);
+    state.read(m_position);
+    state.read(m_hadHardCrash);
+}
+
 Car::~Car()
 {
-    MCWorld::instance().forceRegistry().removeForceGenerators(*this);
+    m_world.forceRegistry().removeForceGenerators(*this);
 }
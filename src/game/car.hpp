@@ -22,11 +22,15 @@
 
 #include "carparticleeffectmanager.hpp"
 #include "carsoundeffectmanager.hpp"
+#include "tire.hpp"
 
 #include <memory>
+#include <vector>
 
 class MCSurface;
 class MCFrictionGenerator;
+class MCWorld;
+class MCStateBuffer;
 class Route;
 
 //! Base class for race cars.
@@ -60,8 +64,9 @@ public:
         float dragQuadratic = 5.0f;
     };
 
-    //! Constructor.
-    Car(Description & desc, MCSurface & surface, unsigned int index, bool isHuman);
+    /*! Constructor.
+     *  \param world The world the car will race in. Its force registry and gravity are used. */
+    Car(Description & desc, MCSurface & surface, unsigned int index, bool isHuman, MCWorld & world);
 
     //! Destructor.
     virtual ~Car();
@@ -167,6 +172,13 @@ public:
 
     CarSoundEffectManagerPtr soundEffectManager() const;
 
+    /*! Save the controls, the wear and the route state into the given buffer.
+     *  The transforms and the motion are saved by MCWorld. */
+    void saveState(MCStateBuffer & state) const;
+
+    //! Restore the state saved with saveState().
+    void restoreState(MCStateBuffer & state);
+
 private:
 
     void initForceGenerators(Description & desc);
@@ -177,10 +189,23 @@ private:
 
     void updateTireWear(int step);
 
+    void updateTires(int step);
+
     void wearOutTires(int step, float factor);
 
+    //! Indices of the tires in m_tires.
+    enum TireIndex
+    {
+        LeftFrontTire,
+        RightFrontTire,
+        LeftRearTire,
+        RightRearTire
+    };
+
     Description m_desc;
 
+    MCWorld & m_world;
+
     MCForceGeneratorPtr m_onTrackFriction;
 
     bool m_leftSideOffTrack;
@@ -237,6 +262,9 @@ private:
 
     CarSoundEffectManagerPtr m_soundEffectManager;
 
+    std::vector<Tire> m_tires;
+
+    //! Render-only child objects that draw the tires.
     MCObjectPtr m_leftFrontTire;
 
     MCObjectPtr m_rightFrontTire;
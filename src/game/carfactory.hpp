@@ -19,8 +19,10 @@
 #include "car.hpp"
 #include "game.hpp"
 
+class MCWorld;
+
 namespace CarFactory {
-CarPtr buildCar(int index, int numCars, Game & game);
+CarPtr buildCar(int index, int numCars, Game & game, MCWorld & world);
 }
 
 #endif // CARFACTORY_HPP
@@ -15,11 +15,14 @@
 
 #include "carparticleeffectmanager.hpp"
 #include "car.hpp"
+#include "randomstreams.hpp"
 
+#include <cassert>
 #include <cmath>
 #include <MCCollisionEvent>
 #include <MCPhysicsComponent>
-#include <MCRandom>
+#include <MCRandomStream>
+#include <MCWorld>
 
 namespace {
 static const int SKID_MARK_DENSITY = 8;
@@ -80,7 +83,8 @@ void CarParticleEffectManager::doRightSkidMark(ParticleFactory::ParticleType typ
 
 void CarParticleEffectManager::doDamageSmoke()
 {
-    if (m_car.damageLevel() <= 0.3f && MCRandom::getValue() > m_car.damageLevel())
+    assert(m_car.world());
+    if (m_car.damageLevel() <= 0.3f && m_car.world()->randomStream(RandomStreams::Particles).getValue() > m_car.damageLevel())
     {
         MCVector3dF smokeLocation = (m_car.leftFrontTireLocation() + m_car.rightFrontTireLocation()) * 0.5f;
         ParticleFactory::instance().doParticle(ParticleFactory::DamageSmoke, smokeLocation);
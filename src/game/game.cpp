@@ -38,14 +38,25 @@
 #include <QDesktopWidget>
 #include <QDir>
 #include <QThread>
-#include <QTime>
 #include <QScreen>
 #include <QSurfaceFormat>
 
+#include <algorithm>
 #include <cassert>
+#include <cstdlib>
+#include <random>
 
 static const unsigned int MAX_PLAYERS = 2;
 
+// Limits the physics steps run on a single frame. The time beyond that is dropped, so that a slow
+// machine slows the game down instead of falling further and further behind.
+static const int MAX_STEPS_PER_FRAME = 5;
+
+// Ticks of a race recorded with scripted input, and the tick on which it starts. The start
+// tick matches the duration of the startlights.
+static const unsigned int FAST_RECORD_TICKS = 1800;
+static const unsigned int FAST_RECORD_START_TICK = 240;
+
 Game * Game::m_instance = nullptr;
 
 Game::Game(int & argc, char ** argv)
@@ -65,6 +76,8 @@ Game::Game(int & argc, char ** argv)
 , m_timeStep(1000 / m_updateFps)
 , m_lapCount(m_settings.loadValue(Settings::lapCountKey(), 5))
 , m_paused(false)
+, m_timeAccumulator(0)
+, m_stepsPerFrame(0)
 , m_renderElapsed(0)
 , m_fps(m_settings.loadValue(Settings::fpsKey()) == 30 ? Fps::Fps30 : Fps::Fps60)
 , m_mode(Mode::OnePlayerRace)
@@ -72,7 +85,7 @@ Game::Game(int & argc, char ** argv)
 , m_audioWorker(new AudioWorker(
       Scene::NUM_CARS, Settings::instance().loadValue(Settings::soundsKey(), true)))
 , m_audioThread(new QThread)
-, m_world(new MCWorld)
+, m_world(new MCWorld(new MCWorldRenderer))
 {
     assert(!Game::m_instance);
     Game::m_instance = this;
@@ -98,14 +111,9 @@ Game::Game(int & argc, char ** argv)
 
     connect(m_eventHandler, &EventHandler::soundRequested, m_audioWorker, &AudioWorker::playSound);
 
-    connect(&m_updateTimer, &QTimer::timeout, [this] () {
-        m_stateMachine->update();
-        m_scene->updateFrame(*m_inputHandler, m_timeStep);
-        m_scene->updateOverlays();
-        m_renderer->renderNow();
-    });
+    connect(&m_updateTimer, &QTimer::timeout, this, &Game::updateFrame);
 
-    m_updateTimer.setInterval(m_updateDelay);
+    setFps(m_fps);
 
     connect(m_stateMachine, &StateMachine::exitGameRequested, this, &Game::exitGame);
 
@@ -114,8 +122,6 @@ Game::Game(int & argc, char ** argv)
         QDir::separator() + "levels");
     m_trackLoader->addTrackSearchPath(QDir::homePath() + QDir::separator() +
         Config::Common::TRACK_SEARCH_PATH);
-
-    m_elapsed.start();
 }
 
 Game & Game::instance()
@@ -133,6 +139,10 @@ static void printHelp()
     std::cout << "--screen [index]  Force a certain screen on multi-display setups." << std::endl;
     std::cout << "--lang [lang]     Force language: fi, fr, it, cs." << std::endl;
     std::cout << "--no-vsync        Force vsync off." << std::endl;
+    std::cout << "--record [file]   Record the input of the next race into a replay file." << std::endl;
+    std::cout << "--replay [file]   Play the race recorded with --record and compare the result." << std::endl;
+    std::cout << "--fast            Play the replay without rendering as fast as possible. With" << std::endl;
+    std::cout << "                  --record, record a short race with scripted input instead." << std::endl;
     std::cout << std::endl;
 }
 
@@ -179,6 +189,18 @@ void Game::parseArgs(int argc, char ** argv)
         {
             m_forceNoVSync = true;
         }
+        else if (args[i] == "--record" && (i + 1) < args.size())
+        {
+            m_recordFileName = args[i + 1];
+        }
+        else if (args[i] == "--replay" && (i + 1) < args.size())
+        {
+            m_replayFileName = args[i + 1];
+        }
+        else if (args[i] == "--fast")
+        {
+            m_isFast = true;
+        }
     }
 
     initTranslations(m_appTranslator, m_app, lang);
@@ -379,6 +401,18 @@ void Game::initScene()
     // Set the current game scene. Renderer calls render()
     // for all objects in the scene.
     m_renderer->setScene(*m_scene);
+
+    if (!m_recordFileName.isEmpty())
+    {
+        connect(m_scene, &Scene::activeTrackChanged, this, &Game::startRecording);
+
+        connect(m_scene, &Scene::raceStarted, [this] () {
+            if (m_isRecording)
+            {
+                m_replay.recordRaceStart();
+            }
+        });
+    }
 }
 
 void Game::init()
@@ -399,12 +433,24 @@ void Game::init()
         throw std::runtime_error("Couldn't load tracks.");
     }
 
-    start();
+    if (!m_replayFileName.isEmpty())
+    {
+        startReplay();
+    }
+    else if (!m_recordFileName.isEmpty() && m_isFast)
+    {
+        startFastRecording();
+    }
+    else
+    {
+        start();
+    }
 }
 
 void Game::start()
 {
     m_paused = false;
+    m_frameTimer.start();
     m_updateTimer.start();
 }
 
@@ -422,6 +468,259 @@ Game::Fps Game::fps() const
 void Game::setFps(Game::Fps fps)
 {
     m_fps = fps;
+
+    m_updateDelay = 1000 / (fps == Fps::Fps30 ? 30 : 60);
+    m_updateTimer.setInterval(m_updateDelay);
+}
+
+int Game::stepsPerFrame() const
+{
+    return m_stepsPerFrame;
+}
+
+void Game::updateFrame()
+{
+    // Run the physics and game logic in fixed steps. The time that doesn't
+    // fill a whole step is carried over to the next frame.
+    m_timeAccumulator += static_cast<float>(m_frameTimer.nsecsElapsed()) / 1000000;
+    m_frameTimer.start();
+    m_timeAccumulator = std::min(m_timeAccumulator, MAX_STEPS_PER_FRAME * m_timeStep);
+
+    m_stepsPerFrame = 0;
+    while (m_timeAccumulator >= m_timeStep)
+    {
+        if (m_isReplaying)
+        {
+            if (!stepReplay())
+            {
+                finishReplay();
+                return;
+            }
+        }
+        else
+        {
+            stepScene();
+        }
+
+        m_scene->updateOverlays();
+
+        m_timeAccumulator -= m_timeStep;
+        m_stepsPerFrame++;
+    }
+
+    // Render the state between the last two steps
+    m_scene->setRenderInterpolation(m_timeAccumulator / m_timeStep);
+    m_renderer->renderNow();
+}
+
+void Game::stepScene()
+{
+    m_stateMachine->update();
+
+    if (m_isRecording)
+    {
+        recordTick();
+    }
+
+    m_scene->updateFrame(*m_inputHandler, m_timeStep);
+}
+
+void Game::startRecording()
+{
+    Replay::Settings settings;
+    settings.trackName = m_scene->activeTrack().trackData().name();
+    settings.lapCount = m_lapCount;
+    settings.mode = static_cast<int>(m_mode);
+    settings.difficulty = static_cast<int>(m_difficultyProfile.difficulty());
+    settings.seed = std::random_device()();
+    settings.timeStep = static_cast<int>(m_timeStep);
+
+    // The AI and the particles must get the same random values when replaying.
+    // The track has just been activated, so the world hasn't been stepped yet.
+    m_world->setRandomSeed(settings.seed);
+
+    m_replay.startRecording(settings);
+    m_isRecording = true;
+
+    MCLogger().info() << "Recording the race to " << m_recordFileName.toStdString();
+}
+
+void Game::recordTick()
+{
+    // Record every tick on which the scene steps the world. The race is over when the
+    // state machine leaves the race.
+    switch (m_stateMachine->state())
+    {
+    case StateMachine::State::GameTransitionIn:
+    case StateMachine::State::DoStartlights:
+    case StateMachine::State::Play:
+        m_replay.record(*m_inputHandler);
+        break;
+    case StateMachine::State::GameTransitionOut:
+        stopRecording();
+        break;
+    default:
+        // The menu is still fading out
+        break;
+    }
+}
+
+void Game::stopRecording()
+{
+    m_isRecording = false;
+    m_replay.setResult(m_scene->carTransforms());
+
+    if (m_replay.save(m_recordFileName))
+    {
+        MCLogger().info() << "Recorded " << m_replay.tickCount() << " ticks to " << m_recordFileName.toStdString();
+    }
+    else
+    {
+        MCLogger().error() << "Failed to save the replay to " << m_recordFileName.toStdString();
+        m_exitCode = EXIT_FAILURE;
+    }
+}
+
+void Game::startReplay()
+{
+    if (!m_replay.load(m_replayFileName))
+    {
+        throw std::runtime_error("Couldn't load replay " + m_replayFileName.toStdString());
+    }
+
+    const Replay::Settings & settings = m_replay.settings();
+    Track * track = nullptr;
+    for (unsigned int i = 0; i < m_trackLoader->tracks(); i++)
+    {
+        if (m_trackLoader->track(i)->trackData().name() == settings.trackName)
+        {
+            track = m_trackLoader->track(i);
+        }
+    }
+
+    if (!track)
+    {
+        throw std::runtime_error("Couldn't find track " + settings.trackName.toStdString() + " of the replay.");
+    }
+
+    MCLogger().info() << "Replaying " << m_replay.tickCount() << " ticks on " << settings.trackName.toStdString();
+
+    m_mode = static_cast<Mode>(settings.mode);
+    m_lapCount = settings.lapCount;
+    m_difficultyProfile.setDifficulty(static_cast<DifficultyProfile::Difficulty>(settings.difficulty));
+    m_timeStep = settings.timeStep;
+
+    // Skip the menus and the transitions. They run on timers, and the only thing they change
+    // in the simulation is the start of the race, which is replayed on the recorded tick.
+    m_scene->setActiveTrack(*track);
+    m_stateMachine->beginReplay();
+
+    m_world->setRandomSeed(settings.seed);
+
+    m_isReplaying = true;
+    m_replayTimer.start();
+
+    if (m_isFast)
+    {
+        QTimer::singleShot(0, this, &Game::runFastReplay);
+    }
+    else
+    {
+        start();
+    }
+}
+
+bool Game::stepReplay()
+{
+    if (m_replay.isRaceStartTick())
+    {
+        m_scene->startRace();
+    }
+
+    if (!m_replay.play(*m_inputHandler))
+    {
+        return false;
+    }
+
+    stepScene();
+    return true;
+}
+
+void Game::runFastReplay()
+{
+    while (stepReplay())
+    {
+    }
+
+    finishReplay();
+}
+
+void Game::startFastRecording()
+{
+    Track * track = m_trackLoader->track(0);
+    assert(track);
+
+    MCLogger().info() << "Recording a scripted race on " << track->trackData().name().toStdString();
+
+    // Activating the track starts the recording
+    m_scene->setActiveTrack(*track);
+    m_stateMachine->beginReplay();
+
+    QTimer::singleShot(0, this, &Game::runFastRecording);
+}
+
+void Game::runFastRecording()
+{
+    for (unsigned int tick = 0; tick < FAST_RECORD_TICKS && m_isRecording; tick++)
+    {
+        if (tick == FAST_RECORD_START_TICK)
+        {
+            m_scene->startRace();
+        }
+
+        // Full throttle with a left turn every four seconds
+        m_inputHandler->setActionState(0, InputHandler::Action::Up, true);
+        m_inputHandler->setActionState(0, InputHandler::Action::Left, tick % 240 < 40);
+
+        stepScene();
+    }
+
+    if (m_isRecording)
+    {
+        stopRecording();
+    }
+
+    exitGame();
+}
+
+void Game::finishReplay()
+{
+    m_isReplaying = false;
+
+    const float simulatedSecs = m_replay.tickCount() * m_timeStep / 1000;
+    const float wallSecs = static_cast<float>(m_replayTimer.nsecsElapsed()) / 1000000000;
+    MCLogger().info() << "Replayed " << simulatedSecs << " s in " << wallSecs << " s ("
+                      << (wallSecs > 0 ? simulatedSecs / wallSecs : 0) << " simulated s per s)";
+
+    const std::vector<float> result = m_scene->carTransforms();
+    if (result == m_replay.result())
+    {
+        MCLogger().info() << "Replay matches the recording.";
+    }
+    else
+    {
+        unsigned int mismatches = 0;
+        const std::vector<float> & recorded = m_replay.result();
+        for (unsigned int i = 0; i + 2 < result.size() && i + 2 < recorded.size(); i += 3)
+        {
+            mismatches += result[i] != recorded[i] || result[i + 1] != recorded[i + 1] || result[i + 2] != recorded[i + 2];
+        }
+
+        MCLogger().error() << "Replay doesn't match the recording: " << mismatches << " car(s) differ.";
+        m_exitCode = EXIT_FAILURE;
+    }
+
+    exitGame();
 }
 
 void Game::togglePause()
@@ -447,7 +746,7 @@ void Game::exitGame()
     m_audioThread->quit();
     m_audioThread->wait();
 
-    m_app.quit();
+    m_app.exit(m_exitCode);
 }
 
 Game::~Game()
@@ -16,14 +16,15 @@
 #ifndef GAME_HPP
 #define GAME_HPP
 
+#include <QElapsedTimer>
 #include <QObject>
 #include <QTimer>
-#include <QTime>
 #include <QTranslator>
 
 #include <MCWorld>
 
 #include "application.hpp"
+#include "replay.hpp"
 #include "settings.hpp"
 
 class AudioWorker;
@@ -91,10 +92,14 @@ public:
     //! Get the split type.
     SplitType splitType() const;
 
+    //! Set the render rate. Physics is always updated at a fixed rate.
     void setFps(Fps fps);
 
     Fps fps() const;
 
+    //! \return number of physics steps run on the latest frame.
+    int stepsPerFrame() const;
+
     //! Set the lap count.
     void setLapCount(int lapCount);
 
@@ -127,6 +132,14 @@ private slots:
 
     void togglePause();
 
+    void startRecording();
+
+    //! Play the whole replay without rendering and exit.
+    void runFastReplay();
+
+    //! Record the whole scripted race without rendering and exit.
+    void runFastRecording();
+
 private:
 
     void adjustSceneSize(int hRes, int vRes);
@@ -143,6 +156,28 @@ private:
 
     void stop();
 
+    void updateFrame();
+
+    //! Run one step of the game logic and the scene with the current input.
+    void stepScene();
+
+    //! Start the race of the replay given with --replay.
+    void startReplay();
+
+    //! Start a race with scripted input on the first track, used with --record and --fast.
+    void startFastRecording();
+
+    //! Record the current input, or stop recording once the race is over.
+    void recordTick();
+
+    void stopRecording();
+
+    //! Update the scene with the input of the next replay tick. \return false at the end.
+    bool stepReplay();
+
+    //! Compare the car transforms with the recording, log the throughput and exit.
+    void finishReplay();
+
     Application m_app;
 
     QTranslator m_appTranslator;
@@ -181,7 +216,12 @@ private:
 
     QTimer m_updateTimer;
 
-    QTime m_elapsed;
+    QElapsedTimer m_frameTimer;
+
+    //! Time in ms not yet simulated.
+    float m_timeAccumulator;
+
+    int m_stepsPerFrame;
 
     int m_renderElapsed;
 
@@ -197,6 +237,23 @@ private:
 
     MCWorld * m_world;
 
+    Replay m_replay;
+
+    QString m_recordFileName;
+
+    QString m_replayFileName;
+
+    bool m_isRecording = false;
+
+    bool m_isReplaying = false;
+
+    //! Record or replay without rendering, see --fast.
+    bool m_isFast = false;
+
+    QElapsedTimer m_replayTimer;
+
+    int m_exitCode = 0;
+
     static Game * m_instance;
 };
 
@@ -68,7 +68,6 @@ HEADERS += \
     ai.hpp \
     application.hpp \
     bridge.hpp \
-    bridgetrigger.hpp \
     car.hpp \
     carfactory.hpp \
     carparticleeffectmanager.hpp \
@@ -95,8 +94,10 @@ HEADERS += \
     particlefactory.hpp \
     pit.hpp \
     race.hpp \
+    randomstreams.hpp \
     renderable.hpp \
     renderer.hpp \
+    replay.hpp \
     scene.hpp \
     settings.hpp \
     shaders.h \
@@ -144,7 +145,8 @@ HEADERS += \
     MiniCore/src/Core/mcobjectdata.hh \
     MiniCore/src/Core/mcobjectfactory.hh \
     MiniCore/src/Core/mcrandom.hh \
-    MiniCore/src/Core/mcrecycler.hh \
+    MiniCore/src/Core/mcrandomstream.hh \
+    MiniCore/src/Core/mcstatebuffer.hh \
     MiniCore/src/Core/mctimerevent.hh \
     MiniCore/src/Core/mctrigonom.hh \
     MiniCore/src/Core/mctypes.hh \
@@ -152,7 +154,10 @@ HEADERS += \
     MiniCore/src/Core/mcvector2d.hh \
     MiniCore/src/Core/mcvector3d.hh \
     MiniCore/src/Core/mcvectoranimation.hh \
+    MiniCore/src/Core/mcvectorbatch.hh \
+    MiniCore/src/Core/mcworkerpool.hh \
     MiniCore/src/Core/mcworld.hh \
+    MiniCore/src/Core/mcworldrendererbase.hh \
     MiniCore/src/Graphics/mccamera.hh \
     MiniCore/src/Graphics/mcglambientlight.hh \
     MiniCore/src/Graphics/mcglcolor.hh \
@@ -182,7 +187,10 @@ HEADERS += \
     MiniCore/src/Physics/mccircleshape.hh \
     MiniCore/src/Physics/mccollisiondetector.hh \
     MiniCore/src/Physics/mccollisionevent.hh \
+    MiniCore/src/Physics/mccollisionfilter.hh \
     MiniCore/src/Physics/mccontact.hh \
+    MiniCore/src/Physics/mccontactarena.hh \
+    MiniCore/src/Physics/mccontactevent.hh \
     MiniCore/src/Physics/mcdragforcegenerator.hh \
     MiniCore/src/Physics/mcedge.hh \
     MiniCore/src/Physics/mcforcegenerator.hh \
@@ -190,14 +198,19 @@ HEADERS += \
     MiniCore/src/Physics/mcfrictiongenerator.hh \
     MiniCore/src/Physics/mcgravitygenerator.hh \
     MiniCore/src/Physics/mcimpulsegenerator.hh \
+    MiniCore/src/Physics/mcislandmanager.hh \
     MiniCore/src/Physics/mcobjectgrid.hh \
     MiniCore/src/Physics/mcoutofboundariesevent.hh \
+    MiniCore/src/Physics/mcpaircache.hh \
     MiniCore/src/Physics/mcphysicscomponent.hh \
+    MiniCore/src/Physics/mcphysicsstate.hh \
     MiniCore/src/Physics/mcrectshape.hh \
     MiniCore/src/Physics/mcsegment.hh \
     MiniCore/src/Physics/mcshape.hh \
     MiniCore/src/Physics/mcspringforcegenerator.hh \
     MiniCore/src/Physics/mcspringforcegenerator2dfast.hh \
+    MiniCore/src/Physics/mcsweepandprune.hh \
+    MiniCore/src/Physics/mctriggervolume.hh \
     MiniCore/src/Text/mctexturefont.hh \
     MiniCore/src/Text/mctexturefontconfigloader.hh \
     MiniCore/src/Text/mctexturefontdata.hh \
@@ -241,7 +254,6 @@ SOURCES += \
     ai.cpp \
     application.cpp \
     bridge.cpp \
-    bridgetrigger.cpp \
     car.cpp \
     carfactory.cpp \
     carparticleeffectmanager.cpp \
@@ -268,6 +280,7 @@ SOURCES += \
     pit.cpp \
     race.cpp \
     renderer.cpp \
+    replay.cpp \
     scene.cpp \
     settings.cpp \
     startlights.cpp \
@@ -305,10 +318,14 @@ SOURCES += \
     MiniCore/src/Core/mcobjectdata.cc \
     MiniCore/src/Core/mcobjectfactory.cc \
     MiniCore/src/Core/mcrandom.cc \
+    MiniCore/src/Core/mcrandomstream.cc \
+    MiniCore/src/Core/mcstatebuffer.cc \
     MiniCore/src/Core/mctimerevent.cc \
     MiniCore/src/Core/mctrigonom.cc \
     MiniCore/src/Core/mctyperegistry.cc \
     MiniCore/src/Core/mcvectoranimation.cc \
+    MiniCore/src/Core/mcvectorbatch.cc \
+    MiniCore/src/Core/mcworkerpool.cc \
     MiniCore/src/Core/mcworld.cc \
     MiniCore/src/Graphics/mccamera.cc \
     MiniCore/src/Graphics/mcglambientlight.cc \
@@ -333,20 +350,28 @@ SOURCES += \
     MiniCore/src/Physics/mccircleshape.cc \
     MiniCore/src/Physics/mccollisiondetector.cc \
     MiniCore/src/Physics/mccollisionevent.cc \
+    MiniCore/src/Physics/mccollisionfilter.cc \
     MiniCore/src/Physics/mccontact.cc \
+    MiniCore/src/Physics/mccontactarena.cc \
+    MiniCore/src/Physics/mccontactevent.cc \
     MiniCore/src/Physics/mcdragforcegenerator.cc \
     MiniCore/src/Physics/mcforcegenerator.cc \
     MiniCore/src/Physics/mcforceregistry.cc \
     MiniCore/src/Physics/mcfrictiongenerator.cc \
     MiniCore/src/Physics/mcgravitygenerator.cc \
     MiniCore/src/Physics/mcimpulsegenerator.cc \
+    MiniCore/src/Physics/mcislandmanager.cc \
     MiniCore/src/Physics/mcobjectgrid.cc \
     MiniCore/src/Physics/mcoutofboundariesevent.cc \
+    MiniCore/src/Physics/mcpaircache.cc \
     MiniCore/src/Physics/mcphysicscomponent.cc \
+    MiniCore/src/Physics/mcphysicsstate.cc \
     MiniCore/src/Physics/mcrectshape.cc \
     MiniCore/src/Physics/mcshape.cc \
     MiniCore/src/Physics/mcspringforcegenerator.cc \
     MiniCore/src/Physics/mcspringforcegenerator2dfast.cc \
+    MiniCore/src/Physics/mcsweepandprune.cc \
+    MiniCore/src/Physics/mctriggervolume.cc \
     MiniCore/src/Text/mctexturefont.cc \
     MiniCore/src/Text/mctexturefontconfigloader.cc \
     MiniCore/src/Text/mctexturefontdata.cc \
@@ -33,6 +33,11 @@ void InputHandler::setActionState(unsigned int playerIndex, Action action, bool
     m_playerActions[playerIndex][static_cast<int>(action)] = state;
 }
 
+unsigned int InputHandler::playerCount() const
+{
+    return static_cast<unsigned int>(m_playerActions.size());
+}
+
 void InputHandler::setEnabled(bool state)
 {
     m_enabled = state;
@@ -45,6 +45,9 @@ public:
     //! Get state of the given action of the given player.
     bool getActionState(unsigned int playerIndex, Action action) const;
 
+    //! \return the number of players.
+    unsigned int playerCount() const;
+
     //! Reset the current actions.
     void reset();
 
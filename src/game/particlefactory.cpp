@@ -14,6 +14,7 @@
 // along with Dust Racing 2D. If not, see <http://www.gnu.org/licenses/>.
 
 #include "particlefactory.hpp"
+#include "randomstreams.hpp"
 
 #include "renderer.hpp"
 #include "layers.hpp"
@@ -22,7 +23,7 @@
 #include <MCGLColor>
 #include <MCParticle>
 #include <MCPhysicsComponent>
-#include <MCRandom>
+#include <MCRandomStream>
 #include <MCSurfaceParticle>
 #include <MCSurfaceParticleRenderer>
 #include <MCWorld>
@@ -32,7 +33,8 @@
 
 ParticleFactory * ParticleFactory::m_instance = nullptr;
 
-ParticleFactory::ParticleFactory()
+ParticleFactory::ParticleFactory(MCWorld & world)
+    : m_world(world)
 {
     assert(!ParticleFactory::m_instance);
     ParticleFactory::m_instance = this;
@@ -45,6 +47,11 @@ ParticleFactory & ParticleFactory::instance()
     return *ParticleFactory::m_instance;
 }
 
+MCRandomStream & ParticleFactory::randomStream() const
+{
+    return m_world.randomStream(RandomStreams::Particles);
+}
+
 void ParticleFactory::preCreateSurfaceParticles(
     int count, std::string typeId, ParticleFactory::ParticleType typeEnum, MCSurface & surface, bool alphaBlend, bool hasShadow)
 {
@@ -152,9 +159,9 @@ void ParticleFactory::doDamageSmoke(MCVector3dFR location, MCVector3dFR velocity
         smoke->init(location + MCVector3dF(0, 0, 10), 12, 3000);
         smoke->setColor(MCGLColor(0.1f, 0.1f, 0.1f, 0.25f));
         smoke->setAnimationStyle(MCParticle::AnimationStyle::FadeOutAndExpand);
-        smoke->rotate(MCRandom::getValue() * 360);
-        smoke->physicsComponent().setVelocity(velocity + MCRandom::randomVector3dPositiveZ() * 0.2f);
-        smoke->addToWorld();
+        smoke->rotate(randomStream().getValue() * 360);
+        smoke->physicsComponent().setVelocity(velocity + randomStream().randomVector3dPositiveZ() * 0.2f);
+        smoke->addToWorld(m_world);
     }
 }
 
@@ -165,9 +172,9 @@ void ParticleFactory::doSkidSmoke(MCVector3dFR location, MCVector3dFR velocity)
         smoke->init(location + MCVector3dF(0, 0, 5), 6, 3000);
         smoke->setColor(MCGLColor(1.0f, 1.0f, 1.0f, 0.1f));
         smoke->setAnimationStyle(MCParticle::AnimationStyle::FadeOutAndExpand);
-        smoke->rotate(MCRandom::getValue() * 360);
-        smoke->physicsComponent().setVelocity(velocity + MCRandom::randomVector3dPositiveZ() * 0.1f);
-        smoke->addToWorld();
+        smoke->rotate(randomStream().getValue() * 360);
+        smoke->physicsComponent().setVelocity(velocity + randomStream().randomVector3dPositiveZ() * 0.1f);
+        smoke->addToWorld(m_world);
     }
 }
 
@@ -178,9 +185,9 @@ void ParticleFactory::doSmoke(MCVector3dFR location, MCVector3dFR velocity) cons
         smoke->init(location + MCVector3dF(0, 0, 10), 12, 3000);
         smoke->setColor(MCGLColor(0.75f, 0.75f, 0.75f, 0.15f));
         smoke->setAnimationStyle(MCParticle::AnimationStyle::FadeOutAndExpand);
-        smoke->rotate(MCRandom::getValue() * 360);
-        smoke->physicsComponent().setVelocity(velocity + MCRandom::randomVector3dPositiveZ() * 0.1f);
-        smoke->addToWorld();
+        smoke->rotate(randomStream().getValue() * 360);
+        smoke->physicsComponent().setVelocity(velocity + randomStream().randomVector3dPositiveZ() * 0.1f);
+        smoke->addToWorld(m_world);
     }
 }
 
@@ -191,9 +198,9 @@ void ParticleFactory::doOffTrackSmoke(MCVector3dFR location) const
         smoke->init(location + MCVector3dF(0, 0, 10), 15, 3000);
         smoke->setColor(MCGLColor(0.6f, 0.4f, 0.0f, 0.25f));
         smoke->setAnimationStyle(MCParticle::AnimationStyle::FadeOut);
-        smoke->rotate(MCRandom::getValue() * 360);
-        smoke->physicsComponent().setVelocity(MCRandom::randomVector3dPositiveZ() * 0.1f);
-        smoke->addToWorld();
+        smoke->rotate(randomStream().getValue() * 360);
+        smoke->physicsComponent().setVelocity(randomStream().randomVector3dPositiveZ() * 0.1f);
+        smoke->addToWorld(m_world);
     }
 }
 
@@ -207,7 +214,7 @@ void ParticleFactory::doOnTrackSkidMark(MCVector3dFR location, int angle) const
         skidMark->rotate(angle);
         skidMark->physicsComponent().setVelocity(MCVector3dF(0, 0, 0));
         skidMark->physicsComponent().setAcceleration(MCVector3dF(0, 0, 0));
-        skidMark->addToWorld();
+        skidMark->addToWorld(m_world);
     }
 }
 
@@ -221,7 +228,7 @@ void ParticleFactory::doOffTrackSkidMark(MCVector3dFR location, int angle) const
         skidMark->rotate(angle);
         skidMark->physicsComponent().setVelocity(MCVector3dF(0, 0, 0));
         skidMark->physicsComponent().setAcceleration(MCVector3dF(0, 0, 0));
-        skidMark->addToWorld();
+        skidMark->addToWorld(m_world);
     }
 }
 
@@ -230,12 +237,12 @@ void ParticleFactory::doMud(MCVector3dFR location, MCVector3dFR velocity) const
     if (MCSurfaceParticle * mud = newSurfaceParticle(Mud))
     {
         mud->init(location, 12, 3000);
-        mud->rotate(MCRandom::getValue() * 360);
+        mud->rotate(randomStream().getValue() * 360);
         mud->setColor(MCGLColor(1.0f, 1.0f, 1.0f, 0.5f));
         mud->setAnimationStyle(MCParticle::AnimationStyle::Shrink);
         mud->physicsComponent().setVelocity(velocity + MCVector3dF(0, 0, 4.0f));
-        mud->physicsComponent().setAcceleration(MCWorld::instance().gravity());
-        mud->addToWorld();
+        mud->physicsComponent().setAcceleration(m_world.gravity());
+        mud->addToWorld(m_world);
     }
 }
 
@@ -243,12 +250,12 @@ void ParticleFactory::doSparkle(MCVector3dFR location, MCVector3dFR velocity) co
 {
     if (MCSurfaceParticle * sparkle = ParticleFactory::newSurfaceParticle(Sparkle))
     {
-        sparkle->init(location, 2 + MCRandom::getValue() * 2, 1500);
+        sparkle->init(location, 2 + randomStream().getValue() * 2, 1500);
         sparkle->setColor(MCGLColor(1.0f, 1.0f, 1.0f, 0.33f));
         sparkle->setAnimationStyle(MCParticle::AnimationStyle::Shrink);
         sparkle->physicsComponent().setVelocity(velocity + MCVector3dF(0, 0, 4.0f));
-        sparkle->physicsComponent().setAcceleration(MCWorld::instance().gravity() * 0.5f);
-        sparkle->addToWorld();
+        sparkle->physicsComponent().setAcceleration(m_world.gravity() * 0.5f);
+        sparkle->addToWorld(m_world);
     }
 }
 
@@ -258,13 +265,13 @@ void ParticleFactory::doLeaf(MCVector3dFR location, MCVector3dFR velocity) const
     {
         leaf->init(location, 5, 3000);
         leaf->setAnimationStyle(MCParticle::AnimationStyle::Shrink);
-        leaf->rotate(MCRandom::getValue() * 360);
+        leaf->rotate(randomStream().getValue() * 360);
         leaf->setColor(MCGLColor(0.0, 0.75f, 0.0, 0.75f));
-        leaf->physicsComponent().setVelocity(velocity + MCVector3dF(0, 0, 2.0f) + MCRandom::randomVector3d() * 0.5f);
-        leaf->physicsComponent().setAngularVelocity((MCRandom::getValue() - 0.5) * 5.0f);
+        leaf->physicsComponent().setVelocity(velocity + MCVector3dF(0, 0, 2.0f) + randomStream().randomVector3d() * 0.5f);
+        leaf->physicsComponent().setAngularVelocity((randomStream().getValue() - 0.5) * 5.0f);
         leaf->physicsComponent().setMomentOfInertia(1.0f);
         leaf->physicsComponent().setAcceleration(MCVector3dF(0, 0, -2.5f));
-        leaf->addToWorld();
+        leaf->addToWorld(m_world);
     }
 }
 
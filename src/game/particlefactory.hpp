@@ -24,7 +24,9 @@
 #include <vector>
 #include <memory>
 
+class MCRandomStream;
 class MCSurfaceParticle;
+class MCWorld;
 
 //! ParticleFactory takes care of spawning and recycling particles.
 class ParticleFactory
@@ -45,8 +47,9 @@ public:
         NumParticleTypes
     };
 
-    //! Constructor.
-    ParticleFactory();
+    /*! Constructor.
+     *  \param world The world the particles are added to. */
+    ParticleFactory(MCWorld & world);
 
     //! Destructor.
     ~ParticleFactory();
@@ -86,6 +89,8 @@ private:
 
     MCSurfaceParticle * newSurfaceParticle(ParticleType typeEnum) const;
 
+    MCRandomStream & randomStream() const;
+
     // Free lists (recycling) for different types of particles.
     mutable MCParticle::ParticleFreeList m_freeLists[NumParticleTypes];
 
@@ -95,6 +100,8 @@ private:
     // Particles to delete.
     std::vector<std::unique_ptr<MCParticle> > m_delete;
 
+    MCWorld & m_world;
+
     static ParticleFactory * m_instance;
 };
 
@@ -16,7 +16,6 @@
 #include "pit.hpp"
 #include "car.hpp"
 
-#include <MCCollisionEvent>
 #include <MCPhysicsComponent>
 #include <MCShape>
 #include <MCShapeView>
@@ -24,48 +23,36 @@
 
 Pit::Pit(MCSurface & surface)
 : MCObject(surface, "pit")
-, m_tag(0)
 {
     physicsComponent().setMass(1, true); // Stationary
     setIsPhysicsObject(false);
-    setIsTriggerObject(true);
     shape()->view()->setHasShadow(false);
+
+    // The pit area is an overlap-only volume instead of a trigger object
+    addTriggerVolume(MCTriggerVolumePtr(new MCTriggerVolume(surface.width(), surface.height(),
+        [this] (MCObject & object, MCTriggerVolume::Event event) {
+            triggerEvent(object, event);
+        })));
 }
 
-void Pit::collisionEvent(MCCollisionEvent & event)
+void Pit::triggerEvent(MCObject & object, MCTriggerVolume::Event event)
 {
     // Cache type id integers.
     static unsigned int carType = MCObject::typeId("car");
 
-    if (event.collidingObject().typeId() == carType)
+    if (object.typeId() == carType)
     {
-        Car & car = static_cast<Car &>(event.collidingObject());
-        if (car.isHuman() && car.speedInKmh() < 25)
+        Car & car = static_cast<Car &>(object);
+        if (event != MCTriggerVolume::Event::Exit && car.isHuman() && car.speedInKmh() < 25)
         {
-            if (m_pittingCars.find(&car) == m_pittingCars.end())
+            if (m_pittingCars.insert(&car).second)
             {
                 emit pitStop(car);
             }
-
-            m_pittingCars[&car] = m_tag;
-        }
-    }
-}
-
-void Pit::onStepTime(int)
-{
-    auto i = m_pittingCars.begin();
-    while (i != m_pittingCars.end())
-    {
-        if (i->second < m_tag)
-        {
-            i = m_pittingCars.erase(i);
         }
         else
         {
-            i++;
+            m_pittingCars.erase(&car);
         }
     }
-
-    m_tag++;
 }
@@ -17,11 +17,11 @@
 #define PIT_HPP
 
 #include <MCObject>
+#include <MCTriggerVolume>
 #include <QObject>
 
-#include <map>
+#include <set>
 
-class MCCollisionEvent;
 class MCSurface;
 class Car;
 
@@ -35,20 +35,15 @@ public:
     //! Constructor.
     Pit(MCSurface & surface);
 
-    //! \reimp
-    virtual void collisionEvent(MCCollisionEvent & event) override;
-
-    //! \reimp
-    virtual void onStepTime(int step) override;
-
 signals:
 
     void pitStop(Car & car);
 
 private:
 
-    std::map<Car *, int> m_pittingCars;
-    int                  m_tag;
+    void triggerEvent(MCObject & object, MCTriggerVolume::Event event);
+
+    std::set<Car *> m_pittingCars;
 };
 
 #endif // PIT_HPP
@@ -39,13 +39,14 @@
 #include <MCPhysicsComponent>
 #include <MCShape>
 #include <MCShapeView>
+#include <MCStateBuffer>
 #include <MCSurfaceManager>
 
 static const int HUMAN_PLAYER_INDEX1 = 0;
 static const int HUMAN_PLAYER_INDEX2 = 1;
 static const int UNLOCK_LIMIT        = 6; // Position required to unlock a new track
 
-Race::Race(Game & game, unsigned int numCars)
+Race::Race(Game & game, unsigned int numCars, MCWorld & world)
 : m_numCars(numCars)
 , m_lapCount(5)
 , m_timing(numCars)
@@ -57,6 +58,7 @@ Race::Race(Game & game, unsigned int numCars)
 , m_bestPos(-1)
 , m_offTrackCounter(0)
 , m_game(game)
+, m_world(world)
 {
     createStartGridObjects();
 
@@ -160,11 +162,11 @@ void placeCar(Car & car, float x, float y, int angle)
     car.rotate(angle);
 }
 
-void placeStartGrid(MCObject & grid, float x, float y, int angle)
+void placeStartGrid(MCWorld & world, MCObject & grid, float x, float y, int angle)
 {
     grid.translate(MCVector2dF(x, y));
     grid.rotate(angle);
-    grid.addToWorld();
+    grid.addToWorld(world);
 }
 
 void Race::translateCarsToStartPositions()
@@ -208,7 +210,7 @@ void Race::translateCarsToStartPositions()
                 const float rowPos = (i / 2) * spacing + (i % 2) * oddOffset;
                 const float colPos = (i % 2) * tileHeight / 3 - tileHeight / 6;
                 placeCar(*order.at(i), startTileX + rowPos, startTileY + colPos, 180);
-                placeStartGrid(*m_startGridObjects.at(i), startTileX + rowPos - gridOffset, startTileY + colPos, 180);
+                placeStartGrid(m_world, *m_startGridObjects.at(i), startTileX + rowPos - gridOffset, startTileY + colPos, 180);
             }
             break;
 
@@ -220,7 +222,7 @@ void Race::translateCarsToStartPositions()
                 const float rowPos = (i / 2) * spacing + (i % 2) * oddOffset;
                 const float colPos = (i % 2) * tileHeight / 3 - tileHeight / 6;
                 placeCar(*order.at(i), startTileX - rowPos, startTileY + colPos, 0);
-                placeStartGrid(*m_startGridObjects.at(i), startTileX - rowPos + gridOffset, startTileY + colPos, 0);
+                placeStartGrid(m_world, *m_startGridObjects.at(i), startTileX - rowPos + gridOffset, startTileY + colPos, 0);
             }
             break;
 
@@ -230,7 +232,7 @@ void Race::translateCarsToStartPositions()
                 const float rowPos = (i % 2) * tileWidth / 3 - tileWidth / 6;
                 const float colPos = (i / 2) * spacing + (i % 2) * oddOffset;
                 placeCar(*order.at(i), startTileX + rowPos, startTileY - colPos, 90);
-                placeStartGrid(*m_startGridObjects.at(i), startTileX + rowPos, startTileY - colPos + gridOffset, 90);
+                placeStartGrid(m_world, *m_startGridObjects.at(i), startTileX + rowPos, startTileY - colPos + gridOffset, 90);
             }
             break;
 
@@ -241,7 +243,7 @@ void Race::translateCarsToStartPositions()
                 const float rowPos = (i % 2) * tileWidth  / 3 - tileWidth / 6;
                 const float colPos = (i / 2) * spacing + (i % 2) * oddOffset;
                 placeCar(*order.at(i), startTileX + rowPos, startTileY + colPos, 270);
-                placeStartGrid(*m_startGridObjects.at(i), startTileX + rowPos, startTileY + colPos - gridOffset, 270);
+                placeStartGrid(m_world, *m_startGridObjects.at(i), startTileX + rowPos, startTileY + colPos - gridOffset, 270);
             }
             break;
         }
@@ -659,6 +661,92 @@ Car & Race::getLoser() const
     return *bestCar;
 }
 
+void Race::saveState(MCStateBuffer & state) const
+{
+    state.write(m_started);
+    state.write(m_checkeredFlagEnabled);
+    state.write(m_winnerFinished);
+    state.write(m_isfinishedSignalSent);
+    state.write(m_bestPos);
+    state.write(m_offTrackCounter);
+
+    state.write(static_cast<unsigned int>(m_progression.size()));
+    for (auto && progression : m_progression)
+    {
+        state.write(progression.first);
+        state.writeVector(progression.second);
+    }
+
+    // Tiles are stored by their matrix location
+    for (auto && car : m_cars)
+    {
+        auto iter = m_stuckHash.find(car->index());
+        const bool hasTile = iter != m_stuckHash.end() && iter->second.first;
+        state.write(hasTile);
+        if (hasTile)
+        {
+            state.write(iter->second.first->matrixLocation().x());
+            state.write(iter->second.first->matrixLocation().y());
+            state.write(iter->second.second);
+        }
+    }
+
+    m_timing.saveState(state);
+
+    for (auto && car : m_cars)
+    {
+        car->saveState(state);
+    }
+}
+
+void Race::restoreState(MCStateBuffer & state)
+{
+    state.read(m_started);
+    state.read(m_checkeredFlagEnabled);
+    state.read(m_winnerFinished);
+    state.read(m_isfinishedSignalSent);
+    state.read(m_bestPos);
+    state.read(m_offTrackCounter);
+
+    m_progression.clear();
+    unsigned int progressionCount = 0;
+    state.read(progressionCount);
+    for (unsigned int i = 0; i < progressionCount && state.isValid(); i++)
+    {
+        int routeProgression = 0;
+        state.read(routeProgression);
+        state.readVector(m_progression[routeProgression]);
+    }
+
+    for (auto && car : m_cars)
+    {
+        auto && counter = m_stuckHash[car->index()];
+        counter = StuckTileCounter(nullptr, 0);
+
+        bool hasTile = false;
+        state.read(hasTile);
+        if (hasTile)
+        {
+            int x = 0;
+            int y = 0;
+            state.read(x);
+            state.read(y);
+            state.read(counter.second);
+            if (m_track && state.isValid())
+            {
+                counter.first = std::static_pointer_cast<TrackTile>(m_track->trackData().map().getTile(x, y));
+            }
+        }
+    }
+
+    m_timing.restoreState(state);
+
+    for (auto && car : m_cars)
+    {
+        car->restoreState(state);
+    }
+}
+
 void Race::setTrack(Track & track, int lapCount)
 {
     m_lapCount = lapCount;
@@ -30,6 +30,8 @@
 
 class Car;
 class Game;
+class MCStateBuffer;
+class MCWorld;
 class OffTrackDetector;
 class Route;
 class Track;
@@ -41,8 +43,9 @@ class Race : public AudioSource
 
 public:
 
-    //! Constructor.
-    Race(Game & game, unsigned int numCars);
+    /*! Constructor.
+     *  \param world The world the start grid is added to. */
+    Race(Game & game, unsigned int numCars, MCWorld & world);
 
     //! Destructor.
     virtual ~Race();
@@ -73,6 +76,13 @@ public:
     //! Get current leading car in the race
     Car & getLeader() const;
 
+    /*! Save the race flags, the positions, the timing and the state of the cars
+     *  into the given buffer. */
+    void saveState(MCStateBuffer & state) const;
+
+    //! Restore the state saved with saveState(). The cars must be the same.
+    void restoreState(MCStateBuffer & state);
+
 signals:
 
     void finished();
@@ -169,6 +179,8 @@ private:
     int m_offTrackCounter;
 
     Game & m_game;
+
+    MCWorld & m_world;
 };
 
 #endif // RACE_HPP
@@ -1,5 +1,5 @@
 // This file is part of Dust Racing 2D.
-// Copyright (C) 2014 Jussi Lind <jussi.lind@iki.fi>
+// Copyright (C) 2018 Jussi Lind <jussi.lind@iki.fi>
 //
 // Dust Racing 2D is free software: you can redistribute it and/or modify
 // it under the terms of the GNU General Public License as published by
@@ -13,25 +13,20 @@
 // You should have received a copy of the GNU General Public License
 // along with Dust Racing 2D. If not, see <http://www.gnu.org/licenses/>.
 
-#ifndef BRIDGETRIGGER_HPP
-#define BRIDGETRIGGER_HPP
+#ifndef RANDOMSTREAMS_HPP
+#define RANDOMSTREAMS_HPP
 
-#include <MCObject>
+namespace RandomStreams {
 
-class Bridge;
-
-class BridgeTrigger : public MCObject
+/*! Indices of the random streams of the world, see MCWorld::randomStream().
+ *  Each subsystem has its own stream so that e.g. the number of particles
+ *  doesn't change the decisions of the AI. */
+enum Stream : unsigned int
 {
-public:
-
-    BridgeTrigger(Bridge & bridge);
-
-    //! \reimp
-    virtual void collisionEvent(MCCollisionEvent & event) override;
-
-private:
-
-    Bridge & m_bridge;
+    AI        = 0,
+    Particles = 1
 };
 
-#endif // BRIDGETRIGGER_HPP
+}
+
+#endif // RANDOMSTREAMS_HPP
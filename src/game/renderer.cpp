@@ -60,7 +60,6 @@ Renderer::Renderer(int hRes, int vRes, bool fullScreen, MCGLScene & glScene)
 , m_vRes(vRes)
 , m_fullHRes(Game::instance().screen()->geometry().width())
 , m_fullVRes(Game::instance().screen()->geometry().height())
-, m_frameCounter(0)
 , m_fullScreen(fullScreen)
 , m_updatePending(false)
 , m_glScene(glScene)
@@ -331,14 +330,9 @@ void Renderer::renderNow()
         initialize();
     }
 
-    m_frameCounter++;
-    if (Game::instance().fps() == Game::Fps::Fps60 ||
-        (Game::instance().fps() == Game::Fps::Fps30 && m_frameCounter & 0x01))
-    {
-        render();
+    render();
 
-        m_context->swapBuffers(this);
-    }
+    m_context->swapBuffers(this);
 }
 
 void Renderer::resizeEvent(QResizeEvent * event)
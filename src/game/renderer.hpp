@@ -160,8 +160,6 @@ private:
 
     int m_fullVRes;
 
-    int m_frameCounter;
-
     bool m_fullScreen;
 
     bool m_updatePending;
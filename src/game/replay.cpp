@@ -0,0 +1,242 @@
+// This file is part of Dust Racing 2D.
+// Copyright (C) 2018 Jussi Lind <jussi.lind@iki.fi>
+//
+// Dust Racing 2D is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// Dust Racing 2D is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Dust Racing 2D. If not, see <http://www.gnu.org/licenses/>.
+
+#include "replay.hpp"
+#include "inputhandler.hpp"
+
+#include <QDataStream>
+#include <QFile>
+
+#include <algorithm>
+#include <limits>
+
+namespace
+{
+const quint32 MAGIC = 0x44523252; // "DR2R"
+const quint32 VERSION = 2;
+
+const unsigned int ACTION_COUNT = static_cast<unsigned int>(InputHandler::Action::EndOfEnum);
+
+// Actions of all players must fit in a byte
+const unsigned int MAX_PLAYERS = 8 / ACTION_COUNT;
+
+const unsigned int NO_RACE_START = std::numeric_limits<unsigned int>::max();
+}
+
+Replay::Replay()
+: m_tickCount(0)
+, m_raceStartTick(NO_RACE_START)
+, m_run(0)
+, m_runTick(0)
+, m_playedTicks(0)
+{
+}
+
+void Replay::startRecording(const Settings & settings)
+{
+    m_settings = settings;
+    m_runs.clear();
+    m_result.clear();
+    m_tickCount = 0;
+    m_raceStartTick = NO_RACE_START;
+    rewind();
+}
+
+void Replay::record(const InputHandler & inputHandler)
+{
+    uint8_t actions = 0;
+    const unsigned int playerCount = std::min(inputHandler.playerCount(), MAX_PLAYERS);
+    for (unsigned int player = 0; player < playerCount; player++)
+    {
+        for (unsigned int action = 0; action < ACTION_COUNT; action++)
+        {
+            if (inputHandler.getActionState(player, static_cast<InputHandler::Action>(action)))
+            {
+                actions |= 1 << (player * ACTION_COUNT + action);
+            }
+        }
+    }
+
+    if (!m_runs.empty() && m_runs.back().actions == actions)
+    {
+        m_runs.back().ticks++;
+    }
+    else
+    {
+        m_runs.push_back({1, actions});
+    }
+
+    m_tickCount++;
+}
+
+void Replay::recordRaceStart()
+{
+    m_raceStartTick = m_tickCount;
+}
+
+void Replay::setResult(const std::vector<float> & carTransforms)
+{
+    m_result = carTransforms;
+}
+
+bool Replay::save(const QString & fileName) const
+{
+    QFile file(fileName);
+    if (!file.open(QIODevice::WriteOnly))
+    {
+        return false;
+    }
+
+    QDataStream out(&file);
+    out << MAGIC << VERSION;
+    out << m_settings.trackName;
+    out << static_cast<qint32>(m_settings.lapCount);
+    out << static_cast<qint32>(m_settings.mode);
+    out << static_cast<qint32>(m_settings.difficulty);
+    out << static_cast<quint32>(m_settings.seed);
+    out << static_cast<qint32>(m_settings.timeStep);
+    out << static_cast<quint32>(m_raceStartTick);
+
+    out << static_cast<quint32>(m_runs.size());
+    for (auto && run : m_runs)
+    {
+        out << static_cast<quint32>(run.ticks) << static_cast<quint8>(run.actions);
+    }
+
+    out.setFloatingPointPrecision(QDataStream::SinglePrecision);
+    out << static_cast<quint32>(m_result.size());
+    for (float value : m_result)
+    {
+        out << value;
+    }
+
+    return out.status() == QDataStream::Ok;
+}
+
+bool Replay::load(const QString & fileName)
+{
+    QFile file(fileName);
+    if (!file.open(QIODevice::ReadOnly))
+    {
+        return false;
+    }
+
+    QDataStream in(&file);
+    quint32 magic = 0;
+    quint32 version = 0;
+    in >> magic >> version;
+    if (magic != MAGIC || version != VERSION)
+    {
+        return false;
+    }
+
+    qint32 lapCount = 0;
+    qint32 mode = 0;
+    qint32 difficulty = 0;
+    quint32 seed = 0;
+    qint32 timeStep = 0;
+    quint32 raceStartTick = 0;
+    in >> m_settings.trackName >> lapCount >> mode >> difficulty >> seed >> timeStep >> raceStartTick;
+    m_settings.lapCount = lapCount;
+    m_settings.mode = mode;
+    m_settings.difficulty = difficulty;
+    m_settings.seed = seed;
+    m_settings.timeStep = timeStep;
+    m_raceStartTick = raceStartTick;
+
+    quint32 runCount = 0;
+    in >> runCount;
+    m_runs.clear();
+    m_tickCount = 0;
+    for (quint32 i = 0; i < runCount && in.status() == QDataStream::Ok; i++)
+    {
+        quint32 ticks = 0;
+        quint8 actions = 0;
+        in >> ticks >> actions;
+        m_runs.push_back({ticks, actions});
+        m_tickCount += ticks;
+    }
+
+    in.setFloatingPointPrecision(QDataStream::SinglePrecision);
+    quint32 resultSize = 0;
+    in >> resultSize;
+    m_result.clear();
+    for (quint32 i = 0; i < resultSize && in.status() == QDataStream::Ok; i++)
+    {
+        float value = 0;
+        in >> value;
+        m_result.push_back(value);
+    }
+
+    rewind();
+
+    return in.status() == QDataStream::Ok;
+}
+
+void Replay::rewind()
+{
+    m_run = 0;
+    m_runTick = 0;
+    m_playedTicks = 0;
+}
+
+bool Replay::play(InputHandler & inputHandler)
+{
+    while (m_run < m_runs.size() && m_runTick >= m_runs[m_run].ticks)
+    {
+        m_run++;
+        m_runTick = 0;
+    }
+
+    if (m_run >= m_runs.size())
+    {
+        return false;
+    }
+
+    const uint8_t actions = m_runs[m_run].actions;
+    const unsigned int playerCount = std::min(inputHandler.playerCount(), MAX_PLAYERS);
+    for (unsigned int player = 0; player < playerCount; player++)
+    {
+        for (unsigned int action = 0; action < ACTION_COUNT; action++)
+        {
+            inputHandler.setActionState(
+                player, static_cast<InputHandler::Action>(action), actions & (1 << (player * ACTION_COUNT + action)));
+        }
+    }
+
+    m_runTick++;
+    m_playedTicks++;
+    return true;
+}
+
+bool Replay::isRaceStartTick() const
+{
+    return m_playedTicks == m_raceStartTick;
+}
+
+const Replay::Settings & Replay::settings() const
+{
+    return m_settings;
+}
+
+unsigned int Replay::tickCount() const
+{
+    return m_tickCount;
+}
+
+const std::vector<float> & Replay::result() const
+{
+    return m_result;
+}
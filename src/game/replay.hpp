@@ -0,0 +1,121 @@
+// This file is part of Dust Racing 2D.
+// Copyright (C) 2018 Jussi Lind <jussi.lind@iki.fi>
+//
+// Dust Racing 2D is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// Dust Racing 2D is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Dust Racing 2D. If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef REPLAY_HPP
+#define REPLAY_HPP
+
+#include <QString>
+
+#include <cstdint>
+#include <vector>
+
+class InputHandler;
+
+/*! Records the actions of the players on each tick of a race and plays them back.
+ *  The recording covers every step of the world from the first one on the new track,
+ *  including the steps before the startlights start the race. Together with the random
+ *  seed set when the track is activated this reproduces the race, so the final car
+ *  transforms of a playback can be compared with the recorded ones.
+ *
+ *  The actions of a tick are packed into a byte and stored as runs of equal bytes. */
+class Replay
+{
+public:
+
+    //! Race settings needed to start the same race again.
+    struct Settings
+    {
+        QString trackName;
+
+        int lapCount = 0;
+
+        int mode = 0;
+
+        int difficulty = 0;
+
+        unsigned int seed = 0;
+
+        int timeStep = 0;
+    };
+
+    //! Constructor.
+    Replay();
+
+    //! Clear the ticks and the result and start recording a race with the given settings.
+    void startRecording(const Settings & settings);
+
+    //! Append the current actions of the players as the next tick.
+    void record(const InputHandler & inputHandler);
+
+    //! Mark that the race starts before the next recorded tick.
+    void recordRaceStart();
+
+    //! Set the final transforms of the cars: x, y and angle for each car.
+    void setResult(const std::vector<float> & carTransforms);
+
+    //! Save to the given file. \return false on failure.
+    bool save(const QString & fileName) const;
+
+    //! Load from the given file and rewind. \return false on failure.
+    bool load(const QString & fileName);
+
+    //! Start playing back from the first tick.
+    void rewind();
+
+    /*! Set the actions of the next tick to the input handler.
+     *  \return false if all ticks have been played. */
+    bool play(InputHandler & inputHandler);
+
+    //! \return true if the race starts before the next tick to be played.
+    bool isRaceStartTick() const;
+
+    //! \return the settings of the recorded race.
+    const Settings & settings() const;
+
+    //! \return the number of recorded ticks.
+    unsigned int tickCount() const;
+
+    //! \return the final car transforms of the recording.
+    const std::vector<float> & result() const;
+
+private:
+
+    struct Run
+    {
+        uint32_t ticks;
+
+        uint8_t actions;
+    };
+
+    Settings m_settings;
+
+    std::vector<Run> m_runs;
+
+    std::vector<float> m_result;
+
+    unsigned int m_tickCount;
+
+    //! Number of ticks recorded before the race started.
+    unsigned int m_raceStartTick;
+
+    //! Playback position.
+    unsigned int m_run;
+
+    unsigned int m_runTick;
+
+    unsigned int m_playedTicks;
+};
+
+#endif // REPLAY_HPP
@@ -0,0 +1,12 @@
+# Records a race with scripted input and replays it. The game exits with
+# an error if the replay doesn't end with the same car transforms.
+
+execute_process(COMMAND ${GAME} --record ${REPLAY_FILE} --fast RESULT_VARIABLE result)
+if(NOT result EQUAL 0)
+    message(FATAL_ERROR "Recording the race failed: ${result}")
+endif()
+
+execute_process(COMMAND ${GAME} --replay ${REPLAY_FILE} --fast RESULT_VARIABLE result)
+if(NOT result EQUAL 0)
+    message(FATAL_ERROR "The replay doesn't match the recording: ${result}")
+endif()
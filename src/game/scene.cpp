@@ -32,6 +32,7 @@
 #include "particlefactory.hpp"
 #include "pit.hpp"
 #include "race.hpp"
+#include "randomstreams.hpp"
 #include "renderer.hpp"
 #include "settings.hpp"
 #include "startlights.hpp"
@@ -50,6 +51,7 @@
 
 #include <MCAssetManager>
 #include <MCCamera>
+#include <MCCollisionDetector>
 #include <MCFrictionGenerator>
 #include <MCGLAmbientLight>
 #include <MCGLDiffuseLight>
@@ -60,6 +62,7 @@
 #include <MCObject>
 #include <MCPhysicsComponent>
 #include <MCShape>
+#include <MCStateBuffer>
 #include <MCSurface>
 #include <MCSurfaceView>
 #include <MCTextureFont>
@@ -87,7 +90,7 @@ Scene::Scene(Game & game, StateMachine & stateMachine, Renderer & renderer, MCWo
 , m_stateMachine(stateMachine)
 , m_renderer(renderer)
 , m_messageOverlay(new MessageOverlay)
-, m_race(game, NUM_CARS)
+, m_race(game, NUM_CARS, world)
 , m_activeTrack(nullptr)
 , m_world(world)
 , m_startlights(new Startlights)
@@ -96,10 +99,11 @@ Scene::Scene(Game & game, StateMachine & stateMachine, Renderer & renderer, MCWo
 , m_mainMenu(nullptr)
 , m_menuManager(nullptr)
 , m_intro(new Intro)
-, m_particleFactory(new ParticleFactory)
+, m_particleFactory(new ParticleFactory(world))
 , m_fadeAnimation(new FadeAnimation)
 {
     connect(m_startlights, &Startlights::raceStarted, &m_race, &Race::start);
+    connect(m_startlights, &Startlights::raceStarted, this, &Scene::raceStarted);
     connect(m_startlights, &Startlights::animationEnded, &m_stateMachine, &StateMachine::endStartlightAnimation);
 
     connect(&m_stateMachine, &StateMachine::startlightAnimationRequested, m_startlights, &Startlights::beginAnimation);
@@ -123,6 +127,7 @@ Scene::Scene(Game & game, StateMachine & stateMachine, Renderer & renderer, MCWo
     for (int i = 0; i < 2; i++)
     {
         m_cameraOffset[i] = 0.0f;
+        m_cameraStep[i] = 0;
         m_timingOverlay[i].setRace(m_race);
     }
 
@@ -133,6 +138,9 @@ Scene::Scene(Game & game, StateMachine & stateMachine, Renderer & renderer, MCWo
 
     m_world.setMetersPerUnit(METERS_PER_UNIT);
 
+    // The race has only one world, so its contact geometry can use all cores
+    m_world.collisionDetector().setThreadCount(0);
+
     MCAssetManager::textureFontManager().font(m_game.fontName()).setShaderProgram(
         m_renderer.program("text"));
     MCAssetManager::textureFontManager().font(m_game.fontName()).setShadowShaderProgram(
@@ -142,7 +150,7 @@ Scene::Scene(Game & game, StateMachine & stateMachine, Renderer & renderer, MCWo
     const MCGLDiffuseLight diffuseLight(MCVector3dF(1.0, -1.0, -1.0), 1.0, 0.9, 0.5, 0.75);
     const MCGLDiffuseLight specularLight(MCVector3dF(1.0, -1.0, -1.0), 1.0, 1.0, 0.8, 0.9);
 
-    MCGLScene & glScene = MCWorld::instance().renderer().glScene();
+    MCGLScene & glScene = m_world.renderer().glScene();
     glScene.setAmbientLight(ambientLight);
     glScene.setDiffuseLight(diffuseLight);
     glScene.setSpecularLight(specularLight);
@@ -182,12 +190,12 @@ void Scene::createCars()
     // Create and add cars.
     for (int i = 0; i < NUM_CARS; i++)
     {
-        CarPtr car(CarFactory::buildCar(i, NUM_CARS, m_game));
+        CarPtr car(CarFactory::buildCar(i, NUM_CARS, m_game, m_world));
         if (car)
         {
             if (!car->isHuman())
             {
-                m_ai.push_back(AIPtr(new AI(*car)));
+                m_ai.push_back(AIPtr(new AI(*car, m_world.randomStream(RandomStreams::AI))));
             }
 
             car->shape()->view()->setShaderProgram(m_renderer.program("car"));
@@ -272,12 +280,12 @@ void Scene::updateFrame(InputHandler & handler, int step)
             {
                 for (int i = 0; i < 2; i++)
                 {
-                    updateCameraLocation(m_camera[i], m_cameraOffset[i], *m_cars.at(i));
+                    updateCameraLocation(i, *m_cars.at(i));
                 }
             }
             else
             {
-                updateCameraLocation(m_camera[0], m_cameraOffset[0], *m_cars.at(0));
+                updateCameraLocation(0, *m_cars.at(0));
             }
         }
     }
@@ -289,7 +297,7 @@ void Scene::updateFrame(InputHandler & handler, int step)
     const float fadeValue = m_renderer.fadeValue();
     if (m_fadeAnimation->isFading())
     {
-        MCGLScene & glScene = MCWorld::instance().renderer().glScene();
+        MCGLScene & glScene = m_world.renderer().glScene();
         glScene.setFadeValue(fadeValue);
     }
 }
@@ -308,6 +316,54 @@ void Scene::updateOverlays()
     m_messageOverlay->update();
 }
 
+void Scene::saveState(MCStateBuffer & state) const
+{
+    m_world.saveState(state);
+    m_race.saveState(state);
+
+    for (AIPtr ai : m_ai)
+    {
+        ai->saveState(state);
+    }
+}
+
+bool Scene::restoreState(MCStateBuffer & state)
+{
+    if (!m_world.restoreState(state))
+    {
+        return false;
+    }
+
+    m_race.restoreState(state);
+
+    for (AIPtr ai : m_ai)
+    {
+        ai->restoreState(state);
+    }
+
+    return state.isValid();
+}
+
+void Scene::startRace()
+{
+    m_race.start();
+
+    emit raceStarted();
+}
+
+std::vector<float> Scene::carTransforms() const
+{
+    std::vector<float> transforms;
+    for (auto && car : m_cars)
+    {
+        transforms.push_back(car->location().i());
+        transforms.push_back(car->location().j());
+        transforms.push_back(car->angle());
+    }
+
+    return transforms;
+}
+
 void Scene::updateWorld(float timeStep)
 {
     // Step time
@@ -322,7 +378,22 @@ void Scene::updateRace()
     emit listenerLocationChanged(m_cars[0]->location().i(), m_cars[0]->location().j());
 }
 
-void Scene::updateCameraLocation(MCCamera & camera, float & offset, MCObject & object)
+void Scene::setRenderInterpolation(float alpha)
+{
+    m_world.setRenderInterpolation(alpha);
+
+    for (int i = 0; i < 2; i++)
+    {
+        // Cameras not updated on the latest step keep their position
+        if (m_cameraStep[i] == m_world.stepCount())
+        {
+            const MCVector2dF loc(m_previousCameraLocation[i] + (m_cameraLocation[i] - m_previousCameraLocation[i]) * alpha);
+            m_camera[i].setPos(loc.i(), loc.j());
+        }
+    }
+}
+
+void Scene::updateCameraLocation(int index, MCObject & object)
 {
     // Update camera location with respect to the car speed.
     // Make changes a bit smoother so that an abrupt decrease
@@ -332,10 +403,17 @@ void Scene::updateCameraLocation(MCCamera & camera, float & offset, MCObject & o
     const float offsetAmplification = m_game.hasTwoHumanPlayers() ? 9.6 : 13.8;
     const float smooth              = 0.2;
 
+    float & offset = m_cameraOffset[index];
     offset += (object.physicsComponent().velocity().lengthFast() - offset) * smooth;
     loc    += object.direction() * offset * offsetAmplification;
 
-    camera.setPos(loc.i(), loc.j());
+    // Interpolate only between consecutive steps so that the camera
+    // doesn't sweep over the track e.g. after a restart.
+    m_previousCameraLocation[index] = m_cameraStep[index] + 1 == m_world.stepCount() ? m_cameraLocation[index] : loc;
+    m_cameraLocation[index] = loc;
+    m_cameraStep[index] = m_world.stepCount();
+
+    m_camera[index].setPos(loc.i(), loc.j());
 }
 
 void Scene::processUserInput(InputHandler & handler)
@@ -446,6 +524,8 @@ void Scene::setActiveTrack(Track & activeTrack)
     setupAI(activeTrack);
 
     setupMinimaps();
+
+    emit activeTrackChanged();
 }
 
 void Scene::setWorldDimensions()
@@ -469,7 +549,7 @@ void Scene::addCarsToWorld()
     // Add objects to the world
     for (CarPtr car : m_cars)
     {
-        car->addToWorld();
+        car->addToWorld(m_world);
     }
 }
 
@@ -490,7 +570,7 @@ void Scene::createNormalObjects()
         assert(trackObject);
 
         MCObject & object = trackObject->object();
-        object.addToWorld();
+        object.addToWorld(m_world);
 
         // Set the base Z of mesh objects at ground level instead of at the object center
         float baseZ = 0;
@@ -532,7 +612,7 @@ void Scene::createBridgeObjects()
 
                 bridge->translate(MCVector3dF(i * w + w / 2, j * h + h / 2, 0));
                 bridge->rotate(tile->rotation());
-                bridge->addToWorld();
+                bridge->addToWorld(m_world);
                 m_bridges.push_back(bridge);
             }
         }
@@ -607,7 +687,7 @@ void Scene::renderTrack()
     case StateMachine::State::DoStartlights:
     case StateMachine::State::Play:
     {
-        MCGLScene & glScene = MCWorld::instance().renderer().glScene();
+        MCGLScene & glScene = m_world.renderer().glScene();
 
         if (m_game.hasTwoHumanPlayers())
         {
@@ -636,7 +716,7 @@ void Scene::renderTrack()
 
 void Scene::renderMenu()
 {
-    MCGLScene & glScene = MCWorld::instance().renderer().glScene();
+    MCGLScene & glScene = m_world.renderer().glScene();
 
     switch (m_stateMachine.state())
     {
@@ -673,7 +753,7 @@ void Scene::renderCommonHUD()
     case StateMachine::State::Play:
     {
         // Setup for common scene
-        MCGLScene & glScene = MCWorld::instance().renderer().glScene();
+        MCGLScene & glScene = m_world.renderer().glScene();
         glScene.setSplitType(MCGLScene::ShowFullScreen);
 
         if (m_race.checkeredFlagEnabled() && !m_game.hasTwoHumanPlayers())
@@ -699,7 +779,7 @@ void Scene::renderHUD()
     case StateMachine::State::DoStartlights:
     case StateMachine::State::Play:
     {
-        MCGLScene & glScene = MCWorld::instance().renderer().glScene();
+        MCGLScene & glScene = m_world.renderer().glScene();
 
         if (m_game.hasTwoHumanPlayers())
         {
@@ -741,7 +821,7 @@ void Scene::renderWorld(MCRenderGroup renderGroup, bool prepareRendering)
     case StateMachine::State::DoStartlights:
     case StateMachine::State::Play:
     {
-        MCGLScene & glScene = MCWorld::instance().renderer().glScene();
+        MCGLScene & glScene = m_world.renderer().glScene();
 
         if (m_game.hasTwoHumanPlayers())
         {
@@ -25,6 +25,7 @@
 
 #include <QObject>
 #include <MCCamera>
+#include <MCGLScene>
 #include <memory>
 #include <vector>
 
@@ -37,6 +38,7 @@ class InputHandler;
 class Intro;
 class MCCamera;
 class MCObject;
+class MCStateBuffer;
 class MCSurface;
 class MCWorld;
 class MessageOverlay;
@@ -81,9 +83,26 @@ public:
     //! Update physics and objects by the given time step in ms.
     void updateFrame(InputHandler & handler, int step);
 
+    /*! Save the simulation state into the given buffer: the world, the race, the cars
+     *  and the AI. Restoring it and updating with the same input gives the same frames. */
+    void saveState(MCStateBuffer & state) const;
+
+    //! Restore the state saved with saveState(). \return false if the state is invalid.
+    bool restoreState(MCStateBuffer & state);
+
+    //! Start the race without the startlights, e.g. when replaying a race.
+    void startRace();
+
+    //! \return x, y and angle of each car in the order of the race.
+    std::vector<float> carTransforms() const;
+
     //! Update HUD overlays.
     void updateOverlays();
 
+    /*! Render objects and cameras between their states before and after the latest step.
+     *  \param alpha Interpolation factor [0.0..1.0]. */
+    void setRenderInterpolation(float alpha);
+
     //! Set the active race track.
     void setActiveTrack(Track & activeTrack);
 
@@ -107,6 +126,12 @@ signals:
 
     void listenerLocationChanged(float x, float y);
 
+    //! Emitted when the race has been set up on a new active track, before the first step.
+    void activeTrackChanged();
+
+    //! Emitted when the race has started.
+    void raceStarted();
+
 private:
 
     void addCarsToWorld();
@@ -145,7 +170,7 @@ private:
 
     void updateAi();
 
-    void updateCameraLocation(MCCamera & camera, float & offset, MCObject & object);
+    void updateCameraLocation(int index, MCObject & object);
 
     void updateRace();
 
@@ -183,6 +208,13 @@ private:
 
     float m_cameraOffset[2];
 
+    MCVector2dF m_cameraLocation[2];
+
+    MCVector2dF m_previousCameraLocation[2];
+
+    //! World step of the latest camera update.
+    unsigned int m_cameraStep[2];
+
     MTFH::MenuPtr m_mainMenu;
 
     MTFH::MenuManager * m_menuManager;
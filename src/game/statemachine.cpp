@@ -189,6 +189,15 @@ void StateMachine::finishRace()
     m_raceFinished = true;
 }
 
+void StateMachine::beginReplay()
+{
+    m_state = State::Play;
+    m_oldState = State::Play;
+    m_raceFinished = false;
+
+    emit renderingEnabled(true);
+}
+
 StateMachine::State StateMachine::state() const
 {
     return m_state;
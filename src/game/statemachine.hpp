@@ -77,6 +77,9 @@ public slots:
 
     void finishRace();
 
+    //! Jump directly into the race without the menus and the transitions, e.g. when replaying a race.
+    void beginReplay();
+
 signals:
 
     void fadeInRequested(int, int, int);
@@ -16,6 +16,8 @@
 #include "timing.hpp"
 #include "car.hpp"
 
+#include <MCStateBuffer>
+
 #include <QString>
 
 #include <cassert>
@@ -230,6 +232,24 @@ void Timing::tick()
     }
 }
 
+void Timing::saveState(MCStateBuffer & state) const
+{
+    state.writeVector(m_times);
+    state.write(m_time);
+    state.write(m_started);
+    state.write(m_lapRecord);
+    state.write(m_raceRecord);
+}
+
+void Timing::restoreState(MCStateBuffer & state)
+{
+    state.readVector(m_times);
+    state.read(m_time);
+    state.read(m_started);
+    state.read(m_lapRecord);
+    state.read(m_raceRecord);
+}
+
 std::wstring Timing::msecsToString(int msec)
 {
     if (msec < 0)
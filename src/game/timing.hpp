@@ -22,6 +22,7 @@
 
 
 class Car;
+class MCStateBuffer;
 
 class Timing : public QObject
 {
@@ -99,6 +100,12 @@ public:
     //! Increase timer assuming 60 Hz update rate
     void tick();
 
+    //! Save the times into the given buffer.
+    void saveState(MCStateBuffer & state) const;
+
+    //! Restore the times saved with saveState().
+    void restoreState(MCStateBuffer & state);
+
     //! Converts msecs to string "mm:ss.zz".
     static std::wstring msecsToString(int msec);
 
@@ -16,21 +16,32 @@
 #include "tire.hpp"
 #include "car.hpp"
 
-#include <MCAssetManager>
-#include <MCMathUtil>
 #include <MCPhysicsComponent>
-#include <MCSurface>
-#include <MCTrigonom>
 
-Tire::Tire(Car & car, float friction, float offTrackFriction)
-    : MCObject(MCAssetManager::surfaceManager().surface("frontTire"), "Tire")
+Tire::Tire(Car & car, const MCVector3dF & location, float friction, float offTrackFriction)
+    : m_car(car)
+    , m_location(location)
+    , m_angle(0)
     , m_isOffTrack(false)
     , m_friction(friction)
     , m_offTrackFriction(offTrackFriction)
     , m_spinCoeff(1.0f)
-    , m_car(car)
 {
-    setBypassCollisions(true);
+}
+
+const MCVector3dF & Tire::location() const
+{
+    return m_location;
+}
+
+void Tire::setAngle(float angle)
+{
+    m_angle = angle;
+}
+
+float Tire::angle() const
+{
+    return m_angle;
 }
 
 void Tire::setIsOffTrack(bool flag)
@@ -43,28 +54,26 @@ void Tire::setSpinCoeff(float spinCoeff)
     m_spinCoeff = spinCoeff;
 }
 
-void Tire::onStepTime(int)
+void Tire::applyForces(const MCVector2dF & velocity, const MCVector2dF & normal, const MCVector3dF & location, float gravity) const
 {
-    if (physicsComponent().velocity().lengthFast() > 0)
+    if (velocity.lengthFast() > 0)
     {
-        const float tireNormalAngle = angle() + 90;
-        const MCVector2dF tire(
-            MCTrigonom::cos(tireNormalAngle), MCTrigonom::sin(tireNormalAngle));
-        MCVector2dF v = physicsComponent().velocity();
+        MCVector2dF v = velocity;
         v.clampFast(0.999f); // Clamp instead of normalizing to avoid artifacts on small values
+        const float mass = m_car.physicsComponent().mass();
         MCVector2dF impulse =
-            MCVector2dF::projection(v, tire) *
+            MCVector2dF::projection(v, normal) *
                 (m_isOffTrack ? m_offTrackFriction : m_friction) * m_spinCoeff *
-                    -MCWorld::instance().gravity().k() * parent().physicsComponent().mass();
-        impulse.clampFast(parent().physicsComponent().mass() * 7.0f * m_car.tireWearFactor());
-        parent().physicsComponent().addForce(-impulse, location());
+                    -gravity * mass;
+        impulse.clampFast(mass * 7.0f * m_car.tireWearFactor());
+        m_car.physicsComponent().addForce(-impulse, location);
 
         if (m_car.isBraking())
         {
             MCVector2dF impulse =
                 v * 0.5f * (m_isOffTrack ? m_offTrackFriction : m_friction) *
-                    -MCWorld::instance().gravity().k() * parent().physicsComponent().mass() * m_car.tireWearFactor();
-            parent().physicsComponent().addForce(-impulse, location());
+                    -gravity * mass * m_car.tireWearFactor();
+            m_car.physicsComponent().addForce(-impulse, location);
         }
     }
 }
@@ -16,24 +16,52 @@
 #ifndef TIRE_HPP
 #define TIRE_HPP
 
-#include <MCObject>
+#include <MCVector2d>
+#include <MCVector3d>
 
 class Car;
 
-class Tire : public MCObject
+/*! Car-local model of a tire. Tires are not objects in the world: the car
+ *  computes the contact points of all of its tires in its own step and the
+ *  tires apply their forces to the car. */
+class Tire
 {
 public:
 
-    Tire(Car & car, float friction, float offTrackFriction);
+    /*! Constructor.
+     *  \param location is the location of the tire relative to the car.
+     *  \param friction is the friction coefficient on the track.
+     *  \param offTrackFriction is the friction coefficient off the track. */
+    Tire(Car & car, const MCVector3dF & location, float friction, float offTrackFriction);
 
-    virtual void onStepTime(int step) override;
+    //! \return location relative to the car.
+    const MCVector3dF & location() const;
+
+    //! Set the steering angle relative to the car.
+    void setAngle(float angle);
+
+    //! \return steering angle relative to the car.
+    float angle() const;
 
     void setIsOffTrack(bool flag);
 
     void setSpinCoeff(float spinCoeff);
 
+    /*! Apply the friction forces of the tire to the car.
+     *  \param velocity is the velocity of the contact point.
+     *  \param normal is the unit normal of the rolling direction of the tire.
+     *  \param location is the location of the contact point in the world.
+     *  \param gravity is the z-component of the gravity of the car's world. */
+    void applyForces(const MCVector2dF & velocity, const MCVector2dF & normal, const MCVector3dF & location, float gravity) const;
+
 private:
 
+    Car & m_car;
+
+    MCVector3dF m_location;
+
+    float m_angle;
+
     bool m_isOffTrack;
 
     float m_friction;
@@ -41,8 +69,6 @@ private:
     float m_offTrackFriction;
 
     float m_spinCoeff;
-
-    Car & m_car;
 };
 
 #endif // TIRE_HPP
@@ -25,7 +25,6 @@
 #include <MCLogger>
 #include <MCObject>
 #include <MCObjectFactory>
-#include <MCRandom>
 #include <MCPhysicsComponent>
 #include <MCShape>
 #include <MCShapeView>
@@ -178,10 +177,12 @@ TrackObject * TrackObjectFactory::build(
     }
     else if (role == "tree")
     {
-        int height = 200 + 200 * MCRandom::getValue();
-        object = MCObjectPtr(new Tree(MCAssetManager::surfaceManager().surface("tree"),
-            1.0f + 0.50f * MCRandom::getValue(),
-            0.1f + 0.2f * MCRandom::getValue(),
+        float values[3];
+        m_random.fill(values, 3);
+        int height = 200 + 200 * values[0];
+        object = MCObjectPtr(new Tree(MCAssetManager::surfaceManager().surface("tree"), m_random,
+            1.0f + 0.50f * values[1],
+            0.1f + 0.2f * values[2],
             height,
             height / 10));
         object->setInitialLocation(location);
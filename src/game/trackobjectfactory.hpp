@@ -18,6 +18,7 @@
 
 #include <QString>
 #include <MCObjectFactory>
+#include <MCRandomStream>
 
 class TrackObject;
 
@@ -36,6 +37,9 @@ public:
 private:
 
     MCObjectFactory  & m_objectFactory;
+
+    //! Tracks are loaded before any world exists, so the scenery has its own stream.
+    MCRandomStream     m_random;
 };
 
 #endif // TRACKOBJECTFACTORY_HPP
@@ -18,16 +18,18 @@
 #include <MCSurface>
 #include <MCPhysicsComponent>
 #include <MCCircleShape>
-#include <MCRandom>
+#include <MCRandomStream>
 #include <MCShape>
 #include <MCShapeView>
 
+#include <vector>
+
 namespace {
 static const float treeBodyRadius = 8;
 static const float treeViewRadius = 48;
 }
 
-Tree::Tree(MCSurface & surface, float r0, float r1, float treeHeight, int branches)
+Tree::Tree(MCSurface & surface, MCRandomStream & random, float r0, float r1, float treeHeight, int branches)
     : MCObject(MCShapePtr(new MCCircleShape(nullptr, treeBodyRadius)), "tree")
 {
     physicsComponent().setMass(1, true); // Stationary
@@ -38,6 +40,12 @@ Tree::Tree(MCSurface & surface, float r0, float r1, float treeHeight, int branch
     shape()->setRadius(treeBodyRadius);
 
     const float branchHeight = treeHeight / branches;
+
+    std::vector<MCVector2dF> offsets(branches);
+    random.fill(offsets.data(), offsets.size());
+    std::vector<float> angles(branches);
+    random.fill(angles.data(), angles.size());
+
     for (int i = 0; i < branches; i++)
     {
         auto branch = new MCObject(surface, i == 0 ? "treeRoot" : "treeBranch");
@@ -53,8 +61,7 @@ Tree::Tree(MCSurface & surface, float r0, float r1, float treeHeight, int branch
         {
             branch->shape()->view()->setHasShadow(false);
             branch->setIsPhysicsObject(false);
-            const auto offset = MCRandom::randomVector2d() * 5;
-            addChildObject(MCObjectPtr(branch), MCVector3dF(0, 0, branchHeight) * (i + 1) + MCVector3dF(offset), MCRandom::getValue() * 360);
+            addChildObject(MCObjectPtr(branch), MCVector3dF(0, 0, branchHeight) * (i + 1) + MCVector3dF(offsets[i] * 5), angles[i] * 360);
         }
 
         const float scale = r0 - (r0 - r1) / branches * i;
@@ -18,13 +18,15 @@
 
 #include <MCObject>
 
+class MCRandomStream;
 class MCSurface;
 
 class Tree : public MCObject
 {
 public:
 
-    Tree(MCSurface & surface, float r0, float r1, float treeHeight, int branches);
+    //! Constructor. The branch offsets and angles are drawn from the given stream.
+    Tree(MCSurface & surface, MCRandomStream & random, float r0, float r1, float treeHeight, int branches);
 };
 
 #endif // TREE_HPP